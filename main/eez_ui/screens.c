@@ -1,3 +1,4 @@
+#include <stdio.h>
 #include <string.h>
 
 #include "screens.h"
@@ -9,6 +10,10 @@
 #include "styles.h"
 #include "ui.h"
 #include "../rs485_comm.h"
+#include "../light_reconcile.h"
+#include "../rs485_frames.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
 
 #include <string.h>
 
@@ -19,17 +24,22 @@ lv_obj_t *tick_value_change_obj;
 static uint32_t log_row_count = 0;
 #define MAX_LOG_ROWS 100
 
-// 添加日志记录
-static void add_log_entry(const char *button_name) {
+// 添加日志记录（LVGL 线程）
+static void add_log_entry(const char *log_text) {
     if (objects.tb_logs == NULL) {
         return;
     }
     
-    
-    
+    // 超过上限时丢弃最旧一行，其余行上移
+    if (log_row_count >= MAX_LOG_ROWS) {
+        for (uint32_t row = 1; row < log_row_count; row++) {
+            lv_table_set_cell_value(objects.tb_logs, row - 1, 0,
+                                    lv_table_get_cell_value(objects.tb_logs, row, 0));
+        }
+        log_row_count--;
+    }
+
     // 添加新日志
-    char log_text[128];
-    snprintf(log_text, sizeof(log_text), "%s 被点击", button_name);
     lv_table_set_cell_value(objects.tb_logs, log_row_count, 0, log_text);
     log_row_count++;
     
@@ -37,11 +47,82 @@ static void add_log_entry(const char *button_name) {
     lv_table_set_row_count(objects.tb_logs, log_row_count);
 }
 
+// 其他任务发来的日志：只入队不等 LVGL 锁，由 LVGL 定时器取出写表格，
+// 避免总线任务被界面渲染拖住
+#define LOG_QUEUE_LENGTH 16
+#define LOG_DRAIN_PERIOD_MS 50
+
+typedef struct {
+    char text[64];
+} log_msg_t;
+
+static QueueHandle_t s_log_queue = NULL;
+
+static void log_drain_timer_cb(lv_timer_t *timer) {
+    (void)timer;
+    log_msg_t msg;
+    while (xQueueReceive(s_log_queue, &msg, 0) == pdTRUE) {
+        add_log_entry(msg.text);
+    }
+}
+
+// 可在任意任务调用，队列满时丢弃
+static void post_log_entry(const char *text) {
+    if (s_log_queue == NULL) {
+        return;
+    }
+    log_msg_t msg;
+    snprintf(msg.text, sizeof(msg.text), "%s", text);
+    xQueueSend(s_log_queue, &msg, 0);
+}
+
+// RS485 任务完成（TX 任务上下文）
+static void on_rs485_done(bool success, void *user_ctx) {
+    char text[64];
+    snprintf(text, sizeof(text), "%s %s", (const char *)user_ctx, success ? "被点击" : "失败");
+    post_log_entry(text);
+}
+
+static const char *light_state_name(uint8_t state) {
+    switch (state) {
+    case RS485_CMD_RED_ON: return "红灯常亮";
+    case RS485_CMD_YELLOW_ON: return "黄灯常亮";
+    case RS485_CMD_GREEN_ON: return "绿灯常亮";
+    case RS485_CMD_RED_SLOW_FLASH: return "红灯慢闪";
+    case RS485_CMD_YELLOW_SLOW_FLASH: return "黄灯慢闪";
+    case RS485_CMD_GREEN_SLOW_FLASH: return "绿灯慢闪";
+    case RS485_CMD_RED_BURST_FLASH: return "红灯爆闪";
+    case RS485_CMD_YELLOW_BURST_FLASH: return "黄灯爆闪";
+    case RS485_CMD_GREEN_BURST_FLASH: return "绿灯爆闪";
+    case RS485_CMD_LIGHT_OFF: return "警灯关闭";
+    default: return "未知状态";
+    }
+}
+
+// 状态协调任务上下文：与总线任务一样只入队，不等 LVGL 锁
+void on_light_state_changed(uint8_t address, uint8_t state, bool confirmed, void *user_ctx) {
+    (void)address;
+    (void)user_ctx;
+    char text[64];
+    snprintf(text, sizeof(text), "%s %s", light_state_name(state), confirmed ? "已确认" : "已发送");
+    post_log_entry(text);
+}
+
+// 只记录期望状态，由状态协调任务在总线空闲时下发最新值；
+// 连续点击被合并，不会排队过期命令
+static void submit_light_command(rs485_cmd_t cmd) {
+    light_reconcile_set(RS485_DEVICE_ADDR, cmd);
+}
+
 void create_screen_main() {
     void *flowState = getFlowState(0, 0);
     (void)flowState;
     lv_obj_t *obj = lv_obj_create(0);
     objects.main = obj;
+    if (s_log_queue == NULL) {
+        s_log_queue = xQueueCreate(LOG_QUEUE_LENGTH, sizeof(log_msg_t));
+        lv_timer_create(log_drain_timer_cb, LOG_DRAIN_PERIOD_MS, NULL);
+    }
     lv_obj_set_pos(obj, 0, 0);
     lv_obj_set_size(obj, 800, 480);
     lv_obj_set_style_bg_color(obj, lv_color_hex(0xff000000), LV_PART_MAIN | LV_STATE_DEFAULT);
@@ -274,78 +355,58 @@ void tick_screen_main() {
 // RS485 按钮事件处理函数
 void on_btn_red_on_clicked(lv_event_t *e) {
     (void)e;
-    if (rs485_send_command(RS485_CMD_RED_ON)) {
-        add_log_entry("红灯常亮");
-    }
+    submit_light_command(RS485_CMD_RED_ON);
 }
 
 void on_btn_yellow_on_clicked(lv_event_t *e) {
     (void)e;
-    if (rs485_send_command(RS485_CMD_YELLOW_ON)) {
-        add_log_entry("黄灯常亮");
-    }
+    submit_light_command(RS485_CMD_YELLOW_ON);
 }
 
 void on_btn_green_on_clicked(lv_event_t *e) {
     (void)e;
-    if (rs485_send_command(RS485_CMD_GREEN_ON)) {
-        add_log_entry("绿灯常亮");
-    }
+    submit_light_command(RS485_CMD_GREEN_ON);
 }
 
 void on_btn_red_slow_clicked(lv_event_t *e) {
     (void)e;
-    if (rs485_send_command(RS485_CMD_RED_SLOW_FLASH)) {
-        add_log_entry("红灯慢闪");
-    }
+    submit_light_command(RS485_CMD_RED_SLOW_FLASH);
 }
 
 void on_btn_yellow_slow_clicked(lv_event_t *e) {
     (void)e;
-    if (rs485_send_command(RS485_CMD_YELLOW_SLOW_FLASH)) {
-        add_log_entry("黄灯慢闪");
-    }
+    submit_light_command(RS485_CMD_YELLOW_SLOW_FLASH);
 }
 
 void on_btn_green_slow_clicked(lv_event_t *e) {
     (void)e;
-    if (rs485_send_command(RS485_CMD_GREEN_SLOW_FLASH)) {
-        add_log_entry("绿灯慢闪");
-    }
+    submit_light_command(RS485_CMD_GREEN_SLOW_FLASH);
 }
 
 void on_btn_red_burst_clicked(lv_event_t *e) {
     (void)e;
-    if (rs485_send_command(RS485_CMD_RED_BURST_FLASH)) {
-        add_log_entry("红灯爆闪");
-    }
+    submit_light_command(RS485_CMD_RED_BURST_FLASH);
 }
 
 void on_btn_yellow_burst_clicked(lv_event_t *e) {
     (void)e;
-    if (rs485_send_command(RS485_CMD_YELLOW_BURST_FLASH)) {
-        add_log_entry("黄灯爆闪");
-    }
+    submit_light_command(RS485_CMD_YELLOW_BURST_FLASH);
 }
 
 void on_btn_green_burst_clicked(lv_event_t *e) {
     (void)e;
-    if (rs485_send_command(RS485_CMD_GREEN_BURST_FLASH)) {
-        add_log_entry("绿灯爆闪");
-    }
+    submit_light_command(RS485_CMD_GREEN_BURST_FLASH);
 }
 
 void on_btn_light_off_clicked(lv_event_t *e) {
     (void)e;
-    if (rs485_send_command(RS485_CMD_LIGHT_OFF)) {
-        add_log_entry("警灯关闭");
-    }
+    submit_light_command(RS485_CMD_LIGHT_OFF);
 }
 
 void on_btn_query_devices_clicked(lv_event_t *e) {
     (void)e;
-    if (rs485_query_devices()) {
-        add_log_entry("查询设备");
+    if (!rs485_submit_query_devices(on_rs485_done, (void *)"查询设备")) {
+        add_log_entry("查询设备 提交失败（队列已满）");
     }
 }
 
@@ -48,6 +48,9 @@ void on_btn_green_burst_clicked(lv_event_t *e);
 void on_btn_light_off_clicked(lv_event_t *e);
 void on_btn_query_devices_clicked(lv_event_t *e);
 
+// 塔灯实际状态变化（状态协调任务上下文），由 main 注册到 light_reconcile
+void on_light_state_changed(uint8_t address, uint8_t state, bool confirmed, void *user_ctx);
+
 void tick_screen_by_id(enum ScreensEnum screenId);
 void tick_screen(int screen_index);
 
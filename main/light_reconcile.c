@@ -0,0 +1,238 @@
+#include "light_reconcile.h"
+#include "rs485_breaker.h"
+#include "rs485_frames.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include <string.h>
+
+static const char *TAG = "LIGHT";
+
+// 协调任务：低于 RS485 TX 任务，高于 LVGL
+#define LIGHT_RECONCILE_TASK_STACK_SIZE 3072
+#define LIGHT_RECONCILE_TASK_PRIORITY 8
+
+// 命令回显与读回的应答超时
+#define LIGHT_RECONCILE_ACK_TIMEOUT_MS 100
+
+typedef struct {
+    light_device_state_t state;
+    uint32_t desired_seq; // 每次 set 递增
+    uint32_t applied_seq; // 已下发的 desired_seq
+} light_slot_t;
+
+static portMUX_TYPE s_light_lock = portMUX_INITIALIZER_UNLOCKED;
+static light_slot_t s_slots[LIGHT_RECONCILE_MAX_DEVICES];
+static size_t s_slot_count = 0;
+
+static rs485_bus_t *s_bus = NULL;
+static TaskHandle_t s_task = NULL;
+static uint32_t s_verify_period_ms = 0;
+static light_state_cb_t s_state_cb = NULL;
+static void *s_state_cb_ctx = NULL;
+
+// 查找或登记设备；调用者需在临界区内
+static light_slot_t *light_slot_locked(uint8_t address, bool create) {
+    for (size_t i = 0; i < s_slot_count; i++) {
+        if (s_slots[i].state.address == address) {
+            return &s_slots[i];
+        }
+    }
+    if (!create || s_slot_count >= LIGHT_RECONCILE_MAX_DEVICES) {
+        return NULL;
+    }
+    light_slot_t *slot = &s_slots[s_slot_count++];
+    memset(slot, 0, sizeof(*slot));
+    slot->state.address = address;
+    slot->state.actual = LIGHT_STATE_UNKNOWN;
+    return slot;
+}
+
+// 更新实际状态，变化时通知
+static void light_set_actual(light_slot_t *slot, uint8_t actual, bool confirmed, bool verified) {
+    portENTER_CRITICAL(&s_light_lock);
+    bool changed = slot->state.actual != actual || slot->state.confirmed != confirmed;
+    slot->state.actual = actual;
+    slot->state.confirmed = confirmed;
+    if (verified) {
+        slot->state.last_verified_us = esp_timer_get_time();
+    }
+    portEXIT_CRITICAL(&s_light_lock);
+
+    if (changed && s_state_cb != NULL) {
+        s_state_cb(slot->state.address, actual, confirmed, s_state_cb_ctx);
+    }
+}
+
+// 下发命令；设备回显请求即视为确认。断路器断开或未能发出时返回 false
+static bool light_apply(light_slot_t *slot, rs485_cmd_t cmd) {
+    uint8_t request[RS485_FRAME_LENGTH];
+    uint8_t response[RS485_FRAME_LENGTH];
+    bool crc_ok = false;
+    uint8_t address = slot->state.address;
+    uart_port_t uart_num = rs485_bus_get_uart(s_bus);
+    if (!rs485_breaker_admit(uart_num, address, NULL)) {
+        return false;
+    }
+    rs485_frames_build(request, address, 0x06, RS485_REG_LIGHT, (uint16_t)cmd);
+
+    // 广播没有应答，只能记为已发送未确认
+    uint32_t timeout_ms = address == RS485_MODBUS_BROADCAST_ADDR ? 0 : LIGHT_RECONCILE_ACK_TIMEOUT_MS;
+    int len = rs485_bus_transact_lane(s_bus, rs485_cmd_lane(cmd), request, RS485_FRAME_LENGTH, response,
+                                      sizeof(response), timeout_ms, &crc_ok);
+    rs485_breaker_report(uart_num, address, len > 0);
+    if (len < 0) {
+        // 未能发出：保持待发
+        return false;
+    }
+
+    portENTER_CRITICAL(&s_light_lock);
+    slot->state.sends++;
+    portEXIT_CRITICAL(&s_light_lock);
+
+    if (len >= 8 && crc_ok && memcmp(response, request, 6) == 0) {
+        light_set_actual(slot, (uint8_t)cmd, true, true);
+    } else {
+        // 已发出但未得到回显：不知道设备是否执行，实际值不变，只撤销确认，等待读回
+        light_set_actual(slot, slot->state.actual, false, false);
+    }
+    return true;
+}
+
+// 读回灯光寄存器；返回 false 表示设备未应答
+static bool light_verify(light_slot_t *slot) {
+    uint8_t request[RS485_FRAME_LENGTH];
+    uint8_t response[RS485_FRAME_LENGTH];
+    bool crc_ok = false;
+    uint8_t address = slot->state.address;
+    uart_port_t uart_num = rs485_bus_get_uart(s_bus);
+    if (address == RS485_MODBUS_BROADCAST_ADDR || !rs485_breaker_admit(uart_num, address, NULL)) {
+        return false;
+    }
+    rs485_frames_build(request, address, 0x03, RS485_REG_LIGHT, 1);
+
+    int len = rs485_bus_transact_lane(s_bus, RS485_LANE_POLL, request, RS485_FRAME_LENGTH, response,
+                                      sizeof(response), LIGHT_RECONCILE_ACK_TIMEOUT_MS, &crc_ok);
+    rs485_breaker_report(uart_num, address, len > 0);
+    // 应答：地址 03 02 值高 值低 CRC
+    if (len < 7 || !crc_ok || response[0] != address || response[1] != 0x03 || response[2] != 2) {
+        return false;
+    }
+    light_set_actual(slot, response[4], true, true);
+    return true;
+}
+
+// 下发所有待发的期望状态，报警命令先于普通命令
+static void light_apply_pending(void) {
+    for (int pass = 0; pass < 2; pass++) {
+        for (size_t i = 0; i < s_slot_count; i++) {
+            light_slot_t *slot = &s_slots[i];
+
+            // 只取最新期望值：其间到达的多次请求在此合并
+            portENTER_CRITICAL(&s_light_lock);
+            bool dirty = slot->applied_seq != slot->desired_seq;
+            uint32_t seq = slot->desired_seq;
+            rs485_cmd_t desired = slot->state.desired;
+            portEXIT_CRITICAL(&s_light_lock);
+
+            bool alarm = rs485_cmd_lane(desired) == RS485_LANE_ALARM;
+            if (!dirty || alarm != (pass == 0)) {
+                continue;
+            }
+            // 断路器断开时保持待发，到读回周期再尝试（届时可能放行探测）
+            if (light_apply(slot, desired)) {
+                portENTER_CRITICAL(&s_light_lock);
+                slot->applied_seq = seq;
+                portEXIT_CRITICAL(&s_light_lock);
+            }
+        }
+    }
+}
+
+static void light_reconcile_task(void *arg) {
+    (void)arg;
+    TickType_t verify_period = s_verify_period_ms ? pdMS_TO_TICKS(s_verify_period_ms) : portMAX_DELAY;
+    TickType_t last_verify = xTaskGetTickCount();
+
+    while (1) {
+        // 有新期望状态时立即唤醒，否则等到下一次读回确认
+        TickType_t elapsed = xTaskGetTickCount() - last_verify;
+        TickType_t wait = verify_period == portMAX_DELAY ? portMAX_DELAY
+                          : (elapsed < verify_period ? verify_period - elapsed : 0);
+        ulTaskNotifyTake(pdTRUE, wait);
+
+        bool verify_due = verify_period != portMAX_DELAY && xTaskGetTickCount() - last_verify >= verify_period;
+        if (verify_due) {
+            last_verify = xTaskGetTickCount();
+        }
+
+        light_apply_pending();
+        for (size_t i = 0; verify_due && i < s_slot_count; i++) {
+            light_slot_t *slot = &s_slots[i];
+
+            portENTER_CRITICAL(&s_light_lock);
+            bool dirty = slot->applied_seq != slot->desired_seq;
+            rs485_cmd_t desired = slot->state.desired;
+            portEXIT_CRITICAL(&s_light_lock);
+
+            if (!dirty && slot->desired_seq != 0 && light_verify(slot) && slot->state.actual != (uint8_t)desired) {
+                // 设备状态被外部改变或上次命令丢失：重新下发
+                ESP_LOGW(TAG, "Light 0x%02X drifted (0x%02X, want 0x%02X), resending", slot->state.address,
+                         slot->state.actual, desired);
+                light_apply(slot, desired);
+            }
+            // 读回期间到达的新命令（尤其是报警）不必等整轮确认结束
+            light_apply_pending();
+        }
+    }
+}
+
+bool light_reconcile_start(rs485_bus_t *bus, uint32_t verify_period_ms, light_state_cb_t cb, void *user_ctx) {
+    if (bus == NULL || s_task != NULL) {
+        return false;
+    }
+    s_bus = bus;
+    s_verify_period_ms = verify_period_ms;
+    s_state_cb = cb;
+    s_state_cb_ctx = user_ctx;
+
+    if (xTaskCreate(light_reconcile_task, "light_reconcile", LIGHT_RECONCILE_TASK_STACK_SIZE, NULL,
+                    LIGHT_RECONCILE_TASK_PRIORITY, &s_task) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create reconcile task");
+        s_task = NULL;
+        return false;
+    }
+    return true;
+}
+
+bool light_reconcile_set(uint8_t address, rs485_cmd_t cmd) {
+    if (s_task == NULL) {
+        return false;
+    }
+
+    portENTER_CRITICAL(&s_light_lock);
+    light_slot_t *slot = light_slot_locked(address, true);
+    if (slot != NULL) {
+        slot->state.desired = cmd;
+        slot->state.requests++;
+        slot->desired_seq++;
+    }
+    portEXIT_CRITICAL(&s_light_lock);
+
+    if (slot == NULL) {
+        return false;
+    }
+    xTaskNotifyGive(s_task);
+    return true;
+}
+
+bool light_reconcile_get(uint8_t address, light_device_state_t *state) {
+    portENTER_CRITICAL(&s_light_lock);
+    light_slot_t *slot = light_slot_locked(address, false);
+    if (slot != NULL) {
+        *state = slot->state;
+    }
+    portEXIT_CRITICAL(&s_light_lock);
+    return slot != NULL;
+}
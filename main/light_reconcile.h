@@ -0,0 +1,74 @@
+#ifndef LIGHT_RECONCILE_H
+#define LIGHT_RECONCILE_H
+
+#include "rs485_comm.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// 同时管理的塔灯数
+#define LIGHT_RECONCILE_MAX_DEVICES 16
+
+// 实际状态未知（尚未确认过）
+#define LIGHT_STATE_UNKNOWN 0x00
+
+// 单个塔灯的期望状态与实际状态
+typedef struct {
+  uint8_t address;
+  rs485_cmd_t desired;        // 最近一次请求的状态
+  uint8_t actual;             // 最近一次确认的状态，LIGHT_STATE_UNKNOWN 表示未知
+  bool confirmed;             // actual 是否经设备应答确认
+  int64_t last_verified_us;   // 最近一次读回确认的时间
+  uint32_t requests;          // 收到的状态请求数
+  uint32_t sends;             // 实际发送的命令帧数（差值即被合并的请求）
+} light_device_state_t;
+
+/**
+ * @brief 实际状态变化回调，在协调任务上下文中调用
+ * @param address 设备地址
+ * @param state 实际状态（rs485_cmd_t 取值），未知时为 LIGHT_STATE_UNKNOWN
+ * @param confirmed 是否经设备应答确认
+ * @param user_ctx 用户参数
+ */
+typedef void (*light_state_cb_t)(uint8_t address, uint8_t state, bool confirmed,
+                                 void *user_ctx);
+
+/**
+ * @brief 启动状态协调任务
+ *
+ * 协调任务只发送每个设备最新的期望状态：总线空闲前到达的多次请求
+ * 合并为一帧，总线负载与请求频率无关。并按周期读回灯光寄存器，
+ * 实际状态与期望不符时重新下发。无应答的塔灯由断路器（rs485_breaker.h）
+ * 暂停收发，期望状态保留到设备恢复后再下发。
+ *
+ * @param bus 塔灯所在总线
+ * @param verify_period_ms 读回确认周期（毫秒），0 表示不周期确认
+ * @param cb 实际状态变化回调，可为 NULL
+ * @param user_ctx 用户参数
+ * @return true 成功, false 失败或已启动
+ */
+bool light_reconcile_start(rs485_bus_t *bus, uint32_t verify_period_ms,
+                           light_state_cb_t cb, void *user_ctx);
+
+/**
+ * @brief 设置设备的期望状态（不阻塞，可在 UI 事件中调用）
+ * @param address 设备地址
+ * @param cmd 期望状态
+ * @return true 已记录, false 未启动或设备表已满
+ */
+bool light_reconcile_set(uint8_t address, rs485_cmd_t cmd);
+
+/**
+ * @brief 读取设备状态
+ * @return true 找到, false 设备未登记
+ */
+bool light_reconcile_get(uint8_t address, light_device_state_t *state);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // LIGHT_RECONCILE_H
@@ -4,11 +4,17 @@
  * SPDX-License-Identifier: CC0-1.0
  */
 
+#include "eez_ui/screens.h"
 #include "eez_ui/ui.h"
 #include "esp_log.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "light_reconcile.h"
+#include "modbus_autobaud.h"
+#include "modbus_gateway.h"
+#include "modbus_slave.h"
 #include "rs485_comm.h"
+#include "rs485_frames.h"
 #include "waveshare_rgb_lcd_port.h"
 #include <stdio.h>
 #include <stdlib.h>
@@ -19,8 +25,39 @@
 #define RS485_UART_NUM UART_NUM_2
 #define RS485_TX_PIN 16      // 参考demo配置
 #define RS485_RX_PIN 15      // 参考demo配置
+#define RS485_DE_PIN UART_PIN_NO_CHANGE // 板载收发器自动换向；外接收发器时填 DE/RE 引脚
 #define RS485_BAUD_RATE 9600 // 参考demo配置
 
+// 启动时自动探测塔灯的波特率与校验，并切到所有塔灯都能应答的最高速率
+// 默认关闭：探测最坏耗时约 15 个设置 × 塔灯数 × 2 次 × 100ms
+#define RS485_AUTOBAUD_ENABLED 0
+
+// Modbus TCP 网关：SCADA/MES 经网络读写塔灯，请求转发到 RS485 总线
+// 默认关闭：本工程尚未初始化 Wi-Fi/以太网，接入网络后置 1
+#define MODBUS_GATEWAY_ENABLED 0
+#define MODBUS_GATEWAY_PORT 502
+#define MODBUS_GATEWAY_CACHE_MS 200    // 重复读在此期间由缓存应答
+#define MODBUS_GATEWAY_REPORT_MS 10000 // 吞吐量日志周期
+
+// 塔灯状态读回确认周期
+#define LIGHT_VERIFY_PERIOD_MS 5000
+
+// PLC 从站口：第二路 RS485，本机作为从站接受 PLC 控制塔灯
+// 默认关闭，按实际接线修改引脚后置 1
+#define PLC_SLAVE_ENABLED 0
+#define PLC_UART_NUM UART_NUM_1
+#define PLC_TX_PIN 20
+#define PLC_RX_PIN 19
+#define PLC_DE_PIN UART_PIN_NO_CHANGE
+#define PLC_BAUD_RATE 9600
+#define PLC_SLAVE_ADDR 0x10
+
+// PLC 侧寄存器映射：0..1 为塔灯状态只读镜像，2 可写（写入即下发命令）
+#define PLC_REG_LIGHT_ACTUAL 0
+#define PLC_REG_LIGHT_CONFIRMED 1
+#define PLC_REG_LIGHT_COMMAND 2
+#define PLC_REG_COUNT 3
+
 // 测试任务配置
 #define RS485_TEST_TASK_STACK_SIZE 4096 // 增加栈大小避免栈溢出
 #define RS485_TEST_TASK_PRIORITY 5      // 降低优先级避免与系统任务冲突
@@ -28,6 +65,108 @@
 
 static const char *TAG_MAIN = "MAIN";
 
+// 线圈 i 对应的灯光命令
+static const rs485_cmd_t s_plc_coil_cmds[] = {
+    RS485_CMD_RED_ON,          RS485_CMD_YELLOW_ON,
+    RS485_CMD_GREEN_ON,        RS485_CMD_RED_SLOW_FLASH,
+    RS485_CMD_YELLOW_SLOW_FLASH, RS485_CMD_GREEN_SLOW_FLASH,
+    RS485_CMD_RED_BURST_FLASH, RS485_CMD_YELLOW_BURST_FLASH,
+    RS485_CMD_GREEN_BURST_FLASH,
+};
+
+static modbus_slave_t *s_plc_slave = NULL;
+
+// PLC 写线圈：与面板按钮一样只设置期望状态
+static void on_plc_command(uint16_t coil, rs485_cmd_t cmd, void *user_ctx) {
+  (void)coil;
+  (void)user_ctx;
+  light_reconcile_set(RS485_DEVICE_ADDR, cmd);
+}
+
+// PLC 写入前检查：命令寄存器只接受预生成帧表中的灯光命令，其余值回异常 03
+static bool on_plc_validate(uint16_t address, uint16_t value, void *user_ctx) {
+  (void)user_ctx;
+  if (address != PLC_REG_LIGHT_COMMAND) {
+    return true;
+  }
+  return value <= 0xFF &&
+         rs485_frames_command(RS485_DEVICE_ADDR, (rs485_cmd_t)value) != NULL;
+}
+
+// PLC 写命令寄存器（取值已由 on_plc_validate 检查）
+static void on_plc_write(uint16_t address, uint16_t quantity, void *user_ctx) {
+  (void)user_ctx;
+  uint16_t value = 0;
+  if (address <= PLC_REG_LIGHT_COMMAND &&
+      address + quantity > PLC_REG_LIGHT_COMMAND &&
+      modbus_slave_get_register(s_plc_slave, PLC_REG_LIGHT_COMMAND, &value)) {
+    light_reconcile_set(RS485_DEVICE_ADDR, (rs485_cmd_t)value);
+  }
+}
+
+// 塔灯状态变化：刷新 PLC 镜像，再转交 UI（UI 侧只把消息投进日志队列，
+// 由 LVGL 定时器取出显示，见 screens.c 的 post_log_entry）
+static void on_light_state(uint8_t address, uint8_t state, bool confirmed,
+                           void *user_ctx) {
+  if (s_plc_slave != NULL && address == RS485_DEVICE_ADDR) {
+    modbus_slave_set_register(s_plc_slave, PLC_REG_LIGHT_ACTUAL, state);
+    modbus_slave_set_register(s_plc_slave, PLC_REG_LIGHT_CONFIRMED, confirmed);
+    modbus_slave_set_active_command(s_plc_slave, (rs485_cmd_t)state);
+  }
+  on_light_state_changed(address, state, confirmed, user_ctx);
+}
+
+static void plc_slave_init(void) {
+  rs485_bus_config_t bus_config = {};
+  bus_config.uart_num = PLC_UART_NUM;
+  bus_config.tx_pin = PLC_TX_PIN;
+  bus_config.rx_pin = PLC_RX_PIN;
+  bus_config.de_pin = PLC_DE_PIN;
+  bus_config.baud_rate = PLC_BAUD_RATE;
+  bus_config.task_core = -1;
+
+  modbus_slave_config_t config = {};
+  config.address = PLC_SLAVE_ADDR;
+  config.register_count = PLC_REG_COUNT;
+  config.writable_start = PLC_REG_LIGHT_COMMAND;
+  config.coil_cmds = s_plc_coil_cmds;
+  config.coil_count = sizeof(s_plc_coil_cmds) / sizeof(s_plc_coil_cmds[0]);
+  config.command_cb = on_plc_command;
+  config.write_cb = on_plc_write;
+  config.validate_cb = on_plc_validate;
+
+  rs485_bus_t *bus = rs485_bus_open(&bus_config);
+  s_plc_slave = modbus_slave_create(&config);
+  if (bus == NULL || s_plc_slave == NULL ||
+      !modbus_slave_start(s_plc_slave, bus)) {
+    ESP_LOGE(TAG_MAIN, "Failed to start PLC slave");
+  }
+}
+
+// 在塔灯地址上探测波特率与校验，须在协调任务启动前调用
+static void rs485_autobaud(void) {
+  static const uint8_t addresses[] = {RS485_DEVICE_ADDR};
+  modbus_autobaud_config_t config = {};
+  config.addresses = addresses;
+  config.address_count = sizeof(addresses) / sizeof(addresses[0]);
+  config.probe_register = RS485_REG_LIGHT;
+  config.apply = true;
+
+  static modbus_autobaud_result_t result;
+  if (!modbus_autobaud_run(rs485_get_default_bus(), &config, &result)) {
+    ESP_LOGW(TAG_MAIN, "Auto-baud found no towers, keeping %d",
+             RS485_BAUD_RATE);
+    return;
+  }
+  if (result.line_baud == 0) {
+    ESP_LOGW(TAG_MAIN, "Auto-baud done in %lu ms, not every tower answers; using %d",
+             (unsigned long)result.elapsed_ms, result.best_baud);
+    return;
+  }
+  ESP_LOGI(TAG_MAIN, "Auto-baud done in %lu ms, towers are configured for %d",
+           (unsigned long)result.elapsed_ms, result.line_baud);
+}
+
 extern "C" void app_main() {
   // 先初始化其他系统组件（避免任务创建时的看门狗检查问题）
   waveshare_esp32_s3_rgb_lcd_init();
@@ -47,11 +186,39 @@ extern "C" void app_main() {
 
   // 初始化 RS485 通信
   bool rs485_ok = false;
-  if (!rs485_init(RS485_UART_NUM, RS485_TX_PIN, RS485_RX_PIN,
+  if (!rs485_init(RS485_UART_NUM, RS485_TX_PIN, RS485_RX_PIN, RS485_DE_PIN,
                   RS485_BAUD_RATE)) {
     ESP_LOGE(TAG_MAIN, "Failed to initialize RS485");
   } else {
     ESP_LOGI(TAG_MAIN, "RS485 initialized successfully");
     rs485_ok = true;
   }
+
+  if (RS485_AUTOBAUD_ENABLED && rs485_ok) {
+    rs485_autobaud();
+  }
+
+  // PLC 从站须在协调任务之前就绪，以便首次状态回调即刷新镜像
+  if (PLC_SLAVE_ENABLED) {
+    plc_slave_init();
+  }
+
+  // 按钮只设置期望状态，由协调任务合并下发并周期读回确认
+  if (rs485_ok && !light_reconcile_start(rs485_get_default_bus(),
+                                         LIGHT_VERIFY_PERIOD_MS,
+                                         on_light_state, NULL)) {
+    ESP_LOGE(TAG_MAIN, "Failed to start light reconciliation");
+  }
+
+  if (MODBUS_GATEWAY_ENABLED && rs485_ok) {
+    modbus_gateway_config_t gateway_config = {
+        .port = MODBUS_GATEWAY_PORT,
+        .cache_ttl_ms = MODBUS_GATEWAY_CACHE_MS,
+        .timeout_ms = 100,
+        .report_ms = MODBUS_GATEWAY_REPORT_MS,
+    };
+    if (!modbus_gateway_start(rs485_get_default_bus(), &gateway_config)) {
+      ESP_LOGE(TAG_MAIN, "Failed to start Modbus TCP gateway");
+    }
+  }
 }
@@ -0,0 +1,139 @@
+#include "modbus_autobaud.h"
+#include "modbus_discovery.h"
+#include "modbus_master.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include <string.h>
+
+static const char *TAG = "MODBUS_BAUD";
+
+#define MODBUS_AUTOBAUD_DEFAULT_PROBES 2
+
+static const int s_rates[MODBUS_AUTOBAUD_RATE_COUNT] = {9600, 19200, 38400, 57600, 115200};
+static const uart_parity_t s_parities[MODBUS_AUTOBAUD_PARITY_COUNT] = {
+    UART_PARITY_DISABLE,
+    UART_PARITY_EVEN,
+    UART_PARITY_ODD,
+};
+
+static char autobaud_parity_char(uart_parity_t parity) {
+    return parity == UART_PARITY_EVEN ? 'E' : (parity == UART_PARITY_ODD ? 'O' : 'N');
+}
+
+// 读一次探测寄存器；只有地址匹配且 CRC 正确的应答才计分（异常应答也说明设置正确）
+static bool autobaud_probe(rs485_bus_t *bus, uint8_t address, uint16_t reg, uint32_t timeout_ms) {
+    modbus_request_t request = {
+        .slave = address,
+        .function = MODBUS_FC_READ_HOLDING_REGISTERS,
+        .address = reg,
+        .quantity = 1,
+    };
+    uint8_t tx[RS485_FRAME_MAX_LEN];
+    uint8_t rx[RS485_FRAME_MAX_LEN];
+    bool crc_ok = false;
+    size_t tx_len = modbus_master_encode(&request, tx);
+    int len = rs485_bus_transact(bus, tx, tx_len, rx, sizeof(rx), timeout_ms, &crc_ok);
+    return len >= 5 && crc_ok && rx[0] == address && (rx[1] & 0x7F) == MODBUS_FC_READ_HOLDING_REGISTERS;
+}
+
+bool modbus_autobaud_run(rs485_bus_t *bus, const modbus_autobaud_config_t *config,
+                         modbus_autobaud_result_t *result) {
+    if (bus == NULL || config == NULL || result == NULL) {
+        return false;
+    }
+    memset(result, 0, sizeof(*result));
+
+    uint8_t addresses[MODBUS_AUTOBAUD_MAX_DEVICES];
+    size_t count = 0;
+    if (config->addresses != NULL) {
+        count = config->address_count < MODBUS_AUTOBAUD_MAX_DEVICES ? config->address_count
+                                                                     : MODBUS_AUTOBAUD_MAX_DEVICES;
+        memcpy(addresses, config->addresses, count);
+    } else {
+        modbus_device_info_t devices[MODBUS_AUTOBAUD_MAX_DEVICES];
+        count = modbus_discovery_get_devices(devices, MODBUS_AUTOBAUD_MAX_DEVICES);
+        for (size_t i = 0; i < count; i++) {
+            addresses[i] = devices[i].address;
+        }
+    }
+    if (count == 0) {
+        ESP_LOGW(TAG, "No known devices to probe");
+        return false;
+    }
+    result->device_count = count;
+
+    int original_baud = 0;
+    uart_parity_t original_parity = UART_PARITY_DISABLE;
+    rs485_bus_get_line(bus, &original_baud, &original_parity);
+
+    uint32_t timeout_ms = config->timeout_ms ? config->timeout_ms : MODBUS_DEFAULT_TIMEOUT_MS;
+    uint8_t probes = config->probes ? config->probes : MODBUS_AUTOBAUD_DEFAULT_PROBES;
+    int64_t start_us = esp_timer_get_time();
+    const modbus_autobaud_score_t *best = NULL;
+    const modbus_autobaud_score_t *line = NULL; // 所有设备都应答的设置
+
+    for (size_t r = 0; r < MODBUS_AUTOBAUD_RATE_COUNT; r++) {
+        for (size_t p = 0; p < MODBUS_AUTOBAUD_PARITY_COUNT; p++) {
+            modbus_autobaud_score_t *score = &result->scores[r * MODBUS_AUTOBAUD_PARITY_COUNT + p];
+            score->baud_rate = s_rates[r];
+            score->parity = s_parities[p];
+            if (!rs485_bus_set_line(bus, score->baud_rate, score->parity)) {
+                continue;
+            }
+
+            for (size_t d = 0; d < count; d++) {
+                bool answered = false;
+                for (uint8_t n = 0; n < probes; n++) {
+                    score->requests++;
+                    if (autobaud_probe(bus, addresses[d], config->probe_register, timeout_ms)) {
+                        score->replies++;
+                        answered = true;
+                    }
+                }
+                if (answered) {
+                    score->devices++;
+                }
+            }
+            ESP_LOGI(TAG, "%d 8%c1: %u/%u devices, %u/%u replies", score->baud_rate,
+                     autobaud_parity_char(score->parity), score->devices, (unsigned)count, score->replies,
+                     score->requests);
+
+            // 速率升序遍历，同分时后来者更快
+            if (score->devices > 0 &&
+                (best == NULL || score->devices > best->devices ||
+                 (score->devices == best->devices && score->replies >= best->replies))) {
+                best = score;
+            }
+            // 设备只在各自配置的设置上应答，正常情况下至多一个设置满分；
+            // 多个满分时（如校验位不敏感的设备）取高速
+            if (score->devices == count &&
+                (line == NULL || score->baud_rate > line->baud_rate ||
+                 (score->baud_rate == line->baud_rate && score->replies > line->replies))) {
+                line = score;
+            }
+        }
+    }
+    result->elapsed_ms = (uint32_t)((esp_timer_get_time() - start_us) / 1000);
+
+    if (best != NULL) {
+        result->best_baud = best->baud_rate;
+        result->best_parity = best->parity;
+    }
+    if (line != NULL) {
+        result->line_baud = line->baud_rate;
+        result->line_parity = line->parity;
+        ESP_LOGI(TAG, "All %u devices answer on %d 8%c1", (unsigned)count, line->baud_rate,
+                 autobaud_parity_char(line->parity));
+    } else {
+        ESP_LOGW(TAG, "No setting reaches all %u devices", (unsigned)count);
+    }
+
+    // 优先选所有设备都应答的设置，其次选覆盖设备最多的设置
+    const modbus_autobaud_score_t *chosen = line != NULL ? line : best;
+    if (config->apply && chosen != NULL) {
+        rs485_bus_set_line(bus, chosen->baud_rate, chosen->parity);
+    } else if (original_baud > 0) {
+        rs485_bus_set_line(bus, original_baud, original_parity);
+    }
+    return best != NULL;
+}
@@ -0,0 +1,76 @@
+#ifndef MODBUS_AUTOBAUD_H
+#define MODBUS_AUTOBAUD_H
+
+#include "rs485_comm.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// 探测的标准波特率与校验组合
+#define MODBUS_AUTOBAUD_RATE_COUNT 5   // 9600 19200 38400 57600 115200
+#define MODBUS_AUTOBAUD_PARITY_COUNT 3 // N E O
+#define MODBUS_AUTOBAUD_SETTING_COUNT \
+  (MODBUS_AUTOBAUD_RATE_COUNT * MODBUS_AUTOBAUD_PARITY_COUNT)
+
+// 单次探测的设备数上限
+#define MODBUS_AUTOBAUD_MAX_DEVICES 32
+
+// 探测参数
+typedef struct {
+  const uint8_t *addresses; // 已知设备地址，NULL 使用地址扫描登记表中的设备
+  size_t address_count;
+  uint16_t probe_register; // 探测读取的保持寄存器地址
+  uint16_t timeout_ms;     // 单次探测的应答超时，0 用默认值
+  uint8_t probes;          // 每个设置下对每个设备的探测次数，0 用默认值
+  bool apply;              // 结束后切到最佳设置；为 false 时恢复原设置
+} modbus_autobaud_config_t;
+
+// 单个设置的得分
+typedef struct {
+  int baud_rate;
+  uart_parity_t parity;
+  uint16_t requests; // 发出的探测数
+  uint16_t replies;  // 地址匹配且 CRC 正确的应答数
+  uint8_t devices;   // 至少应答一次的设备数
+} modbus_autobaud_score_t;
+
+// 探测结果
+typedef struct {
+  modbus_autobaud_score_t scores[MODBUS_AUTOBAUD_SETTING_COUNT];
+  size_t device_count;      // 参与探测的设备数
+  int best_baud;            // 应答设备最多的设置（同分取高速），0 表示无应答
+  uart_parity_t best_parity;
+  int line_baud;            // 检测到的共同线路设置：所有设备都应答的设置，0 表示没有
+  uart_parity_t line_parity;
+  uint32_t elapsed_ms;      // 探测耗时
+} modbus_autobaud_result_t;
+
+/**
+ * @brief 逐一尝试标准波特率与校验，按已知设备的 CRC 正确应答数打分
+ *
+ * 在调用者任务中同步执行，每个设置下逐个设备读一次探测寄存器；
+ * 最坏耗时约 设置数 × 设备数 × 探测次数 × 超时。探测期间总线被
+ * 反复切换，须在其他总线使用者（协调任务、主站等）启动之前调用。
+ *
+ * 设备只在自己配置的线路设置上应答，探测只能找出它们当前所用的设置，
+ * 并不说明设备还支持更高的速率：要把总线提到 115200 等更高速率，须先
+ * 按设备手册把每台设备改配到新速率，再重新探测。
+ *
+ * @param bus 已打开的总线
+ * @param config 探测参数
+ * @param result 输出结果
+ * @return true 至少一个设置得到应答, false 参数非法或全部无应答
+ */
+bool modbus_autobaud_run(rs485_bus_t *bus,
+                         const modbus_autobaud_config_t *config,
+                         modbus_autobaud_result_t *result);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // MODBUS_AUTOBAUD_H
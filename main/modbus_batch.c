@@ -0,0 +1,143 @@
+#include "modbus_batch.h"
+#include "esp_timer.h"
+#include <string.h>
+
+void modbus_batch_init(modbus_batch_t *batch) {
+    batch->count = 0;
+}
+
+static modbus_batch_write_t *modbus_batch_find(modbus_batch_t *batch, uint8_t slave, uint16_t address) {
+    for (uint16_t i = 0; i < batch->count; i++) {
+        if (batch->writes[i].slave == slave && batch->writes[i].address == address) {
+            return &batch->writes[i];
+        }
+    }
+    return NULL;
+}
+
+bool modbus_batch_add(modbus_batch_t *batch, uint8_t slave, uint16_t address, uint16_t value) {
+    modbus_batch_write_t *w = modbus_batch_find(batch, slave, address);
+    if (w != NULL) {
+        w->value = value; // 只保留最后一次写入
+        return true;
+    }
+    if (batch->count >= MODBUS_BATCH_MAX_WRITES) {
+        return false;
+    }
+    w = &batch->writes[batch->count++];
+    w->slave = slave;
+    w->address = address;
+    w->value = value;
+    return true;
+}
+
+// 组内每个设备都写入相同寄存器与值的写入，替换为一条广播写入
+static void modbus_batch_merge_broadcast(modbus_batch_t *batch, const uint8_t *group, size_t group_size) {
+    if (group == NULL || group_size < 2) {
+        return;
+    }
+
+    bool drop[MODBUS_BATCH_MAX_WRITES] = {false};
+    modbus_batch_write_t broadcast[MODBUS_BATCH_MAX_WRITES];
+    uint16_t broadcast_count = 0;
+
+    for (uint16_t i = 0; i < batch->count; i++) {
+        const modbus_batch_write_t *w = &batch->writes[i];
+        if (w->slave != group[0]) {
+            continue;
+        }
+        bool common = true;
+        for (size_t g = 1; g < group_size && common; g++) {
+            const modbus_batch_write_t *other = modbus_batch_find(batch, group[g], w->address);
+            common = other != NULL && other->value == w->value;
+        }
+        if (!common) {
+            continue;
+        }
+        for (size_t g = 0; g < group_size; g++) {
+            drop[modbus_batch_find(batch, group[g], w->address) - batch->writes] = true;
+        }
+        broadcast[broadcast_count].slave = MODBUS_BROADCAST_ADDR;
+        broadcast[broadcast_count].address = w->address;
+        broadcast[broadcast_count].value = w->value;
+        broadcast_count++;
+    }
+
+    // 每条广播至少替换两条写入，压缩后一定放得下
+    uint16_t kept = 0;
+    for (uint16_t i = 0; i < batch->count; i++) {
+        if (!drop[i]) {
+            batch->writes[kept++] = batch->writes[i];
+        }
+    }
+    memcpy(&batch->writes[kept], broadcast, broadcast_count * sizeof(modbus_batch_write_t));
+    batch->count = kept + broadcast_count;
+}
+
+// 按（从站，寄存器）排序，使可合并的写入相邻；批次很小，插入排序即可
+static void modbus_batch_sort(modbus_batch_t *batch) {
+    for (uint16_t i = 1; i < batch->count; i++) {
+        modbus_batch_write_t w = batch->writes[i];
+        uint32_t key = ((uint32_t)w.slave << 16) | w.address;
+        int j = i - 1;
+        while (j >= 0 && (((uint32_t)batch->writes[j].slave << 16) | batch->writes[j].address) > key) {
+            batch->writes[j + 1] = batch->writes[j];
+            j--;
+        }
+        batch->writes[j + 1] = w;
+    }
+}
+
+modbus_status_t modbus_batch_flush(modbus_master_t *master, modbus_batch_t *batch, const uint8_t *group,
+                                   size_t group_size, bool whole_line, modbus_batch_report_t *report) {
+    modbus_batch_report_t local = {0};
+    modbus_status_t last_error = MODBUS_OK;
+    uint16_t values[MODBUS_MAX_WRITE_REGISTERS];
+    modbus_result_t result;
+
+    local.writes = batch->count;
+    // 广播写到线上所有设备：只有 group 就是整条线时才能替代组内逐个写入
+    if (whole_line) {
+        modbus_batch_merge_broadcast(batch, group, group_size);
+    }
+    modbus_batch_sort(batch);
+
+    const modbus_batch_write_t *w = batch->writes;
+    uint16_t i = 0;
+    while (i < batch->count) {
+        // 同一从站地址连续的寄存器合成一帧
+        uint16_t run = 1;
+        while (i + run < batch->count && run < MODBUS_MAX_WRITE_REGISTERS && w[i + run].slave == w[i].slave &&
+               w[i + run].address == w[i].address + run) {
+            run++;
+        }
+        for (uint16_t k = 0; k < run; k++) {
+            values[k] = w[i + k].value;
+        }
+
+        modbus_request_t request = {
+            .slave = w[i].slave,
+            .function = run > 1 ? MODBUS_FC_WRITE_MULTIPLE_REGISTERS : MODBUS_FC_WRITE_SINGLE_REGISTER,
+            .address = w[i].address,
+            .quantity = run,
+            .values = values,
+            .retry_class = MODBUS_CLASS_COMMAND,
+        };
+        int64_t start_us = esp_timer_get_time();
+        modbus_status_t status = modbus_master_execute(master, &request, &result);
+        local.bus_time_us += (uint32_t)(esp_timer_get_time() - start_us);
+        local.frames++;
+        if (status != MODBUS_OK) {
+            local.failed_frames++;
+            last_error = status;
+        }
+        i += run;
+    }
+
+    local.frames_saved = local.writes > local.frames ? local.writes - local.frames : 0;
+    batch->count = 0;
+    if (report != NULL) {
+        *report = local;
+    }
+    return last_error;
+}
@@ -0,0 +1,82 @@
+#ifndef MODBUS_BATCH_H
+#define MODBUS_BATCH_H
+
+#include "modbus_master.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// 一批最多暂存的寄存器写入
+#define MODBUS_BATCH_MAX_WRITES 64
+
+// 一次待发送的单寄存器写入
+typedef struct {
+  uint8_t slave;
+  uint16_t address;
+  uint16_t value;
+} modbus_batch_write_t;
+
+// 待合并的写入集合
+typedef struct {
+  modbus_batch_write_t writes[MODBUS_BATCH_MAX_WRITES];
+  uint16_t count;
+} modbus_batch_t;
+
+// 一次 flush 的结果
+typedef struct {
+  uint16_t writes;        // 合并后的寄存器写入数
+  uint16_t frames;        // 实际发送的帧数
+  uint16_t frames_saved;  // 相对逐个 FC06 节省的帧数
+  uint16_t failed_frames; // 失败的帧数
+  uint32_t bus_time_us;   // 所有帧从发送到应答（广播为发送完成）的耗时
+} modbus_batch_report_t;
+
+/**
+ * @brief 清空批次
+ */
+void modbus_batch_init(modbus_batch_t *batch);
+
+/**
+ * @brief 暂存一次寄存器写入；同一从站同一寄存器的后写覆盖先写
+ * @return true 成功, false 批次已满
+ */
+bool modbus_batch_add(modbus_batch_t *batch, uint8_t slave, uint16_t address,
+                      uint16_t value);
+
+/**
+ * @brief 合并并发送批次中的全部写入，完成后清空批次
+ *
+ * 合并规则：
+ * 1. whole_line 为 true（group 即整条线上的全部设备）且 group 中每个设备
+ *    都写入相同寄存器与值时，改为一帧广播。group 只是部分设备时广播会
+ *    写到组外的设备，因此不合并；
+ * 2. 同一从站地址连续的寄存器合并为 FC10（每帧至多 123 个）；
+ * 3. 剩余的单个寄存器用 FC06。
+ *
+ * 例如“整条线切到红灯”：对每个塔灯 add(addr, RS485_REG_LIGHT,
+ * RS485_CMD_RED_ON)，以整条线的地址表为 group、whole_line 为 true 调用
+ * flush，只发一帧。
+ *
+ * @param master 主站句柄
+ * @param batch 批次
+ * @param group 设备地址表，可为 NULL（不做广播合并）
+ * @param group_size 地址数量
+ * @param whole_line group 是否为整条线上的全部设备，false 时不做广播合并
+ * @param report 输出结果，可为 NULL
+ * @return MODBUS_OK 全部成功，否则为最后一个失败帧的状态
+ */
+modbus_status_t modbus_batch_flush(modbus_master_t *master,
+                                   modbus_batch_t *batch,
+                                   const uint8_t *group, size_t group_size,
+                                   bool whole_line,
+                                   modbus_batch_report_t *report);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // MODBUS_BATCH_H
@@ -0,0 +1,341 @@
+#include "modbus_cache.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/event_groups.h"
+#include "freertos/task.h"
+#include <stdlib.h>
+#include <string.h>
+
+static const char *TAG = "MODBUS_CACHE";
+
+// 刷新任务：与轮询任务同级
+#define MODBUS_CACHE_TASK_STACK_SIZE 4096
+#define MODBUS_CACHE_TASK_PRIORITY 7
+
+// 哈希表槽数（2 的幂，至少为寄存器数的 2 倍以保持探测链短）
+#define MODBUS_CACHE_HASH_SIZE 512
+#define MODBUS_CACHE_HASH_MASK (MODBUS_CACHE_HASH_SIZE - 1)
+
+typedef struct {
+    uint8_t slave;
+    uint8_t function;
+    uint16_t address;
+    uint16_t quantity;
+    uint16_t first_value; // 在 values[] 中的起点
+    uint32_t ttl_us;
+    int64_t updated_us;
+    bool valid;
+    bool pending;              // 已安排刷新，后续请求合并到这次读取
+    uint32_t generation;       // 每次刷新完成递增
+    uint32_t invalidations;    // 每次失效递增，刷新期间变化则结果作废
+    modbus_status_t last_status;
+} modbus_cache_range_t;
+
+typedef struct {
+    uint32_t key; // (slave << 16) | address
+    uint16_t value_index;
+    uint8_t range;
+    bool used;
+} modbus_cache_slot_t;
+
+struct modbus_cache {
+    modbus_master_t *master;
+    TaskHandle_t task;
+    // 每段一位，按刷新代数的奇偶分两组：第 g 代完成时置位 [g & 1] 组并清除另一组，
+    // 置位保持到下一代完成，等待第 g + 1 代的调用者晚到也不会错过
+    EventGroupHandle_t done_events[2];
+    portMUX_TYPE lock;
+    size_t range_count;
+    size_t value_count;
+    modbus_cache_range_t ranges[MODBUS_CACHE_MAX_RANGES];
+    uint16_t values[MODBUS_CACHE_MAX_REGISTERS];
+    modbus_cache_slot_t hash[MODBUS_CACHE_HASH_SIZE];
+    modbus_result_t result; // 仅刷新任务使用
+};
+
+static inline uint32_t modbus_cache_key(uint8_t slave, uint16_t address) {
+    return ((uint32_t)slave << 16) | address;
+}
+
+static inline uint32_t modbus_cache_hash(uint32_t key) {
+    return (key * 2654435761u) >> 23; // Knuth 乘法散列，取高 9 位
+}
+
+// 查找寄存器所在槽位；调用者需在临界区内
+static const modbus_cache_slot_t *modbus_cache_lookup(const modbus_cache_t *cache, uint8_t slave, uint16_t address) {
+    uint32_t key = modbus_cache_key(slave, address);
+    for (uint32_t i = modbus_cache_hash(key), n = 0; n < MODBUS_CACHE_HASH_SIZE; i = (i + 1) & MODBUS_CACHE_HASH_MASK, n++) {
+        const modbus_cache_slot_t *slot = &cache->hash[i];
+        if (!slot->used) {
+            return NULL;
+        }
+        if (slot->key == key) {
+            return slot;
+        }
+    }
+    return NULL;
+}
+
+// 安排整段刷新；已在刷新中的段不重复安排。调用者需在临界区内
+static bool modbus_cache_schedule_locked(modbus_cache_range_t *range) {
+    if (range->pending) {
+        return false;
+    }
+    range->pending = true;
+    return true;
+}
+
+static void modbus_cache_task(void *arg) {
+    modbus_cache_t *cache = (modbus_cache_t *)arg;
+
+    while (1) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        for (size_t r = 0; r < cache->range_count; r++) {
+            modbus_cache_range_t *range = &cache->ranges[r];
+            portENTER_CRITICAL(&cache->lock);
+            bool pending = range->pending;
+            uint32_t invalidations = range->invalidations;
+            portEXIT_CRITICAL(&cache->lock);
+            if (!pending) {
+                continue;
+            }
+
+            modbus_request_t request = {
+                .slave = range->slave,
+                .function = range->function,
+                .address = range->address,
+                .quantity = range->quantity,
+                .retry_class = MODBUS_CLASS_POLL,
+            };
+            modbus_status_t status = modbus_master_execute(cache->master, &request, &cache->result);
+
+            portENTER_CRITICAL(&cache->lock);
+            if (range->invalidations != invalidations) {
+                // 读取期间被失效：结果可能早于那次写入，丢弃并保持待刷新重读
+                portEXIT_CRITICAL(&cache->lock);
+                xTaskNotifyGive(cache->task);
+                continue;
+            }
+            if (status == MODBUS_OK) {
+                memcpy(&cache->values[range->first_value], cache->result.registers,
+                       range->quantity * sizeof(uint16_t));
+                range->updated_us = esp_timer_get_time();
+                range->valid = true;
+            }
+            range->last_status = status;
+            range->pending = false;
+            uint32_t generation = ++range->generation;
+            portEXIT_CRITICAL(&cache->lock);
+
+            // 先置本代的位再清上一代的位，唤醒所有等待该段的调用者
+            xEventGroupSetBits(cache->done_events[generation & 1], 1u << r);
+            xEventGroupClearBits(cache->done_events[(generation + 1) & 1], 1u << r);
+        }
+    }
+}
+
+modbus_cache_t *modbus_cache_create(modbus_master_t *master) {
+    if (master == NULL) {
+        return NULL;
+    }
+    modbus_cache_t *cache = calloc(1, sizeof(modbus_cache_t));
+    if (cache == NULL) {
+        ESP_LOGE(TAG, "Failed to allocate register cache");
+        return NULL;
+    }
+    cache->master = master;
+    portMUX_TYPE lock = portMUX_INITIALIZER_UNLOCKED;
+    cache->lock = lock;
+
+    for (int i = 0; i < 2; i++) {
+        cache->done_events[i] = xEventGroupCreate();
+        if (cache->done_events[i] == NULL) {
+            ESP_LOGE(TAG, "Failed to create cache event group");
+            goto err;
+        }
+    }
+    if (xTaskCreate(modbus_cache_task, "modbus_cache", MODBUS_CACHE_TASK_STACK_SIZE, cache,
+                    MODBUS_CACHE_TASK_PRIORITY, &cache->task) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create cache task");
+        goto err;
+    }
+    return cache;
+
+err:
+    for (int i = 0; i < 2; i++) {
+        if (cache->done_events[i] != NULL) {
+            vEventGroupDelete(cache->done_events[i]);
+        }
+    }
+    free(cache);
+    return NULL;
+}
+
+int modbus_cache_add_range(modbus_cache_t *cache, uint8_t slave, uint8_t function, uint16_t address,
+                           uint16_t quantity, uint32_t ttl_ms) {
+    if (cache == NULL || quantity == 0 || quantity > MODBUS_MAX_READ_REGISTERS ||
+        (function != MODBUS_FC_READ_HOLDING_REGISTERS && function != MODBUS_FC_READ_INPUT_REGISTERS)) {
+        return -1;
+    }
+
+    portENTER_CRITICAL(&cache->lock);
+    if (cache->range_count >= MODBUS_CACHE_MAX_RANGES || cache->value_count + quantity > MODBUS_CACHE_MAX_REGISTERS) {
+        portEXIT_CRITICAL(&cache->lock);
+        return -1;
+    }
+    // 同一寄存器只能属于一个段
+    for (uint16_t i = 0; i < quantity; i++) {
+        if (modbus_cache_lookup(cache, slave, address + i) != NULL) {
+            portEXIT_CRITICAL(&cache->lock);
+            return -1;
+        }
+    }
+
+    int id = (int)cache->range_count++;
+    modbus_cache_range_t *range = &cache->ranges[id];
+    memset(range, 0, sizeof(*range));
+    range->slave = slave;
+    range->function = function;
+    range->address = address;
+    range->quantity = quantity;
+    range->first_value = (uint16_t)cache->value_count;
+    range->ttl_us = ttl_ms * 1000;
+
+    for (uint16_t i = 0; i < quantity; i++) {
+        uint32_t key = modbus_cache_key(slave, address + i);
+        uint32_t h = modbus_cache_hash(key);
+        while (cache->hash[h].used) {
+            h = (h + 1) & MODBUS_CACHE_HASH_MASK;
+        }
+        cache->hash[h].key = key;
+        cache->hash[h].value_index = (uint16_t)(cache->value_count + i);
+        cache->hash[h].range = (uint8_t)id;
+        cache->hash[h].used = true;
+    }
+    cache->value_count += quantity;
+    portEXIT_CRITICAL(&cache->lock);
+    return id;
+}
+
+modbus_cache_state_t modbus_cache_get(modbus_cache_t *cache, uint8_t slave, uint16_t address, uint16_t *value,
+                                      int64_t *age_us) {
+    int64_t now = esp_timer_get_time();
+    modbus_cache_state_t state;
+    bool notify = false;
+
+    portENTER_CRITICAL(&cache->lock);
+    const modbus_cache_slot_t *slot = modbus_cache_lookup(cache, slave, address);
+    if (slot == NULL) {
+        portEXIT_CRITICAL(&cache->lock);
+        return MODBUS_CACHE_UNKNOWN;
+    }
+    modbus_cache_range_t *range = &cache->ranges[slot->range];
+    int64_t age = now - range->updated_us;
+    if (!range->valid) {
+        state = MODBUS_CACHE_MISS;
+        notify = modbus_cache_schedule_locked(range);
+    } else {
+        *value = cache->values[slot->value_index];
+        if (age_us != NULL) {
+            *age_us = age;
+        }
+        state = age <= (int64_t)range->ttl_us ? MODBUS_CACHE_FRESH : MODBUS_CACHE_STALE;
+        if (state == MODBUS_CACHE_STALE) {
+            notify = modbus_cache_schedule_locked(range);
+        }
+    }
+    portEXIT_CRITICAL(&cache->lock);
+
+    if (notify) {
+        xTaskNotifyGive(cache->task);
+    }
+    return state;
+}
+
+modbus_status_t modbus_cache_read(modbus_cache_t *cache, uint8_t slave, uint16_t address, uint16_t quantity,
+                                  uint16_t *values, uint32_t timeout_ms) {
+    if (cache == NULL || quantity == 0) {
+        return MODBUS_ERR_INVALID_ARG;
+    }
+    TickType_t deadline = xTaskGetTickCount() + pdMS_TO_TICKS(timeout_ms);
+
+    while (1) {
+        portENTER_CRITICAL(&cache->lock);
+        const modbus_cache_slot_t *first = modbus_cache_lookup(cache, slave, address);
+        const modbus_cache_slot_t *last = modbus_cache_lookup(cache, slave, address + quantity - 1);
+        if (first == NULL || last == NULL || first->range != last->range) {
+            portEXIT_CRITICAL(&cache->lock);
+            return MODBUS_ERR_INVALID_ARG;
+        }
+        uint8_t r = first->range;
+        modbus_cache_range_t *range = &cache->ranges[r];
+        if (range->valid && esp_timer_get_time() - range->updated_us <= (int64_t)range->ttl_us) {
+            memcpy(values, &cache->values[first->value_index], quantity * sizeof(uint16_t));
+            portEXIT_CRITICAL(&cache->lock);
+            return MODBUS_OK;
+        }
+        uint32_t generation = range->generation;
+        bool notify = modbus_cache_schedule_locked(range);
+        portEXIT_CRITICAL(&cache->lock);
+
+        if (notify) {
+            xTaskNotifyGive(cache->task);
+        }
+
+        // 等待这次（可能由别人发起的）刷新完成
+        TickType_t now = xTaskGetTickCount();
+        if ((int32_t)(deadline - now) <= 0) {
+            return MODBUS_ERR_TIMEOUT;
+        }
+        xEventGroupWaitBits(cache->done_events[(generation + 1) & 1], 1u << r, pdFALSE, pdTRUE, deadline - now);
+
+        // 刷新完成即返回其结果，不再按 TTL 复查（TTL 很短时避免反复刷新）
+        portENTER_CRITICAL(&cache->lock);
+        modbus_status_t status = range->last_status;
+        bool refreshed = range->generation != generation;
+        if (refreshed && status == MODBUS_OK) {
+            memcpy(values, &cache->values[first->value_index], quantity * sizeof(uint16_t));
+        }
+        portEXIT_CRITICAL(&cache->lock);
+        if (refreshed) {
+            return status;
+        }
+    }
+}
+
+void modbus_cache_invalidate(modbus_cache_t *cache, uint8_t slave, uint16_t address, uint16_t quantity) {
+    if (cache == NULL) {
+        return;
+    }
+    bool notify = false;
+
+    portENTER_CRITICAL(&cache->lock);
+    for (size_t r = 0; r < cache->range_count; r++) {
+        modbus_cache_range_t *range = &cache->ranges[r];
+        // 区间相交即失效整段
+        if (range->slave == slave && address < range->address + range->quantity &&
+            range->address < address + quantity) {
+            range->valid = false;
+            range->invalidations++;
+            notify |= modbus_cache_schedule_locked(range);
+        }
+    }
+    portEXIT_CRITICAL(&cache->lock);
+
+    if (notify) {
+        xTaskNotifyGive(cache->task);
+    }
+}
+
+modbus_status_t modbus_cache_write_register(modbus_cache_t *cache, uint8_t slave, uint16_t address,
+                                            uint16_t value) {
+    if (cache == NULL) {
+        return MODBUS_ERR_INVALID_ARG;
+    }
+    modbus_status_t status = modbus_write_single_register(cache->master, slave, address, value);
+    // 无论成败都失效：写入可能已生效但应答丢失
+    modbus_cache_invalidate(cache, slave, address, 1);
+    return status;
+}
@@ -0,0 +1,96 @@
+#ifndef MODBUS_CACHE_H
+#define MODBUS_CACHE_H
+
+#include "modbus_master.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// 缓存容量：寄存器段数与寄存器总数
+#define MODBUS_CACHE_MAX_RANGES 24
+#define MODBUS_CACHE_MAX_REGISTERS 256
+
+// 非阻塞读取结果
+typedef enum {
+  MODBUS_CACHE_FRESH = 0, // 在 TTL 内，直接可用
+  MODBUS_CACHE_STALE,     // 已过期，返回旧值并已安排刷新
+  MODBUS_CACHE_MISS,      // 尚无有效值（未读过或已因写入失效），已安排刷新
+  MODBUS_CACHE_UNKNOWN,   // 该寄存器不在任何缓存段中
+} modbus_cache_state_t;
+
+typedef struct modbus_cache modbus_cache_t;
+
+/**
+ * @brief 创建寄存器缓存并启动刷新任务
+ * @param master 主站句柄
+ * @return 缓存句柄，失败返回 NULL
+ */
+modbus_cache_t *modbus_cache_create(modbus_master_t *master);
+
+/**
+ * @brief 登记一段缓存的寄存器
+ * @param cache 缓存句柄
+ * @param slave 从站地址
+ * @param function FC03 或 FC04
+ * @param address 起始寄存器
+ * @param quantity 寄存器数量（整段一次读取，至多 125）
+ * @param ttl_ms 有效期（毫秒）
+ * @return 段编号，失败返回 -1
+ */
+int modbus_cache_add_range(modbus_cache_t *cache, uint8_t slave,
+                           uint8_t function, uint16_t address,
+                           uint16_t quantity, uint32_t ttl_ms);
+
+/**
+ * @brief 非阻塞读取一个寄存器（常数时间，不访问总线，可在 UI 中调用）
+ *
+ * 过期或缺失时在后台安排一次整段刷新；同一段的多次请求合并为一次读取。
+ *
+ * @param cache 缓存句柄
+ * @param slave 从站地址
+ * @param address 寄存器地址
+ * @param value 输出值（FRESH/STALE 时有效）
+ * @param age_us 输出距上次读取的时间，可为 NULL
+ * @return 读取结果
+ */
+modbus_cache_state_t modbus_cache_get(modbus_cache_t *cache, uint8_t slave,
+                                      uint16_t address, uint16_t *value,
+                                      int64_t *age_us);
+
+/**
+ * @brief 读穿：缓存新鲜时直接返回，否则等待刷新完成（不可在 UI 中调用）
+ * @param cache 缓存句柄
+ * @param slave 从站地址
+ * @param address 起始寄存器
+ * @param quantity 数量，必须位于同一缓存段内
+ * @param values 输出数组
+ * @param timeout_ms 最长等待时间
+ * @return MODBUS_OK 成功；段不存在为 MODBUS_ERR_INVALID_ARG；
+ *         刷新失败为对应事务状态；等待超时为 MODBUS_ERR_TIMEOUT
+ */
+modbus_status_t modbus_cache_read(modbus_cache_t *cache, uint8_t slave,
+                                  uint16_t address, uint16_t quantity,
+                                  uint16_t *values, uint32_t timeout_ms);
+
+/**
+ * @brief 使一段寄存器失效并安排刷新（在别处写入设备后调用）
+ */
+void modbus_cache_invalidate(modbus_cache_t *cache, uint8_t slave,
+                             uint16_t address, uint16_t quantity);
+
+/**
+ * @brief 写单个寄存器并使对应缓存失效（阻塞至事务完成）
+ */
+modbus_status_t modbus_cache_write_register(modbus_cache_t *cache,
+                                            uint8_t slave, uint16_t address,
+                                            uint16_t value);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // MODBUS_CACHE_H
@@ -0,0 +1,313 @@
+#include "modbus_discovery.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include <stdlib.h>
+#include <string.h>
+
+static const char *TAG = "MODBUS_DISC";
+
+// 扫描任务：低于 LVGL 任务，只占用总线空闲时间
+#define MODBUS_DISCOVERY_TASK_STACK_SIZE 4096
+#define MODBUS_DISCOVERY_TASK_PRIORITY 1
+
+// 应答延迟余量：初值、下限与上限（毫秒）
+#define MODBUS_DISCOVERY_TURNAROUND_DEFAULT_MS 20
+#define MODBUS_DISCOVERY_TURNAROUND_MIN_MS 2
+#define MODBUS_DISCOVERY_TURNAROUND_MAX_MS 100
+
+// 第二遍只补扫受干扰丢失的应答，应答延迟余量不超过此值（毫秒）
+#define MODBUS_DISCOVERY_SECOND_PASS_TURNAROUND_MS 5
+
+// FC03 读 1 个寄存器：请求 8 字节，应答 7 字节
+#define MODBUS_PROBE_REQUEST_LEN 8
+#define MODBUS_PROBE_RESPONSE_LEN 7
+
+// 异常码：非法功能码
+#define MODBUS_EXCEPTION_ILLEGAL_FUNCTION 0x01
+
+typedef struct {
+    modbus_master_t *master;
+    modbus_discovery_config_t config;
+    modbus_discovery_done_cb_t done_cb;
+    void *user_ctx;
+    uint32_t char_time_us;
+    uint32_t frame_gap_us;
+    uint32_t turnaround_allow_us; // 当前应答延迟余量
+    uint32_t turnaround_max_us;   // 已发现设备中最大的实测应答延迟
+    bool learned;                 // 是否已有实测值
+    uint8_t silent[(MODBUS_DISCOVERY_LAST_ADDR + 8) / 8]; // 第一遍静默的地址
+} modbus_discovery_ctx_t;
+
+static modbus_discovery_ctx_t s_ctx;
+static volatile bool s_running = false;
+
+static portMUX_TYPE s_registry_lock = portMUX_INITIALIZER_UNLOCKED;
+static modbus_device_info_t s_registry[MODBUS_DISCOVERY_MAX_DEVICES];
+static size_t s_registry_count = 0;
+
+static void registry_upsert(const modbus_device_info_t *info) {
+    portENTER_CRITICAL(&s_registry_lock);
+    for (size_t i = 0; i < s_registry_count; i++) {
+        if (s_registry[i].address == info->address) {
+            s_registry[i] = *info;
+            portEXIT_CRITICAL(&s_registry_lock);
+            return;
+        }
+    }
+    if (s_registry_count < MODBUS_DISCOVERY_MAX_DEVICES) {
+        s_registry[s_registry_count++] = *info;
+    }
+    portEXIT_CRITICAL(&s_registry_lock);
+}
+
+static void registry_set_capabilities(uint8_t address, uint8_t capabilities) {
+    portENTER_CRITICAL(&s_registry_lock);
+    for (size_t i = 0; i < s_registry_count; i++) {
+        if (s_registry[i].address == address) {
+            s_registry[i].capabilities = capabilities;
+            break;
+        }
+    }
+    portEXIT_CRITICAL(&s_registry_lock);
+}
+
+// 超时 = 应答帧传输时间 + t3.5（帧切分）+ 应答延迟余量，向上取整到毫秒
+static uint16_t discovery_timeout_ms(const modbus_discovery_ctx_t *ctx, uint32_t turnaround_allow_us) {
+    uint32_t us = MODBUS_PROBE_RESPONSE_LEN * ctx->char_time_us + ctx->frame_gap_us + turnaround_allow_us;
+    return (uint16_t)((us + 999) / 1000);
+}
+
+// 首字节超时：应答延迟余量 + 2 个字符（快速路径按 2 字节一块上报）+ 1ms
+// 定时粒度余量。静默地址在此放弃，不必等满整帧 + t3.5
+static uint16_t discovery_first_byte_ms(const modbus_discovery_ctx_t *ctx, uint32_t turnaround_allow_us) {
+    uint32_t us = turnaround_allow_us + 2 * ctx->char_time_us + 1000;
+    return (uint16_t)((us + 999) / 1000);
+}
+
+// 第二遍的应答延迟余量：学习到的余量与固定上限取小，未发现任何设备时也不沿用初值
+static uint32_t discovery_second_pass_allow_us(const modbus_discovery_ctx_t *ctx) {
+    uint32_t allow_us = ctx->turnaround_allow_us;
+    if (allow_us > MODBUS_DISCOVERY_SECOND_PASS_TURNAROUND_MS * 1000) {
+        allow_us = MODBUS_DISCOVERY_SECOND_PASS_TURNAROUND_MS * 1000;
+    }
+    return allow_us;
+}
+
+// 用实测往返时间更新应答延迟余量：取最大实测值的 2 倍
+static uint32_t discovery_learn(modbus_discovery_ctx_t *ctx, uint32_t latency_us) {
+    uint32_t frame_us = (MODBUS_PROBE_REQUEST_LEN + MODBUS_PROBE_RESPONSE_LEN) * ctx->char_time_us + ctx->frame_gap_us;
+    uint32_t turnaround_us = latency_us > frame_us ? latency_us - frame_us : 0;
+
+    if (!ctx->learned || turnaround_us > ctx->turnaround_max_us) {
+        ctx->turnaround_max_us = turnaround_us;
+    }
+    ctx->learned = true;
+
+    uint32_t allow_us = ctx->turnaround_max_us * 2;
+    if (allow_us < MODBUS_DISCOVERY_TURNAROUND_MIN_MS * 1000) {
+        allow_us = MODBUS_DISCOVERY_TURNAROUND_MIN_MS * 1000;
+    } else if (allow_us > MODBUS_DISCOVERY_TURNAROUND_MAX_MS * 1000) {
+        allow_us = MODBUS_DISCOVERY_TURNAROUND_MAX_MS * 1000;
+    }
+    ctx->turnaround_allow_us = allow_us;
+    return turnaround_us;
+}
+
+// 探测单个地址；任何合法格式的应答（含异常应答）都说明设备在线
+static bool discovery_probe(modbus_discovery_ctx_t *ctx, uint8_t address, uint16_t timeout_ms,
+                            uint16_t first_byte_ms, modbus_result_t *result) {
+    modbus_request_t request = {
+        .slave = address,
+        .function = MODBUS_FC_READ_HOLDING_REGISTERS,
+        .address = ctx->config.probe_register,
+        .quantity = 1,
+        .timeout_ms = timeout_ms,
+        .first_byte_timeout_ms = first_byte_ms,
+        .retries = 0,
+        .retry_class = MODBUS_CLASS_DISCOVERY,
+    };
+    modbus_status_t status = modbus_master_execute(ctx->master, &request, result);
+    if (status != MODBUS_OK && status != MODBUS_ERR_EXCEPTION && status != MODBUS_ERR_INVALID_RESPONSE) {
+        return false;
+    }
+
+    modbus_device_info_t info = {
+        .address = address,
+        .latency_us = result->latency_us,
+        .turnaround_us = discovery_learn(ctx, result->latency_us),
+        .last_seen_us = esp_timer_get_time(),
+    };
+    registry_upsert(&info);
+    ESP_LOGI(TAG, "Found device 0x%02X, latency %lu us", address, info.latency_us);
+    return true;
+}
+
+static uint8_t discovery_probe_capabilities(modbus_discovery_ctx_t *ctx, uint8_t address, modbus_result_t *result) {
+    static const struct {
+        uint8_t function;
+        uint8_t cap;
+    } probes[] = {
+        {MODBUS_FC_READ_COILS, MODBUS_CAP_READ_COILS},
+        {MODBUS_FC_READ_DISCRETE_INPUTS, MODBUS_CAP_READ_DISCRETE_INPUTS},
+        {MODBUS_FC_READ_HOLDING_REGISTERS, MODBUS_CAP_READ_HOLDING_REGISTERS},
+        {MODBUS_FC_READ_INPUT_REGISTERS, MODBUS_CAP_READ_INPUT_REGISTERS},
+    };
+
+    uint8_t capabilities = 0;
+    for (size_t i = 0; i < sizeof(probes) / sizeof(probes[0]); i++) {
+        modbus_request_t request = {
+            .slave = address,
+            .function = probes[i].function,
+            .address = ctx->config.probe_register,
+            .quantity = 1,
+            .timeout_ms = discovery_timeout_ms(ctx, ctx->turnaround_allow_us),
+            .retries = 1,
+            .retry_class = MODBUS_CLASS_DISCOVERY,
+        };
+        modbus_status_t status = modbus_master_execute(ctx->master, &request, result);
+        if (status == MODBUS_OK ||
+            (status == MODBUS_ERR_EXCEPTION && result->exception_code != MODBUS_EXCEPTION_ILLEGAL_FUNCTION)) {
+            capabilities |= probes[i].cap;
+        }
+    }
+    return capabilities;
+}
+
+static void modbus_discovery_task(void *arg) {
+    modbus_discovery_ctx_t *ctx = (modbus_discovery_ctx_t *)arg;
+    const uint8_t first = ctx->config.first_address;
+    const uint8_t last = ctx->config.last_address;
+    int64_t start_us = esp_timer_get_time();
+    size_t found = 0;
+
+    // 结果放在堆上，避免占用任务栈
+    modbus_result_t *result = malloc(sizeof(modbus_result_t));
+    if (result == NULL) {
+        ESP_LOGE(TAG, "Failed to allocate result buffer");
+        goto done;
+    }
+
+    // 第一遍：全地址扫描，超时随实测应答延迟收紧
+    memset(ctx->silent, 0, sizeof(ctx->silent));
+    for (unsigned addr = first; addr <= last; addr++) {
+        if (discovery_probe(ctx, (uint8_t)addr, discovery_timeout_ms(ctx, ctx->turnaround_allow_us),
+                            discovery_first_byte_ms(ctx, ctx->turnaround_allow_us), result)) {
+            found++;
+        } else {
+            ctx->silent[addr / 8] |= (uint8_t)(1u << (addr % 8));
+        }
+    }
+
+    // 第二遍：静默地址按更短的超时补扫，捕获受干扰丢失的应答
+    if (ctx->config.second_pass) {
+        uint32_t allow_us = discovery_second_pass_allow_us(ctx);
+        uint16_t timeout_ms = discovery_timeout_ms(ctx, allow_us);
+        uint16_t first_byte_ms = discovery_first_byte_ms(ctx, allow_us);
+        ESP_LOGI(TAG, "Second pass over silent addresses, timeout %u ms, first byte %u ms", timeout_ms,
+                 first_byte_ms);
+        for (unsigned addr = first; addr <= last; addr++) {
+            bool silent = ctx->silent[addr / 8] & (1u << (addr % 8));
+            if (silent && discovery_probe(ctx, (uint8_t)addr, timeout_ms, first_byte_ms, result)) {
+                found++;
+            }
+        }
+    }
+
+    if (ctx->config.probe_capabilities) {
+        modbus_device_info_t devices[MODBUS_DISCOVERY_MAX_DEVICES];
+        size_t count = modbus_discovery_get_devices(devices, MODBUS_DISCOVERY_MAX_DEVICES);
+        for (size_t i = 0; i < count; i++) {
+            if (devices[i].address >= first && devices[i].address <= last) {
+                registry_set_capabilities(devices[i].address,
+                                          discovery_probe_capabilities(ctx, devices[i].address, result));
+            }
+        }
+    }
+    free(result);
+
+    ESP_LOGI(TAG, "Scan 0x%02X-0x%02X done in %lld ms: %u device(s), turnaround allowance %lu us", first, last,
+             (esp_timer_get_time() - start_us) / 1000, (unsigned)found, ctx->turnaround_allow_us);
+
+done:
+    if (ctx->done_cb != NULL) {
+        ctx->done_cb(s_registry_count, ctx->user_ctx);
+    }
+    s_running = false;
+    vTaskDelete(NULL);
+}
+
+bool modbus_discovery_start(modbus_master_t *master, const modbus_discovery_config_t *config,
+                            modbus_discovery_done_cb_t done_cb, void *user_ctx) {
+    if (master == NULL || s_running) {
+        return false;
+    }
+
+    modbus_discovery_ctx_t *ctx = &s_ctx;
+    memset(ctx, 0, sizeof(*ctx));
+    if (!rs485_bus_get_timing(modbus_master_get_bus(master), &ctx->char_time_us, &ctx->frame_gap_us)) {
+        return false;
+    }
+    if (config != NULL) {
+        ctx->config = *config;
+    } else {
+        ctx->config.second_pass = true;
+        ctx->config.probe_capabilities = true;
+    }
+    if (ctx->config.first_address < MODBUS_DISCOVERY_FIRST_ADDR) {
+        ctx->config.first_address = MODBUS_DISCOVERY_FIRST_ADDR;
+    }
+    if (ctx->config.last_address == 0 || ctx->config.last_address > MODBUS_DISCOVERY_LAST_ADDR) {
+        ctx->config.last_address = MODBUS_DISCOVERY_LAST_ADDR;
+    }
+    if (ctx->config.first_address > ctx->config.last_address) {
+        return false;
+    }
+    uint16_t turnaround_ms = ctx->config.initial_turnaround_ms ? ctx->config.initial_turnaround_ms
+                                                               : MODBUS_DISCOVERY_TURNAROUND_DEFAULT_MS;
+    ctx->turnaround_allow_us = (uint32_t)turnaround_ms * 1000;
+    ctx->master = master;
+    ctx->done_cb = done_cb;
+    ctx->user_ctx = user_ctx;
+
+    // 重新扫描时清空登记表，已下线的设备不会留在表里
+    portENTER_CRITICAL(&s_registry_lock);
+    s_registry_count = 0;
+    portEXIT_CRITICAL(&s_registry_lock);
+
+    s_running = true;
+    if (xTaskCreate(modbus_discovery_task, "modbus_disc", MODBUS_DISCOVERY_TASK_STACK_SIZE, ctx,
+                    MODBUS_DISCOVERY_TASK_PRIORITY, NULL) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create discovery task");
+        s_running = false;
+        return false;
+    }
+    return true;
+}
+
+bool modbus_discovery_is_running(void) {
+    return s_running;
+}
+
+size_t modbus_discovery_get_devices(modbus_device_info_t *devices, size_t max_devices) {
+    portENTER_CRITICAL(&s_registry_lock);
+    size_t count = s_registry_count < max_devices ? s_registry_count : max_devices;
+    memcpy(devices, s_registry, count * sizeof(modbus_device_info_t));
+    portEXIT_CRITICAL(&s_registry_lock);
+    return count;
+}
+
+bool modbus_discovery_find(uint8_t address, modbus_device_info_t *info) {
+    bool found = false;
+    portENTER_CRITICAL(&s_registry_lock);
+    for (size_t i = 0; i < s_registry_count; i++) {
+        if (s_registry[i].address == address) {
+            *info = s_registry[i];
+            found = true;
+            break;
+        }
+    }
+    portEXIT_CRITICAL(&s_registry_lock);
+    return found;
+}
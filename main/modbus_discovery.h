@@ -0,0 +1,98 @@
+#ifndef MODBUS_DISCOVERY_H
+#define MODBUS_DISCOVERY_H
+
+#include "modbus_master.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// 合法从站地址范围
+#define MODBUS_DISCOVERY_FIRST_ADDR 1
+#define MODBUS_DISCOVERY_LAST_ADDR 247
+
+// 设备登记表容量
+#define MODBUS_DISCOVERY_MAX_DEVICES 32
+
+// 设备能力（按功能码探测，从站未返回“非法功能码”即视为支持）
+typedef enum {
+  MODBUS_CAP_READ_COILS = 1 << 0,             // FC01
+  MODBUS_CAP_READ_DISCRETE_INPUTS = 1 << 1,   // FC02
+  MODBUS_CAP_READ_HOLDING_REGISTERS = 1 << 2, // FC03
+  MODBUS_CAP_READ_INPUT_REGISTERS = 1 << 3,   // FC04
+} modbus_device_cap_t;
+
+// 登记表中的设备
+typedef struct {
+  uint8_t address;
+  uint8_t capabilities;   // modbus_device_cap_t 组合
+  uint32_t latency_us;    // 探测事务往返时间
+  uint32_t turnaround_us; // 估算的从站应答延迟（扣除收发帧时间）
+  int64_t last_seen_us;
+} modbus_device_info_t;
+
+// 扫描参数
+typedef struct {
+  uint8_t first_address;          // 起始地址，0 使用 MODBUS_DISCOVERY_FIRST_ADDR
+  uint8_t last_address;           // 结束地址，0 使用 MODBUS_DISCOVERY_LAST_ADDR
+  uint16_t probe_register;        // 探测读取的保持寄存器地址
+  uint16_t initial_turnaround_ms; // 首个设备发现前的应答延迟余量，0 用默认值
+  bool second_pass;               // 对静默地址以更短的超时再扫一遍
+  bool probe_capabilities;        // 对发现的设备逐个探测功能码
+} modbus_discovery_config_t;
+
+/**
+ * @brief 扫描完成回调，在扫描任务上下文中调用
+ * @param device_count 登记表中的设备数
+ * @param user_ctx 用户参数
+ */
+typedef void (*modbus_discovery_done_cb_t)(size_t device_count, void *user_ctx);
+
+/**
+ * @brief 在后台启动地址扫描（不阻塞）
+ *
+ * 每个地址的超时 = 应答帧传输时间 + t3.5 + 应答延迟余量；应答帧一经
+ * t3.5 切分即结束等待。静默地址只等首字节：发送完成后应答延迟余量
+ * 加 2 个字符内没有收到任何字节即放弃。应答延迟余量从已发现设备的
+ * 实测值自适应收紧。每次扫描开始时清空登记表。扫描任务优先级低于
+ * LVGL，不影响界面刷新。
+ *
+ * @param master 主站句柄
+ * @param config 扫描参数，NULL 使用默认值
+ * @param done_cb 完成回调，可为 NULL
+ * @param user_ctx 用户参数
+ * @return true 已启动, false 参数错误或已有扫描在进行
+ */
+bool modbus_discovery_start(modbus_master_t *master,
+                            const modbus_discovery_config_t *config,
+                            modbus_discovery_done_cb_t done_cb,
+                            void *user_ctx);
+
+/**
+ * @brief 是否有扫描在进行
+ */
+bool modbus_discovery_is_running(void);
+
+/**
+ * @brief 复制设备登记表
+ * @param devices 输出数组
+ * @param max_devices 数组容量
+ * @return 复制的设备数
+ */
+size_t modbus_discovery_get_devices(modbus_device_info_t *devices,
+                                    size_t max_devices);
+
+/**
+ * @brief 按地址查找已登记的设备
+ * @return true 找到, false 未登记
+ */
+bool modbus_discovery_find(uint8_t address, modbus_device_info_t *info);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // MODBUS_DISCOVERY_H
@@ -0,0 +1,133 @@
+#include "modbus_gateway.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "rs485_breaker.h"
+
+static const char *TAG = "MODBUS_GW";
+
+// 网关任务：与缓存刷新同级，总线上的先后由优先级通道决定
+#define MODBUS_GATEWAY_TASK_STACK_SIZE 4096
+#define MODBUS_GATEWAY_TASK_PRIORITY 7
+
+// 无网络事件时 select 的最长等待
+#define MODBUS_GATEWAY_POLL_MS 100
+
+typedef struct {
+    rs485_bus_t *bus;
+    modbus_tcp_t *tcp;
+    uint32_t report_ms;
+    portMUX_TYPE lock;
+    modbus_tcp_stats_t snapshot; // 供其他任务读取
+    bool running;
+} modbus_gateway_t;
+
+static modbus_gateway_t s_gateway = {
+    .lock = portMUX_INITIALIZER_UNLOCKED,
+};
+
+static int64_t modbus_gateway_now_us(void) {
+    return esp_timer_get_time();
+}
+
+static int modbus_gateway_transact(void *ctx, const uint8_t *request, size_t request_len, uint8_t *response,
+                                   size_t response_size, uint32_t timeout_ms) {
+    rs485_bus_t *bus = (rs485_bus_t *)ctx;
+    uart_port_t uart_num = rs485_bus_get_uart(bus);
+    const uint8_t slave = request[0];
+    const bool read = request[1] >= 0x01 && request[1] <= 0x04;
+
+    // 离线塔灯不占用总线，SCADA 立即收到 0x0B
+    if (!rs485_breaker_admit(uart_num, slave, NULL)) {
+        return 0;
+    }
+    int n = rs485_bus_transact_lane(bus, read ? RS485_LANE_POLL : RS485_LANE_COMMAND, request, request_len, response,
+                                    response_size, timeout_ms, NULL);
+    // 已放行的请求必须回报结果，否则半开探测永远等不到结论；出错按无应答计
+    rs485_breaker_report(uart_num, slave, n > 0);
+    return n;
+}
+
+static void modbus_gateway_report(const modbus_tcp_stats_t *prev, const modbus_tcp_stats_t *cur, uint32_t elapsed_ms) {
+    uint32_t requests = cur->requests - prev->requests;
+    uint32_t hits = cur->cache_hits - prev->cache_hits;
+    uint32_t rate_x10 = elapsed_ms > 0 ? (uint32_t)((uint64_t)requests * 10000 / elapsed_ms) : 0;
+    uint32_t busy = elapsed_ms > 0 ? (uint32_t)((cur->bus_us - prev->bus_us) / 10 / elapsed_ms) : 0;
+    ESP_LOGI(TAG, "%lu.%lu req/s (%lu cached), bus busy %lu%%, %u clients, %lu timeouts, %lu errors",
+             (unsigned long)(rate_x10 / 10), (unsigned long)(rate_x10 % 10), (unsigned long)hits, (unsigned long)busy,
+             cur->clients, (unsigned long)(cur->timeouts - prev->timeouts),
+             (unsigned long)(cur->errors - prev->errors));
+}
+
+static void modbus_gateway_task(void *arg) {
+    modbus_gateway_t *gw = (modbus_gateway_t *)arg;
+    modbus_tcp_stats_t reported = {0};
+    int64_t reported_us = esp_timer_get_time();
+
+    while (1) {
+        if (modbus_tcp_poll(gw->tcp, MODBUS_GATEWAY_POLL_MS) < 0) {
+            ESP_LOGE(TAG, "Listen socket failed");
+            vTaskDelay(pdMS_TO_TICKS(1000));
+        }
+
+        modbus_tcp_stats_t stats;
+        modbus_tcp_get_stats(gw->tcp, &stats);
+        portENTER_CRITICAL(&gw->lock);
+        gw->snapshot = stats;
+        portEXIT_CRITICAL(&gw->lock);
+
+        int64_t now_us = esp_timer_get_time();
+        if (gw->report_ms > 0 && now_us - reported_us >= (int64_t)gw->report_ms * 1000) {
+            modbus_gateway_report(&reported, &stats, (uint32_t)((now_us - reported_us) / 1000));
+            reported = stats;
+            reported_us = now_us;
+        }
+    }
+}
+
+bool modbus_gateway_start(rs485_bus_t *bus, const modbus_gateway_config_t *config) {
+    modbus_gateway_t *gw = &s_gateway;
+    if (bus == NULL || config == NULL || gw->running) {
+        return false;
+    }
+
+    modbus_tcp_config_t tcp_config = {
+        .port = config->port,
+        .cache_ttl_ms = config->cache_ttl_ms,
+        .timeout_ms = config->timeout_ms > 0 ? config->timeout_ms : 100,
+        .transact = modbus_gateway_transact,
+        .transact_ctx = bus,
+        .now_us = modbus_gateway_now_us,
+    };
+    gw->tcp = modbus_tcp_create(&tcp_config);
+    if (gw->tcp == NULL) {
+        ESP_LOGE(TAG, "Failed to listen on port %u", config->port ? config->port : MODBUS_TCP_DEFAULT_PORT);
+        return false;
+    }
+    gw->bus = bus;
+    gw->report_ms = config->report_ms;
+
+    if (xTaskCreate(modbus_gateway_task, "modbus_gw", MODBUS_GATEWAY_TASK_STACK_SIZE, gw,
+                    MODBUS_GATEWAY_TASK_PRIORITY, NULL) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create gateway task");
+        modbus_tcp_destroy(gw->tcp);
+        gw->tcp = NULL;
+        return false;
+    }
+    gw->running = true;
+    ESP_LOGI(TAG, "Modbus TCP gateway on port %u, cache %lu ms", config->port ? config->port : MODBUS_TCP_DEFAULT_PORT,
+             (unsigned long)config->cache_ttl_ms);
+    return true;
+}
+
+bool modbus_gateway_get_stats(modbus_tcp_stats_t *stats) {
+    modbus_gateway_t *gw = &s_gateway;
+    if (!gw->running) {
+        return false;
+    }
+    portENTER_CRITICAL(&gw->lock);
+    *stats = gw->snapshot;
+    portEXIT_CRITICAL(&gw->lock);
+    return true;
+}
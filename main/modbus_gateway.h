@@ -0,0 +1,44 @@
+#ifndef MODBUS_GATEWAY_H
+#define MODBUS_GATEWAY_H
+
+#include "modbus_tcp.h"
+#include "rs485_comm.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// 网关配置
+typedef struct {
+  uint16_t port;         // 监听端口，0 使用 502
+  uint32_t cache_ttl_ms; // 读应答缓存有效期，0 不缓存
+  uint32_t timeout_ms;   // 从站应答超时，0 使用 100ms
+  uint32_t report_ms;    // 吞吐量日志周期，0 不打印
+} modbus_gateway_config_t;
+
+/**
+ * @brief 启动 Modbus TCP → RTU 网关（须在网络就绪后调用）
+ *
+ * 读请求走轮询通道，写请求走操作员命令通道，报警命令始终优先；
+ * 从站断路器断开时直接回异常 0x0B，不占用总线。
+ *
+ * @param bus 塔灯所在总线
+ * @param config 配置
+ * @return true 成功, false 监听或任务创建失败
+ */
+bool modbus_gateway_start(rs485_bus_t *bus,
+                          const modbus_gateway_config_t *config);
+
+/**
+ * @brief 读取网关统计
+ * @return false 网关未启动
+ */
+bool modbus_gateway_get_stats(modbus_tcp_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // MODBUS_GATEWAY_H
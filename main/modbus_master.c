@@ -0,0 +1,557 @@
+#include "modbus_master.h"
+#include "rs485_breaker.h"
+#include "rs485_crc.h"
+#include "rs485_devstats.h"
+#include "esp_log.h"
+#include "esp_random.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include <stdlib.h>
+#include <string.h>
+
+static const char *TAG = "MODBUS";
+
+// 主站任务：低于 RS485 TX 任务，高于 LVGL
+#define MODBUS_MASTER_QUEUE_LEN 16
+#define MODBUS_MASTER_TASK_STACK_SIZE 4096
+#define MODBUS_MASTER_TASK_PRIORITY 9
+
+typedef struct {
+    modbus_request_t request;
+    modbus_done_cb_t done_cb;
+    void *user_ctx;
+    bool stop; // 销毁请求：主站任务确认后不再处理任何任务
+} modbus_job_t;
+
+struct modbus_master {
+    rs485_bus_t *bus;
+    QueueHandle_t queue;
+    TaskHandle_t task;
+    SemaphoreHandle_t exited; // 主站任务的退出确认
+    portMUX_TYPE stats_lock;
+    modbus_master_stats_t stats;
+    modbus_retry_policy_t policies[MODBUS_CLASS_COUNT]; // 在 stats_lock 下读写
+    modbus_result_t task_result; // 仅主站任务使用，避免大结构体占用任务栈
+};
+
+static inline void put_u16(uint8_t *p, uint16_t v) {
+    p[0] = (uint8_t)(v >> 8);
+    p[1] = (uint8_t)(v & 0xFF);
+}
+
+static inline uint16_t get_u16(const uint8_t *p) {
+    return (uint16_t)((p[0] << 8) | p[1]);
+}
+
+static bool modbus_is_write(uint8_t function) {
+    return function == MODBUS_FC_WRITE_SINGLE_COIL || function == MODBUS_FC_WRITE_SINGLE_REGISTER ||
+           function == MODBUS_FC_WRITE_MULTIPLE_COILS || function == MODBUS_FC_WRITE_MULTIPLE_REGISTERS;
+}
+
+size_t modbus_master_encode(const modbus_request_t *request, uint8_t *frame) {
+    const uint16_t qty = request->quantity;
+    size_t len = 0;
+
+    frame[len++] = request->slave;
+    frame[len++] = request->function;
+    put_u16(&frame[len], request->address);
+    len += 2;
+
+    switch (request->function) {
+    case MODBUS_FC_READ_COILS:
+    case MODBUS_FC_READ_DISCRETE_INPUTS:
+        if (qty == 0 || qty > MODBUS_MAX_READ_BITS) {
+            return 0;
+        }
+        put_u16(&frame[len], qty);
+        len += 2;
+        break;
+    case MODBUS_FC_READ_HOLDING_REGISTERS:
+    case MODBUS_FC_READ_INPUT_REGISTERS:
+        if (qty == 0 || qty > MODBUS_MAX_READ_REGISTERS) {
+            return 0;
+        }
+        put_u16(&frame[len], qty);
+        len += 2;
+        break;
+    case MODBUS_FC_WRITE_SINGLE_COIL:
+        if (request->values == NULL) {
+            return 0;
+        }
+        put_u16(&frame[len], (((const uint8_t *)request->values)[0] & 0x01) ? 0xFF00 : 0x0000);
+        len += 2;
+        break;
+    case MODBUS_FC_WRITE_SINGLE_REGISTER:
+        if (request->values == NULL) {
+            return 0;
+        }
+        put_u16(&frame[len], ((const uint16_t *)request->values)[0]);
+        len += 2;
+        break;
+    case MODBUS_FC_WRITE_MULTIPLE_COILS: {
+        if (request->values == NULL || qty == 0 || qty > MODBUS_MAX_WRITE_BITS) {
+            return 0;
+        }
+        uint8_t byte_count = (uint8_t)((qty + 7) / 8);
+        put_u16(&frame[len], qty);
+        len += 2;
+        frame[len++] = byte_count;
+        memcpy(&frame[len], request->values, byte_count);
+        len += byte_count;
+        break;
+    }
+    case MODBUS_FC_WRITE_MULTIPLE_REGISTERS: {
+        if (request->values == NULL || qty == 0 || qty > MODBUS_MAX_WRITE_REGISTERS) {
+            return 0;
+        }
+        const uint16_t *regs = (const uint16_t *)request->values;
+        put_u16(&frame[len], qty);
+        len += 2;
+        frame[len++] = (uint8_t)(qty * 2);
+        for (uint16_t i = 0; i < qty; i++) {
+            put_u16(&frame[len], regs[i]);
+            len += 2;
+        }
+        break;
+    }
+    default:
+        return 0;
+    }
+
+    uint16_t crc = rs485_crc16_update(RS485_CRC16_INIT, frame, len);
+    frame[len++] = (uint8_t)(crc & 0xFF); // CRC低字节
+    frame[len++] = (uint8_t)(crc >> 8);   // CRC高字节
+    return len;
+}
+
+modbus_status_t modbus_master_decode(const modbus_request_t *request, const uint8_t *frame, size_t length,
+                                     modbus_result_t *result) {
+    // 最短帧：地址 + 功能码 + 异常码 + CRC
+    if (length < 5 || frame[0] != request->slave) {
+        return MODBUS_ERR_INVALID_RESPONSE;
+    }
+    if (frame[1] == (request->function | 0x80)) {
+        result->exception_code = frame[2];
+        return MODBUS_ERR_EXCEPTION;
+    }
+    if (frame[1] != request->function) {
+        return MODBUS_ERR_INVALID_RESPONSE;
+    }
+
+    switch (request->function) {
+    case MODBUS_FC_READ_COILS:
+    case MODBUS_FC_READ_DISCRETE_INPUTS: {
+        uint8_t byte_count = frame[2];
+        if (byte_count != (request->quantity + 7) / 8 || length < 3u + byte_count + 2u) {
+            return MODBUS_ERR_INVALID_RESPONSE;
+        }
+        memcpy(result->bits, &frame[3], byte_count);
+        break;
+    }
+    case MODBUS_FC_READ_HOLDING_REGISTERS:
+    case MODBUS_FC_READ_INPUT_REGISTERS: {
+        uint8_t byte_count = frame[2];
+        if (byte_count != request->quantity * 2 || length < 3u + byte_count + 2u) {
+            return MODBUS_ERR_INVALID_RESPONSE;
+        }
+        for (uint16_t i = 0; i < request->quantity; i++) {
+            result->registers[i] = get_u16(&frame[3 + i * 2]);
+        }
+        break;
+    }
+    case MODBUS_FC_WRITE_SINGLE_COIL:
+    case MODBUS_FC_WRITE_SINGLE_REGISTER: {
+        // 应答为请求回显
+        uint8_t expected[8];
+        modbus_master_encode(request, expected);
+        if (length < 8 || memcmp(frame, expected, 6) != 0) {
+            return MODBUS_ERR_INVALID_RESPONSE;
+        }
+        break;
+    }
+    case MODBUS_FC_WRITE_MULTIPLE_COILS:
+    case MODBUS_FC_WRITE_MULTIPLE_REGISTERS:
+        if (length < 8 || get_u16(&frame[2]) != request->address || get_u16(&frame[4]) != request->quantity) {
+            return MODBUS_ERR_INVALID_RESPONSE;
+        }
+        break;
+    default:
+        return MODBUS_ERR_INVALID_RESPONSE;
+    }
+    return MODBUS_OK;
+}
+
+// 正常应答的帧长：读功能码随数量变化，写功能码固定 8 字节
+static size_t modbus_response_len(const modbus_request_t *request) {
+    switch (request->function) {
+    case MODBUS_FC_READ_COILS:
+    case MODBUS_FC_READ_DISCRETE_INPUTS:
+        return 5u + (request->quantity + 7u) / 8u;
+    case MODBUS_FC_READ_HOLDING_REGISTERS:
+    case MODBUS_FC_READ_INPUT_REGISTERS:
+        return 5u + request->quantity * 2u;
+    default:
+        return 8;
+    }
+}
+
+// 默认超时从发送完成算起，须覆盖整帧应答：帧在最后一个字节之后再静默
+// 一个 RX 超时（t3.5 向上取整到字符）才发布，另加应答延迟余量
+static uint32_t modbus_default_timeout_ms(const modbus_master_t *master, const modbus_request_t *request) {
+    uint32_t char_time_us = 0;
+    uint32_t frame_gap_us = 0;
+    rs485_bus_get_timing(master->bus, &char_time_us, &frame_gap_us);
+    uint32_t us = (uint32_t)modbus_response_len(request) * char_time_us + frame_gap_us + char_time_us +
+                  MODBUS_DEFAULT_TIMEOUT_MS * 1000;
+    return (us + 999) / 1000;
+}
+
+static void modbus_stats_add(modbus_master_t *master, modbus_status_t status, uint32_t busy_us) {
+    portENTER_CRITICAL(&master->stats_lock);
+    master->stats.attempts++;
+    master->stats.busy_us += busy_us;
+    switch (status) {
+    case MODBUS_ERR_TIMEOUT:
+        master->stats.timeouts++;
+        break;
+    case MODBUS_ERR_CRC:
+        master->stats.crc_errors++;
+        break;
+    case MODBUS_ERR_INVALID_RESPONSE:
+        master->stats.invalid_responses++;
+        break;
+    case MODBUS_ERR_EXCEPTION:
+        master->stats.exceptions++;
+        break;
+    default:
+        break;
+    }
+    portEXIT_CRITICAL(&master->stats_lock);
+}
+
+// 单次尝试：发送请求并解析应答
+static modbus_status_t modbus_attempt(modbus_master_t *master, const modbus_request_t *request,
+                                      const uint8_t *tx_frame, size_t tx_len, modbus_result_t *result) {
+    bool broadcast = request->slave == MODBUS_BROADCAST_ADDR;
+    uint32_t timeout_ms = 0;
+    if (!broadcast) {
+        timeout_ms = request->timeout_ms ? request->timeout_ms : modbus_default_timeout_ms(master, request);
+    }
+
+    // 轮询与扫描走最低优先级通道，报警与操作员命令可在事务间插队
+    rs485_lane_t lane = request->retry_class == MODBUS_CLASS_POLL || request->retry_class == MODBUS_CLASS_DISCOVERY
+                            ? RS485_LANE_POLL
+                            : RS485_LANE_COMMAND;
+    // 应答直接在总线接收区中解析，解析完才归还帧并释放总线；
+    // 占用时间从获得总线算起，不含在通道上排队的时间
+    rs485_frame_t frame;
+    int64_t now_us = esp_timer_get_time();
+    rs485_transact_timing_t timing = {.granted_us = now_us, .tx_start_us = now_us};
+    int ret = rs485_bus_transact_acquire(master->bus, lane, tx_frame, tx_len, &frame, timeout_ms,
+                                         request->first_byte_timeout_ms, &timing);
+    int64_t granted_us = timing.granted_us;
+    result->latency_us = (uint32_t)(esp_timer_get_time() - granted_us);
+
+    modbus_status_t status;
+    if (ret < 0) {
+        status = MODBUS_ERR_BUS;
+    } else if (broadcast) {
+        status = MODBUS_OK;
+    } else if (ret == 0) {
+        status = MODBUS_ERR_TIMEOUT;
+    } else {
+        status = frame.status != RS485_FRAME_OK ? MODBUS_ERR_CRC
+                                                : modbus_master_decode(request, frame.data, frame.length, result);
+        rs485_bus_transact_release(master->bus, &frame);
+    }
+    uint32_t elapsed_us = (uint32_t)(esp_timer_get_time() - granted_us);
+
+    modbus_stats_add(master, status, elapsed_us);
+    return status;
+}
+
+// 第 attempt 次重试前的等待：指数退避加随机抖动
+static uint32_t modbus_backoff_ms(const modbus_retry_policy_t *policy, uint8_t attempt) {
+    if (policy->backoff_ms == 0) {
+        return 0;
+    }
+    uint8_t shift = attempt > 1 ? (uint8_t)(attempt - 1) : 0;
+    uint32_t delay = (uint32_t)policy->backoff_ms << (shift < 16 ? shift : 16);
+    if (policy->backoff_max_ms != 0 && delay > policy->backoff_max_ms) {
+        delay = policy->backoff_max_ms;
+    }
+    uint32_t span = delay * (policy->jitter_percent > 100 ? 100 : policy->jitter_percent) / 100;
+    if (span > 0) {
+        delay = delay - span + esp_random() % (2 * span + 1);
+    }
+    return delay;
+}
+
+modbus_status_t modbus_master_execute(modbus_master_t *master, const modbus_request_t *request,
+                                      modbus_result_t *result) {
+    result->slave = request->slave;
+    result->function = request->function;
+    result->address = request->address;
+    result->quantity = request->quantity;
+    result->exception_code = 0;
+    result->attempts = 0;
+    result->latency_us = 0;
+
+    uint8_t tx_frame[RS485_FRAME_MAX_LEN];
+    size_t tx_len = 0;
+    if (master == NULL ||
+        (request->slave == MODBUS_BROADCAST_ADDR && !modbus_is_write(request->function)) ||
+        (tx_len = modbus_master_encode(request, tx_frame)) == 0) {
+        result->status = MODBUS_ERR_INVALID_ARG;
+        return result->status;
+    }
+
+    modbus_retry_policy_t policy;
+    portENTER_CRITICAL(&master->stats_lock);
+    policy = master->policies[request->retry_class < MODBUS_CLASS_COUNT ? request->retry_class : MODBUS_CLASS_DEFAULT];
+    portEXIT_CRITICAL(&master->stats_lock);
+    uint8_t retries = request->retries ? request->retries : policy.retries;
+
+    uart_port_t uart_num = rs485_bus_get_uart(master->bus);
+    bool probe = false;
+    if (policy.use_breaker && !rs485_breaker_admit(uart_num, request->slave, &probe)) {
+        portENTER_CRITICAL(&master->stats_lock);
+        master->stats.rejected++;
+        portEXIT_CRITICAL(&master->stats_lock);
+        result->status = MODBUS_ERR_CIRCUIT_OPEN;
+        return result->status;
+    }
+    if (probe) {
+        retries = 0; // 探测只确认设备是否回来，失败就继续断开
+    }
+
+    modbus_status_t status;
+    do {
+        if (result->attempts > 0) {
+            rs485_devstats_record_retry(uart_num, request->slave);
+            uint32_t delay_ms = modbus_backoff_ms(&policy, result->attempts);
+            if (delay_ms > 0) {
+                vTaskDelay(pdMS_TO_TICKS(delay_ms));
+            }
+        }
+        result->attempts++;
+        status = modbus_attempt(master, request, tx_frame, tx_len, result);
+        // 异常应答是从站的明确答复，重试无意义
+    } while (status != MODBUS_OK && status != MODBUS_ERR_EXCEPTION && result->attempts <= retries);
+
+    // 扫描中的无应答不计入断路器，但扫到设备可使其恢复闭合
+    bool responded = status != MODBUS_ERR_TIMEOUT && status != MODBUS_ERR_BUS;
+    if (policy.use_breaker || responded) {
+        rs485_breaker_report(uart_num, request->slave, responded);
+    }
+
+    portENTER_CRITICAL(&master->stats_lock);
+    master->stats.transactions++;
+    portEXIT_CRITICAL(&master->stats_lock);
+
+    result->status = status;
+    return status;
+}
+
+// 主站任务：按提交顺序背靠背执行，总线间隔只受 t3.5 约束
+static void modbus_master_task(void *arg) {
+    modbus_master_t *master = (modbus_master_t *)arg;
+    modbus_job_t job;
+
+    while (1) {
+        if (xQueueReceive(master->queue, &job, portMAX_DELAY) != pdTRUE) {
+            continue;
+        }
+        if (job.stop) {
+            break;
+        }
+        modbus_master_execute(master, &job.request, &master->task_result);
+        if (job.done_cb != NULL) {
+            job.done_cb(&master->task_result, job.user_ctx);
+        }
+    }
+
+    // 此时不在事务中、未持有总线通道：确认后等待被删除
+    xSemaphoreGive(master->exited);
+    vTaskSuspend(NULL);
+}
+
+modbus_master_t *modbus_master_create(rs485_bus_t *bus) {
+    if (bus == NULL) {
+        return NULL;
+    }
+
+    modbus_master_t *master = calloc(1, sizeof(modbus_master_t));
+    if (master == NULL) {
+        ESP_LOGE(TAG, "Failed to allocate master");
+        return NULL;
+    }
+    master->bus = bus;
+    portMUX_TYPE lock = portMUX_INITIALIZER_UNLOCKED;
+    master->stats_lock = lock;
+    master->stats.since_us = esp_timer_get_time();
+    for (int i = 0; i < MODBUS_CLASS_COUNT; i++) {
+        master->policies[i].use_breaker = i != MODBUS_CLASS_DISCOVERY;
+    }
+
+    master->queue = xQueueCreate(MODBUS_MASTER_QUEUE_LEN, sizeof(modbus_job_t));
+    master->exited = xSemaphoreCreateBinary();
+    if (master->queue == NULL || master->exited == NULL) {
+        ESP_LOGE(TAG, "Failed to create master queue");
+        if (master->queue != NULL) {
+            vQueueDelete(master->queue);
+        }
+        if (master->exited != NULL) {
+            vSemaphoreDelete(master->exited);
+        }
+        free(master);
+        return NULL;
+    }
+    if (xTaskCreate(modbus_master_task, "modbus_master", MODBUS_MASTER_TASK_STACK_SIZE, master,
+                    MODBUS_MASTER_TASK_PRIORITY, &master->task) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create master task");
+        vQueueDelete(master->queue);
+        vSemaphoreDelete(master->exited);
+        free(master);
+        return NULL;
+    }
+    return master;
+}
+
+void modbus_master_destroy(modbus_master_t *master) {
+    if (master == NULL) {
+        return;
+    }
+    // 停止请求插到队首，其后排队的任务被丢弃；等主站任务做完手头的
+    // 事务、确认退出后才删除，不会在它持有总线通道时将其删除
+    modbus_job_t stop = {.stop = true};
+    xQueueSendToFront(master->queue, &stop, portMAX_DELAY);
+    xSemaphoreTake(master->exited, portMAX_DELAY);
+    vTaskDelete(master->task);
+    vQueueDelete(master->queue);
+    vSemaphoreDelete(master->exited);
+    free(master);
+}
+
+bool modbus_master_set_retry_policy(modbus_master_t *master, modbus_class_t retry_class,
+                                    const modbus_retry_policy_t *policy) {
+    if (master == NULL || policy == NULL || retry_class >= MODBUS_CLASS_COUNT) {
+        return false;
+    }
+    portENTER_CRITICAL(&master->stats_lock);
+    master->policies[retry_class] = *policy;
+    portEXIT_CRITICAL(&master->stats_lock);
+    return true;
+}
+
+rs485_bus_t *modbus_master_get_bus(const modbus_master_t *master) {
+    return master != NULL ? master->bus : NULL;
+}
+
+modbus_status_t modbus_master_submit(modbus_master_t *master, const modbus_request_t *request,
+                                     modbus_done_cb_t done_cb, void *user_ctx) {
+    if (master == NULL || request == NULL) {
+        return MODBUS_ERR_INVALID_ARG;
+    }
+    modbus_job_t job = {
+        .request = *request,
+        .done_cb = done_cb,
+        .user_ctx = user_ctx,
+    };
+    if (xQueueSend(master->queue, &job, 0) != pdTRUE) {
+        return MODBUS_ERR_QUEUE_FULL;
+    }
+    return MODBUS_OK;
+}
+
+void modbus_master_get_stats(const modbus_master_t *master, modbus_master_stats_t *stats) {
+    portENTER_CRITICAL((portMUX_TYPE *)&master->stats_lock);
+    *stats = master->stats;
+    portEXIT_CRITICAL((portMUX_TYPE *)&master->stats_lock);
+}
+
+uint32_t modbus_master_utilization_permille(const modbus_master_t *master) {
+    modbus_master_stats_t stats;
+    modbus_master_get_stats(master, &stats);
+    int64_t elapsed_us = esp_timer_get_time() - stats.since_us;
+    if (elapsed_us <= 0) {
+        return 0;
+    }
+    return (uint32_t)(stats.busy_us * 1000 / (uint64_t)elapsed_us);
+}
+
+// 常用功能码的同步便捷接口
+
+static modbus_status_t modbus_read(modbus_master_t *master, uint8_t slave, uint8_t function, uint16_t address,
+                                   uint16_t quantity, void *out, size_t out_size) {
+    modbus_request_t request = {
+        .slave = slave,
+        .function = function,
+        .address = address,
+        .quantity = quantity,
+    };
+    modbus_result_t result;
+    modbus_status_t status = modbus_master_execute(master, &request, &result);
+    if (status == MODBUS_OK) {
+        memcpy(out, result.bits, out_size);
+    }
+    return status;
+}
+
+static modbus_status_t modbus_write(modbus_master_t *master, uint8_t slave, uint8_t function, uint16_t address,
+                                    uint16_t quantity, const void *values) {
+    modbus_request_t request = {
+        .slave = slave,
+        .function = function,
+        .address = address,
+        .quantity = quantity,
+        .values = values,
+    };
+    modbus_result_t result;
+    return modbus_master_execute(master, &request, &result);
+}
+
+modbus_status_t modbus_read_coils(modbus_master_t *master, uint8_t slave, uint16_t address, uint16_t quantity,
+                                  uint8_t *bits) {
+    return modbus_read(master, slave, MODBUS_FC_READ_COILS, address, quantity, bits, (quantity + 7) / 8);
+}
+
+modbus_status_t modbus_read_discrete_inputs(modbus_master_t *master, uint8_t slave, uint16_t address,
+                                            uint16_t quantity, uint8_t *bits) {
+    return modbus_read(master, slave, MODBUS_FC_READ_DISCRETE_INPUTS, address, quantity, bits, (quantity + 7) / 8);
+}
+
+modbus_status_t modbus_read_holding_registers(modbus_master_t *master, uint8_t slave, uint16_t address,
+                                              uint16_t quantity, uint16_t *registers) {
+    return modbus_read(master, slave, MODBUS_FC_READ_HOLDING_REGISTERS, address, quantity, registers,
+                       quantity * sizeof(uint16_t));
+}
+
+modbus_status_t modbus_read_input_registers(modbus_master_t *master, uint8_t slave, uint16_t address,
+                                            uint16_t quantity, uint16_t *registers) {
+    return modbus_read(master, slave, MODBUS_FC_READ_INPUT_REGISTERS, address, quantity, registers,
+                       quantity * sizeof(uint16_t));
+}
+
+modbus_status_t modbus_write_single_coil(modbus_master_t *master, uint8_t slave, uint16_t address, bool on) {
+    uint8_t bit = on ? 1 : 0;
+    return modbus_write(master, slave, MODBUS_FC_WRITE_SINGLE_COIL, address, 1, &bit);
+}
+
+modbus_status_t modbus_write_single_register(modbus_master_t *master, uint8_t slave, uint16_t address,
+                                             uint16_t value) {
+    return modbus_write(master, slave, MODBUS_FC_WRITE_SINGLE_REGISTER, address, 1, &value);
+}
+
+modbus_status_t modbus_write_multiple_coils(modbus_master_t *master, uint8_t slave, uint16_t address,
+                                            uint16_t quantity, const uint8_t *bits) {
+    return modbus_write(master, slave, MODBUS_FC_WRITE_MULTIPLE_COILS, address, quantity, bits);
+}
+
+modbus_status_t modbus_write_multiple_registers(modbus_master_t *master, uint8_t slave, uint16_t address,
+                                                uint16_t quantity, const uint16_t *registers) {
+    return modbus_write(master, slave, MODBUS_FC_WRITE_MULTIPLE_REGISTERS, address, quantity, registers);
+}
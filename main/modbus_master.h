@@ -0,0 +1,242 @@
+#ifndef MODBUS_MASTER_H
+#define MODBUS_MASTER_H
+
+#include "rs485_comm.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Modbus RTU 功能码
+typedef enum {
+  MODBUS_FC_READ_COILS = 0x01,               // 读线圈
+  MODBUS_FC_READ_DISCRETE_INPUTS = 0x02,     // 读离散输入
+  MODBUS_FC_READ_HOLDING_REGISTERS = 0x03,   // 读保持寄存器
+  MODBUS_FC_READ_INPUT_REGISTERS = 0x04,     // 读输入寄存器
+  MODBUS_FC_WRITE_SINGLE_COIL = 0x05,        // 写单个线圈
+  MODBUS_FC_WRITE_SINGLE_REGISTER = 0x06,    // 写单个寄存器
+  MODBUS_FC_WRITE_MULTIPLE_COILS = 0x0F,     // 写多个线圈
+  MODBUS_FC_WRITE_MULTIPLE_REGISTERS = 0x10, // 写多个寄存器
+} modbus_fc_t;
+
+// 事务结果状态
+typedef enum {
+  MODBUS_OK = 0,
+  MODBUS_ERR_INVALID_ARG,      // 请求参数非法
+  MODBUS_ERR_BUS,              // 发送失败
+  MODBUS_ERR_TIMEOUT,          // 应答超时
+  MODBUS_ERR_CRC,              // 应答 CRC 错误
+  MODBUS_ERR_INVALID_RESPONSE, // 应答地址/功能码/长度不符
+  MODBUS_ERR_EXCEPTION,        // 从站返回异常码
+  MODBUS_ERR_QUEUE_FULL,       // 异步队列已满
+  MODBUS_ERR_CIRCUIT_OPEN,     // 从站断路器断开，未发送
+} modbus_status_t;
+
+// 事务类别，各类别有独立的重试策略
+typedef enum {
+  MODBUS_CLASS_DEFAULT = 0, // 未指定
+  MODBUS_CLASS_COMMAND,     // 操作员命令：值得多等几次
+  MODBUS_CLASS_POLL,        // 周期轮询：下一轮自然重读，不必重试
+  MODBUS_CLASS_DISCOVERY,   // 地址扫描：不经断路器，以免漏掉刚接回的设备
+  MODBUS_CLASS_COUNT,
+} modbus_class_t;
+
+// 重试策略：第 n 次重试前等待 min(backoff_ms << (n-1), backoff_max_ms)，
+// 再叠加 ±jitter_percent% 的随机抖动，避免多个主站同步重试
+typedef struct {
+  uint8_t retries;         // 请求中 retries 为 0 时使用的重试次数
+  uint8_t jitter_percent;  // 抖动幅度（0-100）
+  uint16_t backoff_ms;     // 首次重试前的等待，0 表示立即重试
+  uint16_t backoff_max_ms; // 等待上限
+  bool use_breaker;        // 是否经从站断路器（见 rs485_breaker.h）
+} modbus_retry_policy_t;
+
+// 协议上限
+#define MODBUS_BROADCAST_ADDR 0x00
+#define MODBUS_MAX_READ_REGISTERS 125
+#define MODBUS_MAX_WRITE_REGISTERS 123
+#define MODBUS_MAX_READ_BITS 2000
+#define MODBUS_MAX_WRITE_BITS 1968
+
+// 默认应答延迟余量（毫秒）。请求中超时填 0 时，超时按应答长度推算：
+// 应答帧传输时间 + RX 超时（t3.5）+ 本余量，9600 波特下读 125 个寄存器约 370ms
+#define MODBUS_DEFAULT_TIMEOUT_MS 100
+
+// 一次事务请求
+typedef struct {
+  uint8_t slave;     // 从站地址，0 为广播（仅写功能码，不等待应答）
+  uint8_t function;  // modbus_fc_t
+  uint16_t address;  // 起始地址
+  uint16_t quantity; // 数量（单写功能码忽略）
+  // 写入数据：FC06/FC10 为寄存器值；FC05/FC0F 为按位打包的线圈（LSB 在前）
+  // 异步提交时须保持有效直到完成回调
+  const void *values;
+  uint16_t timeout_ms; // 应答超时（自发送完成起），0 按应答长度推算
+  uint16_t first_byte_timeout_ms; // 首字节超时（自发送完成起），0 表示不单独检测
+  uint8_t retries;     // 超时/CRC/应答错误时的重试次数，0 使用类别策略
+  uint8_t retry_class; // modbus_class_t，决定退避与是否经断路器
+} modbus_request_t;
+
+// 解析后的应答
+typedef struct {
+  modbus_status_t status;
+  uint8_t exception_code; // status 为 MODBUS_ERR_EXCEPTION 时有效
+  uint8_t slave;
+  uint8_t function;
+  uint16_t address;
+  uint16_t quantity;
+  uint8_t attempts;    // 实际发送次数
+  uint32_t latency_us; // 最后一次尝试从获得总线到收到应答的时间
+  union {
+    uint16_t registers[MODBUS_MAX_READ_REGISTERS]; // FC03/FC04
+    uint8_t bits[(MODBUS_MAX_READ_BITS + 7) / 8];  // FC01/FC02，LSB 在前
+  };
+} modbus_result_t;
+
+// 主站统计
+typedef struct {
+  uint32_t transactions; // 完成的事务数
+  uint32_t attempts;     // 总发送次数（含重试）
+  uint32_t timeouts;
+  uint32_t crc_errors;
+  uint32_t invalid_responses;
+  uint32_t exceptions;
+  uint32_t rejected; // 因断路器断开未发送的事务
+  uint64_t busy_us;  // 事务持有总线的累计时间（自获得总线起，不含排队）
+  int64_t since_us;  // 统计起点
+} modbus_master_stats_t;
+
+typedef struct modbus_master modbus_master_t;
+
+/**
+ * @brief 异步事务完成回调，在主站任务上下文中调用
+ * @param result 事务结果，仅在回调期间有效
+ * @param user_ctx 提交时传入的用户参数
+ */
+typedef void (*modbus_done_cb_t)(const modbus_result_t *result, void *user_ctx);
+
+/**
+ * @brief 在总线上创建 Modbus RTU 主站
+ *
+ * 主站任务按提交顺序背靠背发送请求：上一应答结束后只等 t3.5
+ * 便发出下一请求，使总线保持忙碌。
+ *
+ * @param bus 已打开的 RS485 总线
+ * @return 主站句柄，失败返回 NULL
+ */
+modbus_master_t *modbus_master_create(rs485_bus_t *bus);
+
+/**
+ * @brief 销毁主站（未完成的异步请求被丢弃）
+ */
+void modbus_master_destroy(modbus_master_t *master);
+
+/**
+ * @brief 获取主站所在总线
+ */
+rs485_bus_t *modbus_master_get_bus(const modbus_master_t *master);
+
+/**
+ * @brief 设置某一事务类别的重试策略
+ *
+ * 默认策略均不重试、不等待，且除 MODBUS_CLASS_DISCOVERY 外都经断路器。
+ * 退避等待期间不占用总线，其他任务的事务可以插入。
+ *
+ * @return false 类别非法
+ */
+bool modbus_master_set_retry_policy(modbus_master_t *master,
+                                    modbus_class_t retry_class,
+                                    const modbus_retry_policy_t *policy);
+
+/**
+ * @brief 同步执行一次事务（含重试）
+ *
+ * 从站断路器断开时立即返回 MODBUS_ERR_CIRCUIT_OPEN，不占用总线；
+ * 到达探测时间的事务作为探测只发送一次，不重试。
+ * @param master 主站句柄
+ * @param request 请求
+ * @param result 输出结果
+ * @return 结果状态，与 result->status 相同
+ */
+modbus_status_t modbus_master_execute(modbus_master_t *master,
+                                      const modbus_request_t *request,
+                                      modbus_result_t *result);
+
+/**
+ * @brief 异步提交事务（不阻塞）
+ * @return MODBUS_OK 已入队, MODBUS_ERR_QUEUE_FULL 队列已满
+ */
+modbus_status_t modbus_master_submit(modbus_master_t *master,
+                                     const modbus_request_t *request,
+                                     modbus_done_cb_t done_cb, void *user_ctx);
+
+/**
+ * @brief 编码请求帧（地址 + PDU + CRC）
+ * @param request 请求
+ * @param frame 输出缓冲区，至少 RS485_FRAME_MAX_LEN 字节
+ * @return 帧长度，参数非法时返回 0
+ */
+size_t modbus_master_encode(const modbus_request_t *request, uint8_t *frame);
+
+/**
+ * @brief 解析应答帧（已通过 CRC 校验）
+ * @param request 对应的请求
+ * @param frame 应答帧
+ * @param length 应答帧长度
+ * @param result 输出结果
+ * @return 结果状态
+ */
+modbus_status_t modbus_master_decode(const modbus_request_t *request,
+                                     const uint8_t *frame, size_t length,
+                                     modbus_result_t *result);
+
+/**
+ * @brief 读取主站统计
+ */
+void modbus_master_get_stats(const modbus_master_t *master,
+                             modbus_master_stats_t *stats);
+
+/**
+ * @brief 总线利用率（千分比），自统计起点起事务占用时间的比例
+ */
+uint32_t modbus_master_utilization_permille(const modbus_master_t *master);
+
+// 常用功能码的同步便捷接口
+
+modbus_status_t modbus_read_coils(modbus_master_t *master, uint8_t slave,
+                                  uint16_t address, uint16_t quantity,
+                                  uint8_t *bits);
+modbus_status_t modbus_read_discrete_inputs(modbus_master_t *master,
+                                            uint8_t slave, uint16_t address,
+                                            uint16_t quantity, uint8_t *bits);
+modbus_status_t modbus_read_holding_registers(modbus_master_t *master,
+                                              uint8_t slave, uint16_t address,
+                                              uint16_t quantity,
+                                              uint16_t *registers);
+modbus_status_t modbus_read_input_registers(modbus_master_t *master,
+                                            uint8_t slave, uint16_t address,
+                                            uint16_t quantity,
+                                            uint16_t *registers);
+modbus_status_t modbus_write_single_coil(modbus_master_t *master,
+                                         uint8_t slave, uint16_t address,
+                                         bool on);
+modbus_status_t modbus_write_single_register(modbus_master_t *master,
+                                             uint8_t slave, uint16_t address,
+                                             uint16_t value);
+modbus_status_t modbus_write_multiple_coils(modbus_master_t *master,
+                                            uint8_t slave, uint16_t address,
+                                            uint16_t quantity,
+                                            const uint8_t *bits);
+modbus_status_t modbus_write_multiple_registers(modbus_master_t *master,
+                                                uint8_t slave,
+                                                uint16_t address,
+                                                uint16_t quantity,
+                                                const uint16_t *registers);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // MODBUS_MASTER_H
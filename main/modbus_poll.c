@@ -0,0 +1,255 @@
+#include "modbus_poll.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include <stdlib.h>
+#include <string.h>
+
+static const char *TAG = "MODBUS_POLL";
+
+// 轮询任务：低于主站任务与灯光协调任务，高于 LVGL
+#define MODBUS_POLL_TASK_STACK_SIZE 4096
+#define MODBUS_POLL_TASK_PRIORITY 7
+
+// FC03 请求帧长度（地址 + 功能码 + 起始 + 数量 + CRC）
+#define MODBUS_POLL_REQUEST_LEN 8
+
+struct modbus_poll {
+    modbus_master_t *master;
+    TaskHandle_t task;
+    size_t count;
+    modbus_poll_item_t items[MODBUS_POLL_MAX_ITEMS];
+    int64_t next_release_us[MODBUS_POLL_MAX_ITEMS];
+    uint8_t fail_streak[MODBUS_POLL_MAX_ITEMS];
+    portMUX_TYPE stats_lock;
+    modbus_poll_stats_t stats[MODBUS_POLL_MAX_ITEMS];
+    modbus_result_t result; // 仅轮询任务使用
+};
+
+// a 是否比 b 优先：先比优先级类别，再比周期（单调速率），最后按登记顺序
+static bool modbus_poll_higher(const modbus_poll_item_t *items, size_t a, size_t b) {
+    if (items[a].priority != items[b].priority) {
+        return items[a].priority < items[b].priority;
+    }
+    if (items[a].period_ms != items[b].period_ms) {
+        return items[a].period_ms < items[b].period_ms;
+    }
+    return a < b;
+}
+
+static uint32_t modbus_poll_response_len(const modbus_poll_item_t *item) {
+    switch (item->function) {
+    case MODBUS_FC_READ_COILS:
+    case MODBUS_FC_READ_DISCRETE_INPUTS:
+        return 5 + (item->quantity + 7) / 8;
+    default:
+        return 5 + item->quantity * 2;
+    }
+}
+
+uint32_t modbus_poll_cost_us(const modbus_poll_item_t *item, const modbus_poll_timing_t *timing) {
+    uint32_t bytes = MODBUS_POLL_REQUEST_LEN + modbus_poll_response_len(item);
+    return bytes * timing->char_time_us + timing->turnaround_us + 2 * timing->frame_gap_us;
+}
+
+uint32_t modbus_poll_utilization_permille(const modbus_poll_item_t *items, size_t count,
+                                          const modbus_poll_timing_t *timing) {
+    uint64_t permille = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (items[i].period_ms > 0) {
+            permille += (uint64_t)modbus_poll_cost_us(&items[i], timing) / items[i].period_ms;
+        }
+    }
+    return (uint32_t)permille;
+}
+
+bool modbus_poll_schedulable(const modbus_poll_item_t *items, size_t count, const modbus_poll_timing_t *timing,
+                             uint32_t *response_us) {
+    bool ok = true;
+    for (size_t i = 0; i < count; i++) {
+        uint64_t cost = modbus_poll_cost_us(&items[i], timing);
+        uint64_t deadline = (uint64_t)items[i].period_ms * 1000;
+
+        // 总线不可抢占：低优先级项一旦开始发送，最多阻塞一个事务
+        uint64_t blocking = 0;
+        for (size_t j = 0; j < count; j++) {
+            if (j != i && modbus_poll_higher(items, i, j)) {
+                uint64_t c = modbus_poll_cost_us(&items[j], timing);
+                blocking = c > blocking ? c : blocking;
+            }
+        }
+
+        // 开始前的排队时间 w = B + Σ(floor(w/Tj) + 1)·Cj，迭代到不动点
+        uint64_t w = blocking;
+        uint64_t prev;
+        do {
+            prev = w;
+            w = blocking;
+            for (size_t j = 0; j < count; j++) {
+                if (j != i && modbus_poll_higher(items, j, i) && items[j].period_ms > 0) {
+                    uint64_t period = (uint64_t)items[j].period_ms * 1000;
+                    w += (prev / period + 1) * modbus_poll_cost_us(&items[j], timing);
+                }
+            }
+        } while (w != prev && w + cost <= deadline);
+
+        uint64_t response = w + cost;
+        if (response_us != NULL) {
+            response_us[i] = response > UINT32_MAX ? UINT32_MAX : (uint32_t)response;
+        }
+        if (response > deadline) {
+            ok = false;
+        }
+    }
+    return ok;
+}
+
+modbus_poll_t *modbus_poll_create(modbus_master_t *master) {
+    if (master == NULL) {
+        return NULL;
+    }
+    modbus_poll_t *poll = calloc(1, sizeof(modbus_poll_t));
+    if (poll == NULL) {
+        ESP_LOGE(TAG, "Failed to allocate poll scheduler");
+        return NULL;
+    }
+    poll->master = master;
+    portMUX_TYPE lock = portMUX_INITIALIZER_UNLOCKED;
+    poll->stats_lock = lock;
+    return poll;
+}
+
+int modbus_poll_add(modbus_poll_t *poll, const modbus_poll_item_t *item) {
+    if (poll == NULL || item == NULL || poll->task != NULL || poll->count >= MODBUS_POLL_MAX_ITEMS ||
+        item->period_ms == 0 || item->function < MODBUS_FC_READ_COILS ||
+        item->function > MODBUS_FC_READ_INPUT_REGISTERS) {
+        return -1;
+    }
+    int id = (int)poll->count++;
+    poll->items[id] = *item;
+    return id;
+}
+
+// 同一从站的所有轮询项共享在线状态与退避
+static void modbus_poll_update_slave(modbus_poll_t *poll, uint8_t slave, bool success) {
+    portENTER_CRITICAL(&poll->stats_lock);
+    for (size_t i = 0; i < poll->count; i++) {
+        if (poll->items[i].slave != slave) {
+            continue;
+        }
+        modbus_poll_stats_t *st = &poll->stats[i];
+        if (success) {
+            poll->fail_streak[i] = 0;
+            st->offline = false;
+            st->backoff_shift = 0;
+        } else if (++poll->fail_streak[i] >= MODBUS_POLL_OFFLINE_THRESHOLD) {
+            st->offline = true;
+            if (st->backoff_shift < MODBUS_POLL_MAX_BACKOFF_SHIFT) {
+                st->backoff_shift++;
+            }
+        }
+    }
+    portEXIT_CRITICAL(&poll->stats_lock);
+}
+
+static void modbus_poll_run(modbus_poll_t *poll, size_t id, int64_t now) {
+    const modbus_poll_item_t *item = &poll->items[id];
+    modbus_poll_stats_t *st = &poll->stats[id];
+    int64_t release = poll->next_release_us[id];
+    uint32_t jitter_us = (uint32_t)(now - release);
+
+    modbus_request_t request = {
+        .slave = item->slave,
+        .function = item->function,
+        .address = item->address,
+        .quantity = item->quantity,
+        .timeout_ms = item->timeout_ms,
+        .retry_class = MODBUS_CLASS_POLL,
+    };
+    modbus_status_t status = modbus_master_execute(poll->master, &request, &poll->result);
+    int64_t done = esp_timer_get_time();
+
+    // 异常应答说明设备在线，只是拒绝了请求
+    modbus_poll_update_slave(poll, item->slave, status == MODBUS_OK || status == MODBUS_ERR_EXCEPTION);
+
+    portENTER_CRITICAL(&poll->stats_lock);
+    int64_t period_us = ((int64_t)item->period_ms * 1000) << st->backoff_shift;
+    st->polls++;
+    if (status != MODBUS_OK) {
+        st->failures++;
+    }
+    st->last_jitter_us = jitter_us;
+    st->sum_jitter_us += jitter_us;
+    if (jitter_us > st->max_jitter_us) {
+        st->max_jitter_us = jitter_us;
+    }
+    // 固定释放网格，跳过已错过的释放时刻（每个计一次错过）
+    int64_t next = release + period_us;
+    while (next <= done) {
+        next += period_us;
+        st->deadline_misses++;
+    }
+    poll->next_release_us[id] = next;
+    portEXIT_CRITICAL(&poll->stats_lock);
+
+    if (item->cb != NULL) {
+        item->cb((int)id, &poll->result, item->user_ctx);
+    }
+}
+
+static void modbus_poll_task(void *arg) {
+    modbus_poll_t *poll = (modbus_poll_t *)arg;
+
+    while (1) {
+        int64_t now = esp_timer_get_time();
+        int best = -1;
+        int64_t earliest = INT64_MAX;
+        for (size_t i = 0; i < poll->count; i++) {
+            if (poll->next_release_us[i] <= now) {
+                if (best < 0 || modbus_poll_higher(poll->items, i, (size_t)best)) {
+                    best = (int)i;
+                }
+            } else if (poll->next_release_us[i] < earliest) {
+                earliest = poll->next_release_us[i];
+            }
+        }
+
+        if (best >= 0) {
+            modbus_poll_run(poll, (size_t)best, now);
+        } else {
+            // 睡到最早的释放时刻（向上取整到 tick）
+            TickType_t ticks = pdMS_TO_TICKS((uint32_t)((earliest - now + 999) / 1000));
+            vTaskDelay(ticks > 0 ? ticks : 1);
+        }
+    }
+}
+
+bool modbus_poll_start(modbus_poll_t *poll) {
+    if (poll == NULL || poll->task != NULL || poll->count == 0) {
+        return false;
+    }
+
+    // 所有项同时首次释放，由优先级决定初始顺序
+    int64_t now = esp_timer_get_time();
+    for (size_t i = 0; i < poll->count; i++) {
+        poll->next_release_us[i] = now;
+    }
+    if (xTaskCreate(modbus_poll_task, "modbus_poll", MODBUS_POLL_TASK_STACK_SIZE, poll, MODBUS_POLL_TASK_PRIORITY,
+                    &poll->task) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create poll task");
+        poll->task = NULL;
+        return false;
+    }
+    return true;
+}
+
+bool modbus_poll_get_stats(modbus_poll_t *poll, int id, modbus_poll_stats_t *stats) {
+    if (poll == NULL || id < 0 || (size_t)id >= poll->count || stats == NULL) {
+        return false;
+    }
+    portENTER_CRITICAL(&poll->stats_lock);
+    *stats = poll->stats[id];
+    portEXIT_CRITICAL(&poll->stats_lock);
+    return true;
+}
@@ -0,0 +1,125 @@
+#ifndef MODBUS_POLL_H
+#define MODBUS_POLL_H
+
+#include "modbus_master.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// 轮询表容量
+#define MODBUS_POLL_MAX_ITEMS 32
+
+// 连续失败多少次判定设备离线
+#define MODBUS_POLL_OFFLINE_THRESHOLD 3
+
+// 离线退避：每次失败周期翻倍，最多放大到 2^MODBUS_POLL_MAX_BACKOFF_SHIFT 倍
+#define MODBUS_POLL_MAX_BACKOFF_SHIFT 6
+
+/**
+ * @brief 轮询完成回调，在轮询任务上下文中调用
+ * @param id modbus_poll_add() 返回的轮询项编号
+ * @param result 事务结果，仅在回调期间有效
+ * @param user_ctx 用户参数
+ */
+typedef void (*modbus_poll_cb_t)(int id, const modbus_result_t *result,
+                                 void *user_ctx);
+
+// 轮询项：周期性读取一段寄存器/位
+typedef struct {
+  uint8_t slave;
+  uint8_t function;    // FC01/02/03/04
+  uint16_t address;
+  uint16_t quantity;
+  uint32_t period_ms;  // 周期，同时也是截止期限
+  uint8_t priority;    // 优先级类别，0 最高；同类内周期短者优先（单调速率）
+  uint16_t timeout_ms; // 应答超时，0 按应答长度推算（见 modbus_request_t）
+  modbus_poll_cb_t cb;
+  void *user_ctx;
+} modbus_poll_item_t;
+
+// 单个轮询项的运行统计
+typedef struct {
+  uint32_t polls;           // 已执行次数
+  uint32_t failures;        // 失败次数
+  uint32_t deadline_misses; // 超过截止期限完成或被跳过的周期数
+  uint32_t last_jitter_us;  // 最近一次启动时刻相对释放时刻的延迟
+  uint32_t max_jitter_us;
+  uint64_t sum_jitter_us;
+  uint8_t backoff_shift;    // 当前退避倍数的对数，0 表示在线
+  bool offline;
+} modbus_poll_stats_t;
+
+// 总线时序参数（离线可调度性分析用）
+typedef struct {
+  uint32_t char_time_us;  // 单字符时间
+  uint32_t frame_gap_us;  // t3.5
+  uint32_t turnaround_us; // 从站应答延迟上界
+} modbus_poll_timing_t;
+
+typedef struct modbus_poll modbus_poll_t;
+
+/**
+ * @brief 创建轮询调度器（尚未启动）
+ */
+modbus_poll_t *modbus_poll_create(modbus_master_t *master);
+
+/**
+ * @brief 登记轮询项，须在 modbus_poll_start() 之前调用
+ * @return 轮询项编号，失败返回 -1
+ */
+int modbus_poll_add(modbus_poll_t *poll, const modbus_poll_item_t *item);
+
+/**
+ * @brief 启动轮询任务
+ *
+ * 每个轮询项在固定的释放时刻（首次释放 + k·周期）就绪；任务总是执行
+ * 就绪项中优先级最高者，同样的轮询表总得到同样的发送顺序。
+ *
+ * @return true 成功, false 失败
+ */
+bool modbus_poll_start(modbus_poll_t *poll);
+
+/**
+ * @brief 读取轮询项统计
+ */
+bool modbus_poll_get_stats(modbus_poll_t *poll, int id,
+                           modbus_poll_stats_t *stats);
+
+/*
+ * 以下为纯计算接口，不访问总线，可离线评估一张轮询表
+ */
+
+/**
+ * @brief 单次轮询占用总线的最坏时间（请求 + 应答延迟 + 应答 + 两个 t3.5）
+ */
+uint32_t modbus_poll_cost_us(const modbus_poll_item_t *item,
+                             const modbus_poll_timing_t *timing);
+
+/**
+ * @brief 轮询表的总线利用率（千分比）
+ */
+uint32_t modbus_poll_utilization_permille(const modbus_poll_item_t *items,
+                                          size_t count,
+                                          const modbus_poll_timing_t *timing);
+
+/**
+ * @brief 非抢占响应时间分析：判断每项是否都能在周期内完成
+ * @param items 轮询表
+ * @param count 项数
+ * @param timing 总线时序
+ * @param response_us 输出每项的最坏响应时间，可为 NULL
+ * @return true 可调度, false 至少一项可能错过截止期限
+ */
+bool modbus_poll_schedulable(const modbus_poll_item_t *items, size_t count,
+                             const modbus_poll_timing_t *timing,
+                             uint32_t *response_us);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // MODBUS_POLL_H
@@ -0,0 +1,162 @@
+#include "modbus_regmap.h"
+#include "esp_log.h"
+
+static const char *TAG = "MODBUS_REGMAP";
+
+uint16_t modbus_regmap_width(const modbus_reg_def_t *def) {
+    return def->type == MODBUS_REG_U16 || def->type == MODBUS_REG_S16 ? 1 : 2;
+}
+
+static uint32_t modbus_regmap_read_cost_us(uint8_t function, uint16_t quantity, const modbus_poll_timing_t *timing) {
+    modbus_poll_item_t item = {
+        .function = function,
+        .quantity = quantity,
+    };
+    return modbus_poll_cost_us(&item, timing);
+}
+
+uint16_t modbus_regmap_break_even_gap(const modbus_poll_timing_t *timing) {
+    if (timing == NULL || timing->char_time_us == 0) {
+        return 0;
+    }
+    // 单独一帧除数据外的开销，折算成可多读的寄存器数（每个 2 字符）
+    uint32_t overhead = modbus_regmap_read_cost_us(MODBUS_FC_READ_HOLDING_REGISTERS, 1, timing) -
+                        2 * timing->char_time_us;
+    uint32_t gap = overhead / (2 * timing->char_time_us);
+    return gap > MODBUS_MAX_READ_REGISTERS ? MODBUS_MAX_READ_REGISTERS : (uint16_t)gap;
+}
+
+static bool modbus_regmap_def_ok(const modbus_reg_def_t *def) {
+    if (def->function != MODBUS_FC_READ_HOLDING_REGISTERS && def->function != MODBUS_FC_READ_INPUT_REGISTERS) {
+        return false;
+    }
+    if (def->type > MODBUS_REG_F32) {
+        return false;
+    }
+    return (uint32_t)def->address + modbus_regmap_width(def) <= 0x10000;
+}
+
+bool modbus_regmap_plan(const modbus_regmap_t *map, uint16_t max_gap, const modbus_poll_timing_t *timing,
+                        modbus_regmap_plan_t *plan) {
+    if (map == NULL || plan == NULL || map->count == 0 || map->count > MODBUS_REGMAP_MAX_REGS) {
+        return false;
+    }
+    memset(plan, 0, sizeof(*plan));
+    plan->map = map;
+
+    // 按（功能码, 地址）插入排序
+    uint8_t order[MODBUS_REGMAP_MAX_REGS];
+    for (size_t i = 0; i < map->count; i++) {
+        const modbus_reg_def_t *def = &map->regs[i];
+        if (!modbus_regmap_def_ok(def)) {
+            ESP_LOGE(TAG, "%s: invalid register %s", map->name, def->name);
+            return false;
+        }
+        uint32_t key = ((uint32_t)def->function << 16) | def->address;
+        size_t j = i;
+        while (j > 0) {
+            const modbus_reg_def_t *prev = &map->regs[order[j - 1]];
+            if ((((uint32_t)prev->function << 16) | prev->address) <= key) {
+                break;
+            }
+            order[j] = order[j - 1];
+            j--;
+        }
+        order[j] = (uint8_t)i;
+    }
+
+    uint16_t covered = 0; // 定义实际覆盖的寄存器数
+    for (size_t k = 0; k < map->count; k++) {
+        const modbus_reg_def_t *def = &map->regs[order[k]];
+        uint16_t width = modbus_regmap_width(def);
+        uint32_t start = def->address;
+        uint32_t end = start + width - 1;
+
+        if (timing != NULL) {
+            plan->naive_us += modbus_regmap_read_cost_us(def->function, width, timing);
+        }
+
+        if (plan->read_count > 0) {
+            modbus_regmap_read_t *cur = &plan->reads[plan->read_count - 1];
+            uint32_t cur_end = (uint32_t)cur->address + cur->quantity - 1;
+            uint32_t new_end = end > cur_end ? end : cur_end;
+            if (def->function == cur->function && start <= cur_end + 1 + max_gap &&
+                new_end - cur->address + 1 <= MODBUS_MAX_READ_REGISTERS) {
+                if (start > cur_end) {
+                    covered += width;
+                } else if (end > cur_end) {
+                    covered += (uint16_t)(end - cur_end); // 与前一定义重叠
+                }
+                cur->quantity = (uint16_t)(new_end - cur->address + 1);
+                continue;
+            }
+        }
+
+        modbus_regmap_read_t *read = &plan->reads[plan->read_count++];
+        read->function = def->function;
+        read->address = def->address;
+        read->quantity = width;
+        covered += width;
+    }
+
+    for (uint16_t i = 0; i < plan->read_count; i++) {
+        plan->registers += plan->reads[i].quantity;
+        if (timing != NULL) {
+            plan->planned_us += modbus_regmap_read_cost_us(plan->reads[i].function, plan->reads[i].quantity, timing);
+        }
+    }
+    plan->gap_registers = plan->registers - covered;
+    plan->frames_saved = (uint16_t)(map->count - plan->read_count);
+
+    ESP_LOGI(TAG, "%s: %u registers in %u reads (%u saved, %u gap registers), est. %lu us -> %lu us", map->name,
+             (unsigned)map->count, plan->read_count, plan->frames_saved, plan->gap_registers,
+             (unsigned long)plan->naive_us, (unsigned long)plan->planned_us);
+    return true;
+}
+
+void modbus_regmap_store(const modbus_regmap_plan_t *plan, const modbus_result_t *result,
+                         modbus_regmap_values_t *values) {
+    if (result->status != MODBUS_OK) {
+        return;
+    }
+    const modbus_regmap_t *map = plan->map;
+    uint32_t first = result->address;
+    uint32_t last = first + result->quantity; // 不含
+
+    for (size_t i = 0; i < map->count; i++) {
+        const modbus_reg_def_t *def = &map->regs[i];
+        uint16_t width = modbus_regmap_width(def);
+        if (def->function != result->function || def->address < first || def->address + width > last) {
+            continue;
+        }
+        for (uint16_t w = 0; w < width; w++) {
+            values->raw[i][w] = result->registers[def->address - first + w];
+        }
+        values->valid |= 1u << i;
+    }
+}
+
+modbus_status_t modbus_regmap_read(modbus_master_t *master, uint8_t slave, const modbus_regmap_plan_t *plan,
+                                   modbus_regmap_values_t *values) {
+    modbus_status_t last_error = MODBUS_OK;
+    modbus_result_t result;
+
+    values->valid = 0;
+    for (uint16_t i = 0; i < plan->read_count; i++) {
+        const modbus_regmap_read_t *read = &plan->reads[i];
+        modbus_request_t request = {
+            .slave = slave,
+            .function = read->function,
+            .address = read->address,
+            .quantity = read->quantity,
+            .retry_class = MODBUS_CLASS_POLL,
+        };
+        modbus_status_t status = modbus_master_execute(master, &request, &result);
+        if (status == MODBUS_OK) {
+            modbus_regmap_store(plan, &result, values);
+        } else {
+            last_error = status;
+        }
+    }
+    return last_error;
+}
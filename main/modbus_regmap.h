@@ -0,0 +1,204 @@
+#ifndef MODBUS_REGMAP_H
+#define MODBUS_REGMAP_H
+
+#include "modbus_master.h"
+#include "modbus_poll.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// 一张寄存器表最多描述的寄存器数
+#define MODBUS_REGMAP_MAX_REGS 32
+
+// 寄存器值类型；32 位值占两个连续寄存器，高字在前
+typedef enum {
+  MODBUS_REG_U16 = 0,
+  MODBUS_REG_S16,
+  MODBUS_REG_U32,
+  MODBUS_REG_S32,
+  MODBUS_REG_F32,
+} modbus_reg_type_t;
+
+// 寄存器定义
+typedef struct {
+  const char *name;
+  uint8_t function; // FC03 或 FC04
+  uint16_t address;
+  uint8_t type;     // modbus_reg_type_t
+} modbus_reg_def_t;
+
+// 一种设备的寄存器表
+typedef struct {
+  const char *name;
+  const modbus_reg_def_t *regs;
+  size_t count;
+} modbus_regmap_t;
+
+// 按寄存器表读到的值，下标与表中定义一致
+typedef struct {
+  uint16_t raw[MODBUS_REGMAP_MAX_REGS][2];
+  uint32_t valid; // 第 i 位表示第 i 个寄存器已读到
+} modbus_regmap_values_t;
+
+// 合并后的一次读取
+typedef struct {
+  uint8_t function;
+  uint16_t address;
+  uint16_t quantity;
+} modbus_regmap_read_t;
+
+// 读取计划
+typedef struct {
+  const modbus_regmap_t *map;
+  modbus_regmap_read_t reads[MODBUS_REGMAP_MAX_REGS];
+  uint16_t read_count;
+  uint16_t registers;     // 实际读取的寄存器数（含间隙）
+  uint16_t gap_registers; // 为合并而多读的未定义寄存器
+  uint16_t frames_saved;  // 相对逐个定义读取节省的帧数
+  uint32_t naive_us;      // 逐个读取一轮的总线时间估算（未给时序时为 0）
+  uint32_t planned_us;    // 按计划读取一轮的总线时间估算
+} modbus_regmap_plan_t;
+
+/*
+ * 声明式寄存器表：用一个列表宏描述设备类型，再由 MODBUS_REGMAP_DEFINE
+ * 展开成下标枚举、寄存器表与带类型的读取函数。列表宏形如
+ *
+ *   #define METER_REGMAP(X, p)                          \
+ *     X(p, voltage, 0x04, 0x0000, u16)                  \
+ *     X(p, energy, 0x04, 0x0002, u32)                   \
+ *     X(p, power, 0x04, 0x0004, f32)
+ *
+ * 在 .c 文件中 MODBUS_REGMAP_DEFINE(meter, METER_REGMAP) 得到
+ * meter_reg_voltage 等下标、meter_regmap 表和 float meter_get_power(values)。
+ * 类型取 u16/s16/u32/s32/f32。
+ */
+typedef uint16_t modbus_reg_u16_t;
+typedef int16_t modbus_reg_s16_t;
+typedef uint32_t modbus_reg_u32_t;
+typedef int32_t modbus_reg_s32_t;
+typedef float modbus_reg_f32_t;
+
+#define MODBUS_REG_TYPE_u16 MODBUS_REG_U16
+#define MODBUS_REG_TYPE_s16 MODBUS_REG_S16
+#define MODBUS_REG_TYPE_u32 MODBUS_REG_U32
+#define MODBUS_REG_TYPE_s32 MODBUS_REG_S32
+#define MODBUS_REG_TYPE_f32 MODBUS_REG_F32
+
+#define MODBUS_REGMAP_ENUM_(p, name, fc, addr, type) p##_reg_##name,
+#define MODBUS_REGMAP_DEF_(p, name, fc, addr, type)                           \
+  {#name, (fc), (addr), MODBUS_REG_TYPE_##type},
+#define MODBUS_REGMAP_GETTER_(p, name, fc, addr, type)                        \
+  static inline modbus_reg_##type##_t p##_get_##name(                         \
+      const modbus_regmap_values_t *values) {                                 \
+    return modbus_regmap_get_##type(values, p##_reg_##name);                  \
+  }
+
+#define MODBUS_REGMAP_DEFINE(p, LIST)                                         \
+  enum { LIST(MODBUS_REGMAP_ENUM_, p) p##_reg_count };                        \
+  static const modbus_reg_def_t p##_reg_defs[] = {                            \
+      LIST(MODBUS_REGMAP_DEF_, p)};                                           \
+  __attribute__((unused)) static const modbus_regmap_t p##_regmap = {         \
+      #p, p##_reg_defs, p##_reg_count};                                       \
+  LIST(MODBUS_REGMAP_GETTER_, p)
+
+/**
+ * @brief 寄存器是否已读到
+ */
+static inline bool modbus_regmap_valid(const modbus_regmap_values_t *values,
+                                       size_t index) {
+  return index < MODBUS_REGMAP_MAX_REGS && (values->valid >> index) & 1;
+}
+
+// 带类型的读取，未读到时返回 0
+static inline uint16_t modbus_regmap_get_u16(const modbus_regmap_values_t *values,
+                                             size_t index) {
+  return modbus_regmap_valid(values, index) ? values->raw[index][0] : 0;
+}
+
+static inline int16_t modbus_regmap_get_s16(const modbus_regmap_values_t *values,
+                                            size_t index) {
+  return (int16_t)modbus_regmap_get_u16(values, index);
+}
+
+static inline uint32_t modbus_regmap_get_u32(const modbus_regmap_values_t *values,
+                                             size_t index) {
+  if (!modbus_regmap_valid(values, index)) {
+    return 0;
+  }
+  return ((uint32_t)values->raw[index][0] << 16) | values->raw[index][1];
+}
+
+static inline int32_t modbus_regmap_get_s32(const modbus_regmap_values_t *values,
+                                            size_t index) {
+  return (int32_t)modbus_regmap_get_u32(values, index);
+}
+
+static inline float modbus_regmap_get_f32(const modbus_regmap_values_t *values,
+                                          size_t index) {
+  uint32_t bits = modbus_regmap_get_u32(values, index);
+  float f;
+  memcpy(&f, &bits, sizeof(f));
+  return f;
+}
+
+/**
+ * @brief 寄存器定义占用的寄存器数（16 位为 1，32 位为 2）
+ */
+uint16_t modbus_regmap_width(const modbus_reg_def_t *def);
+
+/**
+ * @brief 合并间隙的盈亏点：多读不超过此数量的间隙寄存器比多发一帧省时
+ *
+ * 多发一帧要付出请求帧、应答头尾、应答延迟和两个 t3.5，
+ * 多读一个寄存器只多两个字符。
+ */
+uint16_t modbus_regmap_break_even_gap(const modbus_poll_timing_t *timing);
+
+/**
+ * @brief 生成读取计划
+ *
+ * 按（功能码, 地址）排序后合并：同一功能码、间隙不超过 max_gap 且
+ * 合并后不超过 125 个寄存器的定义放进同一次 FC03/FC04 读取。
+ *
+ * @param map 寄存器表
+ * @param max_gap 允许多读的间隙寄存器数，0 只合并相邻或重叠的定义
+ * @param timing 总线时序，用于估算一轮读取时间，可为 NULL
+ * @param plan 输出计划
+ * @return true 成功, false 表为空、过大或含非法定义
+ */
+bool modbus_regmap_plan(const modbus_regmap_t *map, uint16_t max_gap,
+                        const modbus_poll_timing_t *timing,
+                        modbus_regmap_plan_t *plan);
+
+/**
+ * @brief 把一次读取的应答拆回各寄存器定义
+ *
+ * 可作为 modbus_poll 回调的一部分：把 plan->reads 逐项登记为轮询项，
+ * 在回调中调用本函数。
+ */
+void modbus_regmap_store(const modbus_regmap_plan_t *plan,
+                         const modbus_result_t *result,
+                         modbus_regmap_values_t *values);
+
+/**
+ * @brief 按计划同步读取一个从站（不可在 UI 中调用）
+ * @param master 主站句柄
+ * @param slave 从站地址
+ * @param plan 读取计划
+ * @param values 输出值；失败的读取对应的寄存器保持未读到
+ * @return MODBUS_OK 全部成功，否则为最后一个失败读取的状态
+ */
+modbus_status_t modbus_regmap_read(modbus_master_t *master, uint8_t slave,
+                                   const modbus_regmap_plan_t *plan,
+                                   modbus_regmap_values_t *values);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // MODBUS_REGMAP_H
@@ -0,0 +1,405 @@
+#include "modbus_slave.h"
+#include "rs485_crc.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include <stdlib.h>
+#include <string.h>
+
+static const char *TAG = "MODBUS_SLAVE";
+
+// 从站任务：低于 RS485 RX 任务，高于 TX 任务与主站任务，保证应答及时
+#define MODBUS_SLAVE_TASK_STACK_SIZE 4096
+#define MODBUS_SLAVE_TASK_PRIORITY 11
+
+struct modbus_slave {
+    modbus_slave_config_t config;
+    rs485_bus_t *bus;
+    TaskHandle_t task;
+    portMUX_TYPE lock; // 保护寄存器映射、线圈状态与统计
+    uint16_t registers[MODBUS_SLAVE_MAX_REGISTERS];
+    rs485_cmd_t active_cmd;
+
+    // 本次请求产生的回调，应答发出后再分发（仅从站任务使用）
+    bool pending_command;
+    uint16_t pending_coil;
+    rs485_cmd_t pending_cmd;
+    bool pending_write;
+    uint16_t pending_address;
+    uint16_t pending_quantity;
+
+    modbus_slave_stats_t stats;
+    uint8_t response[RS485_FRAME_MAX_LEN]; // 仅从站任务使用
+};
+
+static inline uint16_t get_u16(const uint8_t *p) {
+    return (uint16_t)((p[0] << 8) | p[1]);
+}
+
+static inline void put_u16(uint8_t *p, uint16_t v) {
+    p[0] = (uint8_t)(v >> 8);
+    p[1] = (uint8_t)(v & 0xFF);
+}
+
+static size_t modbus_slave_finish(uint8_t *response, size_t len) {
+    uint16_t crc = rs485_crc16_update(RS485_CRC16_INIT, response, len);
+    response[len++] = (uint8_t)(crc & 0xFF); // CRC低字节
+    response[len++] = (uint8_t)(crc >> 8);   // CRC高字节
+    return len;
+}
+
+static size_t modbus_slave_exception(modbus_slave_t *slave, uint8_t *response, uint8_t function, uint8_t code) {
+    slave->stats.exceptions++;
+    response[1] = function | 0x80;
+    response[2] = code;
+    return modbus_slave_finish(response, 3);
+}
+
+// 请求帧长度（不含 CRC），无法判断时返回 0
+static size_t modbus_slave_request_len(const uint8_t *request, size_t length) {
+    switch (request[1]) {
+    case MODBUS_FC_READ_COILS:
+    case MODBUS_FC_READ_HOLDING_REGISTERS:
+    case MODBUS_FC_WRITE_SINGLE_COIL:
+    case MODBUS_FC_WRITE_SINGLE_REGISTER:
+        return 6;
+    case MODBUS_FC_WRITE_MULTIPLE_COILS:
+    case MODBUS_FC_WRITE_MULTIPLE_REGISTERS:
+        return length >= 7 ? 7 + request[6] : 0;
+    default:
+        return length - 2; // 未支持的功能码：无法判断长度，整帧回异常
+    }
+}
+
+// 线圈写入后的激活命令；调用者需在临界区内
+static void modbus_slave_write_coil_locked(modbus_slave_t *slave, uint16_t coil, bool on) {
+    rs485_cmd_t cmd = slave->config.coil_cmds[coil];
+    rs485_cmd_t next = slave->active_cmd;
+    if (on) {
+        next = cmd;
+    } else if (slave->active_cmd == cmd) {
+        next = RS485_CMD_LIGHT_OFF; // 关闭当前激活的线圈即关灯
+    }
+    if (next != slave->active_cmd) {
+        slave->active_cmd = next;
+        slave->pending_command = true;
+        slave->pending_coil = coil;
+        slave->pending_cmd = next;
+    }
+}
+
+// FC06/FC10 写入的值是否都被 validate_cb 接受；帧格式由调用者另行检查
+static bool modbus_slave_values_ok(const modbus_slave_t *slave, const uint8_t *request, uint16_t address,
+                                   uint16_t qty) {
+    const modbus_slave_config_t *cfg = &slave->config;
+    if (cfg->validate_cb == NULL) {
+        return true;
+    }
+    if (request[1] == MODBUS_FC_WRITE_SINGLE_REGISTER) {
+        return cfg->validate_cb(address, qty, cfg->user_ctx);
+    }
+    if (request[1] == MODBUS_FC_WRITE_MULTIPLE_REGISTERS && qty <= MODBUS_MAX_WRITE_REGISTERS &&
+        request[6] == qty * 2) {
+        for (uint16_t i = 0; i < qty; i++) {
+            if (!cfg->validate_cb(address + i, get_u16(&request[7 + i * 2]), cfg->user_ctx)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+size_t modbus_slave_process(modbus_slave_t *slave, const uint8_t *request, size_t length, uint8_t *response) {
+    slave->pending_command = false;
+    slave->pending_write = false;
+
+    if (length < 4) {
+        return 0;
+    }
+    uint8_t unit = request[0];
+    bool broadcast = unit == MODBUS_BROADCAST_ADDR;
+    if (!broadcast && unit != slave->config.address) {
+        portENTER_CRITICAL(&slave->lock);
+        slave->stats.ignored++;
+        portEXIT_CRITICAL(&slave->lock);
+        return 0;
+    }
+
+    // 长度不符的帧按协议静默丢弃（允许塔灯帧的 00 00 后缀）
+    uint8_t function = request[1];
+    size_t pdu_len = modbus_slave_request_len(request, length);
+    if (pdu_len == 0 || (length != pdu_len + 2 && length != pdu_len + 4)) {
+        return 0;
+    }
+
+    const modbus_slave_config_t *cfg = &slave->config;
+    // 不足 6 字节的只可能是未支持的功能码，只回异常
+    uint16_t address = length >= 6 ? get_u16(&request[2]) : 0;
+    uint16_t qty = length >= 6 ? get_u16(&request[4]) : 0;
+    size_t len = 0;
+    response[0] = cfg->address;
+    response[1] = function;
+    // 取值检查回调在临界区外调用
+    bool values_ok = modbus_slave_values_ok(slave, request, address, qty);
+
+    portENTER_CRITICAL(&slave->lock);
+    if (broadcast) {
+        slave->stats.broadcasts++;
+    } else {
+        slave->stats.requests++;
+    }
+
+    switch (function) {
+    case MODBUS_FC_READ_COILS: {
+        if (qty == 0 || qty > MODBUS_MAX_READ_BITS) {
+            len = modbus_slave_exception(slave, response, function, MODBUS_EX_ILLEGAL_DATA_VALUE);
+            break;
+        }
+        if ((uint32_t)address + qty > cfg->coil_count) {
+            len = modbus_slave_exception(slave, response, function, MODBUS_EX_ILLEGAL_DATA_ADDRESS);
+            break;
+        }
+        uint8_t byte_count = (uint8_t)((qty + 7) / 8);
+        response[2] = byte_count;
+        memset(&response[3], 0, byte_count);
+        for (uint16_t i = 0; i < qty; i++) {
+            if (cfg->coil_cmds[address + i] == slave->active_cmd) {
+                response[3 + i / 8] |= (uint8_t)(1u << (i % 8));
+            }
+        }
+        len = modbus_slave_finish(response, 3 + byte_count);
+        break;
+    }
+    case MODBUS_FC_READ_HOLDING_REGISTERS: {
+        if (qty == 0 || qty > MODBUS_MAX_READ_REGISTERS) {
+            len = modbus_slave_exception(slave, response, function, MODBUS_EX_ILLEGAL_DATA_VALUE);
+            break;
+        }
+        if ((uint32_t)address + qty > cfg->register_count) {
+            len = modbus_slave_exception(slave, response, function, MODBUS_EX_ILLEGAL_DATA_ADDRESS);
+            break;
+        }
+        response[2] = (uint8_t)(qty * 2);
+        for (uint16_t i = 0; i < qty; i++) {
+            put_u16(&response[3 + i * 2], slave->registers[address + i]);
+        }
+        len = modbus_slave_finish(response, 3 + qty * 2);
+        break;
+    }
+    case MODBUS_FC_WRITE_SINGLE_COIL: {
+        if (qty != 0xFF00 && qty != 0x0000) {
+            len = modbus_slave_exception(slave, response, function, MODBUS_EX_ILLEGAL_DATA_VALUE);
+            break;
+        }
+        if (address >= cfg->coil_count) {
+            len = modbus_slave_exception(slave, response, function, MODBUS_EX_ILLEGAL_DATA_ADDRESS);
+            break;
+        }
+        modbus_slave_write_coil_locked(slave, address, qty == 0xFF00);
+        memcpy(&response[2], &request[2], 4); // 应答即回显请求
+        len = modbus_slave_finish(response, 6);
+        break;
+    }
+    case MODBUS_FC_WRITE_SINGLE_REGISTER: {
+        if (address < cfg->writable_start || address >= cfg->register_count) {
+            len = modbus_slave_exception(slave, response, function, MODBUS_EX_ILLEGAL_DATA_ADDRESS);
+            break;
+        }
+        if (!values_ok) {
+            len = modbus_slave_exception(slave, response, function, MODBUS_EX_ILLEGAL_DATA_VALUE);
+            break;
+        }
+        slave->registers[address] = qty;
+        slave->pending_write = true;
+        slave->pending_address = address;
+        slave->pending_quantity = 1;
+        memcpy(&response[2], &request[2], 4);
+        len = modbus_slave_finish(response, 6);
+        break;
+    }
+    case MODBUS_FC_WRITE_MULTIPLE_COILS: {
+        if (qty == 0 || qty > MODBUS_MAX_WRITE_BITS || request[6] != (qty + 7) / 8) {
+            len = modbus_slave_exception(slave, response, function, MODBUS_EX_ILLEGAL_DATA_VALUE);
+            break;
+        }
+        if ((uint32_t)address + qty > cfg->coil_count) {
+            len = modbus_slave_exception(slave, response, function, MODBUS_EX_ILLEGAL_DATA_ADDRESS);
+            break;
+        }
+        // 先处理 OFF 再处理 ON：同一帧中置位的线圈决定最终命令
+        for (int pass = 0; pass < 2; pass++) {
+            for (uint16_t i = 0; i < qty; i++) {
+                bool on = (request[7 + i / 8] >> (i % 8)) & 1;
+                if (on == (pass == 1)) {
+                    modbus_slave_write_coil_locked(slave, address + i, on);
+                }
+            }
+        }
+        memcpy(&response[2], &request[2], 4);
+        len = modbus_slave_finish(response, 6);
+        break;
+    }
+    case MODBUS_FC_WRITE_MULTIPLE_REGISTERS: {
+        if (qty == 0 || qty > MODBUS_MAX_WRITE_REGISTERS || request[6] != qty * 2) {
+            len = modbus_slave_exception(slave, response, function, MODBUS_EX_ILLEGAL_DATA_VALUE);
+            break;
+        }
+        if (address < cfg->writable_start || (uint32_t)address + qty > cfg->register_count) {
+            len = modbus_slave_exception(slave, response, function, MODBUS_EX_ILLEGAL_DATA_ADDRESS);
+            break;
+        }
+        if (!values_ok) {
+            len = modbus_slave_exception(slave, response, function, MODBUS_EX_ILLEGAL_DATA_VALUE);
+            break;
+        }
+        for (uint16_t i = 0; i < qty; i++) {
+            slave->registers[address + i] = get_u16(&request[7 + i * 2]);
+        }
+        slave->pending_write = true;
+        slave->pending_address = address;
+        slave->pending_quantity = qty;
+        memcpy(&response[2], &request[2], 4);
+        len = modbus_slave_finish(response, 6);
+        break;
+    }
+    default:
+        len = modbus_slave_exception(slave, response, function, MODBUS_EX_ILLEGAL_FUNCTION);
+        break;
+    }
+    portEXIT_CRITICAL(&slave->lock);
+
+    // 广播请求执行但不应答（读请求广播无意义，直接忽略）
+    return broadcast ? 0 : len;
+}
+
+// 分发本次请求产生的回调
+static void modbus_slave_dispatch(modbus_slave_t *slave) {
+    const modbus_slave_config_t *cfg = &slave->config;
+    if (slave->pending_command && cfg->command_cb != NULL) {
+        cfg->command_cb(slave->pending_coil, slave->pending_cmd, cfg->user_ctx);
+    }
+    if (slave->pending_write && cfg->write_cb != NULL) {
+        cfg->write_cb(slave->pending_address, slave->pending_quantity, cfg->user_ctx);
+    }
+    slave->pending_command = false;
+    slave->pending_write = false;
+}
+
+static void modbus_slave_task(void *arg) {
+    modbus_slave_t *slave = (modbus_slave_t *)arg;
+    rs485_frame_t frame;
+
+    while (1) {
+        if (!rs485_frame_acquire(slave->bus, &frame, portMAX_DELAY)) {
+            continue;
+        }
+
+        size_t len = 0;
+        if (frame.status == RS485_FRAME_OK) {
+            len = modbus_slave_process(slave, frame.data, frame.length, slave->response);
+        } else {
+            // CRC 错误的请求不应答，由主站超时重试
+            portENTER_CRITICAL(&slave->lock);
+            slave->stats.crc_errors++;
+            portEXIT_CRITICAL(&slave->lock);
+        }
+        int64_t request_end_us = frame.timestamp_us;
+        rs485_frame_release(slave->bus, &frame);
+
+        if (len > 0) {
+            // 发送前总线保证距请求结束至少 t3.5；应答时间从请求最后一个字节
+            // 算到应答真正开始发送，含这段静默与等总线的时间
+            rs485_transact_timing_t timing = {.tx_start_us = esp_timer_get_time()};
+            bool sent = rs485_bus_send_timed(slave->bus, RS485_LANE_COMMAND, slave->response, len, &timing);
+            uint32_t turnaround_us = (uint32_t)(timing.tx_start_us - request_end_us);
+            portENTER_CRITICAL(&slave->lock);
+            slave->stats.last_turnaround_us = turnaround_us;
+            if (turnaround_us > slave->stats.max_turnaround_us) {
+                slave->stats.max_turnaround_us = turnaround_us;
+            }
+            if (!sent) {
+                slave->stats.send_errors++;
+            }
+            portEXIT_CRITICAL(&slave->lock);
+        }
+        modbus_slave_dispatch(slave);
+    }
+}
+
+modbus_slave_t *modbus_slave_create(const modbus_slave_config_t *config) {
+    if (config == NULL || config->address == MODBUS_BROADCAST_ADDR || config->address > 247 ||
+        config->register_count > MODBUS_SLAVE_MAX_REGISTERS || config->coil_count > MODBUS_SLAVE_MAX_COILS ||
+        (config->coil_count > 0 && config->coil_cmds == NULL)) {
+        return NULL;
+    }
+    modbus_slave_t *slave = calloc(1, sizeof(modbus_slave_t));
+    if (slave == NULL) {
+        ESP_LOGE(TAG, "Failed to allocate slave");
+        return NULL;
+    }
+    slave->config = *config;
+    slave->active_cmd = RS485_CMD_LIGHT_OFF;
+    portMUX_TYPE lock = portMUX_INITIALIZER_UNLOCKED;
+    slave->lock = lock;
+    return slave;
+}
+
+bool modbus_slave_start(modbus_slave_t *slave, rs485_bus_t *bus) {
+    if (slave == NULL || bus == NULL || slave->task != NULL) {
+        return false;
+    }
+    slave->bus = bus;
+
+    // 只有发给本机或广播的完整请求才唤醒从站任务
+    uint8_t addrs[] = {slave->config.address, MODBUS_BROADCAST_ADDR};
+    rs485_bus_set_rx_filter(bus, RS485_PARSER_REQUEST, addrs, sizeof(addrs));
+    if (xTaskCreate(modbus_slave_task, "modbus_slave", MODBUS_SLAVE_TASK_STACK_SIZE, slave,
+                    MODBUS_SLAVE_TASK_PRIORITY, &slave->task) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create slave task");
+        slave->task = NULL;
+        return false;
+    }
+    ESP_LOGI(TAG, "Slave 0x%02X started: %u registers, %u coils", slave->config.address,
+             slave->config.register_count, slave->config.coil_count);
+    return true;
+}
+
+bool modbus_slave_set_register(modbus_slave_t *slave, uint16_t address, uint16_t value) {
+    if (slave == NULL || address >= slave->config.register_count) {
+        return false;
+    }
+    portENTER_CRITICAL(&slave->lock);
+    slave->registers[address] = value;
+    portEXIT_CRITICAL(&slave->lock);
+    return true;
+}
+
+bool modbus_slave_get_register(modbus_slave_t *slave, uint16_t address, uint16_t *value) {
+    if (slave == NULL || value == NULL || address >= slave->config.register_count) {
+        return false;
+    }
+    portENTER_CRITICAL(&slave->lock);
+    *value = slave->registers[address];
+    portEXIT_CRITICAL(&slave->lock);
+    return true;
+}
+
+void modbus_slave_set_active_command(modbus_slave_t *slave, rs485_cmd_t cmd) {
+    if (slave == NULL) {
+        return;
+    }
+    portENTER_CRITICAL(&slave->lock);
+    slave->active_cmd = cmd;
+    portEXIT_CRITICAL(&slave->lock);
+}
+
+bool modbus_slave_get_stats(modbus_slave_t *slave, modbus_slave_stats_t *stats) {
+    if (slave == NULL || stats == NULL) {
+        return false;
+    }
+    portENTER_CRITICAL(&slave->lock);
+    *stats = slave->stats;
+    portEXIT_CRITICAL(&slave->lock);
+    return true;
+}
@@ -0,0 +1,147 @@
+#ifndef MODBUS_SLAVE_H
+#define MODBUS_SLAVE_H
+
+#include "modbus_master.h"
+#include "rs485_comm.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// 寄存器映射容量
+#define MODBUS_SLAVE_MAX_REGISTERS 64
+#define MODBUS_SLAVE_MAX_COILS 16
+
+// Modbus 异常码
+#define MODBUS_EX_ILLEGAL_FUNCTION 0x01
+#define MODBUS_EX_ILLEGAL_DATA_ADDRESS 0x02
+#define MODBUS_EX_ILLEGAL_DATA_VALUE 0x03
+
+/**
+ * @brief 线圈动作回调：主站把线圈写为 ON 时调用，在从站任务中、应答发出之后调用
+ *
+ * 不要阻塞，也不要取 LVGL 锁；需要更新 UI 时只把消息投进队列，由 LVGL
+ * 定时器取出显示（见 eez_ui/screens.c 的 post_log_entry）。
+ *
+ * @param coil 线圈编号
+ * @param cmd 该线圈映射的灯光命令（线圈写为 OFF 时为 RS485_CMD_LIGHT_OFF）
+ * @param user_ctx 用户参数
+ */
+typedef void (*modbus_slave_command_cb_t)(uint16_t coil, rs485_cmd_t cmd,
+                                          void *user_ctx);
+
+/**
+ * @brief 保持寄存器被主站改写后的回调，调用时机与约束同上
+ * @param address 起始寄存器
+ * @param quantity 数量
+ * @param user_ctx 用户参数
+ */
+typedef void (*modbus_slave_write_cb_t)(uint16_t address, uint16_t quantity,
+                                        void *user_ctx);
+
+/**
+ * @brief 保持寄存器写入前的取值检查，在从站任务中、写入之前调用
+ *
+ * 在临界区外调用，但须是纯计算（不阻塞、不访问总线）。返回 false 时
+ * 整个写请求以异常 03（非法数据值）拒绝，寄存器保持不变。
+ *
+ * @param address 寄存器地址
+ * @param value 待写入的值
+ * @param user_ctx 用户参数
+ * @return true 接受, false 拒绝
+ */
+typedef bool (*modbus_slave_validate_cb_t)(uint16_t address, uint16_t value,
+                                           void *user_ctx);
+
+// 从站配置
+typedef struct {
+  uint8_t address;           // 本机从站地址（1..247）
+  uint16_t register_count;   // 保持寄存器数量，至多 MODBUS_SLAVE_MAX_REGISTERS
+  uint16_t writable_start;   // [writable_start, register_count) 允许主站写入，
+                             // 之前的为只读镜像
+  const rs485_cmd_t *coil_cmds; // 线圈 i 映射到 coil_cmds[i]
+  uint16_t coil_count;          // 至多 MODBUS_SLAVE_MAX_COILS
+  modbus_slave_command_cb_t command_cb;
+  modbus_slave_write_cb_t write_cb;
+  modbus_slave_validate_cb_t validate_cb; // 可为 NULL，表示任何值都接受
+  void *user_ctx;
+} modbus_slave_config_t;
+
+// 从站统计
+typedef struct {
+  uint32_t requests;        // 发给本机的有效请求
+  uint32_t broadcasts;      // 广播写请求（不应答）
+  uint32_t exceptions;      // 异常应答数
+  uint32_t crc_errors;      // CRC 错误帧
+  uint32_t ignored;         // 发给其他从站的帧
+  uint32_t send_errors;     // 应答发送失败
+  uint32_t last_turnaround_us; // 请求最后一个字节收完到应答开始发送（含 t3.5）
+  uint32_t max_turnaround_us;
+} modbus_slave_stats_t;
+
+typedef struct modbus_slave modbus_slave_t;
+
+/**
+ * @brief 创建从站（寄存器映射全为 0，尚未挂到总线）
+ * @param config 配置，回调与线圈表在从站生命周期内须保持有效
+ * @return 从站句柄，失败返回 NULL
+ */
+modbus_slave_t *modbus_slave_create(const modbus_slave_config_t *config);
+
+/**
+ * @brief 在总线上启动从站任务
+ *
+ * 从站任务是该总线唯一的接收消费者，优先级仅次于 RS485 RX 任务，
+ * 以便在 t3.5 之后尽快应答；同一总线不能再作为主站使用。
+ *
+ * @return true 成功, false 失败
+ */
+bool modbus_slave_start(modbus_slave_t *slave, rs485_bus_t *bus);
+
+/**
+ * @brief 处理一帧请求并生成应答（纯计算，不访问总线）
+ *
+ * 总线任务与离线测试共用此入口。支持 FC01/03/05/06/0F/10。
+ *
+ * @param slave 从站句柄
+ * @param request 请求帧（CRC 已校验）
+ * @param length 请求帧长度（含 CRC，可带 00 00 后缀）
+ * @param response 应答缓冲区，至少 RS485_FRAME_MAX_LEN 字节
+ * @return 应答长度（含 CRC），0 表示不应答（广播或非本机地址）
+ */
+size_t modbus_slave_process(modbus_slave_t *slave, const uint8_t *request,
+                            size_t length, uint8_t *response);
+
+/**
+ * @brief 更新保持寄存器（供本机其他任务刷新镜像值，不触发写回调）
+ * @return true 成功, false 地址越界
+ */
+bool modbus_slave_set_register(modbus_slave_t *slave, uint16_t address,
+                               uint16_t value);
+
+/**
+ * @brief 读取保持寄存器
+ * @return true 成功, false 地址越界
+ */
+bool modbus_slave_get_register(modbus_slave_t *slave, uint16_t address,
+                               uint16_t *value);
+
+/**
+ * @brief 设置当前激活的线圈（塔灯状态变化时调用，主站读线圈可见）
+ * @param cmd 当前灯光状态；没有对应线圈时所有线圈读为 OFF
+ */
+void modbus_slave_set_active_command(modbus_slave_t *slave, rs485_cmd_t cmd);
+
+/**
+ * @brief 读取从站统计
+ */
+bool modbus_slave_get_stats(modbus_slave_t *slave, modbus_slave_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // MODBUS_SLAVE_H
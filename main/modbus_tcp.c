@@ -0,0 +1,390 @@
+#include "modbus_tcp.h"
+#include "rs485_crc.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+// 连接数与缓冲区之外，每轮最多由缓存连续应答的请求数
+#define MODBUS_TCP_LOCAL_BUDGET (MODBUS_TCP_MAX_CLIENTS * 4)
+
+// 0xFF 在 Modbus TCP 中表示“直连设备”，塔灯在线查询也用它，应答地址不核对
+#define MODBUS_TCP_UNIT_ANY 0xFF
+
+typedef struct {
+    int fd; // -1 为空闲
+    size_t rx_len;
+    uint8_t rx[MODBUS_TCP_RX_BUFFER];
+} modbus_tcp_client_t;
+
+typedef struct {
+    bool used;
+    uint8_t unit;
+    uint8_t request[5]; // 功能码 + 起始地址 + 数量
+    uint8_t length;     // 应答 PDU 长度
+    int64_t stored_us;
+    uint8_t pdu[MODBUS_TCP_PDU_MAX];
+} modbus_tcp_cache_entry_t;
+
+struct modbus_tcp {
+    modbus_tcp_config_t config;
+    int listen_fd;
+    size_t next; // 下一个轮到的连接
+    modbus_tcp_client_t clients[MODBUS_TCP_MAX_CLIENTS];
+    modbus_tcp_cache_entry_t cache[MODBUS_TCP_CACHE_ENTRIES];
+    modbus_tcp_stats_t stats;
+};
+
+static void modbus_tcp_set_nonblocking(int fd) {
+    int flags = fcntl(fd, F_GETFL, 0);
+    fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+}
+
+static void modbus_tcp_close_client(modbus_tcp_t *gw, modbus_tcp_client_t *client) {
+    close(client->fd);
+    client->fd = -1;
+    client->rx_len = 0;
+    gw->stats.clients--;
+}
+
+static bool modbus_tcp_is_read(uint8_t function) {
+    return function >= 0x01 && function <= 0x04;
+}
+
+// 接收缓冲区开头的完整 ADU 长度，不完整返回 0
+static size_t modbus_tcp_adu_length(const modbus_tcp_client_t *client) {
+    if (client->fd < 0 || client->rx_len < 7) {
+        return 0;
+    }
+    size_t length = 6 + (((size_t)client->rx[4] << 8) | client->rx[5]);
+    return client->rx_len >= length ? length : 0;
+}
+
+// 校验 MBAP 头：协议号为 0，长度字段覆盖单元号与至少一个字节的 PDU
+static bool modbus_tcp_header_ok(const modbus_tcp_client_t *client) {
+    if (client->rx_len < 7) {
+        return true;
+    }
+    uint16_t protocol = ((uint16_t)client->rx[2] << 8) | client->rx[3];
+    uint16_t length = ((uint16_t)client->rx[4] << 8) | client->rx[5];
+    return protocol == 0 && length >= 2 && length <= 1 + MODBUS_TCP_PDU_MAX;
+}
+
+static void modbus_tcp_accept(modbus_tcp_t *gw) {
+    int fd = accept(gw->listen_fd, NULL, NULL);
+    if (fd < 0) {
+        return;
+    }
+    for (size_t i = 0; i < MODBUS_TCP_MAX_CLIENTS; i++) {
+        modbus_tcp_client_t *client = &gw->clients[i];
+        if (client->fd < 0) {
+            int one = 1;
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+            modbus_tcp_set_nonblocking(fd);
+            client->fd = fd;
+            client->rx_len = 0;
+            gw->stats.clients++;
+            gw->stats.accepted++;
+            return;
+        }
+    }
+    close(fd);
+    gw->stats.refused++;
+}
+
+static void modbus_tcp_receive(modbus_tcp_t *gw, modbus_tcp_client_t *client) {
+    ssize_t n = recv(client->fd, &client->rx[client->rx_len], sizeof(client->rx) - client->rx_len, 0);
+    if (n == 0 || (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) {
+        modbus_tcp_close_client(gw, client);
+        return;
+    }
+    if (n > 0) {
+        client->rx_len += (size_t)n;
+        if (!modbus_tcp_header_ok(client)) {
+            gw->stats.protocol_errors++;
+            modbus_tcp_close_client(gw, client);
+        }
+    }
+}
+
+static modbus_tcp_cache_entry_t *modbus_tcp_cache_find(modbus_tcp_t *gw, uint8_t unit, const uint8_t *pdu) {
+    for (size_t i = 0; i < MODBUS_TCP_CACHE_ENTRIES; i++) {
+        modbus_tcp_cache_entry_t *entry = &gw->cache[i];
+        if (entry->used && entry->unit == unit && memcmp(entry->request, pdu, sizeof(entry->request)) == 0) {
+            return entry;
+        }
+    }
+    return NULL;
+}
+
+static void modbus_tcp_cache_store(modbus_tcp_t *gw, uint8_t unit, const uint8_t *pdu, const uint8_t *response,
+                                   size_t length, int64_t now_us) {
+    modbus_tcp_cache_entry_t *entry = modbus_tcp_cache_find(gw, unit, pdu);
+    if (entry == NULL) {
+        // 空位或最旧的一条
+        entry = &gw->cache[0];
+        for (size_t i = 0; i < MODBUS_TCP_CACHE_ENTRIES && entry->used; i++) {
+            if (!gw->cache[i].used || gw->cache[i].stored_us < entry->stored_us) {
+                entry = &gw->cache[i];
+            }
+        }
+    }
+    entry->used = true;
+    entry->unit = unit;
+    memcpy(entry->request, pdu, sizeof(entry->request));
+    entry->length = (uint8_t)length;
+    entry->stored_us = now_us;
+    memcpy(entry->pdu, response, length);
+}
+
+// 写入后该从站（广播则全部从站）的缓存失效
+static void modbus_tcp_cache_invalidate(modbus_tcp_t *gw, uint8_t unit) {
+    for (size_t i = 0; i < MODBUS_TCP_CACHE_ENTRIES; i++) {
+        if (unit == 0 || gw->cache[i].unit == unit) {
+            gw->cache[i].used = false;
+        }
+    }
+}
+
+static size_t modbus_tcp_exception(uint8_t *response, uint8_t function, uint8_t code) {
+    response[0] = function | 0x80;
+    response[1] = code;
+    return 2;
+}
+
+// 把一个请求 PDU 转成 RTU 事务，输出应答 PDU；返回应答 PDU 长度
+static size_t modbus_tcp_forward(modbus_tcp_t *gw, uint8_t unit, const uint8_t *pdu, size_t pdu_len,
+                                 uint8_t *response) {
+    uint8_t frame[1 + MODBUS_TCP_PDU_MAX + 2];
+    uint8_t reply[1 + MODBUS_TCP_PDU_MAX + 2];
+    const uint8_t function = pdu[0];
+    const bool broadcast = unit == 0;
+
+    if (broadcast && modbus_tcp_is_read(function)) {
+        gw->stats.errors++;
+        return modbus_tcp_exception(response, function, MODBUS_TCP_EXC_PATH_UNAVAILABLE);
+    }
+    if (!modbus_tcp_is_read(function)) {
+        modbus_tcp_cache_invalidate(gw, unit); // 失败的写也可能已被执行
+    }
+
+    frame[0] = unit;
+    memcpy(&frame[1], pdu, pdu_len);
+    uint16_t crc = rs485_crc16_update(RS485_CRC16_INIT, frame, 1 + pdu_len);
+    frame[1 + pdu_len] = (uint8_t)(crc & 0xFF);
+    frame[2 + pdu_len] = (uint8_t)(crc >> 8);
+
+    int64_t start_us = gw->config.now_us();
+    int n = gw->config.transact(gw->config.transact_ctx, frame, pdu_len + 3, reply, sizeof(reply),
+                                broadcast ? 0 : gw->config.timeout_ms);
+    gw->stats.bus_us += (uint64_t)(gw->config.now_us() - start_us);
+    gw->stats.bus_transactions++;
+
+    if (n < 0) {
+        gw->stats.errors++;
+        return modbus_tcp_exception(response, function, MODBUS_TCP_EXC_PATH_UNAVAILABLE);
+    }
+    if (broadcast) {
+        // 从站不应答广播；写功能码的正常应答是请求 PDU 的前 5 字节
+        size_t length = pdu_len < 5 ? pdu_len : 5;
+        memcpy(response, pdu, length);
+        return length;
+    }
+    if (n == 0) {
+        gw->stats.timeouts++;
+        return modbus_tcp_exception(response, function, MODBUS_TCP_EXC_TARGET_FAILED);
+    }
+    // 塔灯在 CRC 之后多发 00 00；只有去掉后缀正好是完整帧时才去掉
+    if (n >= 10 && reply[n - 1] == 0 && reply[n - 2] == 0 &&
+        rs485_crc16_update(RS485_CRC16_INIT, reply, (size_t)n - 2) == 0) {
+        n -= 2;
+    }
+    if (n < 5 || rs485_crc16_update(RS485_CRC16_INIT, reply, (size_t)n) != 0 ||
+        (unit != MODBUS_TCP_UNIT_ANY && reply[0] != unit) || (reply[1] & 0x7F) != function) {
+        gw->stats.errors++;
+        return modbus_tcp_exception(response, function, MODBUS_TCP_EXC_TARGET_FAILED);
+    }
+
+    size_t length = (size_t)n - 3;
+    memcpy(response, &reply[1], length);
+    if (modbus_tcp_is_read(function) && pdu_len == 5 && !(reply[1] & 0x80) && gw->config.cache_ttl_ms > 0) {
+        modbus_tcp_cache_store(gw, unit, pdu, response, length, gw->config.now_us());
+    }
+    return length;
+}
+
+// 处理连接缓冲区开头的一个请求；返回是否使用了总线
+static bool modbus_tcp_handle(modbus_tcp_t *gw, modbus_tcp_client_t *client, size_t adu_len) {
+    uint8_t adu[MODBUS_TCP_ADU_MAX];
+    const uint8_t unit = client->rx[6];
+    const uint8_t *pdu = &client->rx[7];
+    const size_t pdu_len = adu_len - 7;
+    uint8_t *response = &adu[7];
+    size_t length = 0;
+    bool used_bus = false;
+
+    if (modbus_tcp_is_read(pdu[0]) && pdu_len == 5 && gw->config.cache_ttl_ms > 0) {
+        const modbus_tcp_cache_entry_t *entry = modbus_tcp_cache_find(gw, unit, pdu);
+        if (entry != NULL && gw->config.now_us() - entry->stored_us < (int64_t)gw->config.cache_ttl_ms * 1000) {
+            memcpy(response, entry->pdu, entry->length);
+            length = entry->length;
+            gw->stats.cache_hits++;
+        }
+    }
+    if (length == 0) {
+        length = modbus_tcp_forward(gw, unit, pdu, pdu_len, response);
+        used_bus = true;
+    }
+
+    // 沿用请求的事务号与单元号
+    adu[0] = client->rx[0];
+    adu[1] = client->rx[1];
+    adu[2] = 0;
+    adu[3] = 0;
+    adu[4] = (uint8_t)((length + 1) >> 8);
+    adu[5] = (uint8_t)((length + 1) & 0xFF);
+    adu[6] = unit;
+    gw->stats.requests++;
+
+    client->rx_len -= adu_len;
+    memmove(client->rx, &client->rx[adu_len], client->rx_len);
+
+    // 应答很短，发送缓冲区放不下说明对端已不再读取，直接断开
+    if (send(client->fd, adu, 7 + length, MSG_NOSIGNAL) != (ssize_t)(7 + length)) {
+        modbus_tcp_close_client(gw, client);
+    } else if (!modbus_tcp_header_ok(client)) {
+        gw->stats.protocol_errors++;
+        modbus_tcp_close_client(gw, client);
+    }
+    return used_bus;
+}
+
+static int modbus_tcp_serve(modbus_tcp_t *gw) {
+    int served = 0;
+    for (int budget = MODBUS_TCP_LOCAL_BUDGET; budget > 0; budget--) {
+        // 从上次之后的连接开始轮转，找第一个有完整请求的
+        modbus_tcp_client_t *client = NULL;
+        size_t adu_len = 0;
+        for (size_t k = 0; k < MODBUS_TCP_MAX_CLIENTS && client == NULL; k++) {
+            size_t i = (gw->next + k) % MODBUS_TCP_MAX_CLIENTS;
+            adu_len = modbus_tcp_adu_length(&gw->clients[i]);
+            if (adu_len > 0) {
+                client = &gw->clients[i];
+                gw->next = (i + 1) % MODBUS_TCP_MAX_CLIENTS;
+            }
+        }
+        if (client == NULL) {
+            break;
+        }
+        served++;
+        if (modbus_tcp_handle(gw, client, adu_len)) {
+            break;
+        }
+    }
+    return served;
+}
+
+modbus_tcp_t *modbus_tcp_create(const modbus_tcp_config_t *config) {
+    if (config == NULL || config->transact == NULL || config->now_us == NULL) {
+        return NULL;
+    }
+    modbus_tcp_t *gw = calloc(1, sizeof(modbus_tcp_t));
+    if (gw == NULL) {
+        return NULL;
+    }
+    gw->config = *config;
+    if (gw->config.port == 0) {
+        gw->config.port = MODBUS_TCP_DEFAULT_PORT;
+    }
+    for (size_t i = 0; i < MODBUS_TCP_MAX_CLIENTS; i++) {
+        gw->clients[i].fd = -1;
+    }
+
+    gw->listen_fd = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (gw->listen_fd < 0) {
+        free(gw);
+        return NULL;
+    }
+    int one = 1;
+    setsockopt(gw->listen_fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    struct sockaddr_in addr = {
+        .sin_family = AF_INET,
+        .sin_port = htons(gw->config.port),
+        .sin_addr.s_addr = htonl(INADDR_ANY),
+    };
+    if (bind(gw->listen_fd, (struct sockaddr *)&addr, sizeof(addr)) != 0 ||
+        listen(gw->listen_fd, MODBUS_TCP_MAX_CLIENTS) != 0) {
+        close(gw->listen_fd);
+        free(gw);
+        return NULL;
+    }
+    modbus_tcp_set_nonblocking(gw->listen_fd);
+    return gw;
+}
+
+int modbus_tcp_poll(modbus_tcp_t *gw, uint32_t wait_ms) {
+    fd_set readable;
+    FD_ZERO(&readable);
+    FD_SET(gw->listen_fd, &readable);
+    int max_fd = gw->listen_fd;
+    bool pending = false;
+
+    for (size_t i = 0; i < MODBUS_TCP_MAX_CLIENTS; i++) {
+        const modbus_tcp_client_t *client = &gw->clients[i];
+        if (client->fd < 0) {
+            continue;
+        }
+        pending = pending || modbus_tcp_adu_length(client) > 0;
+        if (client->rx_len < sizeof(client->rx)) {
+            FD_SET(client->fd, &readable);
+            max_fd = client->fd > max_fd ? client->fd : max_fd;
+        }
+    }
+
+    struct timeval timeout = {
+        .tv_sec = pending ? 0 : wait_ms / 1000,
+        .tv_usec = pending ? 0 : (wait_ms % 1000) * 1000,
+    };
+    int ready = select(max_fd + 1, &readable, NULL, NULL, &timeout);
+    if (ready < 0 && errno != EINTR) {
+        return -1;
+    }
+    if (ready > 0) {
+        for (size_t i = 0; i < MODBUS_TCP_MAX_CLIENTS; i++) {
+            modbus_tcp_client_t *client = &gw->clients[i];
+            if (client->fd >= 0 && FD_ISSET(client->fd, &readable)) {
+                modbus_tcp_receive(gw, client);
+            }
+        }
+        if (FD_ISSET(gw->listen_fd, &readable)) {
+            modbus_tcp_accept(gw);
+        }
+    }
+    return modbus_tcp_serve(gw);
+}
+
+void modbus_tcp_get_stats(const modbus_tcp_t *gw, modbus_tcp_stats_t *stats) {
+    *stats = gw->stats;
+}
+
+void modbus_tcp_destroy(modbus_tcp_t *gw) {
+    if (gw == NULL) {
+        return;
+    }
+    for (size_t i = 0; i < MODBUS_TCP_MAX_CLIENTS; i++) {
+        if (gw->clients[i].fd >= 0) {
+            modbus_tcp_close_client(gw, &gw->clients[i]);
+        }
+    }
+    close(gw->listen_fd);
+    free(gw);
+}
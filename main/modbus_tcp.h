@@ -0,0 +1,117 @@
+#ifndef MODBUS_TCP_H
+#define MODBUS_TCP_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Modbus TCP → RTU 网关核心
+ *
+ * 只依赖 BSD 套接字与 rs485_crc，固件（lwIP）与 Linux 主机共用同一份代码；
+ * 总线访问与时钟由调用者以回调提供。单线程运行：调用者在一个任务里
+ * 反复调用 modbus_tcp_poll()。
+ *
+ * - 多路复用：多个 TCP 连接共用一条半双工总线，同一时刻只有一个事务；
+ * - 公平：各连接轮转，每轮每个连接至多一个请求，流水线发来的请求
+ *   留在该连接的接收缓冲区，缓冲区满时不再读取（由 TCP 反压）；
+ * - 缓存：FC01-04 读应答保留 cache_ttl_ms，期间相同的读直接应答，
+ *   不占用总线；对同一从站的任何写入使其缓存失效。
+ */
+
+#define MODBUS_TCP_DEFAULT_PORT 502
+
+// 同时服务的连接数（lwIP 默认最多 10 个套接字，留出余量）
+#define MODBUS_TCP_MAX_CLIENTS 6
+
+// 每个连接的接收缓冲区，可容纳数个流水线请求
+#define MODBUS_TCP_RX_BUFFER 1024
+
+// 读应答缓存条数
+#define MODBUS_TCP_CACHE_ENTRIES 16
+
+// MBAP 头 7 字节 + PDU 至多 253 字节
+#define MODBUS_TCP_ADU_MAX 260
+#define MODBUS_TCP_PDU_MAX 253
+
+// 网关异常码
+#define MODBUS_TCP_EXC_PATH_UNAVAILABLE 0x0A // 无法发送到总线
+#define MODBUS_TCP_EXC_TARGET_FAILED 0x0B    // 从站无应答或应答无效
+
+/**
+ * @brief 总线事务回调
+ * @param ctx 用户参数
+ * @param request RTU 请求帧（含 CRC）
+ * @param request_len 请求帧长度
+ * @param response 应答缓冲区
+ * @param response_size 应答缓冲区大小
+ * @param timeout_ms 应答超时，0 表示广播不等待应答
+ * @return 应答字节数，0 表示超时或无需应答，-1 表示发送失败
+ */
+typedef int (*modbus_tcp_transact_fn)(void *ctx, const uint8_t *request,
+                                      size_t request_len, uint8_t *response,
+                                      size_t response_size,
+                                      uint32_t timeout_ms);
+
+// 网关配置
+typedef struct {
+  uint16_t port;                 // 监听端口，0 使用 502
+  uint32_t cache_ttl_ms;         // 读应答缓存有效期，0 不缓存
+  uint32_t timeout_ms;           // 从站应答超时
+  modbus_tcp_transact_fn transact;
+  void *transact_ctx;
+  int64_t (*now_us)(void);       // 单调时钟（微秒）
+} modbus_tcp_config_t;
+
+// 网关统计
+typedef struct {
+  uint32_t requests;         // 已应答的请求
+  uint32_t bus_transactions; // 实际发到总线的请求
+  uint32_t cache_hits;       // 由缓存应答的请求
+  uint32_t timeouts;         // 从站无应答
+  uint32_t errors;           // 发送失败、应答 CRC/地址/功能码不符
+  uint32_t protocol_errors;  // MBAP 头非法而断开的连接
+  uint32_t accepted;         // 累计接受的连接
+  uint32_t refused;          // 超出连接上限被拒绝的连接
+  uint8_t clients;           // 当前连接数
+  uint64_t bus_us;           // 总线事务累计耗时
+} modbus_tcp_stats_t;
+
+typedef struct modbus_tcp modbus_tcp_t;
+
+/**
+ * @brief 创建网关并开始监听
+ * @return 句柄，参数非法、内存不足或监听失败返回 NULL
+ */
+modbus_tcp_t *modbus_tcp_create(const modbus_tcp_config_t *config);
+
+/**
+ * @brief 运行一轮：等待网络事件，接受连接、收取请求，并按轮转处理请求
+ *
+ * 有待处理的请求时不等待。缓存命中可在一轮内连续应答，每轮至多
+ * 一个总线事务，之后返回，让调用者尽快再次收取网络数据。
+ *
+ * @param wait_ms 无事可做时最长等待时间
+ * @return 本轮应答的请求数，监听套接字出错返回 -1
+ */
+int modbus_tcp_poll(modbus_tcp_t *gw, uint32_t wait_ms);
+
+/**
+ * @brief 读取统计（与 modbus_tcp_poll 在同一线程调用）
+ */
+void modbus_tcp_get_stats(const modbus_tcp_t *gw, modbus_tcp_stats_t *stats);
+
+/**
+ * @brief 关闭所有连接并释放网关
+ */
+void modbus_tcp_destroy(modbus_tcp_t *gw);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // MODBUS_TCP_H
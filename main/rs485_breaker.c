@@ -0,0 +1,189 @@
+#include "rs485_breaker.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include <string.h>
+
+static const char *TAG = "RS485_BREAKER";
+
+typedef struct {
+    rs485_breaker_info_t info;
+    uint8_t backoff_shift; // 探测连续失败次数，决定下一次等待时间
+    int64_t probe_at_us;   // 断开状态下的下一次探测时刻
+} rs485_breaker_slot_t;
+
+static portMUX_TYPE s_breaker_lock = portMUX_INITIALIZER_UNLOCKED;
+static rs485_breaker_slot_t s_slots[RS485_BREAKER_MAX_DEVICES];
+static size_t s_slot_count = 0;
+static rs485_breaker_config_t s_config = {
+    .threshold = RS485_BREAKER_DEFAULT_THRESHOLD,
+    .probe_ms = RS485_BREAKER_DEFAULT_PROBE_MS,
+    .probe_max_ms = RS485_BREAKER_DEFAULT_PROBE_MAX_MS,
+};
+
+// 查找或分配槽位；调用者需在临界区内
+static rs485_breaker_slot_t *rs485_breaker_slot_locked(uart_port_t uart_num, uint8_t address, bool create) {
+    for (size_t i = 0; i < s_slot_count; i++) {
+        if (s_slots[i].info.uart_num == (uint8_t)uart_num && s_slots[i].info.address == address) {
+            return &s_slots[i];
+        }
+    }
+    if (!create || s_slot_count >= RS485_BREAKER_MAX_DEVICES) {
+        return NULL; // 表满，新设备不受断路器保护
+    }
+    rs485_breaker_slot_t *slot = &s_slots[s_slot_count++];
+    memset(slot, 0, sizeof(*slot));
+    slot->info.uart_num = (uint8_t)uart_num;
+    slot->info.address = address;
+    slot->info.state = RS485_BREAKER_CLOSED;
+    return slot;
+}
+
+// 下一次探测的等待时间：probe_ms << backoff_shift，不超过上限
+static uint32_t rs485_breaker_wait_ms(uint8_t backoff_shift) {
+    uint64_t wait = (uint64_t)s_config.probe_ms << (backoff_shift < 16 ? backoff_shift : 16);
+    return wait > s_config.probe_max_ms ? s_config.probe_max_ms : (uint32_t)wait;
+}
+
+void rs485_breaker_configure(const rs485_breaker_config_t *config) {
+    if (config == NULL) {
+        return;
+    }
+    portENTER_CRITICAL(&s_breaker_lock);
+    s_config = *config;
+    if (s_config.probe_max_ms < s_config.probe_ms) {
+        s_config.probe_max_ms = s_config.probe_ms;
+    }
+    portEXIT_CRITICAL(&s_breaker_lock);
+}
+
+bool rs485_breaker_admit(uart_port_t uart_num, uint8_t address, bool *probe) {
+    if (probe != NULL) {
+        *probe = false;
+    }
+    if (address == 0) {
+        return true; // 广播没有应答，无从判断
+    }
+
+    bool allowed = true;
+    bool probing = false;
+    int64_t now_us = esp_timer_get_time();
+    portENTER_CRITICAL(&s_breaker_lock);
+    rs485_breaker_slot_t *slot = rs485_breaker_slot_locked(uart_num, address, false);
+    if (slot != NULL && s_config.threshold != 0) {
+        if (slot->info.state == RS485_BREAKER_OPEN && now_us >= slot->probe_at_us) {
+            // 只放行一个探测，其余调用者在结果返回前继续被拒绝
+            slot->info.state = RS485_BREAKER_HALF_OPEN;
+            slot->info.probes++;
+            probing = true;
+        } else if (slot->info.state != RS485_BREAKER_CLOSED) {
+            slot->info.rejected++;
+            allowed = false;
+        }
+    }
+    portEXIT_CRITICAL(&s_breaker_lock);
+
+    if (probe != NULL) {
+        *probe = probing;
+    }
+    return allowed;
+}
+
+void rs485_breaker_report(uart_port_t uart_num, uint8_t address, bool responded) {
+    if (address == 0) {
+        return;
+    }
+
+    rs485_breaker_state_t before = RS485_BREAKER_CLOSED;
+    rs485_breaker_state_t after = RS485_BREAKER_CLOSED;
+    uint32_t wait_ms = 0;
+    int64_t now_us = esp_timer_get_time();
+    portENTER_CRITICAL(&s_breaker_lock);
+    // 只为出过故障的设备分配槽位，正常设备不占表
+    rs485_breaker_slot_t *slot = rs485_breaker_slot_locked(uart_num, address, !responded);
+    if (slot != NULL) {
+        before = slot->info.state;
+        if (responded) {
+            slot->info.state = RS485_BREAKER_CLOSED;
+            slot->info.failures = 0;
+            slot->backoff_shift = 0;
+        } else {
+            if (slot->info.failures < UINT8_MAX) {
+                slot->info.failures++;
+            }
+            if (before == RS485_BREAKER_HALF_OPEN) {
+                // 探测失败：延长等待后再探
+                if (slot->backoff_shift < 16) {
+                    slot->backoff_shift++;
+                }
+                slot->info.state = RS485_BREAKER_OPEN;
+            } else if (before == RS485_BREAKER_CLOSED && s_config.threshold != 0 &&
+                       slot->info.failures >= s_config.threshold) {
+                slot->info.state = RS485_BREAKER_OPEN;
+                slot->info.trips++;
+                slot->backoff_shift = 0;
+            }
+            if (slot->info.state == RS485_BREAKER_OPEN) {
+                wait_ms = rs485_breaker_wait_ms(slot->backoff_shift);
+                slot->probe_at_us = now_us + (int64_t)wait_ms * 1000;
+            }
+        }
+        after = slot->info.state;
+    }
+    portEXIT_CRITICAL(&s_breaker_lock);
+
+    if (before == RS485_BREAKER_CLOSED && after == RS485_BREAKER_OPEN) {
+        ESP_LOGW(TAG, "UART%d slave 0x%02X not responding, circuit open (probe in %lu ms)", uart_num, address,
+                 (unsigned long)wait_ms);
+    } else if (before != RS485_BREAKER_CLOSED && after == RS485_BREAKER_CLOSED) {
+        ESP_LOGI(TAG, "UART%d slave 0x%02X responding again, circuit closed", uart_num, address);
+    }
+}
+
+// 复制快照并换算下一次探测的剩余时间；调用者需在临界区内
+static void rs485_breaker_copy_locked(const rs485_breaker_slot_t *slot, int64_t now_us,
+                                      rs485_breaker_info_t *info) {
+    *info = slot->info;
+    info->next_probe_ms = 0;
+    if (slot->info.state == RS485_BREAKER_OPEN && slot->probe_at_us > now_us) {
+        info->next_probe_ms = (uint32_t)((slot->probe_at_us - now_us) / 1000);
+    }
+}
+
+bool rs485_breaker_get(uart_port_t uart_num, uint8_t address, rs485_breaker_info_t *info) {
+    if (info == NULL) {
+        return false;
+    }
+    int64_t now_us = esp_timer_get_time();
+    portENTER_CRITICAL(&s_breaker_lock);
+    rs485_breaker_slot_t *slot = rs485_breaker_slot_locked(uart_num, address, false);
+    if (slot != NULL) {
+        rs485_breaker_copy_locked(slot, now_us, info);
+    }
+    portEXIT_CRITICAL(&s_breaker_lock);
+    return slot != NULL;
+}
+
+size_t rs485_breaker_get_all(rs485_breaker_info_t *info, size_t max_devices) {
+    if (info == NULL) {
+        return 0;
+    }
+    int64_t now_us = esp_timer_get_time();
+    portENTER_CRITICAL(&s_breaker_lock);
+    size_t count = s_slot_count < max_devices ? s_slot_count : max_devices;
+    for (size_t i = 0; i < count; i++) {
+        rs485_breaker_copy_locked(&s_slots[i], now_us, &info[i]);
+    }
+    portEXIT_CRITICAL(&s_breaker_lock);
+    return count;
+}
+
+void rs485_breaker_reset(void) {
+    portENTER_CRITICAL(&s_breaker_lock);
+    for (size_t i = 0; i < s_slot_count; i++) {
+        s_slots[i].info.state = RS485_BREAKER_CLOSED;
+        s_slots[i].info.failures = 0;
+        s_slots[i].backoff_shift = 0;
+    }
+    portEXIT_CRITICAL(&s_breaker_lock);
+}
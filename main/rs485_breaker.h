@@ -0,0 +1,93 @@
+#ifndef RS485_BREAKER_H
+#define RS485_BREAKER_H
+
+#include "driver/uart.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// 同时跟踪的设备数（按 UART 端口 + 从站地址区分）
+#define RS485_BREAKER_MAX_DEVICES 32
+
+// 默认参数：连续 3 次事务无应答即断开，1 秒后首次探测，
+// 探测失败则间隔翻倍，最长 30 秒
+#define RS485_BREAKER_DEFAULT_THRESHOLD 3
+#define RS485_BREAKER_DEFAULT_PROBE_MS 1000
+#define RS485_BREAKER_DEFAULT_PROBE_MAX_MS 30000
+
+// 断路器状态
+typedef enum {
+  RS485_BREAKER_CLOSED = 0, // 正常收发
+  RS485_BREAKER_OPEN,       // 设备无应答，事务直接失败不占总线
+  RS485_BREAKER_HALF_OPEN,  // 放行一次探测，其余事务仍直接失败
+} rs485_breaker_state_t;
+
+// 断路器参数
+typedef struct {
+  uint8_t threshold;     // 连续无应答事务数达到此值即断开，0 表示停用
+  uint32_t probe_ms;     // 断开后首次探测的等待时间
+  uint32_t probe_max_ms; // 探测连续失败时等待时间翻倍的上限
+} rs485_breaker_config_t;
+
+// 单个设备的断路器快照
+typedef struct {
+  uint8_t uart_num;
+  uint8_t address;
+  rs485_breaker_state_t state;
+  uint8_t failures;         // 当前连续无应答事务数
+  uint32_t trips;           // 由闭合转为断开的次数
+  uint32_t probes;          // 已放行的探测次数
+  uint32_t rejected;        // 因断开被直接拒绝的事务数
+  uint32_t next_probe_ms;   // 断开时距下一次探测的时间
+} rs485_breaker_info_t;
+
+/**
+ * @brief 设置断路器参数（对所有设备生效）
+ */
+void rs485_breaker_configure(const rs485_breaker_config_t *config);
+
+/**
+ * @brief 事务发送前调用，判断是否允许占用总线
+ *
+ * 断开状态下到达探测时间时转为半开并放行本次事务，调用者须随后
+ * 调用 rs485_breaker_report() 报告结果。广播地址总是放行。
+ *
+ * @param probe 输出：本次事务是否为探测（可为 NULL），探测不应重试
+ * @return true 允许发送, false 断路器断开，事务应直接失败
+ */
+bool rs485_breaker_admit(uart_port_t uart_num, uint8_t address, bool *probe);
+
+/**
+ * @brief 报告一次事务的结果（含重试后的最终结果）
+ * @param responded 设备是否有应答；CRC 错误、异常应答也算有应答
+ */
+void rs485_breaker_report(uart_port_t uart_num, uint8_t address,
+                          bool responded);
+
+/**
+ * @brief 读取单个设备的断路器状态
+ * @return true 找到, false 该设备尚无记录（视为闭合）
+ */
+bool rs485_breaker_get(uart_port_t uart_num, uint8_t address,
+                       rs485_breaker_info_t *info);
+
+/**
+ * @brief 读取所有设备的断路器状态
+ * @return 复制的设备数
+ */
+size_t rs485_breaker_get_all(rs485_breaker_info_t *info, size_t max_devices);
+
+/**
+ * @brief 把所有设备恢复为闭合（如重新接线后手动复位）
+ */
+void rs485_breaker_reset(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // RS485_BREAKER_H
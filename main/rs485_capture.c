@@ -0,0 +1,169 @@
+#include "rs485_capture.h"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include <stdlib.h>
+#include <string.h>
+
+static const char *TAG = "RS485_CAPTURE";
+
+// 导出时每次交给回调的最大字节数
+#define RS485_CAPTURE_EXPORT_CHUNK 64
+
+static portMUX_TYPE s_capture_lock = portMUX_INITIALIZER_UNLOCKED;
+static uint8_t *s_ring = NULL;
+static size_t s_size = 0;
+static size_t s_head = 0; // 下一次写入位置
+static size_t s_used = 0; // 已占用字节数，最老记录从 (s_head - s_used) 开始
+static uint32_t s_records = 0;
+static uint32_t s_dropped = 0;
+static int64_t s_last_us = 0;
+static volatile bool s_enabled = false;
+
+// 环形读写；调用者需持有锁或已暂停记录
+static void ring_write(size_t pos, const uint8_t *data, size_t length) {
+    size_t first = s_size - pos < length ? s_size - pos : length;
+    memcpy(&s_ring[pos], data, first);
+    if (first < length) {
+        memcpy(s_ring, data + first, length - first);
+    }
+}
+
+static void ring_read(size_t pos, uint8_t *data, size_t length) {
+    size_t first = s_size - pos < length ? s_size - pos : length;
+    memcpy(data, &s_ring[pos], first);
+    if (first < length) {
+        memcpy(data + first, s_ring, length - first);
+    }
+}
+
+static size_t ring_tail(void) {
+    return (s_head + s_size - s_used) % s_size;
+}
+
+bool rs485_capture_start(size_t size) {
+    if (s_ring == NULL) {
+        // 抓包只在导出时顺序读取，PSRAM 足够；没有 PSRAM 时退回内部 RAM
+        uint8_t *ring = heap_caps_malloc(size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+        if (ring == NULL) {
+            ring = heap_caps_malloc(size, MALLOC_CAP_8BIT);
+        }
+        if (ring == NULL) {
+            ESP_LOGE(TAG, "Failed to allocate %u byte capture ring", (unsigned)size);
+            return false;
+        }
+        portENTER_CRITICAL(&s_capture_lock);
+        s_ring = ring;
+        s_size = size;
+        portEXIT_CRITICAL(&s_capture_lock);
+        rs485_capture_clear();
+    }
+    s_enabled = true;
+    ESP_LOGI(TAG, "Capturing into %u byte ring", (unsigned)s_size);
+    return true;
+}
+
+void rs485_capture_stop(void) {
+    s_enabled = false;
+}
+
+void rs485_capture_clear(void) {
+    portENTER_CRITICAL(&s_capture_lock);
+    s_head = 0;
+    s_used = 0;
+    s_records = 0;
+    s_dropped = 0;
+    s_last_us = 0;
+    portEXIT_CRITICAL(&s_capture_lock);
+}
+
+void rs485_capture_record(uint8_t uart_num, uint8_t flags, const uint8_t *data, size_t length,
+                          int64_t timestamp_us) {
+    if (!s_enabled) {
+        return;
+    }
+    size_t need = RS485_CAPTURE_RECORD_HEADER_LEN + length;
+
+    portENTER_CRITICAL(&s_capture_lock);
+    if (!s_enabled || need > s_size) {
+        portEXIT_CRITICAL(&s_capture_lock);
+        return;
+    }
+    // 空间不足时整条丢弃最老记录
+    while (s_size - s_used < need) {
+        uint8_t hdr[RS485_CAPTURE_RECORD_HEADER_LEN];
+        rs485_capture_record_t old;
+        ring_read(ring_tail(), hdr, sizeof(hdr));
+        rs485_capture_decode_header(hdr, &old);
+        s_used -= RS485_CAPTURE_RECORD_HEADER_LEN + old.length;
+        s_records--;
+        s_dropped++;
+    }
+
+    int64_t delta = s_records > 0 || s_dropped > 0 ? timestamp_us - s_last_us : 0;
+    uint32_t delta_us = delta < 0 ? 0 : (delta > UINT32_MAX ? UINT32_MAX : (uint32_t)delta);
+    uint8_t hdr[RS485_CAPTURE_RECORD_HEADER_LEN] = {
+        (uint8_t)delta_us,        (uint8_t)(delta_us >> 8), (uint8_t)(delta_us >> 16), (uint8_t)(delta_us >> 24),
+        (uint8_t)length,          (uint8_t)(length >> 8),   flags,                     uart_num,
+    };
+    ring_write(s_head, hdr, sizeof(hdr));
+    ring_write((s_head + sizeof(hdr)) % s_size, data, length);
+    s_head = (s_head + need) % s_size;
+    s_used += need;
+    s_records++;
+    s_last_us = timestamp_us;
+    portEXIT_CRITICAL(&s_capture_lock);
+}
+
+size_t rs485_capture_export(rs485_capture_writer_t writer, void *user_ctx) {
+    if (writer == NULL || s_ring == NULL) {
+        return 0;
+    }
+    // 暂停记录：锁内置位后不会再有新的写入开始
+    portENTER_CRITICAL(&s_capture_lock);
+    bool was_enabled = s_enabled;
+    s_enabled = false;
+    size_t pos = ring_tail();
+    size_t remaining = s_used;
+    portEXIT_CRITICAL(&s_capture_lock);
+
+    uint8_t buf[RS485_CAPTURE_EXPORT_CHUNK];
+    const uint8_t file_hdr[RS485_CAPTURE_FILE_HEADER_LEN] = {'R', '4', '8', '5', RS485_CAPTURE_VERSION, 0, 0, 0};
+    size_t exported = 0;
+    bool ok = writer(file_hdr, sizeof(file_hdr), user_ctx);
+
+    while (ok && remaining >= RS485_CAPTURE_RECORD_HEADER_LEN) {
+        rs485_capture_record_t rec;
+        ring_read(pos, buf, RS485_CAPTURE_RECORD_HEADER_LEN);
+        rs485_capture_decode_header(buf, &rec);
+        if (exported == 0) {
+            memset(buf, 0, 4); // 首条记录的时间差以 0 起算
+        }
+        ok = writer(buf, RS485_CAPTURE_RECORD_HEADER_LEN, user_ctx);
+        pos = (pos + RS485_CAPTURE_RECORD_HEADER_LEN) % s_size;
+
+        for (size_t done = 0; ok && done < rec.length;) {
+            size_t n = rec.length - done < sizeof(buf) ? rec.length - done : sizeof(buf);
+            ring_read(pos, buf, n);
+            ok = writer(buf, n, user_ctx);
+            pos = (pos + n) % s_size;
+            done += n;
+        }
+        remaining -= RS485_CAPTURE_RECORD_HEADER_LEN + rec.length;
+        exported++;
+    }
+
+    s_enabled = was_enabled;
+    return exported;
+}
+
+void rs485_capture_get_stats(uint32_t *records, uint32_t *dropped) {
+    portENTER_CRITICAL(&s_capture_lock);
+    if (records != NULL) {
+        *records = s_records;
+    }
+    if (dropped != NULL) {
+        *dropped = s_dropped;
+    }
+    portEXIT_CRITICAL(&s_capture_lock);
+}
@@ -0,0 +1,107 @@
+#ifndef RS485_CAPTURE_H
+#define RS485_CAPTURE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * 抓包格式（小端），导出流 = 文件头 + 若干记录：
+ *
+ *   文件头 8 字节: "R485" 版本(1) 保留(1) 保留(2)
+ *   记录   8 字节: 距上一记录的时间差 us(4) 帧长(2) 标志(1) UART(1)
+ *                  其后为完整帧内容（帧长字节）
+ *
+ * 时间差以首条记录为 0；超过 UINT32_MAX 时截到 UINT32_MAX。
+ * 此文件不依赖 ESP-IDF，离线回放工具直接包含。
+ */
+#define RS485_CAPTURE_MAGIC "R485"
+#define RS485_CAPTURE_VERSION 1
+#define RS485_CAPTURE_FILE_HEADER_LEN 8
+#define RS485_CAPTURE_RECORD_HEADER_LEN 8
+
+// 记录标志
+#define RS485_CAPTURE_FLAG_RX 0x01        // 0 为本机发送，1 为本机接收
+#define RS485_CAPTURE_FLAG_CRC_ERROR 0x02 // 接收时 CRC 错误
+
+// 解析后的记录头
+typedef struct {
+  uint32_t delta_us;
+  uint16_t length;
+  uint8_t flags;
+  uint8_t uart_num;
+} rs485_capture_record_t;
+
+/**
+ * @brief 导出回调，按顺序接收导出流的各段
+ * @return true 继续, false 中止导出
+ */
+typedef bool (*rs485_capture_writer_t)(const uint8_t *data, size_t length,
+                                       void *user_ctx);
+
+/**
+ * @brief 分配抓包环（优先 PSRAM）并开始记录
+ * @param size 环大小（字节），写满后丢弃最老记录
+ * @return true 成功, false 内存不足
+ */
+bool rs485_capture_start(size_t size);
+
+/**
+ * @brief 停止记录（保留已抓内容以便导出）
+ */
+void rs485_capture_stop(void);
+
+/**
+ * @brief 清空抓包环
+ */
+void rs485_capture_clear(void);
+
+/**
+ * @brief 记录一帧，由 RS485 收发路径调用；未开始时立即返回
+ * @param uart_num 总线所在 UART 端口
+ * @param flags RS485_CAPTURE_FLAG_*
+ * @param data 完整帧
+ * @param length 帧长
+ * @param timestamp_us 帧时刻（esp_timer 时间）
+ */
+void rs485_capture_record(uint8_t uart_num, uint8_t flags, const uint8_t *data,
+                          size_t length, int64_t timestamp_us);
+
+/**
+ * @brief 导出当前抓包内容（文件头 + 全部记录），在调用者上下文中执行
+ *
+ * 导出期间暂停记录，导出后恢复原状态。
+ *
+ * @param writer 导出回调（写文件、串口或网络）
+ * @param user_ctx 用户参数
+ * @return 导出的记录数
+ */
+size_t rs485_capture_export(rs485_capture_writer_t writer, void *user_ctx);
+
+/**
+ * @brief 读取统计：当前记录数与因环满丢弃的记录数
+ */
+void rs485_capture_get_stats(uint32_t *records, uint32_t *dropped);
+
+/**
+ * @brief 解析一条记录头（离线工具与导出共用）
+ * @param buf 至少 RS485_CAPTURE_RECORD_HEADER_LEN 字节
+ */
+static inline void rs485_capture_decode_header(const uint8_t *buf,
+                                               rs485_capture_record_t *rec) {
+  rec->delta_us = (uint32_t)buf[0] | ((uint32_t)buf[1] << 8) |
+                  ((uint32_t)buf[2] << 16) | ((uint32_t)buf[3] << 24);
+  rec->length = (uint16_t)(buf[4] | (buf[5] << 8));
+  rec->flags = buf[6];
+  rec->uart_num = buf[7];
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // RS485_CAPTURE_H
@@ -1,215 +1,1081 @@
 #include "rs485_comm.h"
+#include "rs485_breaker.h"
+#include "rs485_capture.h"
+#include "rs485_crc.h"
+#include "rs485_devstats.h"
+#include "rs485_frames.h"
+#include "rs485_parser.h"
+#include "rs485_trace.h"
 #include "driver/uart.h"
 #include "esp_log.h"
+#include "esp_rom_sys.h"
+#include "esp_timer.h"
 #include "sdkconfig.h"
 #include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
 #include "freertos/task.h"
+#include <stdio.h>
 #include <string.h>
 
 static const char *TAG = "RS485";
-static uart_port_t s_uart_num = UART_NUM_MAX;
-static bool s_initialized = false;
 
-// RS485 命令固定前缀 (根据图片描述: 01 06 00 C2 00)
-#define RS485_CMD_PREFIX_0 0x01
-#define RS485_CMD_PREFIX_1 0x06
-#define RS485_CMD_PREFIX_2 0x00
-#define RS485_CMD_PREFIX_3 0xC2
-#define RS485_CMD_PREFIX_4 0x00
+_Static_assert(RS485_PARSER_MAX_FRAME == RS485_FRAME_MAX_LEN, "parser frame limit must match the bus");
 
-// 命令总长度（前缀5字节 + 命令1字节 + CRC2字节 + 固定后缀2字节00 00）
-#define RS485_CMD_TOTAL_LENGTH 10
+// UART 驱动事件队列与 RX 任务
+#define RS485_UART_QUEUE_SIZE 20
+#define RS485_RX_TASK_STACK_SIZE 4096
+#define RS485_RX_TASK_PRIORITY 12 // 高于 LVGL 任务，保证帧边界及时切分
 
-bool rs485_init(uart_port_t uart_num, int tx_pin, int rx_pin, int baud_rate) {
-    if (s_initialized) {
-        ESP_LOGW(TAG, "RS485 already initialized");
+// 接收帧环：RX 任务（唯一生产者）把帧直接读进静态接收区，描述符环
+// 只记录位置，消费者按序取用并归还，整个接收路径不复制帧数据
+#define RS485_RX_RING_LEN 8 // 必须为 2 的幂
+#define RS485_RX_RING_MASK (RS485_RX_RING_LEN - 1)
+#define RS485_RX_ARENA_SIZE 2048
+
+// IDF 驱动默认的 RX FIFO 满阈值；快速路径按解析进度临时调低
+#define RS485_RX_FULL_THRESHOLD_DEFAULT 120
+
+typedef struct {
+    uint16_t offset; // 帧在接收区中的起点
+    uint16_t length;
+    rs485_frame_status_t status;
+    int64_t timestamp_us;
+} rs485_frame_desc_t;
+
+// 异步发送队列与 TX 任务
+#define RS485_TX_QUEUE_LEN 16
+#define RS485_TX_TASK_STACK_SIZE 4096
+#define RS485_TX_TASK_PRIORITY 10
+
+// 每个优先级通道可同时排队的任务数上限
+#define RS485_LANE_MAX_WAITERS 16
+
+// 组命令等待每个塔灯回显时允许的应答延迟（毫秒）
+#define RS485_ECHO_TURNAROUND_MS 20
+
+typedef enum {
+    RS485_JOB_COMMAND,
+    RS485_JOB_QUERY_DEVICES,
+} rs485_job_type_t;
+
+typedef struct {
+    rs485_job_type_t type;
+    rs485_cmd_t cmd;
+    rs485_done_cb_t done_cb;
+    void *user_ctx;
+} rs485_tx_job_t;
+
+// 接收 CRC 状态：边收边算，同时保留去掉末尾 2 字节时的状态，
+// 以便识别带 00 00 后缀的塔灯帧而无需重扫整帧
+typedef struct {
+    uint16_t crc;    // 累计到最后一个字节
+    uint16_t crc_m1; // 不含最后 1 字节
+    uint16_t crc_m2; // 不含最后 2 字节
+} rs485_rx_crc_t;
+
+struct rs485_bus {
+    bool in_use;
+    uart_port_t uart_num;
+
+    QueueHandle_t uart_queue;     // UART 驱动事件队列
+    QueueHandle_t tx_queue;       // 异步发送任务队列
+    SemaphoreHandle_t rx_frame_sem; // 已发布未取出的帧数，唤醒消费者
+    TaskHandle_t rx_task;
+    TaskHandle_t tx_task;
+
+    // 总线仲裁：按优先级通道串行化总线访问（TX 任务与同步 API）
+    portMUX_TYPE lane_lock;
+    rs485_lanes_t lanes;
+    SemaphoreHandle_t lane_sem[RS485_LANE_COUNT]; // 各通道的等待者在此阻塞
+    int64_t hold_start_us;                        // 当前持有者获得总线的时间
+
+    rs485_frame_cb_t frame_cb;
+    void *frame_cb_ctx;
+    rs485_rx_crc_t rx_crc;
+
+    // 快速路径：逐块解析，只有完整、CRC 正确且地址匹配的帧才唤醒消费者
+    bool fast_path;
+    rs485_parser_t parser;
+    uint8_t rx_full_threshold; // 当前设置的 FIFO 满阈值，仅快速路径使用
+
+    // 首字节检测：请求方置位后，RX 任务在下一块数据到达时记下时刻并清除
+    bool rx_first_byte_armed;
+    int64_t rx_first_byte_us;
+
+    // 单生产者/单消费者接收帧环
+    rs485_frame_desc_t rx_ring[RS485_RX_RING_LEN];
+    uint32_t rx_head;          // 已发布帧计数，仅 RX 任务写
+    uint32_t rx_tail;          // 已归还帧计数，仅消费者写
+    uint32_t rx_read;          // 已取出帧计数，仅消费者使用
+    uint16_t rx_write_offset;  // 下一帧在接收区中的起点，仅 RX 任务使用
+    uint8_t rx_arena[RS485_RX_ARENA_SIZE];
+
+    // 总线时序（由波特率与校验推算）
+    int baud_rate;
+    uart_parity_t parity;
+    uint8_t rx_timeout_symbols;
+    uint32_t char_time_us;            // 一个字符的传输时间
+    uint32_t frame_gap_us;            // 帧间最小静默 t3.5
+    bool hw_half_duplex;              // 是否由 UART 硬件控制 DE/RE
+    volatile int64_t last_activity_us; // 最近一次发送完成或收到帧的时间
+    int64_t tx_start_us;              // 最近一帧开始发送的时间（持有总线者读写）
+
+    rs485_bus_stats_t stats;
+};
+
+// 每个 UART 端口最多一条总线，静态分配
+static rs485_bus_t s_buses[UART_NUM_MAX];
+static rs485_bus_t *s_default_bus = NULL;
+
+// 一个字符的传输时间（微秒），bits_per_char 含起始位、校验位和停止位
+static uint32_t rs485_char_time_us(int baud_rate, int bits_per_char) {
+    return (uint32_t)((bits_per_char * 1000000ULL + baud_rate - 1) / baud_rate);
+}
+
+// Modbus RTU 帧间静默时间 t3.5（微秒）
+// 波特率高于 19200 时规范规定 t3.5 固定为 1750us
+static uint32_t rs485_t35_us(int baud_rate, int bits_per_char) {
+    if (baud_rate > 19200) {
+        return 1750;
+    }
+    return (rs485_char_time_us(baud_rate, bits_per_char) * 7 + 1) / 2;
+}
+
+// t3.5 对应的 UART RX 超时阈值（单位：字符时间）
+static uint8_t rs485_t35_timeout_symbols(int baud_rate, int bits_per_char) {
+    uint32_t char_us = rs485_char_time_us(baud_rate, bits_per_char);
+    uint32_t symbols = (rs485_t35_us(baud_rate, bits_per_char) + char_us - 1) / char_us;
+    if (symbols < 1) {
+        symbols = 1;
+    } else if (symbols > 126) { // 硬件阈值上限
+        symbols = 126;
+    }
+    return (uint8_t)symbols;
+}
+
+// 按当前波特率与校验重算时序并设置 RX 超时；8N1 每字符 10 位，带校验 11 位
+static esp_err_t rs485_apply_timing(rs485_bus_t *bus) {
+    int bits_per_char = bus->parity == UART_PARITY_DISABLE ? 10 : 11;
+    bus->char_time_us = rs485_char_time_us(bus->baud_rate, bits_per_char);
+    bus->frame_gap_us = rs485_t35_us(bus->baud_rate, bits_per_char);
+    bus->rx_timeout_symbols = rs485_t35_timeout_symbols(bus->baud_rate, bits_per_char);
+    return uart_set_rx_timeout(bus->uart_num, bus->rx_timeout_symbols);
+}
+
+static char rs485_parity_char(uart_parity_t parity) {
+    return parity == UART_PARITY_EVEN ? 'E' : (parity == UART_PARITY_ODD ? 'O' : 'N');
+}
+
+static void rs485_rx_crc_reset(rs485_rx_crc_t *c) {
+    c->crc = RS485_CRC16_INIT;
+    c->crc_m1 = RS485_CRC16_INIT;
+    c->crc_m2 = RS485_CRC16_INIT;
+}
+
+static void rs485_rx_crc_feed(rs485_rx_crc_t *c, const uint8_t *data, size_t length) {
+    if (length >= 2) {
+        c->crc_m2 = rs485_crc16_update(c->crc, data, length - 2);
+        c->crc_m1 = rs485_crc16_update_byte(c->crc_m2, data[length - 2]);
+        c->crc = rs485_crc16_update_byte(c->crc_m1, data[length - 1]);
+    } else if (length == 1) {
+        c->crc_m2 = c->crc_m1;
+        c->crc_m1 = c->crc;
+        c->crc = rs485_crc16_update_byte(c->crc, data[0]);
+    }
+}
+
+// 含 CRC 的完整 Modbus 帧累计结果为 0；塔灯帧在 CRC 之后还有 00 00 后缀
+static bool rs485_rx_crc_ok(const rs485_rx_crc_t *c, const uint8_t *frame, size_t length) {
+    if (c->crc == 0) {
+        return true;
+    }
+    return length >= 4 && frame[length - 2] == 0x00 && frame[length - 1] == 0x00 && c->crc_m2 == 0;
+}
+
+// 按通道取得总线：空闲时立即获得，否则排队等释放者直接转交
+static void rs485_bus_lock(rs485_bus_t *bus, rs485_lane_t lane) {
+    int64_t start_us = esp_timer_get_time();
+    portENTER_CRITICAL(&bus->lane_lock);
+    bool granted = rs485_lanes_acquire(&bus->lanes, lane);
+    portEXIT_CRITICAL(&bus->lane_lock);
+    if (!granted) {
+        xSemaphoreTake(bus->lane_sem[lane], portMAX_DELAY);
+    }
+
+    int64_t now_us = esp_timer_get_time();
+    portENTER_CRITICAL(&bus->lane_lock);
+    rs485_lanes_record_wait(&bus->lanes, lane, granted ? 0 : (uint32_t)(now_us - start_us));
+    bus->hold_start_us = now_us;
+    portEXIT_CRITICAL(&bus->lane_lock);
+}
+
+static void rs485_bus_unlock(rs485_bus_t *bus) {
+    uint32_t hold_us = (uint32_t)(esp_timer_get_time() - bus->hold_start_us);
+    portENTER_CRITICAL(&bus->lane_lock);
+    int next = rs485_lanes_release(&bus->lanes, hold_us);
+    portEXIT_CRITICAL(&bus->lane_lock);
+    if (next >= 0) {
+        xSemaphoreGive(bus->lane_sem[next]);
+    }
+}
+
+// 多帧操作的帧间检查点：有更高通道排队时让出总线再重新排队
+static void rs485_bus_yield(rs485_bus_t *bus, rs485_lane_t lane) {
+    portENTER_CRITICAL(&bus->lane_lock);
+    bool yield = rs485_lanes_should_yield(&bus->lanes, lane);
+    if (yield) {
+        bus->lanes.stats[lane].yields++;
+    }
+    portEXIT_CRITICAL(&bus->lane_lock);
+    if (yield) {
+        rs485_bus_unlock(bus);
+        rs485_bus_lock(bus, lane);
+    }
+}
+
+// 保证距上一次总线活动至少 t3.5，剩余时间不足一个 tick 时忙等
+static void rs485_wait_frame_gap(rs485_bus_t *bus) {
+    int64_t remaining = bus->last_activity_us + bus->frame_gap_us - esp_timer_get_time();
+    if (remaining <= 0) {
+        return;
+    }
+    if (remaining >= portTICK_PERIOD_MS * 1000) {
+        vTaskDelay(remaining / (portTICK_PERIOD_MS * 1000));
+        remaining = bus->last_activity_us + bus->frame_gap_us - esp_timer_get_time();
+    }
+    if (remaining > 0) {
+        esp_rom_delay_us((uint32_t)remaining);
+    }
+}
+
+// 发送一帧并等待最后一位移出；调用者需持有总线（rs485_bus_lock）
+// 硬件半双工模式下 DE 在停止位结束后由 UART 立即释放，无需软件延时
+static bool rs485_write_frame(rs485_bus_t *bus, const uint8_t *data, size_t length) {
+    rs485_wait_frame_gap(bus);
+
+    bus->tx_start_us = esp_timer_get_time();
+    int bytes_written = uart_write_bytes(bus->uart_num, data, length);
+    if (bytes_written != (int)length) {
+        bus->stats.tx_errors++;
+        rs485_trace_record(bus->uart_num, RS485_TRACE_TX_ERROR, data, length);
+        return false;
+    }
+
+    // 超时按实际传输时间计算，另加 2 个 tick 余量
+    uint32_t tx_ms = (uint32_t)((length * bus->char_time_us + 999) / 1000);
+    esp_err_t ret = uart_wait_tx_done(bus->uart_num, pdMS_TO_TICKS(tx_ms) + 2);
+    bus->last_activity_us = esp_timer_get_time();
+    if (ret != ESP_OK) {
+        bus->stats.tx_errors++;
+        rs485_trace_record(bus->uart_num, RS485_TRACE_TX_ERROR, data, length);
+        return false;
+    }
+
+    if (bus->hw_half_duplex) {
+        bool collision = false;
+        uart_get_collision_flag(bus->uart_num, &collision);
+        if (collision) {
+            bus->stats.collisions++;
+            rs485_trace_record(bus->uart_num, RS485_TRACE_COLLISION, data, length);
+            return false;
+        }
+    }
+
+    bus->stats.tx_frames++;
+    bus->stats.tx_bytes += length;
+    rs485_trace_record(bus->uart_num, RS485_TRACE_TX, data, length);
+    rs485_capture_record((uint8_t)bus->uart_num, 0, data, length, bus->last_activity_us);
+    rs485_devstats_record_tx(bus->uart_num, data[0]);
+    return true;
+}
+
+// 为下一帧在接收区中预留 RS485_FRAME_MAX_LEN 字节的连续空间
+// 帧按发布顺序占用接收区，最老的未归还帧之前的区域都不可写
+static bool rs485_rx_reserve(rs485_bus_t *bus) {
+    uint32_t head = bus->rx_head;
+    uint32_t tail = __atomic_load_n(&bus->rx_tail, __ATOMIC_ACQUIRE);
+    if (head == tail) {
+        bus->rx_write_offset = 0; // 环为空，整个接收区可用
+        return true;
+    }
+    if (head - tail >= RS485_RX_RING_LEN) {
+        return false;
+    }
+
+    uint32_t oldest = bus->rx_ring[tail & RS485_RX_RING_MASK].offset;
+    uint32_t wr = bus->rx_write_offset;
+    if (wr > oldest) {
+        if (RS485_RX_ARENA_SIZE - wr >= RS485_FRAME_MAX_LEN) {
+            return true;
+        }
+        if (oldest > RS485_FRAME_MAX_LEN) {
+            bus->rx_write_offset = 0; // 回绕到接收区开头
+            return true;
+        }
+        return false;
+    }
+    // 写位置在最老帧之前：保留至少 1 字节间隔，使 wr == oldest 只表示环为空
+    return oldest - wr > RS485_FRAME_MAX_LEN;
+}
+
+// 帧在 RX 超时（线路静默约 t3.5）之后才上报：最后一个字节的时刻由上报时刻倒推
+static int64_t rs485_rx_last_byte_us(const rs485_bus_t *bus) {
+    return esp_timer_get_time() - (int64_t)bus->rx_timeout_symbols * bus->char_time_us;
+}
+
+// last_byte_us 为帧最后一个字节收完的时刻，下一帧的 t3.5 从这里算起
+static void rs485_dispatch_frame(rs485_bus_t *bus, size_t length, bool crc_ok, int64_t last_byte_us) {
+    const uint8_t *frame = &bus->rx_arena[bus->rx_write_offset];
+    int64_t now = last_byte_us;
+    bus->last_activity_us = now;
+    bus->stats.rx_frames++;
+    bus->stats.rx_bytes += length;
+
+    if (!crc_ok) {
+        bus->stats.rx_crc_errors++;
+    }
+    rs485_trace_record(bus->uart_num, crc_ok ? RS485_TRACE_RX : RS485_TRACE_RX_CRC_ERROR, frame, length);
+    rs485_capture_record((uint8_t)bus->uart_num,
+                         RS485_CAPTURE_FLAG_RX | (crc_ok ? 0 : RS485_CAPTURE_FLAG_CRC_ERROR), frame, length, now);
+
+    rs485_frame_cb_t cb = bus->frame_cb;
+    if (cb != NULL) {
+        cb(frame, length, bus->frame_cb_ctx);
+    }
+
+    // 发布描述符：先写内容，再以 release 语义推进 head
+    uint32_t head = bus->rx_head;
+    rs485_frame_desc_t *desc = &bus->rx_ring[head & RS485_RX_RING_MASK];
+    desc->offset = bus->rx_write_offset;
+    desc->length = (uint16_t)length;
+    desc->status = crc_ok ? RS485_FRAME_OK : RS485_FRAME_CRC_ERROR;
+    desc->timestamp_us = now;
+    __atomic_store_n(&bus->rx_head, head + 1, __ATOMIC_RELEASE);
+    bus->rx_write_offset += (uint16_t)length;
+    xSemaphoreGive(bus->rx_frame_sem);
+}
+
+// 快速路径下按解析进度设置 FIFO 满阈值，使下一次 UART_DATA 恰在长度
+// 可判定或本帧最后一个字节进入 FIFO 时产生；默认阈值 120 下短帧只能等
+// RX 超时才上报，提前发布无从谈起。本帧已按预期长度收完时 FIFO 往往恰好
+// 读空、不会再有 RX 超时，阈值按下一帧的地址与功能码设置，下一帧开头才能
+// 及时上报并据间隔结束本帧；其余已有结果或只能等静默时恢复默认，少打断 CPU
+static void rs485_rx_fast_threshold(rs485_bus_t *bus) {
+    const rs485_parser_t *p = &bus->parser;
+    int want;
+    if (p->result == RS485_PARSE_FRAME || p->result == RS485_PARSE_CRC_ERROR) {
+        want = 2;
+    } else if (p->result != RS485_PARSE_INCOMPLETE || p->open_length) {
+        want = RS485_RX_FULL_THRESHOLD_DEFAULT;
+    } else if (p->expected != 0) {
+        want = p->expected - p->received;
+    } else if (p->count_index != 0) {
+        want = p->count_index + 1 - p->received;
+    } else {
+        want = 2 - p->received; // 地址与功能码
+    }
+    if (want < 1) {
+        want = 1;
+    } else if (want > RS485_RX_FULL_THRESHOLD_DEFAULT) {
+        want = RS485_RX_FULL_THRESHOLD_DEFAULT;
+    }
+    if (want != bus->rx_full_threshold) {
+        uart_set_rx_full_threshold(bus->uart_num, want);
+        bus->rx_full_threshold = (uint8_t)want;
+    }
+}
+
+// 快速路径下解析器给出最终结果后的处理；返回 true 表示本帧已结束
+// length 为本帧已读入的字节数，last_byte_us 为其中最后一个字节收完的时刻。
+// 同一块里预期长度之后的字节（塔灯帧的 00 00 后缀）不属于本帧
+static bool rs485_rx_fast_result(rs485_bus_t *bus, rs485_parse_result_t result, size_t length,
+                                 int64_t last_byte_us) {
+    const uint8_t *frame = &bus->rx_arena[bus->rx_write_offset];
+    if ((result == RS485_PARSE_FRAME || result == RS485_PARSE_CRC_ERROR) && bus->parser.expected != 0 &&
+        bus->parser.expected < length) {
+        last_byte_us -= (int64_t)(length - bus->parser.expected) * bus->char_time_us;
+        length = bus->parser.expected;
+    }
+    switch (result) {
+    case RS485_PARSE_FRAME:
+        // 收满预期长度即发布，不必等 t3.5
+        rs485_dispatch_frame(bus, length, true, last_byte_us);
+        return true;
+    case RS485_PARSE_FOREIGN:
+        // 别的从站的帧：只计数，不记录跟踪、不唤醒任何任务
+        bus->stats.rx_filtered++;
+        return true;
+    case RS485_PARSE_CRC_ERROR:
+        bus->last_activity_us = last_byte_us;
+        bus->stats.rx_frames++;
+        bus->stats.rx_bytes += length;
+        bus->stats.rx_crc_errors++;
+        rs485_trace_record(bus->uart_num, RS485_TRACE_RX_CRC_ERROR, frame, length);
+        rs485_capture_record((uint8_t)bus->uart_num, RS485_CAPTURE_FLAG_RX | RS485_CAPTURE_FLAG_CRC_ERROR, frame,
+                             length, bus->last_activity_us);
+        return true;
+    case RS485_PARSE_OVERRUN:
+    case RS485_PARSE_TRUNCATED:
+        bus->stats.rx_errors++;
+        rs485_trace_record(bus->uart_num, RS485_TRACE_RX_ERROR, NULL, length);
+        return true;
+    default:
         return false;
     }
+}
 
-    ESP_LOGI(TAG, "=== RS485 Initialization Parameters ===");
-    ESP_LOGI(TAG, "UART Port Number: UART_NUM_%d", uart_num);
-    ESP_LOGI(TAG, "TX Pin: GPIO%d", tx_pin);
-    ESP_LOGI(TAG, "RX Pin: GPIO%d", rx_pin);
-    ESP_LOGI(TAG, "Baud Rate: %d", baud_rate);
+// 读出并丢弃本次事件报告的字节。不用 uart_flush_input：驱动缓冲区里可能
+// 已有下一帧的字节，清空还会连带丢掉尚未处理的 RX 超时
+static void rs485_rx_skip_bytes(rs485_bus_t *bus, size_t size) {
+    uint8_t scratch[64];
+    while (size > 0) {
+        int len = uart_read_bytes(bus->uart_num, scratch, size < sizeof(scratch) ? size : sizeof(scratch), 0);
+        if (len <= 0) {
+            break;
+        }
+        size -= (size_t)len;
+    }
+}
+
+// RX 任务看到等待中的应答的第一块数据：记下时刻，FIFO 满阈值恢复默认，
+// 其余字节照常等 RX 超时切帧（快速路径自行管理阈值）
+static void rs485_rx_first_byte(rs485_bus_t *bus) {
+    __atomic_store_n(&bus->rx_first_byte_us, esp_timer_get_time(), __ATOMIC_RELEASE);
+    if (!bus->fast_path) {
+        uart_set_rx_full_threshold(bus->uart_num, RS485_RX_FULL_THRESHOLD_DEFAULT);
+    }
+}
+
+// RX 任务中正在接收的一帧
+typedef struct {
+    size_t len;
+    bool error;
+    bool reserved;
+    bool dropped;
+    bool done;            // 快速路径已得出结果，本帧余下字节直接丢弃
+    int64_t last_byte_us; // 快速路径：最近读出的一块的最后一个字节的时刻
+} rs485_rx_frame_t;
+
+static void rs485_rx_frame_reset(rs485_bus_t *bus, rs485_rx_frame_t *rx) {
+    rx->len = 0;
+    rx->error = false;
+    rx->reserved = false;
+    rx->dropped = false;
+    rx->done = false;
+    rs485_rx_crc_reset(&bus->rx_crc);
+    rs485_parser_reset(&bus->parser);
+}
+
+// 线路静默，结束当前帧；last_byte_us 为本帧最后一个字节收完的时刻
+static void rs485_rx_frame_end(rs485_bus_t *bus, rs485_rx_frame_t *rx, int64_t last_byte_us) {
+    if (rx->dropped) {
+        bus->stats.rx_dropped++;
+        rs485_trace_record(bus->uart_num, RS485_TRACE_RX_DROPPED, NULL, rx->len);
+    } else if (rx->done) {
+        // 可能还有后缀字节；帧已按上报时刻发布，倒推出的时刻可能更早，不往回改
+        if (last_byte_us > bus->last_activity_us) {
+            bus->last_activity_us = last_byte_us;
+        }
+    } else if (rx->len > 0 && !rx->error && bus->fast_path) {
+        rs485_rx_fast_result(bus, rs485_parser_finish(&bus->parser), rx->len, last_byte_us);
+    } else if (rx->len > 0 && !rx->error) {
+        const uint8_t *frame = &bus->rx_arena[bus->rx_write_offset];
+        rs485_dispatch_frame(bus, rx->len, rs485_rx_crc_ok(&bus->rx_crc, frame, rx->len), last_byte_us);
+    } else if (rx->error) {
+        bus->stats.rx_errors++;
+        rs485_trace_record(bus->uart_num, RS485_TRACE_RX_ERROR, NULL, rx->len);
+    }
+    rs485_rx_frame_reset(bus, rx);
+}
+
+// RX 任务：消费 UART 事件，以 RX 超时（线路静默 t3.5）切分完整帧
+// 数据直接读入接收区的预留位置并边收边算 CRC；启用快速路径时
+// 改由解析器按功能码判断帧长，提前发布或就地丢弃
+static void rs485_rx_task(void *arg) {
+    rs485_bus_t *bus = (rs485_bus_t *)arg;
+    uart_event_t event;
+    rs485_rx_frame_t rx = {0};
+    rs485_rx_frame_reset(bus, &rx);
+
+    while (1) {
+        if (xQueueReceive(bus->uart_queue, &event, portMAX_DELAY) != pdTRUE) {
+            continue;
+        }
+
+        switch (event.type) {
+        case UART_DATA: {
+            if (__atomic_exchange_n(&bus->rx_first_byte_armed, false, __ATOMIC_ACQ_REL)) {
+                rs485_rx_first_byte(bus);
+            }
+            // 本块最后一个字节收完的时刻：RX 超时上报的块要倒推超时时间
+            int64_t chunk_end_us = event.timeout_flag ? rs485_rx_last_byte_us(bus) : esp_timer_get_time();
+            if (bus->fast_path && (rx.done || rx.dropped)) {
+                // 快速路径按帧长调低了 FIFO 满阈值，帧尾恰好读空 FIFO 时硬件不再
+                // 报 RX 超时：本块首字节距上一块末字节超过 t3.5 即说明上一帧已结束。
+                // 未收完的帧仍等 RX 超时结束，任务调度的延迟不会把一帧从中间切开
+                int64_t first_byte_us = chunk_end_us - (int64_t)event.size * bus->char_time_us;
+                if (first_byte_us - rx.last_byte_us > (int64_t)bus->frame_gap_us) {
+                    rs485_rx_frame_end(bus, &rx, rx.last_byte_us);
+                }
+            }
+            if (!rx.reserved && !rx.dropped) {
+                rx.reserved = rs485_rx_reserve(bus);
+                rx.dropped = !rx.reserved;
+            }
+            if (rx.dropped || rx.done) {
+                // 消费者未及时归还导致接收区已满，或快速路径已判定本帧：丢弃本次的字节
+                rs485_rx_skip_bytes(bus, event.size);
+            } else {
+                if (rx.len + event.size > RS485_FRAME_MAX_LEN) {
+                    // 超长帧：丢弃已收部分，直到下一次静默；解析器不再接收本帧的字节
+                    rx.len = 0;
+                    rx.error = true;
+                    rs485_rx_crc_reset(&bus->rx_crc);
+                    rs485_parser_reset(&bus->parser);
+                }
+                if (event.size > 0) {
+                    uint8_t *dst = &bus->rx_arena[bus->rx_write_offset + rx.len];
+                    int len = uart_read_bytes(bus->uart_num, dst, event.size, 0);
+                    if (len > 0 && bus->fast_path && !rx.error) {
+                        rx.len += (size_t)len;
+                        rx.done = rs485_rx_fast_result(bus, rs485_parser_feed(&bus->parser, dst, (size_t)len),
+                                                       rx.len, chunk_end_us);
+                    } else if (len > 0) {
+                        rs485_rx_crc_feed(&bus->rx_crc, dst, (size_t)len);
+                        rx.len += (size_t)len;
+                    }
+                }
+            }
+            rx.last_byte_us = chunk_end_us;
+            if (event.timeout_flag) {
+                rs485_rx_frame_end(bus, &rx, rx.last_byte_us);
+            }
+            if (bus->fast_path) {
+                rs485_rx_fast_threshold(bus);
+            }
+            break;
+        }
+        case UART_FIFO_OVF:
+        case UART_BUFFER_FULL:
+            bus->stats.rx_overflows++;
+            rs485_trace_record(bus->uart_num, RS485_TRACE_RX_OVERFLOW, NULL, event.size);
+            uart_flush_input(bus->uart_num);
+            xQueueReset(bus->uart_queue);
+            rs485_rx_frame_reset(bus, &rx);
+            if (bus->fast_path) {
+                rs485_rx_fast_threshold(bus);
+            }
+            break;
+        case UART_FRAME_ERR:
+        case UART_PARITY_ERR:
+            rx.error = true;
+            break;
+        default:
+            break;
+        }
+    }
+}
+
+// TX 任务：依次执行提交的命令，完成后回调通知提交者
+static void rs485_tx_task(void *arg) {
+    rs485_bus_t *bus = (rs485_bus_t *)arg;
+    rs485_tx_job_t job;
+
+    while (1) {
+        if (xQueueReceive(bus->tx_queue, &job, portMAX_DELAY) != pdTRUE) {
+            continue;
+        }
+
+        bool ok = false;
+        switch (job.type) {
+        case RS485_JOB_COMMAND:
+            ok = rs485_bus_send_command(bus, job.cmd);
+            break;
+        case RS485_JOB_QUERY_DEVICES:
+            ok = rs485_bus_query_devices(bus);
+            break;
+        }
+
+        if (job.done_cb != NULL) {
+            job.done_cb(ok, job.user_ctx);
+        }
+    }
+}
+
+static bool rs485_submit_job(rs485_bus_t *bus, const rs485_tx_job_t *job) {
+    if (bus == NULL || !bus->in_use) {
+        ESP_LOGE(TAG, "RS485 not initialized");
+        return false;
+    }
+
+    // 不阻塞调用者：队列满直接拒绝；报警命令插到队首，不排在查询之后
+    bool alarm = job->type == RS485_JOB_COMMAND && rs485_cmd_lane(job->cmd) == RS485_LANE_ALARM;
+    if ((alarm ? xQueueSendToFront(bus->tx_queue, job, 0) : xQueueSend(bus->tx_queue, job, 0)) != pdTRUE) {
+        ESP_LOGW(TAG, "TX queue full, job rejected");
+        return false;
+    }
+    return true;
+}
+
+static void rs485_bus_release(rs485_bus_t *bus) {
+    if (bus->tx_task != NULL) {
+        vTaskDelete(bus->tx_task);
+    }
+    if (bus->rx_task != NULL) {
+        vTaskDelete(bus->rx_task);
+    }
+    uart_driver_delete(bus->uart_num);
+    if (bus->rx_frame_sem != NULL) {
+        vSemaphoreDelete(bus->rx_frame_sem);
+    }
+    if (bus->tx_queue != NULL) {
+        vQueueDelete(bus->tx_queue);
+    }
+    for (int lane = 0; lane < RS485_LANE_COUNT; lane++) {
+        if (bus->lane_sem[lane] != NULL) {
+            vSemaphoreDelete(bus->lane_sem[lane]);
+        }
+    }
+    memset(bus, 0, sizeof(*bus));
+}
+
+rs485_bus_t *rs485_bus_open(const rs485_bus_config_t *config) {
+    if (config == NULL || config->uart_num < 0 || config->uart_num >= UART_NUM_MAX) {
+        ESP_LOGE(TAG, "Invalid bus config");
+        return NULL;
+    }
+    uart_port_t uart_num = config->uart_num;
+    rs485_bus_t *bus = &s_buses[uart_num];
+    if (bus->in_use) {
+        ESP_LOGW(TAG, "RS485 bus on UART%d already open", uart_num);
+        return NULL;
+    }
 
     uart_config_t uart_config = {
-        .baud_rate = baud_rate,
+        .baud_rate = config->baud_rate,
         .data_bits = UART_DATA_8_BITS,
-        .parity = UART_PARITY_DISABLE,
+        .parity = config->parity,
         .stop_bits = UART_STOP_BITS_1,
         .flow_ctrl = UART_HW_FLOWCTRL_DISABLE,
         .source_clk = UART_SCLK_DEFAULT,
     };
 
-    ESP_LOGI(TAG, "UART Configuration:");
-    ESP_LOGI(TAG, "  Baud Rate: %d", uart_config.baud_rate);
-    ESP_LOGI(TAG, "  Data Bits: %s", uart_config.data_bits == UART_DATA_5_BITS ? "5" :
-                                      uart_config.data_bits == UART_DATA_6_BITS ? "6" :
-                                      uart_config.data_bits == UART_DATA_7_BITS ? "7" :
-                                      uart_config.data_bits == UART_DATA_8_BITS ? "8" :
-                                      uart_config.data_bits == UART_DATA_BITS_MAX ? "MAX" : "UNKNOWN");
-    ESP_LOGI(TAG, "  Parity: %s", uart_config.parity == UART_PARITY_DISABLE ? "DISABLE" : 
-                                   uart_config.parity == UART_PARITY_EVEN ? "EVEN" : 
-                                   uart_config.parity == UART_PARITY_ODD ? "ODD" : "UNKNOWN");
-    ESP_LOGI(TAG, "  Stop Bits: %s", uart_config.stop_bits == UART_STOP_BITS_1 ? "1" :
-                                      uart_config.stop_bits == UART_STOP_BITS_1_5 ? "1.5" :
-                                      uart_config.stop_bits == UART_STOP_BITS_2 ? "2" : "UNKNOWN");
-    ESP_LOGI(TAG, "  Flow Control: %s", uart_config.flow_ctrl == UART_HW_FLOWCTRL_DISABLE ? "DISABLE" :
-                                          uart_config.flow_ctrl == UART_HW_FLOWCTRL_RTS ? "RTS" :
-                                          uart_config.flow_ctrl == UART_HW_FLOWCTRL_CTS ? "CTS" :
-                                          uart_config.flow_ctrl == UART_HW_FLOWCTRL_CTS_RTS ? "CTS_RTS" : "UNKNOWN");
-    ESP_LOGI(TAG, "  Source Clock: %s", uart_config.source_clk == UART_SCLK_APB ? "APB" :
-                                         uart_config.source_clk == UART_SCLK_RTC ? "RTC" :
-                                         uart_config.source_clk == UART_SCLK_XTAL ? "XTAL" :
-                                         uart_config.source_clk == UART_SCLK_DEFAULT ? "DEFAULT" : "UNKNOWN");
-
     // 中断分配标志（参照 uart_echo_example）
     int intr_alloc_flags = 0;
 #if CONFIG_UART_ISR_IN_IRAM
     intr_alloc_flags = ESP_INTR_FLAG_IRAM;
-    ESP_LOGI(TAG, "Interrupt Allocation: IRAM");
-#else
-    ESP_LOGI(TAG, "Interrupt Allocation: Default");
 #endif
 
-    ESP_LOGI(TAG, "UART Driver Install:");
-    ESP_LOGI(TAG, "  RX Buffer Size: 1024 bytes");
-    ESP_LOGI(TAG, "  TX Buffer Size: 1024 bytes");
-    ESP_LOGI(TAG, "  Queue Size: 0 (no event queue)");
-    ESP_LOGI(TAG, "  Interrupt Flags: 0x%X", intr_alloc_flags);
-
-    esp_err_t ret = uart_driver_install(uart_num, 1024, 1024, 0, NULL, intr_alloc_flags);
+    esp_err_t ret = uart_driver_install(uart_num, 1024, 1024, RS485_UART_QUEUE_SIZE, &bus->uart_queue,
+                                        intr_alloc_flags);
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "Failed to install UART driver: %s", esp_err_to_name(ret));
-        return false;
+        return NULL;
     }
-    ESP_LOGI(TAG, "✓ UART driver installed successfully");
+    bus->uart_num = uart_num;
 
     ret = uart_param_config(uart_num, &uart_config);
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "Failed to configure UART: %s", esp_err_to_name(ret));
-        uart_driver_delete(uart_num);
-        return false;
+        goto err;
     }
-    ESP_LOGI(TAG, "✓ UART parameters configured successfully");
 
-    ret = uart_set_pin(uart_num, tx_pin, rx_pin, UART_PIN_NO_CHANGE, UART_PIN_NO_CHANGE);
+    // DE/RE 接到 RTS，由 UART 硬件控制收发方向
+    ret = uart_set_pin(uart_num, config->tx_pin, config->rx_pin,
+                       config->de_pin >= 0 ? config->de_pin : UART_PIN_NO_CHANGE, UART_PIN_NO_CHANGE);
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "Failed to set UART pins: %s", esp_err_to_name(ret));
-        uart_driver_delete(uart_num);
-        return false;
+        goto err;
     }
-    ESP_LOGI(TAG, "✓ UART pins set successfully");
-    ESP_LOGI(TAG, "  RTS Pin: UART_PIN_NO_CHANGE");
-    ESP_LOGI(TAG, "  CTS Pin: UART_PIN_NO_CHANGE");
 
-    s_uart_num = uart_num;
-    s_initialized = true;
-    ESP_LOGI(TAG, "=== RS485 Initialization Complete ===");
-    ESP_LOGI(TAG, "RS485 ready on UART%d, TX=GPIO%d, RX=GPIO%d, Baud=%d", 
-             uart_num, tx_pin, rx_pin, baud_rate);
-    
-    return true;
+    bus->hw_half_duplex = config->de_pin >= 0;
+    if (bus->hw_half_duplex) {
+        ret = uart_set_mode(uart_num, UART_MODE_RS485_HALF_DUPLEX);
+        if (ret != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to set RS485 half-duplex mode: %s", esp_err_to_name(ret));
+            goto err;
+        }
+    }
+
+    bus->baud_rate = config->baud_rate;
+    bus->parity = config->parity;
+    ret = rs485_apply_timing(bus);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to set RX timeout: %s", esp_err_to_name(ret));
+        goto err;
+    }
+
+    bus->rx_frame_sem = xSemaphoreCreateCounting(RS485_RX_RING_LEN, 0);
+    bus->tx_queue = xQueueCreate(RS485_TX_QUEUE_LEN, sizeof(rs485_tx_job_t));
+    portMUX_TYPE lane_lock = portMUX_INITIALIZER_UNLOCKED;
+    bus->lane_lock = lane_lock;
+    rs485_lanes_init(&bus->lanes);
+    bool lanes_ok = true;
+    for (int lane = 0; lane < RS485_LANE_COUNT; lane++) {
+        bus->lane_sem[lane] = xSemaphoreCreateCounting(RS485_LANE_MAX_WAITERS, 0);
+        lanes_ok = lanes_ok && bus->lane_sem[lane] != NULL;
+    }
+    if (bus->rx_frame_sem == NULL || bus->tx_queue == NULL || !lanes_ok) {
+        ESP_LOGE(TAG, "Failed to create RS485 queues");
+        goto err;
+    }
+
+    // 各总线的任务可绑定到不同核并行运行
+    BaseType_t core_id = (config->task_core < 0) ? tskNO_AFFINITY : config->task_core;
+    char task_name[16];
+    snprintf(task_name, sizeof(task_name), "rs485_rx%d", uart_num);
+    if (xTaskCreatePinnedToCore(rs485_rx_task, task_name, RS485_RX_TASK_STACK_SIZE, bus,
+                                RS485_RX_TASK_PRIORITY, &bus->rx_task, core_id) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create RX task");
+        goto err;
+    }
+    snprintf(task_name, sizeof(task_name), "rs485_tx%d", uart_num);
+    if (xTaskCreatePinnedToCore(rs485_tx_task, task_name, RS485_TX_TASK_STACK_SIZE, bus,
+                                RS485_TX_TASK_PRIORITY, &bus->tx_task, core_id) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create TX task");
+        goto err;
+    }
+
+    bus->in_use = true;
+    ESP_LOGI(TAG, "RS485 ready on UART%d, TX=GPIO%d, RX=GPIO%d, DE=%s, %d 8%c1, t3.5=%lu us",
+             uart_num, config->tx_pin, config->rx_pin, bus->hw_half_duplex ? "RTS" : "auto", config->baud_rate,
+             rs485_parity_char(bus->parity), bus->frame_gap_us);
+
+    return bus;
+
+err:
+    rs485_bus_release(bus);
+    return NULL;
 }
 
-uint16_t rs485_calculate_crc16(const uint8_t *data, uint16_t length) {
-    uint16_t crc = 0xFFFF;
-    
-    for (uint16_t i = 0; i < length; i++) {
-        crc ^= (uint16_t)data[i];
-        
-        for (uint8_t j = 0; j < 8; j++) {
-            if (crc & 0x0001) {
-                crc = (crc >> 1) ^ 0xA001;
-            } else {
-                crc >>= 1;
-            }
-        }
+void rs485_bus_close(rs485_bus_t *bus) {
+    if (bus == NULL || !bus->in_use) {
+        return;
+    }
+
+    uart_port_t uart_num = bus->uart_num;
+    bus->in_use = false;
+    // 等当前事务结束再删除，避免带锁删除 TX 任务
+    rs485_bus_lock(bus, RS485_LANE_ALARM);
+    vTaskDelete(bus->tx_task);
+    bus->tx_task = NULL;
+    rs485_bus_unlock(bus);
+    rs485_bus_release(bus);
+
+    if (s_default_bus == bus) {
+        s_default_bus = NULL;
     }
-    
-    return crc;
+    ESP_LOGI(TAG, "RS485 bus on UART%d closed", uart_num);
 }
 
-bool rs485_send_command(rs485_cmd_t cmd) {
-    if (!s_initialized) {
+bool rs485_bus_send(rs485_bus_t *bus, const uint8_t *data, size_t length) {
+    return rs485_bus_send_lane(bus, RS485_LANE_COMMAND, data, length);
+}
+
+bool rs485_bus_send_lane(rs485_bus_t *bus, rs485_lane_t lane, const uint8_t *data, size_t length) {
+    return rs485_bus_send_timed(bus, lane, data, length, NULL);
+}
+
+bool rs485_bus_send_timed(rs485_bus_t *bus, rs485_lane_t lane, const uint8_t *data, size_t length,
+                          rs485_transact_timing_t *timing) {
+    if (bus == NULL || !bus->in_use || lane >= RS485_LANE_COUNT) {
         ESP_LOGE(TAG, "RS485 not initialized");
         return false;
     }
 
-    // 构建命令数据（不含CRC和固定后缀）
-    uint8_t cmd_data[6];  // 6字节：前缀5字节 + 命令1字节
-    cmd_data[0] = RS485_CMD_PREFIX_0;
-    cmd_data[1] = RS485_CMD_PREFIX_1;
-    cmd_data[2] = RS485_CMD_PREFIX_2;
-    cmd_data[3] = RS485_CMD_PREFIX_3;
-    cmd_data[4] = RS485_CMD_PREFIX_4;
-    cmd_data[5] = (uint8_t)cmd;
-
-    // 计算CRC（对前6字节计算）
-    uint16_t crc = rs485_calculate_crc16(cmd_data, 6);
-    
-    // 构建完整命令（包含CRC + 固定后缀00 00）
-    uint8_t full_cmd[RS485_CMD_TOTAL_LENGTH];
-    memcpy(full_cmd, cmd_data, 6);
-    full_cmd[6] = (uint8_t)(crc & 0xFF);        // CRC低字节
-    full_cmd[7] = (uint8_t)((crc >> 8) & 0xFF); // CRC高字节
-    full_cmd[8] = 0x00;                          // 固定后缀：00
-    full_cmd[9] = 0x00;                          // 固定后缀：00
+    if (data == NULL || length == 0) {
+        ESP_LOGE(TAG, "Invalid data or length");
+        return false;
+    }
 
-    // 发送数据
-    int bytes_written = uart_write_bytes(s_uart_num, full_cmd, RS485_CMD_TOTAL_LENGTH);
-    
-    if (bytes_written != RS485_CMD_TOTAL_LENGTH) {
-        ESP_LOGE(TAG, "Failed to send command, written %d/%d bytes", bytes_written, RS485_CMD_TOTAL_LENGTH);
+    rs485_bus_lock(bus, lane);
+    bool ok = rs485_write_frame(bus, data, length);
+    if (timing != NULL) {
+        timing->granted_us = bus->hold_start_us;
+        timing->tx_start_us = bus->tx_start_us;
+    }
+    rs485_bus_unlock(bus);
+    return ok;
+}
+
+bool rs485_frame_acquire(rs485_bus_t *bus, rs485_frame_t *frame, uint32_t timeout_ms) {
+    if (bus == NULL || !bus->in_use || frame == NULL) {
         return false;
     }
 
-    // 等待发送完成（参照 demo，但添加超时保护）
-    esp_err_t ret = uart_wait_tx_done(s_uart_num, pdMS_TO_TICKS(100));
-    if (ret != ESP_OK) {
-        ESP_LOGW(TAG, "Timeout waiting for TX done: %s", esp_err_to_name(ret));
+    // 等待 RX 任务发布的下一帧（线路静默即返回，不必等满超时）
+    if (xSemaphoreTake(bus->rx_frame_sem, pdMS_TO_TICKS(timeout_ms)) != pdTRUE) {
+        return false;
     }
+    const rs485_frame_desc_t *desc = &bus->rx_ring[bus->rx_read & RS485_RX_RING_MASK];
+    bus->rx_read++;
 
-    // 打印发送的命令详情（用于调试）
-    ESP_LOGI(TAG, "Command sent: 0x%02X, Full cmd: %02X %02X %02X %02X %02X %02X %02X %02X %02X %02X",
-             cmd, full_cmd[0], full_cmd[1], full_cmd[2], full_cmd[3],
-             full_cmd[4], full_cmd[5], full_cmd[6], full_cmd[7], full_cmd[8], full_cmd[9]);
+    frame->data = &bus->rx_arena[desc->offset];
+    frame->length = desc->length;
+    frame->status = desc->status;
+    frame->timestamp_us = desc->timestamp_us;
     return true;
 }
 
-bool rs485_send_data(const uint8_t *data, size_t length) {
-    if (!s_initialized) {
+void rs485_frame_release(rs485_bus_t *bus, const rs485_frame_t *frame) {
+    (void)frame; // 按取出顺序归还，只需推进 tail
+    if (bus == NULL || bus->rx_tail == bus->rx_read) {
+        return;
+    }
+    __atomic_store_n(&bus->rx_tail, bus->rx_tail + 1, __ATOMIC_RELEASE);
+}
+
+// 丢弃所有已发布未取出的帧；调用者需持有总线（rs485_bus_lock） 且未持有帧
+static void rs485_rx_discard(rs485_bus_t *bus) {
+    while (xSemaphoreTake(bus->rx_frame_sem, 0) == pdTRUE) {
+        bus->rx_read++;
+    }
+    __atomic_store_n(&bus->rx_tail, bus->rx_read, __ATOMIC_RELEASE);
+}
+
+// 首字节检测：把 FIFO 满阈值临时降到 1，应答的第一个字节一进 FIFO 就产生
+// 数据事件，不必等整帧收完再加 RX 超时
+static void rs485_arm_first_byte(rs485_bus_t *bus) {
+    __atomic_store_n(&bus->rx_first_byte_us, 0, __ATOMIC_RELAXED);
+    if (!bus->fast_path) {
+        uart_set_rx_full_threshold(bus->uart_num, 1);
+    }
+    __atomic_store_n(&bus->rx_first_byte_armed, true, __ATOMIC_RELEASE);
+}
+
+// 撤销未触发的首字节检测；已触发时阈值已由 RX 任务恢复
+static void rs485_disarm_first_byte(rs485_bus_t *bus) {
+    if (__atomic_exchange_n(&bus->rx_first_byte_armed, false, __ATOMIC_ACQ_REL) && !bus->fast_path) {
+        uart_set_rx_full_threshold(bus->uart_num, RS485_RX_FULL_THRESHOLD_DEFAULT);
+    }
+}
+
+// 等待应答帧。给出 first_byte_ms 时先只等这么久：期间一个字节都没收到
+// 就判定无应答，不再等满 timeout_ms
+static bool rs485_wait_response(rs485_bus_t *bus, rs485_frame_t *response, uint32_t timeout_ms,
+                                uint32_t first_byte_ms) {
+    if (first_byte_ms == 0 || first_byte_ms >= timeout_ms) {
+        return rs485_frame_acquire(bus, response, timeout_ms);
+    }
+    bool got = rs485_frame_acquire(bus, response, first_byte_ms);
+    if (!got && __atomic_load_n(&bus->rx_first_byte_us, __ATOMIC_ACQUIRE) != 0) {
+        got = rs485_frame_acquire(bus, response, timeout_ms - first_byte_ms);
+    }
+    rs485_disarm_first_byte(bus);
+    return got;
+}
+
+// 发送请求并取出应答帧；调用者需持有总线（rs485_bus_lock）
+// 返回 1 取到应答（用完需 rs485_frame_release），0 超时或无需应答，-1 发送失败
+static int rs485_request(rs485_bus_t *bus, const uint8_t *request, size_t request_len, rs485_frame_t *response,
+                         uint32_t timeout_ms, uint32_t first_byte_ms) {
+    // 发送前丢弃残留帧，确保收到的是本次请求的应答
+    rs485_rx_discard(bus);
+    if (timeout_ms != 0 && first_byte_ms != 0 && first_byte_ms < timeout_ms) {
+        rs485_arm_first_byte(bus);
+    }
+
+    // 发送完成即切回接收，应答可在 t3.5 后立即到达
+    uint32_t rx_errors = bus->stats.rx_errors;
+    if (!rs485_write_frame(bus, request, request_len)) {
+        rs485_disarm_first_byte(bus);
+        return -1;
+    }
+    int64_t tx_done_us = bus->last_activity_us;
+    if (timeout_ms == 0) {
+        // 广播或无需应答
+        return 0;
+    }
+    if (!rs485_wait_response(bus, response, timeout_ms, first_byte_ms)) {
+        bus->stats.rx_timeouts++;
+        rs485_trace_record(bus->uart_num, RS485_TRACE_RX_TIMEOUT, NULL, 0);
+        // 等待期间出现过帧错误说明设备应答了但帧已损坏
+        if (bus->stats.rx_errors != rx_errors) {
+            rs485_devstats_record_framing_error(bus->uart_num, request[0]);
+        } else {
+            rs485_devstats_record_timeout(bus->uart_num, request[0]);
+        }
+        return 0;
+    }
+
+    // 时间戳即最后一个字节的时刻，首字节时刻按字符时间倒推
+    int64_t last_byte_us = response->timestamp_us;
+    int64_t first_byte_us = last_byte_us - (int64_t)(response->length - 1) * bus->char_time_us;
+    if (first_byte_us < tx_done_us) {
+        first_byte_us = tx_done_us;
+    }
+    if (last_byte_us < first_byte_us) {
+        last_byte_us = first_byte_us;
+    }
+    rs485_devstats_record_response(bus->uart_num, request[0], response->status == RS485_FRAME_OK,
+                                   (uint32_t)(first_byte_us - tx_done_us), (uint32_t)(last_byte_us - tx_done_us));
+    return 1;
+}
+
+int rs485_bus_receive(rs485_bus_t *bus, uint8_t *buffer, size_t buffer_size, uint32_t timeout_ms) {
+    if (bus == NULL || !bus->in_use) {
         ESP_LOGE(TAG, "RS485 not initialized");
-        return false;
+        return -1;
     }
 
-    if (data == NULL || length == 0) {
-        ESP_LOGE(TAG, "Invalid data or length");
+    if (buffer == NULL || buffer_size == 0) {
+        ESP_LOGE(TAG, "Invalid buffer or buffer size");
+        return -1;
+    }
+
+    rs485_frame_t frame;
+    if (!rs485_frame_acquire(bus, &frame, timeout_ms)) {
+        // 超时，但没有错误
+        return 0;
+    }
+
+    size_t len = frame.length < buffer_size ? frame.length : buffer_size;
+    memcpy(buffer, frame.data, len);
+    rs485_frame_release(bus, &frame);
+    return (int)len;
+}
+
+int rs485_bus_transact(rs485_bus_t *bus, const uint8_t *request, size_t request_len, uint8_t *response,
+                       size_t response_size, uint32_t timeout_ms, bool *crc_ok) {
+    return rs485_bus_transact_lane(bus, RS485_LANE_COMMAND, request, request_len, response, response_size,
+                                   timeout_ms, crc_ok);
+}
+
+int rs485_bus_transact_lane(rs485_bus_t *bus, rs485_lane_t lane, const uint8_t *request, size_t request_len,
+                            uint8_t *response, size_t response_size, uint32_t timeout_ms, bool *crc_ok) {
+    rs485_frame_t frame;
+    int ret = rs485_bus_transact_acquire(bus, lane, request, request_len, &frame, timeout_ms, 0, NULL);
+    if (ret <= 0) {
+        return ret;
+    }
+
+    size_t len = frame.length < response_size ? frame.length : response_size;
+    memcpy(response, frame.data, len);
+    if (crc_ok != NULL) {
+        *crc_ok = frame.status == RS485_FRAME_OK && len == frame.length;
+    }
+    rs485_bus_transact_release(bus, &frame);
+    return (int)len;
+}
+
+int rs485_bus_transact_acquire(rs485_bus_t *bus, rs485_lane_t lane, const uint8_t *request, size_t request_len,
+                               rs485_frame_t *response, uint32_t timeout_ms, uint32_t first_byte_ms,
+                               rs485_transact_timing_t *timing) {
+    if (bus == NULL || !bus->in_use || lane >= RS485_LANE_COUNT || response == NULL) {
+        ESP_LOGE(TAG, "RS485 not initialized");
+        return -1;
+    }
+
+    // 请求与应答之间独占总线，避免其他命令插入；取到应答时由调用者归还后才释放
+    rs485_bus_lock(bus, lane);
+    int ret = rs485_request(bus, request, request_len, response, timeout_ms, first_byte_ms);
+    if (timing != NULL) {
+        timing->granted_us = bus->hold_start_us;
+        timing->tx_start_us = bus->tx_start_us;
+    }
+    if (ret <= 0) {
+        rs485_bus_unlock(bus);
+    }
+    return ret;
+}
+
+void rs485_bus_transact_release(rs485_bus_t *bus, const rs485_frame_t *response) {
+    rs485_frame_release(bus, response);
+    rs485_bus_unlock(bus);
+}
+
+// 取得发往 addr 的灯光命令帧：已配置地址与广播用编译期常量，其余地址运行期构建到 buf
+static const uint8_t *rs485_command_frame(uint8_t addr, rs485_cmd_t cmd, uint8_t *buf) {
+    const uint8_t *frame = rs485_frames_command(addr, cmd);
+    if (frame != NULL) {
+        return frame;
+    }
+    if (rs485_frames_command(RS485_DEVICE_ADDR, cmd) == NULL) {
+        return NULL; // 未知命令
+    }
+    rs485_frames_build(buf, addr, 0x06, RS485_REG_LIGHT, (uint16_t)cmd);
+    return buf;
+}
+
+bool rs485_bus_send_command(rs485_bus_t *bus, rs485_cmd_t cmd) {
+    return rs485_bus_send_command_to(bus, RS485_DEVICE_ADDR, cmd);
+}
+
+bool rs485_bus_send_command_to(rs485_bus_t *bus, uint8_t addr, rs485_cmd_t cmd) {
+    if (bus == NULL || !bus->in_use) {
+        ESP_LOGE(TAG, "RS485 not initialized");
         return false;
     }
 
-    int bytes_written = uart_write_bytes(s_uart_num, data, length);
-    
-    if (bytes_written != (int)length) {
-        ESP_LOGE(TAG, "Failed to send data, written %d/%zu bytes", bytes_written, length);
+    // 命令帧在编译期生成（含 CRC），直接发送 flash 中的常量
+    uint8_t buf[RS485_FRAME_LENGTH];
+    const uint8_t *full_cmd = rs485_command_frame(addr, cmd, buf);
+    if (full_cmd == NULL) {
+        ESP_LOGE(TAG, "Unknown command: 0x%02X", cmd);
         return false;
     }
 
-    uart_wait_tx_done(s_uart_num, pdMS_TO_TICKS(100));
-    return true;
+    // 发送数据
+    rs485_bus_lock(bus, rs485_cmd_lane(cmd));
+    bool ok = rs485_write_frame(bus, full_cmd, RS485_FRAME_LENGTH);
+    rs485_bus_unlock(bus);
+    // 发送的帧由 rs485_write_frame() 记入总线跟踪，需要时用 rs485_trace_dump() 查看
+    return ok;
 }
 
-void rs485_deinit(void) {
-    if (s_initialized && s_uart_num < UART_NUM_MAX) {
-        uart_driver_delete(s_uart_num);
-        s_initialized = false;
-        s_uart_num = UART_NUM_MAX;
-        ESP_LOGI(TAG, "RS485 deinitialized");
+// 回显帧（可带 00 00 后缀）传输 + RX 超时 + 应答延迟余量
+uint32_t rs485_bus_echo_timeout_ms(const rs485_bus_t *bus) {
+    uint32_t us = RS485_FRAME_LENGTH * bus->char_time_us + bus->frame_gap_us + bus->char_time_us +
+                  RS485_ECHO_TURNAROUND_MS * 1000;
+    return (us + 999) / 1000;
+}
+
+size_t rs485_bus_send_group_command(rs485_bus_t *bus, const uint8_t *addrs, size_t count, rs485_cmd_t cmd) {
+    if (addrs == NULL || count == 0) {
+        // 整条线一帧广播：总线时间与塔灯数量无关
+        return rs485_bus_send_command_to(bus, RS485_MODBUS_BROADCAST_ADDR, cmd) ? 1 : 0;
+    }
+    if (bus == NULL || !bus->in_use) {
+        ESP_LOGE(TAG, "RS485 not initialized");
+        return 0;
+    }
+    if (rs485_frames_command(RS485_DEVICE_ADDR, cmd) == NULL) {
+        ESP_LOGE(TAG, "Unknown command: 0x%02X", cmd);
+        return 0;
     }
+
+    // 整组只取一次总线，同级及更低通道的命令不会插进组内；更高通道（如报警）
+    // 排队时在帧间让出。每个塔灯都回显 FC06，须等回显收完再发下一帧，
+    // 否则回显会与发往下一个塔灯的请求相撞
+    size_t acked = 0;
+    uint8_t buf[RS485_FRAME_LENGTH];
+    uint32_t echo_timeout_ms = rs485_bus_echo_timeout_ms(bus);
+    rs485_lane_t lane = rs485_cmd_lane(cmd);
+    rs485_bus_lock(bus, lane);
+    for (size_t i = 0; i < count; i++) {
+        if (i > 0) {
+            rs485_bus_yield(bus, lane);
+        }
+        const uint8_t *frame = rs485_command_frame(addrs[i], cmd, buf);
+        bool broadcast = addrs[i] == RS485_MODBUS_BROADCAST_ADDR;
+        rs485_frame_t echo;
+        int ret = rs485_request(bus, frame, RS485_FRAME_LENGTH, &echo, broadcast ? 0 : echo_timeout_ms, 0);
+        if (ret > 0) {
+            if (echo.status == RS485_FRAME_OK && echo.length >= 6 && memcmp(echo.data, frame, 6) == 0) {
+                acked++;
+            }
+            rs485_frame_release(bus, &echo);
+        } else if (ret == 0 && broadcast) {
+            acked++;
+        }
+    }
+    rs485_bus_unlock(bus);
+    return acked;
 }
 
-bool rs485_query_devices(void) {
-    if (!s_initialized) {
+bool rs485_bus_query_devices(rs485_bus_t *bus) {
+    if (bus == NULL || !bus->in_use) {
         ESP_LOGE(TAG, "RS485 not initialized");
         return false;
     }
@@ -219,123 +1085,213 @@ bool rs485_query_devices(void) {
     // 03: 功能码（读保持寄存器）
     // 00 3F: 起始地址（0x003F = 63）
     // 00 00: 寄存器数量
-    // 构建命令数据（不含CRC）
-    uint8_t cmd_data[6] = {0xFF, 0x03, 0x00, 0x3F, 0x00, 0x00};
-    
-    // 计算CRC（对前6字节计算）
-    uint16_t crc = rs485_calculate_crc16(cmd_data, 6);
-    
-    // 构建完整命令（包含CRC + 固定后缀00 00）
-    uint8_t query_cmd[10];
-    memcpy(query_cmd, cmd_data, 6);
-    query_cmd[6] = (uint8_t)(crc & 0xFF);        // CRC低字节
-    query_cmd[7] = (uint8_t)((crc >> 8) & 0xFF); // CRC高字节
-    query_cmd[8] = 0x00;                          // 固定后缀：00
-    query_cmd[9] = 0x00;                          // 固定后缀：00
-    
-    ESP_LOGI(TAG, "Query command CRC calculated: 0x%04X (low=0x%02X, high=0x%02X)", 
-             crc, query_cmd[6], query_cmd[7]);
-
-    // 发送查询命令
-    int bytes_written = uart_write_bytes(s_uart_num, query_cmd, sizeof(query_cmd));
-    
-    if (bytes_written != sizeof(query_cmd)) {
-        ESP_LOGE(TAG, "Failed to send query command, written %d/%zu bytes", bytes_written, sizeof(query_cmd));
+    const uint8_t *query_cmd = rs485_frames_query_devices();
+
+    // 塔灯离线时断路器断开，查询直接失败而不是每次都等满 1000ms
+    if (!rs485_breaker_admit(bus->uart_num, query_cmd[0], NULL)) {
         return false;
     }
 
-    // 等待发送完成
-    esp_err_t ret = uart_wait_tx_done(s_uart_num, pdMS_TO_TICKS(100));
-    if (ret != ESP_OK) {
-        ESP_LOGW(TAG, "Timeout waiting for TX done: %s", esp_err_to_name(ret));
+    // 等待应答帧：线路静默 t3.5 后立即返回，1000ms 只是上限
+    // 请求、应答与超时都记入总线跟踪，这里不再打印
+    rs485_bus_lock(bus, RS485_LANE_POLL);
+    rs485_frame_t frame;
+    int len = rs485_request(bus, query_cmd, RS485_FRAME_LENGTH, &frame, 1000, 0);
+
+    if (len > 0) {
+        rs485_frame_release(bus, &frame);
     }
+    rs485_bus_unlock(bus);
+    rs485_breaker_report(bus->uart_num, query_cmd[0], len > 0);
+    return len > 0;
+}
 
-    ESP_LOGI(TAG, "Query command sent: %02X %02X %02X %02X %02X %02X %02X %02X %02X %02X",
-             query_cmd[0], query_cmd[1], query_cmd[2], query_cmd[3],
-             query_cmd[4], query_cmd[5], query_cmd[6], query_cmd[7], query_cmd[8], query_cmd[9]);
+bool rs485_bus_submit_command(rs485_bus_t *bus, rs485_cmd_t cmd, rs485_done_cb_t done_cb, void *user_ctx) {
+    rs485_tx_job_t job = {
+        .type = RS485_JOB_COMMAND,
+        .cmd = cmd,
+        .done_cb = done_cb,
+        .user_ctx = user_ctx,
+    };
+    return rs485_submit_job(bus, &job);
+}
 
-    // 清空接收缓冲区（在发送前）
-    uart_flush_input(s_uart_num);
-    
-    // 给设备一些响应时间（RS485设备通常需要几毫秒处理）
-    vTaskDelay(pdMS_TO_TICKS(10));
+bool rs485_bus_submit_query_devices(rs485_bus_t *bus, rs485_done_cb_t done_cb, void *user_ctx) {
+    rs485_tx_job_t job = {
+        .type = RS485_JOB_QUERY_DEVICES,
+        .done_cb = done_cb,
+        .user_ctx = user_ctx,
+    };
+    return rs485_submit_job(bus, &job);
+}
 
-    // 等待并接收响应数据（增加超时时间到1000ms）
-    uint8_t rx_buffer[256];
-    ESP_LOGI(TAG, "Waiting for response (timeout: 1000ms)...");
-    int len = rs485_receive_data(rx_buffer, sizeof(rx_buffer), 1000); // 1000ms超时
-    
-    if (len > 0) {
-        ESP_LOGI(TAG, "✓ Received %d bytes:", len);
-        
-        
-        // 打印为连续字符串格式
-        char hex_str[512] = {0};
-        for (int i = 0; i < len && i < 64; i++) { // 限制长度避免溢出
-            char temp[4];
-            snprintf(temp, sizeof(temp), "%02X ", rx_buffer[i]);
-            strcat(hex_str, temp);
-        }
-        ESP_LOGI(TAG, "Response: %s", hex_str);
-        
-        return true;
-    } else if (len == 0) {
-        // 检查是否有数据在缓冲区中但没有读取完
-        size_t buffered_size = 0;
-        uart_get_buffered_data_len(s_uart_num, &buffered_size);
-        if (buffered_size > 0) {
-            ESP_LOGW(TAG, "Timeout but found %zu bytes in buffer, trying to read...", buffered_size);
-            len = uart_read_bytes(s_uart_num, rx_buffer, 
-                                  (buffered_size < sizeof(rx_buffer) - 1) ? buffered_size : sizeof(rx_buffer) - 1, 0);
-            if (len > 0) {
-                ESP_LOGI(TAG, "✓ Read %d bytes from buffer:", len);
-                char hex_str[512] = {0};
-                for (int i = 0; i < len && i < 64; i++) {
-                    char temp[4];
-                    snprintf(temp, sizeof(temp), "%02X ", rx_buffer[i]);
-                    strcat(hex_str, temp);
-                }
-                ESP_LOGI(TAG, "Response: %s", hex_str);
-                return true;
-            }
-        }
-        ESP_LOGW(TAG, "✗ No response received (timeout after 1000ms)");
-        ESP_LOGW(TAG, "Possible causes:");
-        ESP_LOGW(TAG, "  1. Device not connected or powered off");
-        ESP_LOGW(TAG, "  2. Wrong baud rate (current: check main.cpp)");
-        ESP_LOGW(TAG, "  3. Wrong device address (sent: 0x%02X)", query_cmd[0]);
-        ESP_LOGW(TAG, "  4. RS485 transceiver direction control issue");
-        ESP_LOGW(TAG, "  5. TX/RX wires swapped");
+bool rs485_bus_set_rx_filter(rs485_bus_t *bus, rs485_parser_dir_t dir, const uint8_t *addrs, size_t count) {
+    if (bus == NULL || !bus->in_use) {
         return false;
-    } else {
-        ESP_LOGE(TAG, "Error receiving data");
+    }
+    rs485_parser_init(&bus->parser, dir);
+    for (size_t i = 0; addrs != NULL && i < count; i++) {
+        rs485_parser_accept(&bus->parser, addrs[i]);
+    }
+    bus->rx_full_threshold = 0; // 强制按新解析器重设
+    rs485_rx_fast_threshold(bus);
+    bus->fast_path = true;
+    return true;
+}
+
+void rs485_bus_register_frame_callback(rs485_bus_t *bus, rs485_frame_cb_t cb, void *user_ctx) {
+    if (bus == NULL) {
+        return;
+    }
+    // 先清回调再换参数，避免 RX 任务拿到新旧混搭的组合
+    bus->frame_cb = NULL;
+    bus->frame_cb_ctx = user_ctx;
+    bus->frame_cb = cb;
+}
+
+rs485_lane_t rs485_cmd_lane(rs485_cmd_t cmd) {
+    return cmd == RS485_CMD_RED_BURST_FLASH ? RS485_LANE_ALARM : RS485_LANE_COMMAND;
+}
+
+bool rs485_bus_get_lane_stats(const rs485_bus_t *bus, rs485_lane_stats_t stats[RS485_LANE_COUNT]) {
+    if (bus == NULL || !bus->in_use || stats == NULL) {
         return false;
     }
+    portENTER_CRITICAL((portMUX_TYPE *)&bus->lane_lock);
+    memcpy(stats, bus->lanes.stats, sizeof(bus->lanes.stats));
+    portEXIT_CRITICAL((portMUX_TYPE *)&bus->lane_lock);
+    return true;
 }
 
-int rs485_receive_data(uint8_t *buffer, size_t buffer_size, uint32_t timeout_ms) {
-    if (!s_initialized) {
-        ESP_LOGE(TAG, "RS485 not initialized");
-        return -1;
+bool rs485_bus_get_stats(const rs485_bus_t *bus, rs485_bus_stats_t *stats) {
+    if (bus == NULL || !bus->in_use || stats == NULL) {
+        return false;
     }
+    *stats = bus->stats;
+    return true;
+}
 
-    if (buffer == NULL || buffer_size == 0) {
-        ESP_LOGE(TAG, "Invalid buffer or buffer size");
-        return -1;
+uart_port_t rs485_bus_get_uart(const rs485_bus_t *bus) {
+    return bus != NULL ? bus->uart_num : UART_NUM_MAX;
+}
+
+bool rs485_bus_set_line(rs485_bus_t *bus, int baud_rate, uart_parity_t parity) {
+    if (bus == NULL || !bus->in_use || baud_rate <= 0) {
+        return false;
     }
 
-    // 注意：不清空缓冲区，因为可能在查询函数中已经清空过了
-    // 如果需要清空，应该在调用此函数前清空
+    // 持总线锁切换，不会打断进行中的事务；切换前等发送完毕
+    rs485_bus_lock(bus, RS485_LANE_COMMAND);
+    uart_wait_tx_done(bus->uart_num, portMAX_DELAY);
+    esp_err_t ret = uart_set_baudrate(bus->uart_num, (uint32_t)baud_rate);
+    if (ret == ESP_OK) {
+        ret = uart_set_parity(bus->uart_num, parity);
+    }
+    if (ret == ESP_OK) {
+        bus->baud_rate = baud_rate;
+        bus->parity = parity;
+        ret = rs485_apply_timing(bus);
+    }
+    // 旧设置下收到的残余字节已无意义
+    uart_flush_input(bus->uart_num);
+    bus->last_activity_us = esp_timer_get_time();
+    rs485_bus_unlock(bus);
 
-    // 等待接收数据
-    int len = uart_read_bytes(s_uart_num, buffer, buffer_size - 1, pdMS_TO_TICKS(timeout_ms));
-    
-    if (len > 0) {
-        buffer[len] = '\0'; // 确保字符串结束
-    } else if (len == 0) {
-        // 超时，但没有错误
-        ESP_LOGD(TAG, "Receive timeout after %lu ms", timeout_ms);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to set UART%d to %d 8%c1: %s", bus->uart_num, baud_rate, rs485_parity_char(parity),
+                 esp_err_to_name(ret));
+        return false;
     }
-    
-    return len;
+    ESP_LOGI(TAG, "UART%d now %d 8%c1, t3.5=%lu us", bus->uart_num, baud_rate, rs485_parity_char(parity),
+             bus->frame_gap_us);
+    return true;
+}
+
+bool rs485_bus_get_line(const rs485_bus_t *bus, int *baud_rate, uart_parity_t *parity) {
+    if (bus == NULL || !bus->in_use) {
+        return false;
+    }
+    if (baud_rate != NULL) {
+        *baud_rate = bus->baud_rate;
+    }
+    if (parity != NULL) {
+        *parity = bus->parity;
+    }
+    return true;
+}
+
+bool rs485_bus_get_timing(const rs485_bus_t *bus, uint32_t *char_time_us, uint32_t *frame_gap_us) {
+    if (bus == NULL || !bus->in_use) {
+        return false;
+    }
+    if (char_time_us != NULL) {
+        *char_time_us = bus->char_time_us;
+    }
+    if (frame_gap_us != NULL) {
+        *frame_gap_us = bus->frame_gap_us;
+    }
+    return true;
+}
+
+// 默认总线上的兼容接口
+
+rs485_bus_t *rs485_get_default_bus(void) {
+    return s_default_bus;
+}
+
+bool rs485_init(uart_port_t uart_num, int tx_pin, int rx_pin, int de_pin, int baud_rate) {
+    if (s_default_bus != NULL) {
+        ESP_LOGW(TAG, "RS485 already initialized");
+        return false;
+    }
+
+    rs485_bus_config_t config = {
+        .uart_num = uart_num,
+        .tx_pin = tx_pin,
+        .rx_pin = rx_pin,
+        .de_pin = de_pin,
+        .baud_rate = baud_rate,
+        .task_core = -1,
+    };
+    s_default_bus = rs485_bus_open(&config);
+    return s_default_bus != NULL;
+}
+
+uint16_t rs485_calculate_crc16(const uint8_t *data, uint16_t length) {
+    return rs485_crc16_update(RS485_CRC16_INIT, data, length);
+}
+
+bool rs485_send_command(rs485_cmd_t cmd) {
+    return rs485_bus_send_command(s_default_bus, cmd);
+}
+
+bool rs485_send_data(const uint8_t *data, size_t length) {
+    return rs485_bus_send(s_default_bus, data, length);
+}
+
+bool rs485_submit_command(rs485_cmd_t cmd, rs485_done_cb_t done_cb, void *user_ctx) {
+    return rs485_bus_submit_command(s_default_bus, cmd, done_cb, user_ctx);
+}
+
+bool rs485_submit_query_devices(rs485_done_cb_t done_cb, void *user_ctx) {
+    return rs485_bus_submit_query_devices(s_default_bus, done_cb, user_ctx);
+}
+
+void rs485_register_frame_callback(rs485_frame_cb_t cb, void *user_ctx) {
+    rs485_bus_register_frame_callback(s_default_bus, cb, user_ctx);
+}
+
+void rs485_deinit(void) {
+    if (s_default_bus != NULL) {
+        rs485_bus_close(s_default_bus);
+        ESP_LOGI(TAG, "RS485 deinitialized");
+    }
+}
+
+bool rs485_query_devices(void) {
+    return rs485_bus_query_devices(s_default_bus);
+}
+
+int rs485_receive_data(uint8_t *buffer, size_t buffer_size, uint32_t timeout_ms) {
+    return rs485_bus_receive(s_default_bus, buffer, buffer_size, timeout_ms);
 }
@@ -2,6 +2,8 @@
 #define RS485_COMM_H
 
 #include "driver/uart.h"
+#include "rs485_lanes.h"
+#include "rs485_parser.h"
 #include <stdbool.h>
 #include <stdint.h>
 
@@ -23,15 +25,375 @@ typedef enum {
   RS485_CMD_LIGHT_OFF = 0x60           // 警灯关闭
 } rs485_cmd_t;
 
+// 单帧最大长度（Modbus RTU ADU 上限）
+#define RS485_FRAME_MAX_LEN 256
+
+/**
+ * @brief 帧接收回调，在 RX 任务上下文中调用
+ * @param frame 帧数据，仅在回调期间有效
+ * @param length 帧长度
+ * @param user_ctx 注册时传入的用户参数
+ */
+typedef void (*rs485_frame_cb_t)(const uint8_t *frame, size_t length,
+                                 void *user_ctx);
+
+/**
+ * @brief 异步任务完成回调，在 TX 任务上下文中调用
+ * @param success 是否发送/查询成功
+ * @param user_ctx 提交时传入的用户参数
+ */
+typedef void (*rs485_done_cb_t)(bool success, void *user_ctx);
+
+// RS485 总线句柄，每个 UART 端口一条，各自拥有缓冲区、RX/TX 任务与统计
+typedef struct rs485_bus rs485_bus_t;
+
+// 接收帧状态
+typedef enum {
+  RS485_FRAME_OK = 0,        // CRC 正确
+  RS485_FRAME_CRC_ERROR = 1, // CRC 错误
+} rs485_frame_status_t;
+
+// 接收帧视图：data 直接指向总线接收区，rs485_frame_release() 之前有效
+typedef struct {
+  const uint8_t *data;
+  uint16_t length;
+  rs485_frame_status_t status;
+  int64_t timestamp_us; // 帧最后一个字节收完的时刻（不含其后的 t3.5 静默）
+} rs485_frame_t;
+
+// 总线配置
+typedef struct {
+  uart_port_t uart_num; // UART 端口号
+  int tx_pin;           // TX 引脚
+  int rx_pin;           // RX 引脚
+  int de_pin;           // DE/RE 引脚，UART_PIN_NO_CHANGE 表示收发器自动换向
+  int baud_rate;        // 波特率
+  uart_parity_t parity; // 校验，默认 UART_PARITY_DISABLE（8N1）
+  int task_core;        // RX/TX 任务绑定的核，-1 表示不绑定
+} rs485_bus_config_t;
+
+// 总线统计
+typedef struct {
+  uint32_t tx_frames;     // 发送帧数
+  uint32_t tx_bytes;      // 发送字节数
+  uint32_t tx_errors;     // 发送失败次数
+  uint32_t collisions;    // 总线冲突次数（硬件半双工模式）
+  uint32_t rx_frames;     // 接收帧数
+  uint32_t rx_bytes;      // 接收字节数
+  uint32_t rx_crc_errors; // CRC 错误帧数
+  uint32_t rx_errors;     // 帧错误/校验错误/超长帧
+  uint32_t rx_overflows;  // FIFO 或缓冲区溢出次数
+  uint32_t rx_dropped;    // 接收队列满丢弃的帧数
+  uint32_t rx_timeouts;   // 等待应答超时次数
+  uint32_t rx_filtered;   // 快速路径丢弃的他址帧数
+} rs485_bus_stats_t;
+
+/**
+ * @brief 打开一条 RS485 总线
+ * @param config 总线配置
+ * @return 总线句柄，失败返回 NULL
+ */
+rs485_bus_t *rs485_bus_open(const rs485_bus_config_t *config);
+
+/**
+ * @brief 关闭总线并释放 UART 驱动与任务
+ * @param bus 总线句柄
+ */
+void rs485_bus_close(rs485_bus_t *bus);
+
+/**
+ * @brief 在指定总线上发送原始数据（阻塞至发送完成）
+ * @param bus 总线句柄
+ * @param data 数据缓冲区
+ * @param length 数据长度
+ * @return true 成功, false 失败
+ */
+bool rs485_bus_send(rs485_bus_t *bus, const uint8_t *data, size_t length);
+
+/**
+ * @brief 按优先级通道发送原始数据（rs485_bus_send() 走操作员命令通道）
+ */
+bool rs485_bus_send_lane(rs485_bus_t *bus, rs485_lane_t lane,
+                         const uint8_t *data, size_t length);
+
+/**
+ * @brief 从指定总线接收下一帧并复制到调用者缓冲区（带超时）
+ *
+ * 帧长超过缓冲区时截断，不追加 '\0'。需要避免复制时使用
+ * rs485_frame_acquire()。
+ *
+ * @param bus 总线句柄
+ * @param buffer 接收缓冲区
+ * @param buffer_size 缓冲区大小
+ * @param timeout_ms 超时时间（毫秒）
+ * @return 接收到的字节数，0 表示超时，-1 表示错误
+ */
+int rs485_bus_receive(rs485_bus_t *bus, uint8_t *buffer, size_t buffer_size,
+                      uint32_t timeout_ms);
+
+/**
+ * @brief 取出下一接收帧（零拷贝）
+ *
+ * 帧数据留在总线的静态接收区中，用完须按取出顺序调用
+ * rs485_frame_release() 归还。每条总线同一时刻只允许一个消费者；
+ * rs485_bus_transact() 与 rs485_bus_receive() 也是消费者。
+ *
+ * @param bus 总线句柄
+ * @param frame 输出帧视图
+ * @param timeout_ms 超时时间（毫秒）
+ * @return true 取到帧, false 超时或总线未打开
+ */
+bool rs485_frame_acquire(rs485_bus_t *bus, rs485_frame_t *frame,
+                         uint32_t timeout_ms);
+
+/**
+ * @brief 归还 rs485_frame_acquire() 取出的帧，之后 frame->data 失效
+ */
+void rs485_frame_release(rs485_bus_t *bus, const rs485_frame_t *frame);
+
+/**
+ * @brief 在指定总线上执行一次请求/应答事务
+ *
+ * 发送期间独占总线；应答在线路静默 t3.5 后立即返回。
+ *
+ * @param bus 总线句柄
+ * @param request 请求帧（含 CRC）
+ * @param request_len 请求帧长度
+ * @param response 应答缓冲区
+ * @param response_size 应答缓冲区大小
+ * @param timeout_ms 应答超时（毫秒），0 表示不等待应答（广播）
+ * @param crc_ok 输出应答 CRC 是否正确，可为 NULL
+ * @return 应答字节数，0 表示超时或无需应答，-1 表示发送失败
+ */
+int rs485_bus_transact(rs485_bus_t *bus, const uint8_t *request,
+                       size_t request_len, uint8_t *response,
+                       size_t response_size, uint32_t timeout_ms,
+                       bool *crc_ok);
+
+/**
+ * @brief 按优先级通道执行一次请求/应答事务
+ *
+ * 总线忙时按通道排队：释放时总是先放行最高的非空通道，报警通道的
+ * 最坏等待约为正在进行的一次事务的时长。rs485_bus_transact() 走
+ * 操作员命令通道。
+ *
+ * @param lane 优先级通道
+ * 其余参数与返回值同 rs485_bus_transact()
+ */
+int rs485_bus_transact_lane(rs485_bus_t *bus, rs485_lane_t lane,
+                            const uint8_t *request, size_t request_len,
+                            uint8_t *response, size_t response_size,
+                            uint32_t timeout_ms, bool *crc_ok);
+
+// rs485_bus_transact_acquire() 的事务时刻（esp_timer 微秒）
+typedef struct {
+  int64_t granted_us;  // 获得总线（不含在通道上排队）
+  int64_t tx_start_us; // 等满 t3.5 后请求第一个字节开始发送
+} rs485_transact_timing_t;
+
+/**
+ * @brief 按优先级通道执行一次请求/应答事务，应答留在接收区不复制
+ *
+ * 返回 1 时 response 指向总线接收区中的应答帧，且调用者仍持有总线，
+ * 须尽快解析并调用 rs485_bus_transact_release() 归还帧、释放总线。
+ * 返回 0 或 -1 时总线已释放，无需归还。
+ *
+ * @param response 输出应答帧视图，status 给出 CRC 是否正确
+ * @param first_byte_ms 首字节超时：发送完成后这么久一个字节都没收到
+ *        即按超时返回，不再等满 timeout_ms（用于扫描静默地址）；
+ *        0 或不小于 timeout_ms 时不单独检测
+ * @param timing 输出事务时刻，可为 NULL；参数非法时不写入
+ * 其余参数同 rs485_bus_transact_lane()
+ * @return 1 收到应答，0 超时或无需应答，-1 发送失败
+ */
+int rs485_bus_transact_acquire(rs485_bus_t *bus, rs485_lane_t lane,
+                               const uint8_t *request, size_t request_len,
+                               rs485_frame_t *response, uint32_t timeout_ms,
+                               uint32_t first_byte_ms,
+                               rs485_transact_timing_t *timing);
+
+/**
+ * @brief 归还 rs485_bus_transact_acquire() 取到的应答并释放总线
+ */
+void rs485_bus_transact_release(rs485_bus_t *bus,
+                                const rs485_frame_t *response);
+
+/**
+ * @brief 同 rs485_bus_send_lane()，并给出实际开始发送的时刻
+ *
+ * 不丢弃接收区里已收到的帧，供从站应答使用（应答期间主站可能已发下一帧）。
+ * @param timing 输出发送时刻，可为 NULL；参数非法时不写入
+ */
+bool rs485_bus_send_timed(rs485_bus_t *bus, rs485_lane_t lane,
+                          const uint8_t *data, size_t length,
+                          rs485_transact_timing_t *timing);
+
+/**
+ * @brief 命令所属的优先级通道：红灯爆闪为报警，其余为操作员命令
+ */
+rs485_lane_t rs485_cmd_lane(rs485_cmd_t cmd);
+
+/**
+ * @brief 读取各优先级通道的统计（获得次数、最坏等待、最长持有）
+ * @param stats 输出数组，RS485_LANE_COUNT 项
+ * @return true 成功, false 总线未打开
+ */
+bool rs485_bus_get_lane_stats(const rs485_bus_t *bus,
+                              rs485_lane_stats_t stats[RS485_LANE_COUNT]);
+
 /**
- * @brief 初始化 RS485 通信
+ * @brief 在指定总线上发送灯光命令
+ * @param bus 总线句柄
+ * @param cmd 命令类型
+ * @return true 成功, false 失败
+ */
+bool rs485_bus_send_command(rs485_bus_t *bus, rs485_cmd_t cmd);
+
+/**
+ * @brief 向指定地址的塔灯发送灯光命令
+ * @param bus 总线句柄
+ * @param addr 设备地址，RS485_MODBUS_BROADCAST_ADDR 为广播
+ * @param cmd 命令类型
+ * @return true 成功, false 失败
+ */
+bool rs485_bus_send_command_to(rs485_bus_t *bus, uint8_t addr,
+                               rs485_cmd_t cmd);
+
+/**
+ * @brief 等待塔灯 FC06 回显的超时（毫秒）
+ *
+ * 按当前线路参数计算：回显帧传输、RX 超时加塔灯应答延迟余量。
+ */
+uint32_t rs485_bus_echo_timeout_ms(const rs485_bus_t *bus);
+
+/**
+ * @brief 向一组塔灯发送同一灯光命令
+ *
+ * addrs 为 NULL 或 count 为 0 时发送一帧广播（所有塔灯同时执行，
+ * 无应答）；否则在一次总线占用内逐个发送，每帧等塔灯的 FC06 回显
+ * 收完（或短超时）再发下一帧，回显不会与下一帧请求相撞。
+ *
+ * @param bus 总线句柄
+ * @param addrs 设备地址列表
+ * @param count 地址数量
+ * @param cmd 命令类型
+ * @return 收到正确回显的帧数（列表中的广播地址发送成功即计入）
+ */
+size_t rs485_bus_send_group_command(rs485_bus_t *bus, const uint8_t *addrs,
+                                    size_t count, rs485_cmd_t cmd);
+
+/**
+ * @brief 在指定总线上查询在线设备
+ * @param bus 总线句柄
+ * @return true 成功, false 失败
+ */
+bool rs485_bus_query_devices(rs485_bus_t *bus);
+
+/**
+ * @brief 向指定总线异步提交灯光命令（不阻塞）
+ * @return true 已入队, false 未打开或队列已满
+ */
+bool rs485_bus_submit_command(rs485_bus_t *bus, rs485_cmd_t cmd,
+                              rs485_done_cb_t done_cb, void *user_ctx);
+
+/**
+ * @brief 向指定总线异步提交在线设备查询（不阻塞）
+ * @return true 已入队, false 未打开或队列已满
+ */
+bool rs485_bus_submit_query_devices(rs485_bus_t *bus, rs485_done_cb_t done_cb,
+                                    void *user_ctx);
+
+/**
+ * @brief 启用接收快速路径
+ *
+ * RX 任务每读出一块 FIFO 数据就推进解析器：按功能码推算帧长，
+ * 并随之调低 UART 的 RX FIFO 满阈值，使预期的最后一个字节一到就
+ * 产生数据事件；收满即发布（只含预期长度，塔灯帧的 00 00 后缀不计
+ * 入），不必等 t3.5；CRC 错误、截断及地址不在列表中的帧
+ * 就地丢弃，不唤醒消费者，也不调用帧接收回调。功能码未知的帧
+ * 仍在线路静默时按 CRC 判断。须在总线空闲时调用（通常紧随
+ * rs485_bus_open()）。
+ *
+ * @param bus 总线句柄
+ * @param dir 本机收请求（从站）还是收应答（主站）
+ * @param addrs 接收的地址列表，广播地址须显式列出；NULL 表示接收所有地址
+ * @param count 地址数量
+ * @return true 成功, false 总线未打开
+ */
+bool rs485_bus_set_rx_filter(rs485_bus_t *bus, rs485_parser_dir_t dir,
+                             const uint8_t *addrs, size_t count);
+
+/**
+ * @brief 注册指定总线的帧接收回调
+ */
+void rs485_bus_register_frame_callback(rs485_bus_t *bus, rs485_frame_cb_t cb,
+                                       void *user_ctx);
+
+/**
+ * @brief 读取总线统计
+ * @param bus 总线句柄
+ * @param stats 输出统计快照
+ * @return true 成功, false 总线未打开
+ */
+bool rs485_bus_get_stats(const rs485_bus_t *bus, rs485_bus_stats_t *stats);
+
+/**
+ * @brief 获取总线所在 UART 端口（按设备统计以端口 + 地址为键）
+ * @return UART 端口号，bus 为 NULL 时返回 UART_NUM_MAX
+ */
+uart_port_t rs485_bus_get_uart(const rs485_bus_t *bus);
+
+/**
+ * @brief 运行中切换波特率与校验（数据位 8、停止位 1 不变）
+ *
+ * 在总线锁内切换，不打断进行中的事务；字符时间、t3.5 与 RX 超时阈值
+ * 随之重算，接收缓冲中的残余字节被清空。
+ *
+ * @param bus 总线句柄
+ * @param baud_rate 波特率
+ * @param parity 校验
+ * @return true 成功, false 总线未打开或 UART 设置失败
+ */
+bool rs485_bus_set_line(rs485_bus_t *bus, int baud_rate, uart_parity_t parity);
+
+/**
+ * @brief 读取当前波特率与校验
+ * @return true 成功, false 总线未打开
+ */
+bool rs485_bus_get_line(const rs485_bus_t *bus, int *baud_rate,
+                        uart_parity_t *parity);
+
+/**
+ * @brief 获取总线字符时间与帧间隔（t3.5）
+ * @param bus 总线句柄
+ * @param char_time_us 输出单字符传输时间（微秒），可为 NULL
+ * @param frame_gap_us 输出帧间隔（微秒），可为 NULL
+ * @return true 成功, false 总线未打开
+ */
+bool rs485_bus_get_timing(const rs485_bus_t *bus, uint32_t *char_time_us,
+                          uint32_t *frame_gap_us);
+
+/**
+ * @brief 获取 rs485_init() 打开的默认总线
+ * @return 默认总线句柄，未初始化时返回 NULL
+ */
+rs485_bus_t *rs485_get_default_bus(void);
+
+/**
+ * @brief 初始化 RS485 通信（打开默认总线）
+ *
+ * 以下不带 bus 参数的接口均作用于默认总线。
+ *
  * @param uart_num UART 端口号
  * @param tx_pin TX 引脚
  * @param rx_pin RX 引脚
+ * @param de_pin 收发器 DE/RE 引脚，传 UART_PIN_NO_CHANGE 表示收发器自动换向；
+ *               指定引脚时启用 UART 硬件 RS485 半双工模式（自动方向控制与冲突检测）
  * @param baud_rate 波特率
  * @return true 成功, false 失败
  */
-bool rs485_init(uart_port_t uart_num, int tx_pin, int rx_pin, int baud_rate);
+bool rs485_init(uart_port_t uart_num, int tx_pin, int rx_pin, int de_pin,
+                int baud_rate);
 
 /**
  * @brief 计算 CRC16 校验码 (Modbus CRC16)
@@ -56,6 +418,35 @@ bool rs485_send_command(rs485_cmd_t cmd);
  */
 bool rs485_send_data(const uint8_t *data, size_t length);
 
+/**
+ * @brief 异步提交 RS485 命令（不阻塞，可在 LVGL 事件回调中调用）
+ * @param cmd 命令类型
+ * @param done_cb 完成回调，可为 NULL
+ * @param user_ctx 透传给回调的用户参数
+ * @return true 已入队, false 未初始化或队列已满
+ */
+bool rs485_submit_command(rs485_cmd_t cmd, rs485_done_cb_t done_cb,
+                          void *user_ctx);
+
+/**
+ * @brief 异步提交在线设备查询（不阻塞）
+ * @param done_cb 完成回调，可为 NULL
+ * @param user_ctx 透传给回调的用户参数
+ * @return true 已入队, false 未初始化或队列已满
+ */
+bool rs485_submit_query_devices(rs485_done_cb_t done_cb, void *user_ctx);
+
+/**
+ * @brief 注册帧接收回调
+ *
+ * RX 任务以 Modbus t3.5 静默间隔切分帧，线路一静默就调用回调。
+ * 回调中不要长时间阻塞，否则会延误后续帧。
+ *
+ * @param cb 回调函数，传 NULL 取消注册
+ * @param user_ctx 透传给回调的用户参数
+ */
+void rs485_register_frame_callback(rs485_frame_cb_t cb, void *user_ctx);
+
 /**
  * @brief 反初始化 RS485 通信
  */
@@ -69,6 +460,9 @@ bool rs485_query_devices(void);
 
 /**
  * @brief 接收 RS485 数据（带超时）
+ *
+ * 返回 RX 任务切分出的下一帧，帧结束后立即返回。
+ *
  * @param buffer 接收缓冲区
  * @param buffer_size 缓冲区大小
  * @param timeout_ms 超时时间（毫秒）
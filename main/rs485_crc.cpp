@@ -0,0 +1,72 @@
+#include "rs485_crc.h"
+
+#include <array>
+
+namespace {
+
+constexpr uint16_t kCrc16Poly = 0xA001;
+
+// 逐位算法，仅用于编译期生成查找表
+constexpr uint16_t crc16_bitwise(uint16_t crc) {
+  for (int j = 0; j < 8; j++) {
+    crc = (crc & 0x0001) ? (crc >> 1) ^ kCrc16Poly : crc >> 1;
+  }
+  return crc;
+}
+
+// kTables[k][i]：字节 i 后再跟 k 个零字节时的 CRC 贡献，供 slicing-by-4 使用
+using crc16_tables_t = std::array<std::array<uint16_t, 256>, 4>;
+
+constexpr crc16_tables_t make_crc16_tables() {
+  crc16_tables_t t{};
+  for (int i = 0; i < 256; i++) {
+    t[0][i] = crc16_bitwise((uint16_t)i);
+  }
+  for (int k = 1; k < 4; k++) {
+    for (int i = 0; i < 256; i++) {
+      t[k][i] = (t[k - 1][i] >> 8) ^ t[0][t[k - 1][i] & 0xFF];
+    }
+  }
+  return t;
+}
+
+constexpr crc16_tables_t kTables = make_crc16_tables();
+
+static_assert(kTables[0][0x01] == 0xC0C1, "Modbus CRC16 table mismatch");
+static_assert(kTables[0][0xFF] == 0x4040, "Modbus CRC16 table mismatch");
+
+} // namespace
+
+extern "C" uint16_t rs485_crc16_update_byte(uint16_t crc, uint8_t byte) {
+  return (crc >> 8) ^ kTables[0][(crc ^ byte) & 0xFF];
+}
+
+extern "C" uint16_t rs485_crc16_update(uint16_t crc, const uint8_t *data,
+                                       size_t length) {
+  while (length >= 4) {
+    uint16_t x = crc ^ (uint16_t)(data[0] | (data[1] << 8));
+    crc = kTables[3][x & 0xFF] ^ kTables[2][x >> 8] ^ kTables[1][data[2]] ^
+          kTables[0][data[3]];
+    data += 4;
+    length -= 4;
+  }
+  while (length--) {
+    crc = (crc >> 8) ^ kTables[0][(crc ^ *data++) & 0xFF];
+  }
+  return crc;
+}
+
+extern "C" uint16_t rs485_crc16_bitwise(const uint8_t *data, size_t length) {
+  uint16_t crc = RS485_CRC16_INIT;
+  for (size_t i = 0; i < length; i++) {
+    crc ^= (uint16_t)data[i];
+    for (uint8_t j = 0; j < 8; j++) {
+      if (crc & 0x0001) {
+        crc = (crc >> 1) ^ kCrc16Poly;
+      } else {
+        crc >>= 1;
+      }
+    }
+  }
+  return crc;
+}
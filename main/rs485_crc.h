@@ -0,0 +1,46 @@
+#ifndef RS485_CRC_H
+#define RS485_CRC_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Modbus CRC16 初始值（多项式 0xA001，反射）
+#define RS485_CRC16_INIT 0xFFFF
+
+/**
+ * @brief 增量更新 CRC16（单字节）
+ *
+ * 用于接收路径边收边算：对完整 Modbus 帧（含末尾 CRC）累计后结果为 0。
+ *
+ * @param crc 当前 CRC 状态，首次传 RS485_CRC16_INIT
+ * @param byte 新字节
+ * @return 更新后的 CRC 状态
+ */
+uint16_t rs485_crc16_update_byte(uint16_t crc, uint8_t byte);
+
+/**
+ * @brief 增量更新 CRC16（数据块，slicing-by-4 查表）
+ * @param crc 当前 CRC 状态，首次传 RS485_CRC16_INIT
+ * @param data 数据缓冲区
+ * @param length 数据长度
+ * @return 更新后的 CRC 状态
+ */
+uint16_t rs485_crc16_update(uint16_t crc, const uint8_t *data, size_t length);
+
+/**
+ * @brief 逐位参考实现（原始算法），仅用于等价性校验与基准对比
+ * @param data 数据缓冲区
+ * @param length 数据长度
+ * @return 完整 CRC16
+ */
+uint16_t rs485_crc16_bitwise(const uint8_t *data, size_t length);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // RS485_CRC_H
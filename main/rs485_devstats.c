@@ -0,0 +1,182 @@
+#include "rs485_devstats.h"
+#include "freertos/FreeRTOS.h"
+#include <string.h>
+
+// 每个设备一个槽位；写者在临界区内串行更新并推进序号，
+// 读者不加锁，按序号前后一致性判断是否需要重读（seqlock）
+typedef struct {
+    uint32_t seq; // 奇数表示正在更新
+    rs485_device_stats_t stats;
+} rs485_devstats_slot_t;
+
+static portMUX_TYPE s_devstats_lock = portMUX_INITIALIZER_UNLOCKED;
+static rs485_devstats_slot_t s_slots[RS485_DEVSTATS_MAX_DEVICES];
+static uint32_t s_slot_count = 0;
+// 地址 -> 槽位号 + 1，0 表示未分配
+static uint8_t s_slot_index[UART_NUM_MAX][256];
+
+static unsigned rs485_latency_bucket(uint32_t us) {
+    if (us < (1u << RS485_LATENCY_BUCKET_SHIFT)) {
+        return 0;
+    }
+    unsigned bucket = (unsigned)(31 - __builtin_clz(us)) - RS485_LATENCY_BUCKET_SHIFT + 1;
+    return bucket < RS485_LATENCY_BUCKETS ? bucket : RS485_LATENCY_BUCKETS - 1;
+}
+
+void rs485_latency_hist_add(rs485_latency_hist_t *hist, uint32_t us) {
+    hist->buckets[rs485_latency_bucket(us)]++;
+    if (hist->count == 0 || us < hist->min_us) {
+        hist->min_us = us;
+    }
+    if (us > hist->max_us) {
+        hist->max_us = us;
+    }
+    hist->count++;
+    hist->sum_us += us;
+}
+
+// 查找或分配槽位；调用者需在临界区内
+static rs485_devstats_slot_t *rs485_devstats_slot_locked(uart_port_t uart_num, uint8_t address) {
+    if (uart_num < 0 || uart_num >= UART_NUM_MAX) {
+        return NULL;
+    }
+    uint8_t index = s_slot_index[uart_num][address];
+    if (index != 0) {
+        return &s_slots[index - 1];
+    }
+    if (s_slot_count >= RS485_DEVSTATS_MAX_DEVICES) {
+        return NULL; // 表满，新设备不再统计
+    }
+
+    rs485_devstats_slot_t *slot = &s_slots[s_slot_count];
+    memset(slot, 0, sizeof(*slot));
+    slot->stats.uart_num = (uint8_t)uart_num;
+    slot->stats.address = address;
+    __atomic_store_n(&s_slot_index[uart_num][address], (uint8_t)(s_slot_count + 1), __ATOMIC_RELEASE);
+    __atomic_store_n(&s_slot_count, s_slot_count + 1, __ATOMIC_RELEASE);
+    return slot;
+}
+
+static rs485_devstats_slot_t *rs485_devstats_begin(uart_port_t uart_num, uint8_t address) {
+    portENTER_CRITICAL(&s_devstats_lock);
+    rs485_devstats_slot_t *slot = rs485_devstats_slot_locked(uart_num, address);
+    if (slot == NULL) {
+        portEXIT_CRITICAL(&s_devstats_lock);
+        return NULL;
+    }
+    __atomic_store_n(&slot->seq, slot->seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    return slot;
+}
+
+static void rs485_devstats_end(rs485_devstats_slot_t *slot) {
+    __atomic_store_n(&slot->seq, slot->seq + 1, __ATOMIC_RELEASE);
+    portEXIT_CRITICAL(&s_devstats_lock);
+}
+
+void rs485_devstats_record_tx(uart_port_t uart_num, uint8_t address) {
+    rs485_devstats_slot_t *slot = rs485_devstats_begin(uart_num, address);
+    if (slot != NULL) {
+        slot->stats.tx_frames++;
+        rs485_devstats_end(slot);
+    }
+}
+
+void rs485_devstats_record_response(uart_port_t uart_num, uint8_t address, bool crc_ok, uint32_t first_byte_us,
+                                    uint32_t last_byte_us) {
+    rs485_devstats_slot_t *slot = rs485_devstats_begin(uart_num, address);
+    if (slot == NULL) {
+        return;
+    }
+    slot->stats.rx_frames++;
+    if (crc_ok) {
+        // 只有 CRC 正确的应答计入延迟，避免噪声帧污染分布
+        rs485_latency_hist_add(&slot->stats.first_byte, first_byte_us);
+        rs485_latency_hist_add(&slot->stats.last_byte, last_byte_us);
+    } else {
+        slot->stats.crc_errors++;
+    }
+    rs485_devstats_end(slot);
+}
+
+void rs485_devstats_record_timeout(uart_port_t uart_num, uint8_t address) {
+    rs485_devstats_slot_t *slot = rs485_devstats_begin(uart_num, address);
+    if (slot != NULL) {
+        slot->stats.timeouts++;
+        rs485_devstats_end(slot);
+    }
+}
+
+void rs485_devstats_record_framing_error(uart_port_t uart_num, uint8_t address) {
+    rs485_devstats_slot_t *slot = rs485_devstats_begin(uart_num, address);
+    if (slot != NULL) {
+        slot->stats.framing_errors++;
+        rs485_devstats_end(slot);
+    }
+}
+
+void rs485_devstats_record_retry(uart_port_t uart_num, uint8_t address) {
+    rs485_devstats_slot_t *slot = rs485_devstats_begin(uart_num, address);
+    if (slot != NULL) {
+        slot->stats.retries++;
+        rs485_devstats_end(slot);
+    }
+}
+
+// 无锁读取一个槽位：序号为奇数或前后不一致时重读
+static void rs485_devstats_read_slot(const rs485_devstats_slot_t *slot, rs485_device_stats_t *stats) {
+    uint32_t begin;
+    uint32_t end;
+    do {
+        begin = __atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE);
+        *stats = slot->stats;
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        end = __atomic_load_n(&slot->seq, __ATOMIC_RELAXED);
+    } while ((begin & 1) != 0 || begin != end);
+}
+
+bool rs485_devstats_snapshot(uart_port_t uart_num, uint8_t address, rs485_device_stats_t *stats) {
+    if (uart_num < 0 || uart_num >= UART_NUM_MAX || stats == NULL) {
+        return false;
+    }
+    uint8_t index = __atomic_load_n(&s_slot_index[uart_num][address], __ATOMIC_ACQUIRE);
+    if (index == 0) {
+        return false;
+    }
+    rs485_devstats_read_slot(&s_slots[index - 1], stats);
+    return true;
+}
+
+size_t rs485_devstats_snapshot_all(rs485_device_stats_t *stats, size_t max_devices) {
+    uint32_t count = __atomic_load_n(&s_slot_count, __ATOMIC_ACQUIRE);
+    if (count > max_devices) {
+        count = (uint32_t)max_devices;
+    }
+    for (uint32_t i = 0; i < count; i++) {
+        rs485_devstats_read_slot(&s_slots[i], &stats[i]);
+    }
+    return count;
+}
+
+void rs485_devstats_reset(void) {
+    portENTER_CRITICAL(&s_devstats_lock);
+    __atomic_store_n(&s_slot_count, 0, __ATOMIC_RELEASE);
+    memset(s_slot_index, 0, sizeof(s_slot_index));
+    portEXIT_CRITICAL(&s_devstats_lock);
+}
+
+uint32_t rs485_latency_percentile_us(const rs485_latency_hist_t *hist, unsigned percent) {
+    if (hist->count == 0) {
+        return 0;
+    }
+    uint64_t target = ((uint64_t)hist->count * percent + 99) / 100;
+    uint64_t seen = 0;
+    for (unsigned i = 0; i < RS485_LATENCY_BUCKETS - 1; i++) {
+        seen += hist->buckets[i];
+        if (seen >= target && seen > 0) {
+            uint32_t upper = 1u << (i + RS485_LATENCY_BUCKET_SHIFT);
+            return upper < hist->max_us ? upper : hist->max_us;
+        }
+    }
+    return hist->max_us;
+}
@@ -0,0 +1,96 @@
+#ifndef RS485_DEVSTATS_H
+#define RS485_DEVSTATS_H
+
+#include "driver/uart.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// 同时跟踪的设备数（按 UART 端口 + 从站地址区分）
+#define RS485_DEVSTATS_MAX_DEVICES 32
+
+// 延迟直方图：桶 0 覆盖 [0, 128) 微秒，桶 i 覆盖 [2^(i+6), 2^(i+7))，
+// 末桶（>= 2^21 即约 2 秒）收纳所有更大值
+#define RS485_LATENCY_BUCKETS 16
+#define RS485_LATENCY_BUCKET_SHIFT 7 // 桶 0 上界为 2^7 微秒
+
+// 对数分桶的延迟直方图（微秒）
+typedef struct {
+  uint32_t buckets[RS485_LATENCY_BUCKETS];
+  uint32_t count;
+  uint32_t min_us;
+  uint32_t max_us;
+  uint64_t sum_us;
+} rs485_latency_hist_t;
+
+// 单个设备的统计快照
+typedef struct {
+  uint8_t uart_num;
+  uint8_t address;
+  uint32_t tx_frames;      // 发往该设备的请求帧
+  uint32_t rx_frames;      // 收到的应答帧（含 CRC 错误）
+  uint32_t crc_errors;     // 应答 CRC 错误
+  uint32_t framing_errors; // 等待应答期间出现帧错误/校验错误
+  uint32_t timeouts;       // 应答超时
+  uint32_t retries;        // 上层重试次数
+  rs485_latency_hist_t first_byte; // 请求发送完成到应答首字节
+  rs485_latency_hist_t last_byte;  // 请求发送完成到应答末字节
+} rs485_device_stats_t;
+
+/*
+ * 记录接口由总线层与主站在事务路径上调用，只做计数与分桶；
+ * 延迟由调用者传入，本模块不读时钟，便于用合成时间驱动。
+ */
+void rs485_devstats_record_tx(uart_port_t uart_num, uint8_t address);
+void rs485_devstats_record_response(uart_port_t uart_num, uint8_t address,
+                                    bool crc_ok, uint32_t first_byte_us,
+                                    uint32_t last_byte_us);
+void rs485_devstats_record_timeout(uart_port_t uart_num, uint8_t address);
+void rs485_devstats_record_framing_error(uart_port_t uart_num,
+                                         uint8_t address);
+void rs485_devstats_record_retry(uart_port_t uart_num, uint8_t address);
+
+/**
+ * @brief 读取单个设备的统计快照（读者无锁，与记录并发时自动重读）
+ * @return true 找到, false 该设备尚无记录
+ */
+bool rs485_devstats_snapshot(uart_port_t uart_num, uint8_t address,
+                             rs485_device_stats_t *stats);
+
+/**
+ * @brief 读取所有设备的统计快照
+ * @param stats 输出数组
+ * @param max_devices 数组容量
+ * @return 复制的设备数
+ */
+size_t rs485_devstats_snapshot_all(rs485_device_stats_t *stats,
+                                   size_t max_devices);
+
+/**
+ * @brief 清空所有设备统计
+ */
+void rs485_devstats_reset(void);
+
+/**
+ * @brief 向直方图加入一个样本（调用者负责并发保护）
+ */
+void rs485_latency_hist_add(rs485_latency_hist_t *hist, uint32_t us);
+
+/**
+ * @brief 由直方图估算延迟分位数（取所在桶的上界）
+ * @param hist 直方图
+ * @param percent 分位（0-100）
+ * @return 延迟上界（微秒），无样本时返回 0
+ */
+uint32_t rs485_latency_percentile_us(const rs485_latency_hist_t *hist,
+                                     unsigned percent);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // RS485_DEVSTATS_H
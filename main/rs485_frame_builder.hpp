@@ -0,0 +1,77 @@
+#ifndef RS485_FRAME_BUILDER_HPP
+#define RS485_FRAME_BUILDER_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+// 编译期 Modbus RTU 帧构建（仅头文件）
+//
+// 塔灯帧格式：地址 功能码 寄存器(2) 值(2) CRC低 CRC高 00 00
+// 即标准 8 字节 FC03/FC06 帧后附固定后缀 00 00，共 10 字节。
+// 所有参数已知的帧都在编译期生成（含 CRC），以常量形式存放在 flash 中。
+
+namespace rs485 {
+
+inline constexpr std::size_t kFrameLength = 10;
+using frame_t = std::array<uint8_t, kFrameLength>;
+
+inline constexpr uint8_t kFcReadHolding = 0x03;
+inline constexpr uint8_t kFcWriteSingle = 0x06;
+
+// 编译期 CRC（逐位算法；运行期请用 rs485_crc16_update）
+constexpr uint16_t crc16(const uint8_t *data, std::size_t length) {
+  uint16_t crc = 0xFFFF;
+  for (std::size_t i = 0; i < length; i++) {
+    crc ^= data[i];
+    for (int j = 0; j < 8; j++) {
+      crc = (crc & 0x0001) ? (crc >> 1) ^ 0xA001 : crc >> 1;
+    }
+  }
+  return crc;
+}
+
+constexpr frame_t make_frame(uint8_t addr, uint8_t fc, uint16_t reg,
+                             uint16_t value) {
+  frame_t f{};
+  f[0] = addr;
+  f[1] = fc;
+  f[2] = (uint8_t)(reg >> 8);
+  f[3] = (uint8_t)(reg & 0xFF);
+  f[4] = (uint8_t)(value >> 8);
+  f[5] = (uint8_t)(value & 0xFF);
+  uint16_t crc = crc16(f.data(), 6);
+  f[6] = (uint8_t)(crc & 0xFF); // CRC低字节
+  f[7] = (uint8_t)(crc >> 8);   // CRC高字节
+  f[8] = 0x00;                  // 固定后缀：00
+  f[9] = 0x00;                  // 固定后缀：00
+  return f;
+}
+
+// 单帧常量，例如 frame_v<0x01, kFcWriteSingle, 0x00C2, 0x11>
+template <uint8_t Addr, uint8_t Fc, uint16_t Reg, uint16_t Value>
+inline constexpr frame_t frame_v = make_frame(Addr, Fc, Reg, Value);
+
+// 一个地址下对一组值的写单寄存器帧，顺序与 Values 一致
+template <uint8_t Addr, uint16_t Reg, uint16_t... Values>
+inline constexpr std::array<frame_t, sizeof...(Values)> write_frames_v = {
+    make_frame(Addr, kFcWriteSingle, Reg, Values)...};
+
+// 一组地址 × 一组值的写单寄存器帧表
+template <uint16_t Reg, typename Addrs, typename Values> struct write_table;
+
+template <uint16_t Reg, uint8_t... Addrs, uint16_t... Values>
+struct write_table<Reg, std::integer_sequence<uint8_t, Addrs...>,
+                   std::integer_sequence<uint16_t, Values...>> {
+  static constexpr std::size_t kAddrCount = sizeof...(Addrs);
+  static constexpr std::size_t kValueCount = sizeof...(Values);
+  static constexpr std::array<uint8_t, kAddrCount> kAddrs = {Addrs...};
+  static constexpr std::array<uint16_t, kValueCount> kValues = {Values...};
+  static constexpr std::array<std::array<frame_t, kValueCount>, kAddrCount>
+      kFrames = {write_frames_v<Addrs, Reg, Values...>...};
+};
+
+} // namespace rs485
+
+#endif // RS485_FRAME_BUILDER_HPP
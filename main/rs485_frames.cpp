@@ -0,0 +1,81 @@
+#include "rs485_frames.h"
+#include "rs485_crc.h"
+#include "rs485_frame_builder.hpp"
+
+namespace {
+
+// 已配置的塔灯地址，另含广播地址以便一帧控制整条线
+using device_addrs_t = std::integer_sequence<uint8_t, RS485_DEVICE_ADDR,
+                                             RS485_MODBUS_BROADCAST_ADDR>;
+
+// rs485_cmd_t 全部取值
+using light_cmds_t = std::integer_sequence<
+    uint16_t, RS485_CMD_RED_ON, RS485_CMD_YELLOW_ON, RS485_CMD_GREEN_ON,
+    RS485_CMD_RED_SLOW_FLASH, RS485_CMD_YELLOW_SLOW_FLASH,
+    RS485_CMD_GREEN_SLOW_FLASH, RS485_CMD_RED_BURST_FLASH,
+    RS485_CMD_YELLOW_BURST_FLASH, RS485_CMD_GREEN_BURST_FLASH,
+    RS485_CMD_LIGHT_OFF>;
+
+using light_table_t =
+    rs485::write_table<RS485_REG_LIGHT, device_addrs_t, light_cmds_t>;
+
+// 查询在线设备: FF 03 00 3F 00 00 [CRC低] [CRC高] 00 00
+constexpr rs485::frame_t kQueryFrame =
+    rs485::frame_v<RS485_BROADCAST_ADDR, rs485::kFcReadHolding,
+                   RS485_REG_QUERY, 0x0000>;
+
+// CRC 与原先运行期构建的帧一致
+static_assert(rs485::frame_v<0x01, 0x06, 0x00C2, 0x11>[6] == 0xE8 &&
+                  rs485::frame_v<0x01, 0x06, 0x00C2, 0x11>[7] == 0x3A,
+              "light frame CRC mismatch");
+static_assert(kQueryFrame[6] == 0x60 && kQueryFrame[7] == 0x18,
+              "query frame CRC mismatch");
+
+// 命令字节 -> 表内下标，-1 表示未知命令
+constexpr std::array<int8_t, 256> make_cmd_index() {
+  std::array<int8_t, 256> index{};
+  for (auto &i : index) {
+    i = -1;
+  }
+  for (std::size_t i = 0; i < light_table_t::kValueCount; i++) {
+    index[light_table_t::kValues[i]] = (int8_t)i;
+  }
+  return index;
+}
+
+constexpr std::array<int8_t, 256> kCmdIndex = make_cmd_index();
+
+} // namespace
+
+extern "C" const uint8_t *rs485_frames_command(uint8_t addr, rs485_cmd_t cmd) {
+  int8_t cmd_index = kCmdIndex[(uint8_t)cmd];
+  if (cmd_index < 0) {
+    return nullptr;
+  }
+  for (std::size_t a = 0; a < light_table_t::kAddrCount; a++) {
+    if (light_table_t::kAddrs[a] == addr) {
+      return light_table_t::kFrames[a][cmd_index].data();
+    }
+  }
+  return nullptr;
+}
+
+extern "C" const uint8_t *rs485_frames_query_devices(void) {
+  return kQueryFrame.data();
+}
+
+extern "C" size_t rs485_frames_build(uint8_t *out, uint8_t addr, uint8_t fc,
+                                     uint16_t reg, uint16_t value) {
+  out[0] = addr;
+  out[1] = fc;
+  out[2] = (uint8_t)(reg >> 8);
+  out[3] = (uint8_t)(reg & 0xFF);
+  out[4] = (uint8_t)(value >> 8);
+  out[5] = (uint8_t)(value & 0xFF);
+  uint16_t crc = rs485_crc16_update(RS485_CRC16_INIT, out, 6);
+  out[6] = (uint8_t)(crc & 0xFF);
+  out[7] = (uint8_t)(crc >> 8);
+  out[8] = 0x00;
+  out[9] = 0x00;
+  return RS485_FRAME_LENGTH;
+}
@@ -0,0 +1,57 @@
+#ifndef RS485_FRAMES_H
+#define RS485_FRAMES_H
+
+#include "rs485_comm.h"
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// 塔灯帧长度（8 字节 Modbus 帧 + 固定后缀 00 00）
+#define RS485_FRAME_LENGTH 10
+
+// 塔灯寄存器与地址
+#define RS485_DEVICE_ADDR 0x01     // 默认塔灯地址
+#define RS485_BROADCAST_ADDR 0xFF  // 查询在线设备使用的地址
+#define RS485_MODBUS_BROADCAST_ADDR 0x00 // Modbus 广播地址，从站执行但不应答
+#define RS485_REG_LIGHT 0x00C2     // 灯光命令寄存器
+#define RS485_REG_QUERY 0x003F     // 在线查询寄存器
+
+// 塔灯可读寄存器表，用 modbus_regmap.h 的 MODBUS_REGMAP_DEFINE 展开
+#define RS485_TOWER_REGMAP(X, p)                                              \
+  X(p, address, 0x03, RS485_REG_QUERY, u16)                                   \
+  X(p, light, 0x03, RS485_REG_LIGHT, u16)
+
+/**
+ * @brief 获取预生成的灯光命令帧（编译期生成，位于 flash）
+ * @param addr 设备地址，必须是已配置的地址或 RS485_MODBUS_BROADCAST_ADDR
+ * @param cmd 命令类型
+ * @return 指向 RS485_FRAME_LENGTH 字节帧的指针，未预生成时返回 NULL
+ */
+const uint8_t *rs485_frames_command(uint8_t addr, rs485_cmd_t cmd);
+
+/**
+ * @brief 获取预生成的在线设备查询帧
+ * @return 指向 RS485_FRAME_LENGTH 字节帧的指针
+ */
+const uint8_t *rs485_frames_query_devices(void);
+
+/**
+ * @brief 运行期构建帧（仅用于参数动态的报文）
+ * @param out 输出缓冲区，至少 RS485_FRAME_LENGTH 字节
+ * @param addr 设备地址
+ * @param fc 功能码
+ * @param reg 寄存器地址
+ * @param value 寄存器值或数量
+ * @return 帧长度
+ */
+size_t rs485_frames_build(uint8_t *out, uint8_t addr, uint8_t fc, uint16_t reg,
+                          uint16_t value);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // RS485_FRAMES_H
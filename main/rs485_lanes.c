@@ -0,0 +1,56 @@
+#include "rs485_lanes.h"
+#include <string.h>
+
+void rs485_lanes_init(rs485_lanes_t *lanes) {
+    memset(lanes, 0, sizeof(*lanes));
+}
+
+bool rs485_lanes_acquire(rs485_lanes_t *lanes, rs485_lane_t lane) {
+    // 空闲且无人排队才直接获得；有人排队时总线必然忙（释放即转交）
+    if (!lanes->busy) {
+        lanes->busy = true;
+        lanes->owner = (uint8_t)lane;
+        return true;
+    }
+    lanes->waiting[lane]++;
+    return false;
+}
+
+int rs485_lanes_release(rs485_lanes_t *lanes, uint32_t hold_us) {
+    rs485_lane_stats_t *owner = &lanes->stats[lanes->owner];
+    if (hold_us > owner->max_hold_us) {
+        owner->max_hold_us = hold_us;
+    }
+
+    // 严格优先级：总线直接转交给最高的非空通道，避免释放与唤醒之间被低通道抢占
+    for (int lane = 0; lane < RS485_LANE_COUNT; lane++) {
+        if (lanes->waiting[lane] > 0) {
+            lanes->waiting[lane]--;
+            lanes->owner = (uint8_t)lane;
+            return lane;
+        }
+    }
+    lanes->busy = false;
+    return -1;
+}
+
+void rs485_lanes_record_wait(rs485_lanes_t *lanes, rs485_lane_t lane, uint32_t wait_us) {
+    rs485_lane_stats_t *st = &lanes->stats[lane];
+    st->grants++;
+    if (wait_us > 0) {
+        st->waits++;
+        st->total_wait_us += wait_us;
+        if (wait_us > st->max_wait_us) {
+            st->max_wait_us = wait_us;
+        }
+    }
+}
+
+bool rs485_lanes_should_yield(const rs485_lanes_t *lanes, rs485_lane_t lane) {
+    for (int higher = 0; higher < (int)lane; higher++) {
+        if (lanes->waiting[higher] > 0) {
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,79 @@
+#ifndef RS485_LANES_H
+#define RS485_LANES_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * 总线优先级通道：总线空闲时按严格优先级放行等待者（同一通道内先来
+ * 先得）。一次持有期内的事务不会被打断，因此高优先级通道的最坏等待
+ * 约为其他通道单次持有时间的最大值。
+ *
+ * 本模块只维护排队计数与统计，不阻塞也不读时钟，调用者负责加锁与
+ * 唤醒；离线基准工具直接包含。
+ */
+
+// 优先级通道，数值越小优先级越高
+typedef enum {
+  RS485_LANE_ALARM = 0, // 报警命令（如红灯爆闪），须在限定时间内送达
+  RS485_LANE_COMMAND,   // 操作员命令
+  RS485_LANE_POLL,      // 后台轮询、查询与扫描
+  RS485_LANE_COUNT,
+} rs485_lane_t;
+
+// 单个通道的统计（微秒）
+typedef struct {
+  uint32_t grants;       // 获得总线的次数
+  uint32_t waits;        // 其中需要排队的次数
+  uint32_t max_wait_us;  // 最坏排队等待
+  uint64_t total_wait_us;
+  uint32_t max_hold_us;  // 单次持有总线的最长时间
+  uint32_t yields;       // 多帧操作为更高通道让出总线的次数
+} rs485_lane_stats_t;
+
+typedef struct {
+  bool busy;
+  uint8_t owner;                      // 当前持有者所在通道
+  uint16_t waiting[RS485_LANE_COUNT]; // 各通道排队数
+  rs485_lane_stats_t stats[RS485_LANE_COUNT];
+} rs485_lanes_t;
+
+/**
+ * @brief 初始化（总线空闲、统计清零）
+ */
+void rs485_lanes_init(rs485_lanes_t *lanes);
+
+/**
+ * @brief 申请总线
+ * @return true 立即获得, false 已排队，须等 rs485_lanes_release() 放行本通道
+ */
+bool rs485_lanes_acquire(rs485_lanes_t *lanes, rs485_lane_t lane);
+
+/**
+ * @brief 释放总线并选出下一持有者
+ * @param hold_us 本次持有时间，计入持有者通道的统计
+ * @return 被放行的通道（调用者唤醒该通道的一个等待者）；无人等待时返回 -1
+ */
+int rs485_lanes_release(rs485_lanes_t *lanes, uint32_t hold_us);
+
+/**
+ * @brief 记录一次获得总线时的等待时间（立即获得时传 0）
+ */
+void rs485_lanes_record_wait(rs485_lanes_t *lanes, rs485_lane_t lane,
+                             uint32_t wait_us);
+
+/**
+ * @brief 是否有比 lane 更高优先级的通道在排队（多帧操作在帧间据此让出总线）
+ */
+bool rs485_lanes_should_yield(const rs485_lanes_t *lanes, rs485_lane_t lane);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // RS485_LANES_H
@@ -0,0 +1,130 @@
+#include "rs485_parser.h"
+#include <string.h>
+
+#ifdef ESP_PLATFORM
+#include "esp_attr.h"
+#else
+// 离线回放工具在主机上直接编译本文件
+#define IRAM_ATTR
+#define DRAM_ATTR
+#define FORCE_INLINE_ATTR static inline __attribute__((always_inline))
+#endif
+
+// 半字节 CRC16 表（多项式 0xA001），只有 32 字节，与解析器一起常驻内存，
+// 解析热路径不经过 flash cache
+static DRAM_ATTR const uint16_t s_crc_nibble[16] = {
+    0x0000, 0xCC01, 0xD801, 0x1400, 0xF001, 0x3C00, 0x2800, 0xE401,
+    0xA001, 0x6C00, 0x7800, 0xB401, 0x5000, 0x9C01, 0x8801, 0x4400,
+};
+
+FORCE_INLINE_ATTR uint16_t rs485_parser_crc_byte(uint16_t crc, uint8_t byte) {
+    crc = (crc >> 4) ^ s_crc_nibble[(crc ^ byte) & 0x0F];
+    crc = (crc >> 4) ^ s_crc_nibble[(crc ^ (byte >> 4)) & 0x0F];
+    return crc;
+}
+
+// 由功能码确定帧长：固定长度直接给出，变长帧记下字节数字段位置
+// 长度均含地址、功能码与 CRC
+static IRAM_ATTR void rs485_parser_on_function(rs485_parser_t *p, uint8_t fc) {
+    if (p->dir == RS485_PARSER_RESPONSE) {
+        if (fc & 0x80) {
+            p->expected = 5; // 异常应答
+            return;
+        }
+        switch (fc) {
+        case 0x01: case 0x02: case 0x03: case 0x04: case 0x0C: case 0x11: case 0x17:
+            p->count_index = 2;
+            return;
+        case 0x07:
+            p->expected = 5;
+            return;
+        case 0x05: case 0x06: case 0x0B: case 0x0F: case 0x10:
+            p->expected = 8;
+            return;
+        case 0x16:
+            p->expected = 10;
+            return;
+        default:
+            break;
+        }
+    } else {
+        switch (fc) {
+        case 0x01: case 0x02: case 0x03: case 0x04: case 0x05: case 0x06:
+            p->expected = 8;
+            return;
+        case 0x07: case 0x0B: case 0x0C: case 0x11:
+            p->expected = 4;
+            return;
+        case 0x0F: case 0x10:
+            p->count_index = 6;
+            return;
+        case 0x16:
+            p->expected = 10;
+            return;
+        case 0x17:
+            p->count_index = 10;
+            return;
+        default:
+            break;
+        }
+    }
+    p->open_length = true;
+}
+
+void rs485_parser_init(rs485_parser_t *parser, rs485_parser_dir_t dir) {
+    memset(parser, 0, sizeof(*parser));
+    parser->dir = dir;
+    rs485_parser_reset(parser);
+}
+
+void rs485_parser_accept(rs485_parser_t *parser, uint8_t address) {
+    parser->filter = true;
+    parser->accept[address >> 5] |= 1u << (address & 31);
+}
+
+IRAM_ATTR void rs485_parser_reset(rs485_parser_t *parser) {
+    parser->received = 0;
+    parser->expected = 0;
+    parser->crc = 0xFFFF;
+    parser->count_index = 0;
+    parser->open_length = false;
+    parser->result = RS485_PARSE_INCOMPLETE;
+}
+
+IRAM_ATTR rs485_parse_result_t rs485_parser_feed(rs485_parser_t *p, const uint8_t *data, size_t length) {
+    for (size_t i = 0; i < length && p->result == RS485_PARSE_INCOMPLETE; i++) {
+        uint8_t byte = data[i];
+        uint16_t pos = p->received++;
+        p->crc = rs485_parser_crc_byte(p->crc, byte);
+
+        if (pos == 0) {
+            if (p->filter && !(p->accept[byte >> 5] & (1u << (byte & 31)))) {
+                p->result = RS485_PARSE_FOREIGN;
+            }
+            continue;
+        }
+        if (pos == 1) {
+            rs485_parser_on_function(p, byte);
+        } else if (p->count_index != 0 && pos == p->count_index) {
+            // 字节数字段之后还有 byte 个数据字节和 2 字节 CRC
+            p->expected = (uint16_t)(pos + 1 + byte + 2);
+        }
+        if (p->expected > RS485_PARSER_MAX_FRAME || (p->open_length && p->received > RS485_PARSER_MAX_FRAME)) {
+            p->result = RS485_PARSE_OVERRUN;
+        } else if (p->expected != 0 && p->received == p->expected) {
+            p->result = p->crc == 0 ? RS485_PARSE_FRAME : RS485_PARSE_CRC_ERROR;
+        }
+    }
+    return p->result;
+}
+
+IRAM_ATTR rs485_parse_result_t rs485_parser_finish(rs485_parser_t *p) {
+    if (p->result == RS485_PARSE_INCOMPLETE) {
+        if (p->open_length && p->received >= 4) {
+            p->result = p->crc == 0 ? RS485_PARSE_FRAME : RS485_PARSE_CRC_ERROR;
+        } else {
+            p->result = RS485_PARSE_TRUNCATED;
+        }
+    }
+    return p->result;
+}
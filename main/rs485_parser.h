@@ -0,0 +1,83 @@
+#ifndef RS485_PARSER_H
+#define RS485_PARSER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// 单帧上限，与 RS485_FRAME_MAX_LEN 相同（本头文件不依赖 ESP-IDF）
+#define RS485_PARSER_MAX_FRAME 256
+
+// 解析方向：从站收请求，主站收应答，二者按功能码推算的帧长不同
+typedef enum {
+  RS485_PARSER_REQUEST = 0,
+  RS485_PARSER_RESPONSE,
+} rs485_parser_dir_t;
+
+// 解析结果
+typedef enum {
+  RS485_PARSE_INCOMPLETE = 0, // 需要更多字节（或功能码未知，须等 t3.5 判断）
+  RS485_PARSE_FRAME,          // 已收满预期长度且 CRC 正确
+  RS485_PARSE_FOREIGN,        // 地址不在接收列表中，丢弃至下一次静默
+  RS485_PARSE_CRC_ERROR,      // 已收满预期长度但 CRC 错误
+  RS485_PARSE_OVERRUN,        // 长度字段超出单帧上限
+  RS485_PARSE_TRUNCATED,      // 未收满预期长度线路即静默
+} rs485_parse_result_t;
+
+// 逐字节帧解析器：按功能码确定帧长并边收边算 CRC
+typedef struct {
+  rs485_parser_dir_t dir;
+  bool filter;         // 为 false 时接收所有地址
+  uint32_t accept[8];  // 接收地址位图
+  uint16_t received;   // 本帧已收字节数
+  uint16_t expected;   // 含 CRC 的预期帧长，0 表示尚未确定
+  uint16_t crc;        // 已收字节的 CRC 累计，整帧正确时为 0
+  uint8_t count_index; // 字节数字段的位置，0 表示帧长固定或未知
+  bool open_length;    // 功能码未知，只能等线路静默
+  rs485_parse_result_t result;
+} rs485_parser_t;
+
+/**
+ * @brief 初始化解析器（接收所有地址）
+ */
+void rs485_parser_init(rs485_parser_t *parser, rs485_parser_dir_t dir);
+
+/**
+ * @brief 把地址加入接收列表；广播地址须显式加入
+ */
+void rs485_parser_accept(rs485_parser_t *parser, uint8_t address);
+
+/**
+ * @brief 开始新的一帧（线路静默 t3.5 时调用）
+ */
+void rs485_parser_reset(rs485_parser_t *parser);
+
+/**
+ * @brief 喂入一段字节（通常是一次 FIFO 读出的数据）
+ *
+ * 一旦得出 INCOMPLETE 以外的结果，本帧后续字节（如塔灯帧的 00 00
+ * 后缀）都被忽略，结果保持不变直到 rs485_parser_reset()。
+ *
+ * @return 当前解析结果
+ */
+rs485_parse_result_t rs485_parser_feed(rs485_parser_t *parser,
+                                       const uint8_t *data, size_t length);
+
+/**
+ * @brief 线路静默时结束本帧
+ *
+ * 功能码未知的帧只能在此按 CRC 判断；预期长度已知但未收满为截断帧。
+ *
+ * @return 本帧最终结果，不会是 RS485_PARSE_INCOMPLETE
+ */
+rs485_parse_result_t rs485_parser_finish(rs485_parser_t *parser);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // RS485_PARSER_H
@@ -0,0 +1,250 @@
+#include "rs485_schedule.h"
+#include "rs485_frames.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include <stdlib.h>
+#include <string.h>
+
+static const char *TAG = "RS485_SCHED";
+
+// 发送任务：高于 TX 任务与主站，到点后尽快抢到 CPU；低于 RX 任务
+#define RS485_SCHEDULE_TASK_STACK_SIZE 3072
+#define RS485_SCHEDULE_TASK_PRIORITY 11
+
+// 预编码的一步
+typedef struct {
+    uint32_t at_us;
+    rs485_lane_t lane;
+    uint8_t frame[RS485_FRAME_LENGTH];
+} rs485_schedule_entry_t;
+
+struct rs485_schedule {
+    rs485_bus_t *bus;
+    esp_timer_handle_t timer;
+    TaskHandle_t task;
+    portMUX_TYPE lock;
+    bool running;
+    bool exiting;               // 销毁中：发送任务回到等待点后确认退出
+    SemaphoreHandle_t exited;   // 发送任务的退出确认
+    int64_t base_us;       // 本轮时间轴起点
+    uint32_t period_us;
+    size_t next;           // 下一步的下标
+    rs485_schedule_stats_t stats;
+    size_t count;
+    rs485_schedule_entry_t entries[];
+};
+
+// esp_timer 回调只负责唤醒发送任务，不在定时器任务里碰总线
+static void rs485_schedule_timer_cb(void *arg) {
+    rs485_schedule_t *schedule = (rs485_schedule_t *)arg;
+    xTaskNotifyGive(schedule->task);
+}
+
+static void rs485_schedule_record(rs485_schedule_t *schedule, bool ok, int64_t late_us, uint32_t send_us) {
+    int32_t late = late_us > INT32_MAX ? INT32_MAX : (int32_t)late_us;
+    rs485_schedule_stats_t *st = &schedule->stats;
+
+    portENTER_CRITICAL(&schedule->lock);
+    if (!ok) {
+        st->failed++;
+    }
+    if (st->fired == 0 || late < st->min_late_us) {
+        st->min_late_us = late;
+    }
+    if (st->fired == 0 || late > st->max_late_us) {
+        st->max_late_us = late;
+    }
+    st->fired++;
+    st->sum_late_us += late;
+    rs485_latency_hist_add(&st->late, late > 0 ? (uint32_t)late : 0);
+    if (send_us > st->max_send_us) {
+        st->max_send_us = send_us;
+    }
+    portEXIT_CRITICAL(&schedule->lock);
+}
+
+// 发送任务：发出所有已到点的步，然后把定时器设到下一步
+static void rs485_schedule_task(void *arg) {
+    rs485_schedule_t *schedule = (rs485_schedule_t *)arg;
+
+    while (1) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        portENTER_CRITICAL(&schedule->lock);
+        bool exiting = schedule->exiting;
+        portEXIT_CRITICAL(&schedule->lock);
+        if (exiting) {
+            break;
+        }
+
+        while (1) {
+            portENTER_CRITICAL(&schedule->lock);
+            if (!schedule->running) {
+                portEXIT_CRITICAL(&schedule->lock);
+                break;
+            }
+            const rs485_schedule_entry_t *entry = &schedule->entries[schedule->next];
+            int64_t due_us = schedule->base_us + entry->at_us;
+            int64_t now_us = esp_timer_get_time();
+            if (due_us > now_us) {
+                portEXIT_CRITICAL(&schedule->lock);
+                esp_timer_stop(schedule->timer);
+                esp_timer_start_once(schedule->timer, (uint64_t)(due_us - now_us));
+                break;
+            }
+            if (++schedule->next == schedule->count) {
+                schedule->next = 0;
+                schedule->stats.cycles++;
+                if (schedule->period_us != 0) {
+                    schedule->base_us += schedule->period_us;
+                } else {
+                    schedule->running = false;
+                }
+            }
+            portEXIT_CRITICAL(&schedule->lock);
+
+            // 单播的塔灯会回显 FC06：占住总线等回显收完再放行，回显不会与下一帧
+            // （本时间轴或其他使用者的）相撞；回显内容不需要，直接丢弃
+            bool broadcast = entry->frame[0] == RS485_MODBUS_BROADCAST_ADDR;
+            uint32_t timeout_ms = broadcast ? 0 : rs485_bus_echo_timeout_ms(schedule->bus);
+            rs485_transact_timing_t timing = {.granted_us = now_us, .tx_start_us = now_us};
+            rs485_frame_t echo;
+            int ret = rs485_bus_transact_acquire(schedule->bus, entry->lane, entry->frame, RS485_FRAME_LENGTH, &echo,
+                                                 timeout_ms, 0, &timing);
+            bool ok = broadcast ? ret == 0 : ret > 0 && echo.status == RS485_FRAME_OK;
+            if (ret > 0) {
+                rs485_bus_transact_release(schedule->bus, &echo);
+            }
+            int64_t done_us = esp_timer_get_time();
+            // 偏差按帧真正开始发送的时刻计，含等总线与 t3.5
+            rs485_schedule_record(schedule, ok, timing.tx_start_us - due_us, (uint32_t)(done_us - now_us));
+        }
+    }
+
+    // 只有本任务会重设定时器：先停掉再确认，此后不再碰定时器与总线，等待被删除
+    esp_timer_stop(schedule->timer);
+    xSemaphoreGive(schedule->exited);
+    vTaskSuspend(NULL);
+}
+
+rs485_schedule_t *rs485_schedule_create(rs485_bus_t *bus, const rs485_schedule_step_t *steps, size_t count) {
+    if (bus == NULL || steps == NULL || count == 0) {
+        return NULL;
+    }
+    for (size_t i = 0; i < count; i++) {
+        if (rs485_frames_command(RS485_DEVICE_ADDR, steps[i].cmd) == NULL) {
+            ESP_LOGE(TAG, "Unknown command 0x%02X at step %u", steps[i].cmd, (unsigned)i);
+            return NULL;
+        }
+    }
+
+    rs485_schedule_t *schedule = calloc(1, sizeof(rs485_schedule_t) + count * sizeof(rs485_schedule_entry_t));
+    if (schedule == NULL) {
+        ESP_LOGE(TAG, "Failed to allocate %u step schedule", (unsigned)count);
+        return NULL;
+    }
+    schedule->bus = bus;
+    portMUX_TYPE lock = portMUX_INITIALIZER_UNLOCKED;
+    schedule->lock = lock;
+    schedule->count = count;
+
+    // 预编码并按时刻插入排序；同一时刻保持传入顺序
+    for (size_t i = 0; i < count; i++) {
+        rs485_schedule_entry_t entry = {
+            .at_us = steps[i].at_us,
+            .lane = rs485_cmd_lane(steps[i].cmd),
+        };
+        rs485_frames_build(entry.frame, steps[i].address, 0x06, RS485_REG_LIGHT, (uint16_t)steps[i].cmd);
+        size_t j = i;
+        while (j > 0 && schedule->entries[j - 1].at_us > entry.at_us) {
+            schedule->entries[j] = schedule->entries[j - 1];
+            j--;
+        }
+        schedule->entries[j] = entry;
+    }
+
+    const esp_timer_create_args_t timer_args = {
+        .callback = rs485_schedule_timer_cb,
+        .arg = schedule,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "rs485_sched",
+    };
+    schedule->exited = xSemaphoreCreateBinary();
+    if (schedule->exited == NULL) {
+        ESP_LOGE(TAG, "Failed to create schedule semaphore");
+        free(schedule);
+        return NULL;
+    }
+    if (esp_timer_create(&timer_args, &schedule->timer) != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to create schedule timer");
+        vSemaphoreDelete(schedule->exited);
+        free(schedule);
+        return NULL;
+    }
+    if (xTaskCreate(rs485_schedule_task, "rs485_sched", RS485_SCHEDULE_TASK_STACK_SIZE, schedule,
+                    RS485_SCHEDULE_TASK_PRIORITY, &schedule->task) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create schedule task");
+        esp_timer_delete(schedule->timer);
+        vSemaphoreDelete(schedule->exited);
+        free(schedule);
+        return NULL;
+    }
+    return schedule;
+}
+
+bool rs485_schedule_start(rs485_schedule_t *schedule, uint32_t delay_us, uint32_t period_us) {
+    if (schedule == NULL || (period_us != 0 && period_us < schedule->entries[schedule->count - 1].at_us)) {
+        return false;
+    }
+    esp_timer_stop(schedule->timer);
+    portENTER_CRITICAL(&schedule->lock);
+    schedule->base_us = esp_timer_get_time() + delay_us;
+    schedule->period_us = period_us;
+    schedule->next = 0;
+    schedule->running = true;
+    portEXIT_CRITICAL(&schedule->lock);
+    // 由发送任务设置首个定时，避免与其并发操作定时器
+    xTaskNotifyGive(schedule->task);
+    return true;
+}
+
+void rs485_schedule_stop(rs485_schedule_t *schedule) {
+    if (schedule == NULL) {
+        return;
+    }
+    portENTER_CRITICAL(&schedule->lock);
+    schedule->running = false;
+    portEXIT_CRITICAL(&schedule->lock);
+    esp_timer_stop(schedule->timer);
+}
+
+bool rs485_schedule_is_running(const rs485_schedule_t *schedule) {
+    return schedule != NULL && schedule->running;
+}
+
+void rs485_schedule_get_stats(const rs485_schedule_t *schedule, rs485_schedule_stats_t *stats) {
+    portENTER_CRITICAL((portMUX_TYPE *)&schedule->lock);
+    *stats = schedule->stats;
+    portEXIT_CRITICAL((portMUX_TYPE *)&schedule->lock);
+}
+
+void rs485_schedule_destroy(rs485_schedule_t *schedule) {
+    if (schedule == NULL) {
+        return;
+    }
+    rs485_schedule_stop(schedule);
+    portENTER_CRITICAL(&schedule->lock);
+    schedule->exiting = true;
+    portEXIT_CRITICAL(&schedule->lock);
+    // 等发送任务做完手头的发送、回到等待点确认退出：此后它不再持有总线，
+    // 也不会重设定时器（停止前它可能刚设置过，由它自己在确认前停掉）
+    xTaskNotifyGive(schedule->task);
+    xSemaphoreTake(schedule->exited, portMAX_DELAY);
+    esp_timer_delete(schedule->timer);
+    vTaskDelete(schedule->task);
+    vSemaphoreDelete(schedule->exited);
+    free(schedule);
+}
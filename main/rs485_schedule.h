@@ -0,0 +1,87 @@
+#ifndef RS485_SCHEDULE_H
+#define RS485_SCHEDULE_H
+
+#include "rs485_comm.h"
+#include "rs485_devstats.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// 时间轴上的一步：在 at_us 时刻向 address 发送灯光命令
+typedef struct {
+  uint32_t at_us;  // 相对时间轴起点（微秒）
+  uint8_t address; // 塔灯地址，0 为广播
+  rs485_cmd_t cmd;
+} rs485_schedule_step_t;
+
+// 定时精度统计（微秒）
+typedef struct {
+  uint32_t fired;         // 已发送的步数
+  uint32_t failed;        // 发送失败或单播未收到正确回显的步数
+  uint32_t cycles;        // 已完成的时间轴轮数
+  int32_t min_late_us;    // 开始发送时刻相对计划时刻的偏差，负数为提前
+  int32_t max_late_us;
+  int64_t sum_late_us;
+  rs485_latency_hist_t late; // 滞后分布（提前计为 0）
+  uint32_t max_send_us;      // 单步从到点唤醒到事务结束的最长时间（含等总线与回显）
+} rs485_schedule_stats_t;
+
+typedef struct rs485_schedule rs485_schedule_t;
+
+/**
+ * @brief 创建定时命令时间轴
+ *
+ * 所有帧在此一次性编码（含 CRC）并按时间排序（同一时刻保持传入顺序），
+ * 运行期只做定时与发送，不构建帧也不分配内存。到点由 esp_timer 唤醒
+ * 专用发送任务，报警命令走报警通道，其余走操作员命令通道。单播步
+ * 发送后继续占住总线直到回显收完或超时（rs485_bus_echo_timeout_ms()），
+ * 回显被丢弃。
+ *
+ * @param bus 塔灯所在总线
+ * @param steps 时间轴（可乱序）
+ * @param count 步数
+ * @return 句柄，参数非法或内存不足返回 NULL
+ */
+rs485_schedule_t *rs485_schedule_create(rs485_bus_t *bus,
+                                        const rs485_schedule_step_t *steps,
+                                        size_t count);
+
+/**
+ * @brief 启动时间轴（正在运行时从头重新开始）
+ * @param delay_us 距时间轴起点的延迟
+ * @param period_us 循环周期，0 表示只运行一轮；须不小于最后一步的时刻
+ * @return true 已启动, false 参数非法
+ */
+bool rs485_schedule_start(rs485_schedule_t *schedule, uint32_t delay_us,
+                          uint32_t period_us);
+
+/**
+ * @brief 停止时间轴（正在发送的一帧会发完）
+ */
+void rs485_schedule_stop(rs485_schedule_t *schedule);
+
+/**
+ * @brief 时间轴是否在运行（单轮运行结束后返回 false）
+ */
+bool rs485_schedule_is_running(const rs485_schedule_t *schedule);
+
+/**
+ * @brief 读取定时精度统计
+ */
+void rs485_schedule_get_stats(const rs485_schedule_t *schedule,
+                              rs485_schedule_stats_t *stats);
+
+/**
+ * @brief 停止并释放时间轴
+ */
+void rs485_schedule_destroy(rs485_schedule_t *schedule);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // RS485_SCHEDULE_H
@@ -0,0 +1,149 @@
+#include "rs485_trace.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include <string.h>
+
+static const char *TAG = "RS485_TRACE";
+
+// 打印任务：低于 LVGL 任务
+#define RS485_TRACE_TASK_STACK_SIZE 3072
+#define RS485_TRACE_TASK_PRIORITY 1
+
+// 打印时每次从环中取出的记录数
+#define RS485_TRACE_DUMP_BATCH 8
+
+static portMUX_TYPE s_trace_lock = portMUX_INITIALIZER_UNLOCKED;
+static rs485_trace_record_t s_ring[RS485_TRACE_RING_LEN];
+static uint32_t s_write_seq = 0; // 下一条记录的序号
+static uint32_t s_read_seq = 0;  // 下一条待读取记录的序号
+static volatile rs485_trace_level_t s_level = RS485_TRACE_LEVEL_ERRORS;
+static TaskHandle_t s_dump_task = NULL;
+
+static const char *const s_event_names[] = {
+    [RS485_TRACE_TX] = "TX",
+    [RS485_TRACE_RX] = "RX",
+    [RS485_TRACE_RX_CRC_ERROR] = "RX CRC_ERR",
+    [RS485_TRACE_TX_ERROR] = "TX_ERR",
+    [RS485_TRACE_COLLISION] = "COLLISION",
+    [RS485_TRACE_RX_TIMEOUT] = "RX_TIMEOUT",
+    [RS485_TRACE_RX_ERROR] = "RX_ERR",
+    [RS485_TRACE_RX_OVERFLOW] = "RX_OVERFLOW",
+    [RS485_TRACE_RX_DROPPED] = "RX_DROPPED",
+};
+
+static bool rs485_trace_is_error(rs485_trace_event_t event) {
+    return event != RS485_TRACE_TX && event != RS485_TRACE_RX;
+}
+
+void rs485_trace_record(uart_port_t uart_num, rs485_trace_event_t event, const uint8_t *data, size_t length) {
+    rs485_trace_level_t level = s_level;
+    if (level == RS485_TRACE_LEVEL_OFF || (level == RS485_TRACE_LEVEL_ERRORS && !rs485_trace_is_error(event))) {
+        return;
+    }
+    size_t copy = 0;
+    if (data != NULL && (level == RS485_TRACE_LEVEL_BYTES || rs485_trace_is_error(event))) {
+        copy = length < RS485_TRACE_DATA_MAX ? length : RS485_TRACE_DATA_MAX;
+    }
+    int64_t now = esp_timer_get_time();
+
+    portENTER_CRITICAL(&s_trace_lock);
+    rs485_trace_record_t *rec = &s_ring[s_write_seq % RS485_TRACE_RING_LEN];
+    rec->timestamp_us = now;
+    rec->seq = s_write_seq++;
+    rec->length = (uint16_t)length;
+    rec->uart_num = (uint8_t)uart_num;
+    rec->event = (uint8_t)event;
+    rec->captured = (uint8_t)copy;
+    if (copy > 0) {
+        memcpy(rec->data, data, copy);
+    }
+    portEXIT_CRITICAL(&s_trace_lock);
+}
+
+void rs485_trace_set_level(rs485_trace_level_t level) {
+    s_level = level;
+}
+
+rs485_trace_level_t rs485_trace_get_level(void) {
+    return s_level;
+}
+
+size_t rs485_trace_read(rs485_trace_record_t *records, size_t max_records, uint32_t *lost) {
+    size_t count = 0;
+    uint32_t skipped = 0;
+
+    portENTER_CRITICAL(&s_trace_lock);
+    // 读取落后超过一整圈时跳到仍在环中的最老记录
+    if (s_write_seq - s_read_seq > RS485_TRACE_RING_LEN) {
+        skipped = s_write_seq - s_read_seq - RS485_TRACE_RING_LEN;
+        s_read_seq = s_write_seq - RS485_TRACE_RING_LEN;
+    }
+    while (count < max_records && s_read_seq != s_write_seq) {
+        records[count++] = s_ring[s_read_seq % RS485_TRACE_RING_LEN];
+        s_read_seq++;
+    }
+    portEXIT_CRITICAL(&s_trace_lock);
+
+    if (lost != NULL) {
+        *lost = skipped;
+    }
+    return count;
+}
+
+// 逐字节查表转十六进制，避免 snprintf/strcat
+static void rs485_trace_format_hex(char *out, const uint8_t *data, size_t length) {
+    static const char hex[] = "0123456789ABCDEF";
+    for (size_t i = 0; i < length; i++) {
+        *out++ = hex[data[i] >> 4];
+        *out++ = hex[data[i] & 0x0F];
+        *out++ = ' ';
+    }
+    *out = '\0';
+}
+
+size_t rs485_trace_dump(void) {
+    rs485_trace_record_t records[RS485_TRACE_DUMP_BATCH];
+    char hex[RS485_TRACE_DATA_MAX * 3 + 1];
+    size_t total = 0;
+    size_t count;
+    uint32_t lost;
+
+    while ((count = rs485_trace_read(records, RS485_TRACE_DUMP_BATCH, &lost)) > 0) {
+        if (lost > 0) {
+            ESP_LOGW(TAG, "%lu trace record(s) overwritten before dump", lost);
+        }
+        for (size_t i = 0; i < count; i++) {
+            const rs485_trace_record_t *rec = &records[i];
+            // 只打印实际保存的字节：FRAMES 级别与无数据事件的 data 是上一轮残留
+            rs485_trace_format_hex(hex, rec->data, rec->captured);
+            ESP_LOGI(TAG, "#%lu %lld.%06lld UART%d %-11s len=%u %s%s", rec->seq, rec->timestamp_us / 1000000,
+                     rec->timestamp_us % 1000000, rec->uart_num, s_event_names[rec->event], rec->length, hex,
+                     rec->captured > 0 && rec->length > rec->captured ? "..." : "");
+        }
+        total += count;
+    }
+    return total;
+}
+
+static void rs485_trace_dump_task(void *arg) {
+    TickType_t period = pdMS_TO_TICKS((uint32_t)(uintptr_t)arg);
+    while (1) {
+        vTaskDelay(period);
+        rs485_trace_dump();
+    }
+}
+
+bool rs485_trace_start_dump_task(uint32_t period_ms) {
+    if (s_dump_task != NULL || period_ms == 0) {
+        return false;
+    }
+    if (xTaskCreate(rs485_trace_dump_task, "rs485_trace", RS485_TRACE_TASK_STACK_SIZE, (void *)(uintptr_t)period_ms,
+                    RS485_TRACE_TASK_PRIORITY, &s_dump_task) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create trace dump task");
+        s_dump_task = NULL;
+        return false;
+    }
+    return true;
+}
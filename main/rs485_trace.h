@@ -0,0 +1,97 @@
+#ifndef RS485_TRACE_H
+#define RS485_TRACE_H
+
+#include "driver/uart.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// 每条记录保存的最大原始字节数，超出部分截断（长度字段仍为实际帧长）
+#define RS485_TRACE_DATA_MAX 32
+
+// 记录条数，写满后覆盖最老记录
+#define RS485_TRACE_RING_LEN 64
+
+// 总线事件类型
+typedef enum {
+  RS485_TRACE_TX = 0,        // 发送一帧
+  RS485_TRACE_RX,            // 收到一帧（CRC 正确）
+  RS485_TRACE_RX_CRC_ERROR,  // 收到一帧（CRC 错误）
+  RS485_TRACE_TX_ERROR,      // 写入失败或等待发送完成超时
+  RS485_TRACE_COLLISION,     // 硬件半双工模式检测到冲突
+  RS485_TRACE_RX_TIMEOUT,    // 等待应答超时
+  RS485_TRACE_RX_ERROR,      // 帧错误/校验错误/超长帧
+  RS485_TRACE_RX_OVERFLOW,   // UART FIFO 或缓冲区溢出
+  RS485_TRACE_RX_DROPPED,    // 接收帧环已满，帧被丢弃
+} rs485_trace_event_t;
+
+// 运行时记录级别
+typedef enum {
+  RS485_TRACE_LEVEL_OFF = 0, // 不记录
+  RS485_TRACE_LEVEL_ERRORS,  // 只记录异常事件
+  RS485_TRACE_LEVEL_FRAMES,  // 记录所有事件，不保存帧内容
+  RS485_TRACE_LEVEL_BYTES,   // 记录所有事件及帧内容
+} rs485_trace_level_t;
+
+// 一条记录
+typedef struct {
+  int64_t timestamp_us;
+  uint32_t seq;    // 递增序号，可据此发现被覆盖的记录
+  uint16_t length; // 实际帧长
+  uint8_t uart_num;
+  uint8_t event;    // rs485_trace_event_t
+  uint8_t captured; // data 中实际保存的字节数，不记录内容时为 0
+  uint8_t data[RS485_TRACE_DATA_MAX];
+} rs485_trace_record_t;
+
+/**
+ * @brief 记录一次总线事件
+ *
+ * 只做一次 memcpy，不格式化、不打印，可在 TX/RX 路径上调用。
+ *
+ * @param uart_num 总线所在 UART 端口
+ * @param event 事件类型
+ * @param data 帧数据，可为 NULL
+ * @param length 帧长度
+ */
+void rs485_trace_record(uart_port_t uart_num, rs485_trace_event_t event,
+                        const uint8_t *data, size_t length);
+
+/**
+ * @brief 设置/读取记录级别（默认 RS485_TRACE_LEVEL_ERRORS）
+ */
+void rs485_trace_set_level(rs485_trace_level_t level);
+rs485_trace_level_t rs485_trace_get_level(void);
+
+/**
+ * @brief 按序复制尚未读取的记录
+ * @param records 输出数组
+ * @param max_records 数组容量
+ * @param lost 输出因覆盖而丢失的记录数，可为 NULL
+ * @return 复制的记录数
+ */
+size_t rs485_trace_read(rs485_trace_record_t *records, size_t max_records,
+                        uint32_t *lost);
+
+/**
+ * @brief 格式化并打印尚未读取的记录（在调用者上下文中执行）
+ * @return 打印的记录数
+ */
+size_t rs485_trace_dump(void);
+
+/**
+ * @brief 启动低优先级任务，周期性打印新记录
+ * @param period_ms 打印周期（毫秒）
+ * @return true 成功, false 失败或已启动
+ */
+bool rs485_trace_start_dump_task(uint32_t period_ms);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // RS485_TRACE_H
@@ -0,0 +1,199 @@
+/*
+ * 写入批次合并规则主机测试（Linux）
+ *
+ * 编译 main/modbus_batch.c，本文件提供 modbus_master_execute() 的替身：
+ * 只记录发出的每个请求（从站、功能码、地址、数量与写入值），可按从站
+ * 注入失败。据此检查 modbus_batch_flush 的合并规则：
+ *
+ *   - 同一从站同一寄存器的后写覆盖先写，批次满时 add 返回 false；
+ *   - 只有 whole_line 为 true 且组内每个设备写入相同寄存器与值时合并为
+ *     一帧广播；组只是部分设备、或有设备的值不同时不合并；
+ *   - 同一从站连续寄存器合并为 FC10（满批也只一帧），其余用 FC06；
+ *   - 统计（合并后写入数、帧数、节省帧数、失败帧数）与返回状态。
+ *
+ * 编译（在 tools 目录）：
+ *   make batch_test
+ *
+ * 任何一项检查不通过退出码为 1。
+ */
+#include "modbus_batch.h"
+#include "host_test.h"
+#include "rs485_frames.h"
+#include <stdio.h>
+#include <string.h>
+
+#define MAX_SENT 128
+
+typedef struct {
+  uint8_t slave;
+  uint8_t function;
+  uint16_t address;
+  uint16_t quantity;
+  uint16_t values[MODBUS_MAX_WRITE_REGISTERS];
+} sent_t;
+
+static sent_t s_sent[MAX_SENT];
+static size_t s_sent_count;
+static uint8_t s_fail_slave; // 发往该从站的请求返回超时，0 表示不注入
+
+modbus_status_t modbus_master_execute(modbus_master_t *master, const modbus_request_t *request,
+                                      modbus_result_t *result) {
+  (void)master;
+  if (s_sent_count < MAX_SENT) {
+    sent_t *s = &s_sent[s_sent_count++];
+    s->slave = request->slave;
+    s->function = request->function;
+    s->address = request->address;
+    s->quantity = request->quantity;
+    uint16_t n = request->function == MODBUS_FC_WRITE_SINGLE_REGISTER ? 1 : request->quantity;
+    memcpy(s->values, request->values, n * sizeof(uint16_t));
+  }
+  result->status = s_fail_slave != 0 && request->slave == s_fail_slave ? MODBUS_ERR_TIMEOUT : MODBUS_OK;
+  return result->status;
+}
+
+static const uint8_t s_line[] = {1, 2, 3};
+
+static modbus_status_t flush(modbus_batch_t *batch, const uint8_t *group, size_t group_size,
+                             bool whole_line, modbus_batch_report_t *report) {
+  s_sent_count = 0;
+  return modbus_batch_flush(NULL, batch, group, group_size, whole_line, report);
+}
+
+static void test_add(void) {
+  modbus_batch_t batch;
+  modbus_batch_init(&batch);
+  CHECK(modbus_batch_add(&batch, 1, RS485_REG_LIGHT, RS485_CMD_RED_ON), "add");
+  CHECK(modbus_batch_add(&batch, 1, RS485_REG_LIGHT, RS485_CMD_GREEN_ON), "overwrite");
+  CHECK(batch.count == 1 && batch.writes[0].value == RS485_CMD_GREEN_ON, "last write wins: %u writes",
+        batch.count);
+
+  for (uint16_t i = 1; i < MODBUS_BATCH_MAX_WRITES; i++) {
+    modbus_batch_add(&batch, 2, i, i);
+  }
+  CHECK(batch.count == MODBUS_BATCH_MAX_WRITES, "batch filled to %u", batch.count);
+  CHECK(!modbus_batch_add(&batch, 3, 0, 0), "add to a full batch");
+  CHECK(modbus_batch_add(&batch, 2, 1, 99), "overwrite in a full batch");
+}
+
+static void test_broadcast_whole_line(void) {
+  modbus_batch_t batch;
+  modbus_batch_report_t report;
+  modbus_batch_init(&batch);
+  for (size_t i = 0; i < sizeof(s_line); i++) {
+    modbus_batch_add(&batch, s_line[i], RS485_REG_LIGHT, RS485_CMD_RED_ON);
+  }
+  modbus_status_t status = flush(&batch, s_line, sizeof(s_line), true, &report);
+  CHECK(status == MODBUS_OK && s_sent_count == 1, "whole line: %zu frames", s_sent_count);
+  CHECK(s_sent[0].slave == MODBUS_BROADCAST_ADDR && s_sent[0].function == MODBUS_FC_WRITE_SINGLE_REGISTER &&
+            s_sent[0].address == RS485_REG_LIGHT && s_sent[0].values[0] == RS485_CMD_RED_ON,
+        "whole line: slave %u fc %u reg 0x%X value 0x%X", s_sent[0].slave, s_sent[0].function,
+        s_sent[0].address, s_sent[0].values[0]);
+  CHECK(report.writes == 3 && report.frames == 1 && report.frames_saved == 2 && report.failed_frames == 0,
+        "whole line report: %u writes, %u frames, %u saved", report.writes, report.frames,
+        report.frames_saved);
+  CHECK(batch.count == 0, "flush empties the batch");
+}
+
+// 组只是线上的一部分：广播会写到组外的设备，必须逐个写
+static void test_no_broadcast_for_subset(void) {
+  modbus_batch_t batch;
+  modbus_batch_init(&batch);
+  modbus_batch_add(&batch, 1, RS485_REG_LIGHT, RS485_CMD_RED_ON);
+  modbus_batch_add(&batch, 2, RS485_REG_LIGHT, RS485_CMD_RED_ON);
+  static const uint8_t subset[] = {1, 2};
+  flush(&batch, subset, sizeof(subset), false, NULL);
+  CHECK(s_sent_count == 2, "subset: %zu frames", s_sent_count);
+  for (size_t i = 0; i < s_sent_count; i++) {
+    CHECK(s_sent[i].slave == subset[i] && s_sent[i].function == MODBUS_FC_WRITE_SINGLE_REGISTER,
+          "subset frame %zu: slave %u fc %u", i, s_sent[i].slave, s_sent[i].function);
+  }
+}
+
+// 有一个设备的值不同：该寄存器不合并，值相同的另一个寄存器照样合并
+static void test_partial_common(void) {
+  modbus_batch_t batch;
+  modbus_batch_init(&batch);
+  for (size_t i = 0; i < sizeof(s_line); i++) {
+    modbus_batch_add(&batch, s_line[i], RS485_REG_LIGHT, s_line[i] == 2 ? RS485_CMD_LIGHT_OFF : RS485_CMD_RED_ON);
+    modbus_batch_add(&batch, s_line[i], 0x0100, 7);
+  }
+  flush(&batch, s_line, sizeof(s_line), true, NULL);
+  size_t broadcasts = 0;
+  size_t light_writes = 0;
+  for (size_t i = 0; i < s_sent_count; i++) {
+    if (s_sent[i].slave == MODBUS_BROADCAST_ADDR) {
+      broadcasts++;
+      CHECK(s_sent[i].address == 0x0100 && s_sent[i].values[0] == 7, "broadcast reg 0x%X", s_sent[i].address);
+    } else {
+      light_writes++;
+      CHECK(s_sent[i].address == RS485_REG_LIGHT, "unicast reg 0x%X", s_sent[i].address);
+    }
+  }
+  CHECK(broadcasts == 1 && light_writes == 3, "%zu broadcasts, %zu light writes", broadcasts, light_writes);
+}
+
+// 连续寄存器合成 FC10，超过 123 个拆帧；不连续的单个寄存器用 FC06
+static void test_fc10_runs(void) {
+  modbus_batch_t batch;
+  modbus_batch_report_t report;
+  modbus_batch_init(&batch);
+  // 逆序加入，验证排序后能合并
+  for (int r = 4; r >= 0; r--) {
+    modbus_batch_add(&batch, 5, (uint16_t)(0x10 + r), (uint16_t)(0x100 + r));
+  }
+  modbus_batch_add(&batch, 5, 0x20, 0xAA);
+  modbus_batch_add(&batch, 6, 0x11, 0xBB);
+  flush(&batch, NULL, 0, false, &report);
+  CHECK(s_sent_count == 3, "runs: %zu frames", s_sent_count);
+  CHECK(s_sent[0].slave == 5 && s_sent[0].function == MODBUS_FC_WRITE_MULTIPLE_REGISTERS &&
+            s_sent[0].address == 0x10 && s_sent[0].quantity == 5,
+        "run: slave %u fc %u addr 0x%X qty %u", s_sent[0].slave, s_sent[0].function, s_sent[0].address,
+        s_sent[0].quantity);
+  for (uint16_t r = 0; r < 5 && s_sent_count > 0; r++) {
+    CHECK(s_sent[0].values[r] == 0x100 + r, "run value %u = 0x%X", r, s_sent[0].values[r]);
+  }
+  CHECK(s_sent[1].slave == 5 && s_sent[1].function == MODBUS_FC_WRITE_SINGLE_REGISTER && s_sent[1].address == 0x20,
+        "single after run");
+  CHECK(s_sent[2].slave == 6 && s_sent[2].function == MODBUS_FC_WRITE_SINGLE_REGISTER && s_sent[2].address == 0x11,
+        "other slave");
+  CHECK(report.writes == 7 && report.frames == 3 && report.frames_saved == 4, "runs report");
+}
+
+// 批次容量（64）小于 FC10 上限（123）：整批连续寄存器必须只发一帧
+static void test_fc10_cap(void) {
+  modbus_batch_t batch;
+  modbus_batch_init(&batch);
+  for (uint16_t r = 0; r < MODBUS_BATCH_MAX_WRITES; r++) {
+    modbus_batch_add(&batch, 7, r, r);
+  }
+  flush(&batch, NULL, 0, false, NULL);
+  CHECK(s_sent_count == 1 && s_sent[0].quantity == MODBUS_BATCH_MAX_WRITES, "full batch: %zu frames, qty %u",
+        s_sent_count, s_sent_count ? s_sent[0].quantity : 0);
+  _Static_assert(MODBUS_BATCH_MAX_WRITES <= MODBUS_MAX_WRITE_REGISTERS, "a full batch fits one FC10 frame");
+}
+
+static void test_failures(void) {
+  modbus_batch_t batch;
+  modbus_batch_report_t report;
+  modbus_batch_init(&batch);
+  modbus_batch_add(&batch, 1, RS485_REG_LIGHT, RS485_CMD_RED_ON);
+  modbus_batch_add(&batch, 2, RS485_REG_LIGHT, RS485_CMD_GREEN_ON);
+  s_fail_slave = 2;
+  modbus_status_t status = flush(&batch, NULL, 0, false, &report);
+  s_fail_slave = 0;
+  CHECK(status == MODBUS_ERR_TIMEOUT, "status %d", status);
+  CHECK(report.frames == 2 && report.failed_frames == 1, "failed frames %u of %u", report.failed_frames,
+        report.frames);
+}
+
+int main(void) {
+  test_add();
+  test_broadcast_whole_line();
+  test_no_broadcast_for_subset();
+  test_partial_common();
+  test_fc10_runs();
+  test_fc10_cap();
+  test_failures();
+  return host_test_summary();
+}
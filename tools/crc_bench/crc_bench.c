@@ -0,0 +1,173 @@
+/*
+ * Modbus CRC16 等价性校验与基准（Linux）
+ *
+ * 把固件的查表实现（main/rs485_crc.cpp：slicing-by-4 块更新与逐字节
+ * 增量更新）与逐位参考实现逐一比对：随机长度与内容的缓冲区、随机
+ * 分块的流式累计、以及“含 CRC 的整帧累计为 0”的接收端判据。随后
+ * 对典型帧长测各实现的吞吐。
+ *
+ * 编译（在仓库根目录）：
+ *   g++ -O2 -Imain -x c tools/crc_bench/crc_bench.c -x c++ main/rs485_crc.cpp \
+ *       -o crc_bench
+ *
+ * 用法：
+ *   crc_bench [-n 随机用例数] [-s 随机种子]
+ *
+ * 存在不一致时退出码为 1，可直接用作回归测试。
+ */
+#include "rs485_crc.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define BENCH_MAX_LEN 512
+
+static int64_t now_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static uint16_t crc_bytewise(const uint8_t *data, size_t length) {
+  uint16_t crc = RS485_CRC16_INIT;
+  for (size_t i = 0; i < length; i++) {
+    crc = rs485_crc16_update_byte(crc, data[i]);
+  }
+  return crc;
+}
+
+static uint16_t crc_block(const uint8_t *data, size_t length) {
+  return rs485_crc16_update(RS485_CRC16_INIT, data, length);
+}
+
+// 随机分块累计，模拟 RX 任务按 FIFO 块边收边算
+static uint16_t crc_chunked(const uint8_t *data, size_t length) {
+  uint16_t crc = RS485_CRC16_INIT;
+  size_t done = 0;
+  while (done < length) {
+    size_t chunk = 1 + (size_t)rand() % 17;
+    chunk = chunk > length - done ? length - done : chunk;
+    crc = rs485_crc16_update(crc, &data[done], chunk);
+    done += chunk;
+  }
+  return crc;
+}
+
+static int check_known_vectors(void) {
+  // 塔灯红灯常亮帧 01 06 00 C2 00 11 → CRC E8 3A（低字节在前）
+  static const uint8_t red_on[] = {0x01, 0x06, 0x00, 0xC2, 0x00, 0x11};
+  // 标准校验值："123456789" → 0x4B37
+  static const uint8_t check[] = "123456789";
+  int failures = 0;
+  uint16_t crc = rs485_crc16_bitwise(check, 9);
+  if (crc != 0x4B37 || crc_block(check, 9) != 0x4B37) {
+    printf("check vector: bitwise %04X, table %04X, expected 4B37\n", crc,
+           crc_block(check, 9));
+    failures++;
+  }
+  crc = crc_block(red_on, sizeof(red_on));
+  uint8_t frame[8];
+  memcpy(frame, red_on, 6);
+  frame[6] = (uint8_t)(crc & 0xFF);
+  frame[7] = (uint8_t)(crc >> 8);
+  if (crc != rs485_crc16_bitwise(red_on, 6) || crc_block(frame, 8) != 0) {
+    printf("red-on frame: table %04X, bitwise %04X, residue %04X\n", crc,
+           rs485_crc16_bitwise(red_on, 6), crc_block(frame, 8));
+    failures++;
+  }
+  return failures;
+}
+
+static int check_random(unsigned cases) {
+  uint8_t buf[BENCH_MAX_LEN + 2];
+  int failures = 0;
+  for (unsigned n = 0; n < cases; n++) {
+    size_t length = (size_t)rand() % (BENCH_MAX_LEN + 1);
+    for (size_t i = 0; i < length; i++) {
+      buf[i] = (uint8_t)rand();
+    }
+    uint16_t ref = rs485_crc16_bitwise(buf, length);
+    uint16_t block = crc_block(buf, length);
+    uint16_t bytewise = crc_bytewise(buf, length);
+    uint16_t chunked = crc_chunked(buf, length);
+
+    // 追加 CRC 后整帧累计应为 0
+    buf[length] = (uint8_t)(ref & 0xFF);
+    buf[length + 1] = (uint8_t)(ref >> 8);
+    uint16_t residue = crc_block(buf, length + 2);
+
+    if (block != ref || bytewise != ref || chunked != ref || residue != 0) {
+      if (failures < 10) {
+        printf("length %zu: bitwise %04X, block %04X, bytewise %04X, "
+               "chunked %04X, residue %04X\n",
+               length, ref, block, bytewise, chunked, residue);
+      }
+      failures++;
+    }
+  }
+  return failures;
+}
+
+static volatile uint16_t s_sink;
+
+static double bench_mbps(uint16_t (*fn)(const uint8_t *, size_t),
+                         const uint8_t *data, size_t length) {
+  // 每个实现至少跑约 50ms
+  size_t iterations = 0;
+  int64_t start = now_ns();
+  int64_t elapsed;
+  do {
+    for (int i = 0; i < 1000; i++) {
+      s_sink ^= fn(data, length);
+    }
+    iterations += 1000;
+    elapsed = now_ns() - start;
+  } while (elapsed < 50000000);
+  return (double)iterations * length / (elapsed / 1e9) / 1e6;
+}
+
+static void run_bench(void) {
+  static const size_t sizes[] = {8, 10, 64, 256, 512};
+  uint8_t buf[BENCH_MAX_LEN];
+  for (size_t i = 0; i < sizeof(buf); i++) {
+    buf[i] = (uint8_t)rand();
+  }
+  printf("%6s %12s %12s %12s %8s\n", "bytes", "bitwise MB/s", "bytewise",
+         "slice-by-4", "speedup");
+  for (size_t k = 0; k < sizeof(sizes) / sizeof(sizes[0]); k++) {
+    double bitwise = bench_mbps(rs485_crc16_bitwise, buf, sizes[k]);
+    double bytewise = bench_mbps(crc_bytewise, buf, sizes[k]);
+    double block = bench_mbps(crc_block, buf, sizes[k]);
+    printf("%6zu %12.1f %12.1f %12.1f %7.1fx\n", sizes[k], bitwise, bytewise,
+           block, block / bitwise);
+  }
+}
+
+int main(int argc, char **argv) {
+  unsigned cases = 100000;
+  unsigned seed = (unsigned)time(NULL);
+  int opt;
+  while ((opt = getopt(argc, argv, "n:s:")) != -1) {
+    switch (opt) {
+    case 'n': cases = (unsigned)strtoul(optarg, NULL, 0); break;
+    case 's': seed = (unsigned)strtoul(optarg, NULL, 0); break;
+    default:
+      fprintf(stderr, "usage: %s [-n cases] [-s seed]\n", argv[0]);
+      return 2;
+    }
+  }
+  srand(seed);
+
+  int failures = check_known_vectors();
+  failures += check_random(cases);
+  printf("equivalence: %u random buffers (seed %u), %d mismatches\n", cases,
+         seed, failures);
+  if (failures > 0) {
+    return 1;
+  }
+  run_bench();
+  return 0;
+}
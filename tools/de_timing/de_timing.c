@@ -0,0 +1,305 @@
+/*
+ * RS485 半双工 DE 时序检查（Linux）
+ *
+ * 把固件同一份总线代码（main/rs485_comm.c）编译到主机替身上
+ * （tools/host_shim：FreeRTOS 用 pthread，UART 接伪终端并按波特率模拟
+ * 线路），由进程内的应答线程在伪终端主端扮演塔灯。替身记录每次发送
+ * 的 DE 窗口与每个接收突发，据此检查：
+ *
+ *   - 配置了 DE 引脚时每帧都在硬件半双工模式下发送（DE 覆盖整帧），
+ *     未配置时不置 DE；
+ *   - DE 窗口与对端应答在线路上从不重叠（无冲突）；
+ *   - 每次发送前线路已静默至少 t3.5（上一次发送或收到的应答之后）；
+ *   - 收到应答后到下一次请求 DE 置位的空闲时间（中位数）不超过
+ *     t3.5 + 主机调度余量：帧间只有协议规定的最小间隔，RX 超时上报
+ *     的那段静默不再额外叠加一个 t3.5，收发切换中也没有固定延时。
+ *
+ * 编译（在 tools 目录）：
+ *   make de_timing
+ *
+ * 用法：
+ *   de_timing [-n 每个波特率的事务数] [-t 应答延迟us] [-j 调度余量us]
+ *
+ * 任何一项检查不通过退出码为 1，可直接用作回归测试。
+ */
+#include "rs485_comm.h"
+#include "rs485_crc.h"
+#include "rs485_frames.h"
+#include "driver/uart.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <unistd.h>
+
+#define TEST_UART UART_NUM_1
+#define TEST_DE_PIN 4
+#define LINE_LOG_MAX 1024
+
+typedef struct {
+  int fd;
+  uint32_t turnaround_us;
+  volatile bool stop;
+  uint32_t responses;
+} responder_t;
+
+static void sleep_us(uint32_t us) {
+  struct timespec ts = {us / 1000000, (long)(us % 1000000) * 1000};
+  while (nanosleep(&ts, &ts) != 0 && errno == EINTR) {
+  }
+}
+
+// 塔灯替身：按帧长切帧（不依赖主机调度下的静默检测），只应答发给 0x01
+// 的 8 字节 FC03 读；10 字节的广播写命令不应答
+static void *responder_thread(void *arg) {
+  responder_t *r = arg;
+  uint8_t buf[256];
+  size_t len = 0;
+  while (!r->stop) {
+    struct pollfd pfd = {.fd = r->fd, .events = POLLIN};
+    if (poll(&pfd, 1, 20) <= 0 || !(pfd.revents & POLLIN)) {
+      continue;
+    }
+    ssize_t n = read(r->fd, &buf[len], sizeof(buf) - len);
+    if (n <= 0) {
+      continue;
+    }
+    len += (size_t)n;
+    while (len > 0) {
+      size_t frame_len = buf[0] == RS485_MODBUS_BROADCAST_ADDR ? RS485_FRAME_LENGTH : 8;
+      if (len < frame_len) {
+        break;
+      }
+      if (buf[0] == RS485_DEVICE_ADDR && buf[1] == 0x03 &&
+          rs485_crc16_update(RS485_CRC16_INIT, buf, frame_len) == 0) {
+        uint8_t resp[7] = {RS485_DEVICE_ADDR, 0x03, 0x02, 0x00, RS485_CMD_LIGHT_OFF};
+        uint16_t crc = rs485_crc16_update(RS485_CRC16_INIT, resp, 5);
+        resp[5] = (uint8_t)(crc & 0xFF);
+        resp[6] = (uint8_t)(crc >> 8);
+        sleep_us(r->turnaround_us);
+        if (write(r->fd, resp, sizeof(resp)) == (ssize_t)sizeof(resp)) {
+          r->responses++;
+        }
+      }
+      len -= frame_len;
+      memmove(buf, &buf[frame_len], len);
+    }
+  }
+  return NULL;
+}
+
+static int open_pty(char *slave, size_t slave_size) {
+  int fd = posix_openpt(O_RDWR | O_NOCTTY);
+  if (fd < 0 || grantpt(fd) != 0 || unlockpt(fd) != 0 ||
+      ptsname_r(fd, slave, slave_size) != 0) {
+    perror("posix_openpt");
+    return -1;
+  }
+  struct termios tio;
+  tcgetattr(fd, &tio);
+  cfmakeraw(&tio);
+  tcsetattr(fd, TCSANOW, &tio);
+  return fd;
+}
+
+typedef struct {
+  int baud;
+  bool de;
+  size_t transactions;
+  size_t tx_frames;
+  size_t responses;
+  uint32_t frame_gap_us;
+  int64_t min_gap_us;     // 发送前最短静默
+  int64_t median_idle_us; // 应答结束到下一次 DE 置位的空闲，中位数
+  int64_t max_idle_us;
+  int64_t idle_limit_us;
+  int failures;
+} run_result_t;
+
+static int cmp_i64(const void *a, const void *b) {
+  int64_t x = *(const int64_t *)a, y = *(const int64_t *)b;
+  return x < y ? -1 : x > y;
+}
+
+static void check_line_log(const host_uart_line_t *log, size_t count, run_result_t *res) {
+  int64_t *idle = calloc(count, sizeof(*idle));
+  size_t idle_count = 0;
+  res->min_gap_us = INT64_MAX;
+  for (size_t i = 0; i < count; i++) {
+    const host_uart_line_t *e = &log[i];
+    if (e->collision) {
+      printf("  %s at %lld us overlaps the other direction\n", e->tx ? "TX" : "RX",
+             (long long)e->start_us);
+      res->failures++;
+    }
+    if (!e->tx) {
+      res->responses++;
+      continue;
+    }
+    res->tx_frames++;
+    if (e->de != res->de) {
+      printf("  TX at %lld us: DE %s, expected %s\n", (long long)e->start_us,
+             e->de ? "asserted" : "not driven", res->de ? "asserted" : "not driven");
+      res->failures++;
+    }
+    if (i == 0) {
+      continue;
+    }
+    const host_uart_line_t *prev = &log[i - 1];
+    int64_t gap = e->start_us - prev->end_us;
+    if (gap < res->min_gap_us) {
+      res->min_gap_us = gap;
+    }
+    if (gap < (int64_t)res->frame_gap_us) {
+      printf("  TX at %lld us only %lld us after previous %s (t3.5 %lu us)\n",
+             (long long)e->start_us, (long long)gap, prev->tx ? "TX" : "RX",
+             (unsigned long)res->frame_gap_us);
+      res->failures++;
+    }
+    if (!prev->tx) {
+      idle[idle_count++] = gap;
+    }
+  }
+  // 主机调度偶有毫秒级抖动，用中位数判断切换中是否有固定延时
+  if (idle_count > 0) {
+    qsort(idle, idle_count, sizeof(*idle), cmp_i64);
+    res->median_idle_us = idle[idle_count / 2];
+    res->max_idle_us = idle[idle_count - 1];
+  }
+  free(idle);
+}
+
+static run_result_t run_baud(int baud, bool de, const char *slave, responder_t *responder,
+                             size_t transactions, uint32_t slack_us) {
+  run_result_t res = {.baud = baud, .de = de};
+  rs485_bus_config_t config = {
+      .uart_num = TEST_UART,
+      .tx_pin = 17,
+      .rx_pin = 18,
+      .de_pin = de ? TEST_DE_PIN : UART_PIN_NO_CHANGE,
+      .baud_rate = baud,
+      .parity = UART_PARITY_DISABLE,
+      .task_core = -1,
+  };
+  if (host_uart_attach(TEST_UART, slave) != ESP_OK) {
+    perror(slave);
+    res.failures++;
+    return res;
+  }
+  rs485_bus_t *bus = rs485_bus_open(&config);
+  if (bus == NULL) {
+    printf("  bus open failed\n");
+    host_uart_detach(TEST_UART);
+    res.failures++;
+    return res;
+  }
+  rs485_bus_get_timing(bus, NULL, &res.frame_gap_us);
+
+  uint8_t request[8] = {RS485_DEVICE_ADDR, 0x03, 0x00, 0xC2, 0x00, 0x01};
+  uint16_t crc = rs485_crc16_update(RS485_CRC16_INIT, request, 6);
+  request[6] = (uint8_t)(crc & 0xFF);
+  request[7] = (uint8_t)(crc >> 8);
+
+  vTaskDelay(pdMS_TO_TICKS(20));
+  host_uart_line_t *log = calloc(LINE_LOG_MAX, sizeof(*log));
+  host_uart_line_log(TEST_UART, log, LINE_LOG_MAX); // 丢弃打开总线时的记录
+
+  for (size_t i = 0; i < transactions; i++) {
+    uint8_t response[16];
+    bool crc_ok = false;
+    int n = rs485_bus_transact(bus, request, sizeof(request), response, sizeof(response), 200,
+                               &crc_ok);
+    if (n != 7 || !crc_ok) {
+      printf("  transaction %zu: %d bytes, crc %s\n", i, n, crc_ok ? "ok" : "bad");
+      res.failures++;
+    } else {
+      res.transactions++;
+    }
+    // 两帧背靠背广播：帧间只应有 t3.5
+    rs485_bus_send_command_to(bus, RS485_MODBUS_BROADCAST_ADDR, RS485_CMD_RED_ON);
+    rs485_bus_send_command_to(bus, RS485_MODBUS_BROADCAST_ADDR, RS485_CMD_LIGHT_OFF);
+  }
+  vTaskDelay(pdMS_TO_TICKS(20));
+
+  size_t count = host_uart_line_log(TEST_UART, log, LINE_LOG_MAX);
+  check_line_log(log, count, &res);
+  res.idle_limit_us = res.frame_gap_us + slack_us;
+  if (res.median_idle_us > res.idle_limit_us) {
+    printf("  median %lld us idle between a response and the next request (limit %lld us)\n",
+           (long long)res.median_idle_us, (long long)res.idle_limit_us);
+    res.failures++;
+  }
+  if (res.tx_frames != 3 * transactions) {
+    printf("  %zu frames on the line, expected %zu\n", res.tx_frames, 3 * transactions);
+    res.failures++;
+  }
+
+  rs485_bus_stats_t stats;
+  rs485_bus_get_stats(bus, &stats);
+  if (stats.collisions != 0 || stats.tx_errors != 0 || stats.rx_timeouts != 0) {
+    printf("  bus stats: %lu collisions, %lu tx errors, %lu rx timeouts\n",
+           (unsigned long)stats.collisions, (unsigned long)stats.tx_errors,
+           (unsigned long)stats.rx_timeouts);
+    res.failures++;
+  }
+  free(log);
+  rs485_bus_close(bus);
+  host_uart_detach(TEST_UART);
+  return res;
+}
+
+int main(int argc, char **argv) {
+  size_t transactions = 50;
+  uint32_t turnaround_us = 1000;
+  uint32_t slack_us = 2000; // 主机调度与伪终端的抖动
+  int opt;
+  while ((opt = getopt(argc, argv, "n:t:j:")) != -1) {
+    switch (opt) {
+    case 'n': transactions = strtoul(optarg, NULL, 0); break;
+    case 't': turnaround_us = (uint32_t)strtoul(optarg, NULL, 0); break;
+    case 'j': slack_us = (uint32_t)strtoul(optarg, NULL, 0); break;
+    default:
+      fprintf(stderr, "usage: %s [-n transactions] [-t turnaround_us] [-j slack_us]\n", argv[0]);
+      return 2;
+    }
+  }
+  esp_log_level_set("*", ESP_LOG_WARN);
+
+  char slave[64];
+  responder_t responder = {.turnaround_us = turnaround_us};
+  responder.fd = open_pty(slave, sizeof(slave));
+  if (responder.fd < 0) {
+    return 1;
+  }
+  pthread_t thread;
+  pthread_create(&thread, NULL, responder_thread, &responder);
+
+  static const struct {
+    int baud;
+    bool de;
+  } runs[] = {{9600, true}, {19200, true}, {115200, true}, {9600, false}};
+  int failures = 0;
+  printf("%6s %4s %6s %6s %8s %10s %10s %10s %10s\n", "baud", "DE", "txns", "frames", "t3.5 us",
+         "min gap", "idle p50", "idle max", "limit");
+  for (size_t i = 0; i < sizeof(runs) / sizeof(runs[0]); i++) {
+    run_result_t res = run_baud(runs[i].baud, runs[i].de, slave, &responder, transactions, slack_us);
+    printf("%6d %4s %6zu %6zu %8lu %10lld %10lld %10lld %10lld%s\n", res.baud,
+           res.de ? "RTS" : "-", res.transactions, res.tx_frames, (unsigned long)res.frame_gap_us,
+           (long long)res.min_gap_us, (long long)res.median_idle_us, (long long)res.max_idle_us,
+           (long long)res.idle_limit_us,
+           res.failures ? "  FAIL" : "");
+    failures += res.failures;
+  }
+
+  responder.stop = true;
+  pthread_join(thread, NULL);
+  close(responder.fd);
+  printf("%s: %d failure(s)\n", failures ? "FAIL" : "PASS", failures);
+  return failures ? 1 : 0;
+}
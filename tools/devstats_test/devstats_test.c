@@ -0,0 +1,244 @@
+/*
+ * 设备统计与延迟直方图主机测试（Linux）
+ *
+ * 直接包含固件源码 main/rs485_devstats.c（可访问其静态槽位），用合成的
+ * 延迟驱动记录接口，检查：
+ *
+ *   - 分桶边界：127/128、255/256、2^21-1/2^21 及极值落在文档所述的桶；
+ *   - 分位数：按桶上界估算，并以实测最大值封顶；
+ *   - 各计数器、快照与设备表满时的行为；
+ *   - seqlock：写者更新到一半（序号为奇数）时读者持续重读，写者结束后
+ *     读到一致的新值；并发读写下快照从不出现撕裂。
+ *
+ * 编译（在 tools 目录）：
+ *   make devstats_test
+ *
+ * 任何一项检查不通过退出码为 1。
+ */
+#include "../../main/rs485_devstats.c"
+#include "host_test.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <time.h>
+
+static void sleep_ms(unsigned ms) {
+  struct timespec ts = {ms / 1000, (long)(ms % 1000) * 1000000};
+  nanosleep(&ts, NULL);
+}
+
+static void test_bucket_edges(void) {
+  static const struct {
+    uint32_t us;
+    unsigned bucket;
+  } cases[] = {
+      {0, 0},
+      {127, 0},
+      {128, 1},
+      {255, 1},
+      {256, 2},
+      {1000, 3},
+      {(1u << 20) - 1, 13},
+      {1u << 20, 14},
+      {(1u << 21) - 1, 14},
+      {1u << 21, 15},
+      {UINT32_MAX, RS485_LATENCY_BUCKETS - 1},
+  };
+  for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+    rs485_latency_hist_t hist = {0};
+    rs485_latency_hist_add(&hist, cases[i].us);
+    unsigned found = RS485_LATENCY_BUCKETS;
+    for (unsigned b = 0; b < RS485_LATENCY_BUCKETS; b++) {
+      if (hist.buckets[b] != 0) {
+        found = b;
+      }
+    }
+    CHECK(found == cases[i].bucket, "%lu us in bucket %u, expected %u",
+          (unsigned long)cases[i].us, found, cases[i].bucket);
+  }
+}
+
+static void test_percentiles(void) {
+  rs485_latency_hist_t hist = {0};
+  CHECK(rs485_latency_percentile_us(&hist, 50) == 0, "empty histogram");
+
+  // 90 个 100us、9 个 1000us、1 个 50000us
+  for (int i = 0; i < 90; i++) {
+    rs485_latency_hist_add(&hist, 100);
+  }
+  for (int i = 0; i < 9; i++) {
+    rs485_latency_hist_add(&hist, 1000);
+  }
+  rs485_latency_hist_add(&hist, 50000);
+
+  CHECK(hist.count == 100 && hist.min_us == 100 && hist.max_us == 50000 &&
+            hist.sum_us == 90 * 100 + 9 * 1000 + 50000,
+        "count %lu min %lu max %lu sum %llu", (unsigned long)hist.count,
+        (unsigned long)hist.min_us, (unsigned long)hist.max_us,
+        (unsigned long long)hist.sum_us);
+
+  static const struct {
+    unsigned percent;
+    uint32_t us;
+  } cases[] = {
+      {0, 128},    {50, 128},   {90, 128},   {91, 1024},
+      {99, 1024},  {100, 50000}, // 桶上界 65536 被最大值封顶
+  };
+  for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+    uint32_t us = rs485_latency_percentile_us(&hist, cases[i].percent);
+    CHECK(us == cases[i].us, "p%u = %lu us, expected %lu", cases[i].percent,
+          (unsigned long)us, (unsigned long)cases[i].us);
+  }
+
+  // 末桶没有上界，分位数取最大值
+  rs485_latency_hist_t tail = {0};
+  rs485_latency_hist_add(&tail, 3000000);
+  CHECK(rs485_latency_percentile_us(&tail, 50) == 3000000, "tail p50 = %lu",
+        (unsigned long)rs485_latency_percentile_us(&tail, 50));
+}
+
+static void test_counters(void) {
+  rs485_devstats_reset();
+  rs485_device_stats_t stats;
+  CHECK(!rs485_devstats_snapshot(UART_NUM_1, 0x05, &stats), "unknown device");
+
+  for (int i = 0; i < 4; i++) {
+    rs485_devstats_record_tx(UART_NUM_1, 0x05);
+  }
+  rs485_devstats_record_response(UART_NUM_1, 0x05, true, 1500, 6000);
+  rs485_devstats_record_response(UART_NUM_1, 0x05, false, 1, 2);
+  rs485_devstats_record_timeout(UART_NUM_1, 0x05);
+  rs485_devstats_record_framing_error(UART_NUM_1, 0x05);
+  rs485_devstats_record_retry(UART_NUM_1, 0x05);
+  rs485_devstats_record_tx(UART_NUM_2, 0x05); // 另一条总线上的同地址设备
+
+  CHECK(rs485_devstats_snapshot(UART_NUM_1, 0x05, &stats), "snapshot");
+  CHECK(stats.uart_num == UART_NUM_1 && stats.address == 0x05, "identity");
+  CHECK(stats.tx_frames == 4 && stats.rx_frames == 2 && stats.crc_errors == 1 &&
+            stats.timeouts == 1 && stats.framing_errors == 1 && stats.retries == 1,
+        "counters tx %lu rx %lu crc %lu timeout %lu framing %lu retry %lu",
+        (unsigned long)stats.tx_frames, (unsigned long)stats.rx_frames,
+        (unsigned long)stats.crc_errors, (unsigned long)stats.timeouts,
+        (unsigned long)stats.framing_errors, (unsigned long)stats.retries);
+  // CRC 错误的应答不计入延迟
+  CHECK(stats.first_byte.count == 1 && stats.first_byte.max_us == 1500 &&
+            stats.last_byte.count == 1 && stats.last_byte.max_us == 6000,
+        "latency samples");
+
+  CHECK(rs485_devstats_snapshot(UART_NUM_2, 0x05, &stats) && stats.tx_frames == 1,
+        "second bus");
+  CHECK(!rs485_devstats_snapshot(UART_NUM_MAX, 0x05, &stats), "invalid port");
+
+  // 表满后新设备不再统计（上面已占两个槽位）
+  for (unsigned addr = 0x10; addr < 0x10 + RS485_DEVSTATS_MAX_DEVICES; addr++) {
+    rs485_devstats_record_tx(UART_NUM_0, (uint8_t)addr);
+  }
+  rs485_device_stats_t all[RS485_DEVSTATS_MAX_DEVICES + 1];
+  size_t count = rs485_devstats_snapshot_all(all, RS485_DEVSTATS_MAX_DEVICES + 1);
+  CHECK(count == RS485_DEVSTATS_MAX_DEVICES, "%zu devices tracked", count);
+  CHECK(rs485_devstats_snapshot(UART_NUM_0, 0x10 + RS485_DEVSTATS_MAX_DEVICES - 3, &stats),
+        "last device that fits");
+  CHECK(!rs485_devstats_snapshot(UART_NUM_0, 0x10 + RS485_DEVSTATS_MAX_DEVICES - 2, &stats),
+        "device beyond capacity");
+
+  rs485_devstats_reset();
+  CHECK(rs485_devstats_snapshot_all(all, RS485_DEVSTATS_MAX_DEVICES) == 0, "reset");
+}
+
+typedef struct {
+  uart_port_t uart_num;
+  uint8_t address;
+  volatile bool done;
+  volatile bool stop;
+  rs485_device_stats_t stats;
+  uint64_t reads;
+  uint64_t torn;
+} reader_t;
+
+static void *reader_once(void *arg) {
+  reader_t *r = arg;
+  rs485_devstats_snapshot(r->uart_num, r->address, &r->stats);
+  r->done = true;
+  return NULL;
+}
+
+// 写者更新到一半：读者必须一直重读，直到序号恢复为偶数
+static void test_seqlock_retry(void) {
+  rs485_devstats_reset();
+  rs485_devstats_record_tx(UART_NUM_1, 0x20);
+  rs485_devstats_slot_t *slot = &s_slots[s_slot_index[UART_NUM_1][0x20] - 1];
+
+  portENTER_CRITICAL(&s_devstats_lock);
+  __atomic_store_n(&slot->seq, slot->seq + 1, __ATOMIC_RELEASE);
+  slot->stats.tx_frames = 99; // 只写了一半
+
+  reader_t reader = {.uart_num = UART_NUM_1, .address = 0x20};
+  pthread_t thread;
+  pthread_create(&thread, NULL, reader_once, &reader);
+  sleep_ms(30);
+  CHECK(!reader.done, "reader returned while the slot was being written");
+
+  slot->stats.rx_frames = 99;
+  __atomic_store_n(&slot->seq, slot->seq + 1, __ATOMIC_RELEASE);
+  portEXIT_CRITICAL(&s_devstats_lock);
+  pthread_join(thread, NULL);
+  CHECK(reader.done && reader.stats.tx_frames == 99 && reader.stats.rx_frames == 99,
+        "reader saw tx %lu rx %lu", (unsigned long)reader.stats.tx_frames,
+        (unsigned long)reader.stats.rx_frames);
+}
+
+static void *reader_loop(void *arg) {
+  reader_t *r = arg;
+  while (!r->stop) {
+    rs485_device_stats_t s;
+    if (!rs485_devstats_snapshot(r->uart_num, r->address, &s)) {
+      continue;
+    }
+    r->reads++;
+    // 写者每次记录 tx 后紧跟一次应答（末字节 = 首字节 + 1000），
+    // 一致的快照里样本数与和必须相互吻合
+    bool consistent = s.first_byte.count == s.last_byte.count &&
+                      s.last_byte.sum_us == s.first_byte.sum_us + 1000ULL * s.last_byte.count &&
+                      s.rx_frames == s.first_byte.count &&
+                      (s.tx_frames == s.rx_frames || s.tx_frames == s.rx_frames + 1);
+    if (!consistent) {
+      r->torn++;
+    }
+  }
+  return NULL;
+}
+
+static void test_seqlock_concurrent(unsigned records) {
+  rs485_devstats_reset();
+  rs485_devstats_record_tx(UART_NUM_1, 0x30);
+  rs485_devstats_record_response(UART_NUM_1, 0x30, true, 0, 1000);
+
+  reader_t reader = {.uart_num = UART_NUM_1, .address = 0x30};
+  pthread_t thread;
+  pthread_create(&thread, NULL, reader_loop, &reader);
+  for (unsigned i = 0; i < records; i++) {
+    uint32_t first = (i * 2654435761u) % 200000; // 覆盖多个桶
+    rs485_devstats_record_tx(UART_NUM_1, 0x30);
+    rs485_devstats_record_response(UART_NUM_1, 0x30, true, first, first + 1000);
+  }
+  reader.stop = true;
+  pthread_join(thread, NULL);
+
+  rs485_device_stats_t stats;
+  rs485_devstats_snapshot(UART_NUM_1, 0x30, &stats);
+  CHECK(stats.rx_frames == records + 1 && stats.tx_frames == records + 1,
+        "final counters %lu/%lu", (unsigned long)stats.tx_frames,
+        (unsigned long)stats.rx_frames);
+  CHECK(reader.torn == 0, "%llu of %llu snapshots torn", (unsigned long long)reader.torn,
+        (unsigned long long)reader.reads);
+  printf("concurrent: %u records, %llu snapshots, %llu torn\n", records,
+         (unsigned long long)reader.reads, (unsigned long long)reader.torn);
+}
+
+int main(void) {
+  test_bucket_edges();
+  test_percentiles();
+  test_counters();
+  test_seqlock_retry();
+  test_seqlock_concurrent(2000000);
+  return host_test_summary();
+}
@@ -0,0 +1,246 @@
+/*
+ * ESP-IDF 系统服务主机替身：时钟、esp_timer、日志、错误名、随机数与堆
+ */
+#include "esp_err.h"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "esp_random.h"
+#include "esp_rom_sys.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include <errno.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+static int64_t s_boot_us;
+
+static int64_t monotonic_us(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+__attribute__((constructor)) static void host_esp_init(void) { s_boot_us = monotonic_us(); }
+
+int64_t esp_timer_get_time(void) { return monotonic_us() - s_boot_us; }
+
+// 先睡到最后 100us 再忙等：单核主机上整段忙等会饿死对端线程
+void esp_rom_delay_us(uint32_t us) {
+  int64_t end = esp_timer_get_time() + us;
+  if (us > 200) {
+    struct timespec ts = {0, (long)(us - 100) * 1000};
+    nanosleep(&ts, NULL);
+  }
+  while (esp_timer_get_time() < end) {
+  }
+}
+
+// esp_timer：每个定时器一个线程
+
+struct esp_timer {
+  esp_timer_cb_t callback;
+  void *arg;
+  pthread_t thread;
+  pthread_mutex_t lock;
+  pthread_cond_t cond;
+  bool armed;
+  bool deleted;
+  uint64_t period_us; // 0 为单次
+  int64_t next_us;
+};
+
+static struct timespec timespec_at(int64_t esp_us) {
+  int64_t abs_us = esp_us + s_boot_us;
+  struct timespec ts = {(time_t)(abs_us / 1000000), (long)(abs_us % 1000000) * 1000};
+  return ts;
+}
+
+static void *esp_timer_thread(void *arg) {
+  esp_timer_handle_t timer = arg;
+  pthread_mutex_lock(&timer->lock);
+  while (!timer->deleted) {
+    if (!timer->armed) {
+      pthread_cond_wait(&timer->cond, &timer->lock);
+      continue;
+    }
+    if (esp_timer_get_time() < timer->next_us) {
+      struct timespec ts = timespec_at(timer->next_us);
+      pthread_cond_timedwait(&timer->cond, &timer->lock, &ts);
+      continue;
+    }
+    if (timer->period_us > 0) {
+      timer->next_us += (int64_t)timer->period_us;
+    } else {
+      timer->armed = false;
+    }
+    pthread_mutex_unlock(&timer->lock);
+    timer->callback(timer->arg);
+    pthread_mutex_lock(&timer->lock);
+  }
+  pthread_mutex_unlock(&timer->lock);
+  return NULL;
+}
+
+esp_err_t esp_timer_create(const esp_timer_create_args_t *args, esp_timer_handle_t *out_handle) {
+  if (args == NULL || args->callback == NULL || out_handle == NULL) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  esp_timer_handle_t timer = calloc(1, sizeof(*timer));
+  if (timer == NULL) {
+    return ESP_ERR_NO_MEM;
+  }
+  timer->callback = args->callback;
+  timer->arg = args->arg;
+  pthread_mutex_init(&timer->lock, NULL);
+  pthread_condattr_t attr;
+  pthread_condattr_init(&attr);
+  pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+  pthread_cond_init(&timer->cond, &attr);
+  pthread_condattr_destroy(&attr);
+  if (pthread_create(&timer->thread, NULL, esp_timer_thread, timer) != 0) {
+    free(timer);
+    return ESP_ERR_NO_MEM;
+  }
+  *out_handle = timer;
+  return ESP_OK;
+}
+
+static esp_err_t esp_timer_start(esp_timer_handle_t timer, uint64_t timeout_us, uint64_t period_us) {
+  if (timer == NULL) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  esp_err_t ret = ESP_OK;
+  pthread_mutex_lock(&timer->lock);
+  if (timer->armed) {
+    ret = ESP_ERR_INVALID_STATE;
+  } else {
+    timer->armed = true;
+    timer->period_us = period_us;
+    timer->next_us = esp_timer_get_time() + (int64_t)timeout_us;
+    pthread_cond_signal(&timer->cond);
+  }
+  pthread_mutex_unlock(&timer->lock);
+  return ret;
+}
+
+esp_err_t esp_timer_start_once(esp_timer_handle_t timer, uint64_t timeout_us) {
+  return esp_timer_start(timer, timeout_us, 0);
+}
+
+esp_err_t esp_timer_start_periodic(esp_timer_handle_t timer, uint64_t period_us) {
+  return esp_timer_start(timer, period_us, period_us);
+}
+
+esp_err_t esp_timer_stop(esp_timer_handle_t timer) {
+  if (timer == NULL) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  esp_err_t ret = ESP_OK;
+  pthread_mutex_lock(&timer->lock);
+  if (!timer->armed) {
+    ret = ESP_ERR_INVALID_STATE;
+  }
+  timer->armed = false;
+  pthread_cond_signal(&timer->cond);
+  pthread_mutex_unlock(&timer->lock);
+  return ret;
+}
+
+bool esp_timer_is_active(esp_timer_handle_t timer) {
+  pthread_mutex_lock(&timer->lock);
+  bool armed = timer->armed;
+  pthread_mutex_unlock(&timer->lock);
+  return armed;
+}
+
+esp_err_t esp_timer_delete(esp_timer_handle_t timer) {
+  if (timer == NULL) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  pthread_mutex_lock(&timer->lock);
+  if (timer->armed) {
+    pthread_mutex_unlock(&timer->lock);
+    return ESP_ERR_INVALID_STATE;
+  }
+  timer->deleted = true;
+  pthread_cond_signal(&timer->cond);
+  pthread_mutex_unlock(&timer->lock);
+  if (pthread_equal(timer->thread, pthread_self())) {
+    pthread_detach(timer->thread); // 在自己的回调里删除：线程随后自行退出
+    return ESP_OK;
+  }
+  pthread_join(timer->thread, NULL);
+  pthread_mutex_destroy(&timer->lock);
+  pthread_cond_destroy(&timer->cond);
+  free(timer);
+  return ESP_OK;
+}
+
+// 日志
+
+static esp_log_level_t s_log_level = ESP_LOG_INFO;
+
+void esp_log_level_set(const char *tag, esp_log_level_t level) {
+  if (tag != NULL && strcmp(tag, "*") == 0) {
+    s_log_level = level;
+  }
+}
+
+void esp_log_write(esp_log_level_t level, const char *tag, const char *format, ...) {
+  static const char letters[] = "NEWIDV";
+  if (level > s_log_level) {
+    return;
+  }
+  // 写日志期间不响应 vTaskDelete 的取消，避免带着 stdio 锁退出
+  int cancel_state;
+  pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, &cancel_state);
+  va_list args;
+  va_start(args, format);
+  flockfile(stderr);
+  fprintf(stderr, "%c (%lld) %s: ", letters[level], (long long)(esp_timer_get_time() / 1000), tag);
+  vfprintf(stderr, format, args);
+  fputc('\n', stderr);
+  funlockfile(stderr);
+  va_end(args);
+  pthread_setcancelstate(cancel_state, NULL);
+}
+
+// 错误码
+
+const char *esp_err_to_name(esp_err_t code) {
+  switch (code) {
+  case ESP_OK: return "ESP_OK";
+  case ESP_FAIL: return "ESP_FAIL";
+  case ESP_ERR_NO_MEM: return "ESP_ERR_NO_MEM";
+  case ESP_ERR_INVALID_ARG: return "ESP_ERR_INVALID_ARG";
+  case ESP_ERR_INVALID_STATE: return "ESP_ERR_INVALID_STATE";
+  case ESP_ERR_INVALID_SIZE: return "ESP_ERR_INVALID_SIZE";
+  case ESP_ERR_NOT_FOUND: return "ESP_ERR_NOT_FOUND";
+  case ESP_ERR_NOT_SUPPORTED: return "ESP_ERR_NOT_SUPPORTED";
+  case ESP_ERR_TIMEOUT: return "ESP_ERR_TIMEOUT";
+  default: return "UNKNOWN ERROR";
+  }
+}
+
+void host_esp_abort(const char *expr, esp_err_t code, const char *file, int line) {
+  fprintf(stderr, "ESP_ERROR_CHECK failed: %s (%s) at %s:%d\n", esp_err_to_name(code), expr, file,
+          line);
+  abort();
+}
+
+uint32_t esp_random(void) { return ((uint32_t)random() << 16) ^ (uint32_t)random(); }
+
+void *heap_caps_malloc(size_t size, uint32_t caps) {
+  (void)caps;
+  return malloc(size);
+}
+
+void *heap_caps_calloc(size_t n, size_t size, uint32_t caps) {
+  (void)caps;
+  return calloc(n, size);
+}
+
+void heap_caps_free(void *ptr) { free(ptr); }
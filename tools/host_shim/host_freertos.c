@@ -0,0 +1,566 @@
+/*
+ * FreeRTOS 主机替身实现，见 include/freertos/FreeRTOS.h
+ *
+ * 所有阻塞都落在 pthread_cond_(timed)wait 上，并以清理函数释放互斥量，
+ * 因此 vTaskDelete() 可在任意阻塞点取消其他任务。
+ */
+#include "freertos/FreeRTOS.h"
+#include "freertos/event_groups.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include "esp_timer.h"
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+struct tskTaskControlBlock {
+  pthread_t thread;
+  TaskFunction_t fn;
+  void *arg;
+  char name[16];
+  pthread_mutex_t lock;
+  pthread_cond_t cond;
+  uint32_t notify_value;
+  bool notify_pending;
+};
+
+struct QueueDefinition {
+  pthread_mutex_t lock;
+  pthread_cond_t readable;
+  pthread_cond_t writable;
+  uint8_t *storage;
+  UBaseType_t length;
+  UBaseType_t item_size; // 0 表示信号量
+  UBaseType_t head;
+  UBaseType_t count;
+};
+
+// 等待者由 xEventGroupSetBits 在持锁时判定并标记，与 FreeRTOS 语义一致：
+// 置位瞬间已在等待的任务一定被唤醒，之后立即清位也不会丢失
+typedef struct event_waiter {
+  struct event_waiter *next;
+  EventBits_t bits;
+  bool wait_for_all;
+  bool clear_on_exit;
+  bool satisfied;
+  EventBits_t result;
+} event_waiter_t;
+
+struct EventGroupDef_t {
+  pthread_mutex_t lock;
+  pthread_cond_t cond;
+  EventBits_t bits;
+  event_waiter_t *waiters;
+};
+
+static __thread TaskHandle_t s_current_task;
+
+static void cond_init(pthread_cond_t *cond) {
+  pthread_condattr_t attr;
+  pthread_condattr_init(&attr);
+  pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+  pthread_cond_init(cond, &attr);
+  pthread_condattr_destroy(&attr);
+}
+
+static void unlock_mutex(void *mutex) { pthread_mutex_unlock((pthread_mutex_t *)mutex); }
+
+static struct timespec deadline_after(TickType_t ticks) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  uint64_t ns = (uint64_t)pdTICKS_TO_MS(ticks) * 1000000ULL + (uint64_t)ts.tv_nsec;
+  ts.tv_sec += (time_t)(ns / 1000000000ULL);
+  ts.tv_nsec = (long)(ns % 1000000000ULL);
+  return ts;
+}
+
+// 等待一次条件变量；返回 false 表示已到期限（ticks 为 0 时直接返回 false）
+static bool cond_wait(pthread_cond_t *cond, pthread_mutex_t *mutex, TickType_t ticks,
+                      const struct timespec *deadline) {
+  if (ticks == 0) {
+    return false;
+  }
+  if (ticks == portMAX_DELAY) {
+    pthread_cond_wait(cond, mutex);
+    return true;
+  }
+  return pthread_cond_timedwait(cond, mutex, deadline) != ETIMEDOUT;
+}
+
+BaseType_t xPortGetCoreID(void) { return 0; }
+
+// 任务
+
+static TaskHandle_t task_alloc(TaskFunction_t fn, const char *name, void *arg) {
+  TaskHandle_t task = calloc(1, sizeof(*task));
+  if (task == NULL) {
+    return NULL;
+  }
+  task->fn = fn;
+  task->arg = arg;
+  snprintf(task->name, sizeof(task->name), "%s", name != NULL ? name : "");
+  pthread_mutex_init(&task->lock, NULL);
+  cond_init(&task->cond);
+  return task;
+}
+
+static void task_free(TaskHandle_t task) {
+  pthread_mutex_destroy(&task->lock);
+  pthread_cond_destroy(&task->cond);
+  free(task);
+}
+
+static void *task_entry(void *arg) {
+  TaskHandle_t task = arg;
+  s_current_task = task;
+  task->fn(task->arg);
+  // FreeRTOS 任务函数不允许返回
+  fprintf(stderr, "task %s returned without vTaskDelete\n", task->name);
+  abort();
+}
+
+BaseType_t xTaskCreate(TaskFunction_t fn, const char *name, uint32_t stack_depth, void *arg,
+                       UBaseType_t priority, TaskHandle_t *out_task) {
+  (void)stack_depth;
+  (void)priority;
+  TaskHandle_t task = task_alloc(fn, name, arg);
+  if (task == NULL) {
+    return pdFAIL;
+  }
+  // 先交出句柄再启动线程，新任务可能立即用到它
+  if (out_task != NULL) {
+    *out_task = task;
+  }
+  if (pthread_create(&task->thread, NULL, task_entry, task) != 0) {
+    if (out_task != NULL) {
+      *out_task = NULL;
+    }
+    task_free(task);
+    return pdFAIL;
+  }
+  return pdPASS;
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char *name, uint32_t stack_depth,
+                                   void *arg, UBaseType_t priority, TaskHandle_t *out_task,
+                                   BaseType_t core_id) {
+  (void)core_id;
+  return xTaskCreate(fn, name, stack_depth, arg, priority, out_task);
+}
+
+void vTaskDelete(TaskHandle_t task) {
+  if (task == NULL || task == s_current_task) {
+    task = s_current_task;
+    if (task != NULL) {
+      pthread_detach(task->thread);
+      s_current_task = NULL;
+      task_free(task);
+    }
+    pthread_exit(NULL);
+  }
+  pthread_cancel(task->thread);
+  pthread_join(task->thread, NULL);
+  task_free(task);
+}
+
+void vTaskSuspend(TaskHandle_t task) {
+  if (task != NULL && task != s_current_task) {
+    fprintf(stderr, "vTaskSuspend of another task is not supported\n");
+    abort();
+  }
+  while (1) {
+    pause(); // 取消点
+  }
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void) {
+  if (s_current_task == NULL) {
+    s_current_task = task_alloc(NULL, "main", NULL);
+    s_current_task->thread = pthread_self();
+  }
+  return s_current_task;
+}
+
+static void sleep_until_us(int64_t target_us) {
+  int64_t remaining = target_us - esp_timer_get_time();
+  if (remaining > 0) {
+    struct timespec ts = {(time_t)(remaining / 1000000), (long)(remaining % 1000000) * 1000};
+    while (nanosleep(&ts, &ts) != 0 && errno == EINTR) {
+    }
+  }
+}
+
+void vTaskDelay(TickType_t ticks) {
+  if (ticks == 0) {
+    sched_yield();
+    return;
+  }
+  sleep_until_us(esp_timer_get_time() + (int64_t)pdTICKS_TO_MS(ticks) * 1000);
+}
+
+TickType_t xTaskGetTickCount(void) {
+  return (TickType_t)(esp_timer_get_time() / (1000 * portTICK_PERIOD_MS));
+}
+
+BaseType_t xTaskDelayUntil(TickType_t *previous_wake, TickType_t increment) {
+  TickType_t target = *previous_wake + increment;
+  *previous_wake = target;
+  if ((int32_t)(target - xTaskGetTickCount()) <= 0) {
+    return pdFALSE;
+  }
+  sleep_until_us((int64_t)pdTICKS_TO_MS(target) * 1000);
+  return pdTRUE;
+}
+
+// 任务通知
+
+BaseType_t xTaskNotify(TaskHandle_t task, uint32_t value, eNotifyAction action) {
+  BaseType_t ret = pdPASS;
+  pthread_mutex_lock(&task->lock);
+  switch (action) {
+  case eSetBits:
+    task->notify_value |= value;
+    break;
+  case eIncrement:
+    task->notify_value++;
+    break;
+  case eSetValueWithOverwrite:
+    task->notify_value = value;
+    break;
+  case eSetValueWithoutOverwrite:
+    if (task->notify_pending) {
+      ret = pdFAIL;
+    } else {
+      task->notify_value = value;
+    }
+    break;
+  case eNoAction:
+    break;
+  }
+  task->notify_pending = true;
+  pthread_cond_broadcast(&task->cond);
+  pthread_mutex_unlock(&task->lock);
+  return ret;
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task) { return xTaskNotify(task, 0, eIncrement); }
+
+BaseType_t xTaskNotifyFromISR(TaskHandle_t task, uint32_t value, eNotifyAction action,
+                              BaseType_t *woken) {
+  if (woken != NULL) {
+    *woken = pdFALSE;
+  }
+  return xTaskNotify(task, value, action);
+}
+
+void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t *woken) {
+  xTaskNotifyFromISR(task, 0, eIncrement, woken);
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clear_on_exit, TickType_t ticks) {
+  TaskHandle_t self = xTaskGetCurrentTaskHandle();
+  struct timespec deadline = deadline_after(ticks);
+  uint32_t value;
+  pthread_mutex_lock(&self->lock);
+  pthread_cleanup_push(unlock_mutex, &self->lock);
+  while (self->notify_value == 0 && cond_wait(&self->cond, &self->lock, ticks, &deadline)) {
+  }
+  value = self->notify_value;
+  if (value != 0) {
+    self->notify_value = clear_on_exit ? 0 : value - 1;
+  }
+  self->notify_pending = false;
+  pthread_cleanup_pop(1);
+  return value;
+}
+
+BaseType_t xTaskNotifyWait(uint32_t clear_on_entry, uint32_t clear_on_exit, uint32_t *value,
+                           TickType_t ticks) {
+  TaskHandle_t self = xTaskGetCurrentTaskHandle();
+  struct timespec deadline = deadline_after(ticks);
+  BaseType_t ret;
+  pthread_mutex_lock(&self->lock);
+  pthread_cleanup_push(unlock_mutex, &self->lock);
+  if (!self->notify_pending) {
+    self->notify_value &= ~clear_on_entry;
+  }
+  while (!self->notify_pending && cond_wait(&self->cond, &self->lock, ticks, &deadline)) {
+  }
+  if (value != NULL) {
+    *value = self->notify_value;
+  }
+  ret = self->notify_pending ? pdTRUE : pdFALSE;
+  if (self->notify_pending) {
+    self->notify_value &= ~clear_on_exit;
+    self->notify_pending = false;
+  }
+  pthread_cleanup_pop(1);
+  return ret;
+}
+
+uint32_t ulTaskNotifyValueClear(TaskHandle_t task, uint32_t bits) {
+  if (task == NULL) {
+    task = xTaskGetCurrentTaskHandle();
+  }
+  pthread_mutex_lock(&task->lock);
+  uint32_t old = task->notify_value;
+  task->notify_value &= ~bits;
+  pthread_mutex_unlock(&task->lock);
+  return old;
+}
+
+// 队列与信号量
+
+static QueueHandle_t queue_create(UBaseType_t length, UBaseType_t item_size, UBaseType_t count) {
+  QueueHandle_t queue = calloc(1, sizeof(*queue));
+  if (queue == NULL || length == 0) {
+    free(queue);
+    return NULL;
+  }
+  if (item_size > 0) {
+    queue->storage = malloc((size_t)length * item_size);
+    if (queue->storage == NULL) {
+      free(queue);
+      return NULL;
+    }
+  }
+  queue->length = length;
+  queue->item_size = item_size;
+  queue->count = count;
+  pthread_mutex_init(&queue->lock, NULL);
+  cond_init(&queue->readable);
+  cond_init(&queue->writable);
+  return queue;
+}
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t item_size) {
+  return queue_create(length, item_size, 0);
+}
+
+SemaphoreHandle_t xSemaphoreCreateBinary(void) { return queue_create(1, 0, 0); }
+
+SemaphoreHandle_t xSemaphoreCreateCounting(UBaseType_t max_count, UBaseType_t initial_count) {
+  return initial_count > max_count ? NULL : queue_create(max_count, 0, initial_count);
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void) { return queue_create(1, 0, 1); }
+
+void vQueueDelete(QueueHandle_t queue) {
+  if (queue == NULL) {
+    return;
+  }
+  pthread_mutex_destroy(&queue->lock);
+  pthread_cond_destroy(&queue->readable);
+  pthread_cond_destroy(&queue->writable);
+  free(queue->storage);
+  free(queue);
+}
+
+static BaseType_t queue_send(QueueHandle_t queue, const void *item, TickType_t ticks, bool front,
+                             bool overwrite) {
+  struct timespec deadline = deadline_after(ticks);
+  BaseType_t ret = pdFALSE;
+  pthread_mutex_lock(&queue->lock);
+  pthread_cleanup_push(unlock_mutex, &queue->lock);
+  if (overwrite && queue->count == queue->length) {
+    queue->count--;
+  }
+  while (queue->count == queue->length && cond_wait(&queue->writable, &queue->lock, ticks, &deadline)) {
+  }
+  if (queue->count < queue->length) {
+    UBaseType_t slot;
+    if (front) {
+      queue->head = (queue->head + queue->length - 1) % queue->length;
+      slot = queue->head;
+    } else {
+      slot = (queue->head + queue->count) % queue->length;
+    }
+    if (queue->item_size > 0) {
+      memcpy(&queue->storage[(size_t)slot * queue->item_size], item, queue->item_size);
+    }
+    queue->count++;
+    pthread_cond_signal(&queue->readable);
+    ret = pdTRUE;
+  }
+  pthread_cleanup_pop(1);
+  return ret;
+}
+
+BaseType_t xQueueSend(QueueHandle_t queue, const void *item, TickType_t ticks) {
+  return queue_send(queue, item, ticks, false, false);
+}
+
+BaseType_t xQueueSendToFront(QueueHandle_t queue, const void *item, TickType_t ticks) {
+  return queue_send(queue, item, ticks, true, false);
+}
+
+BaseType_t xQueueOverwrite(QueueHandle_t queue, const void *item) {
+  return queue_send(queue, item, 0, false, true);
+}
+
+BaseType_t xQueueSendFromISR(QueueHandle_t queue, const void *item, BaseType_t *woken) {
+  if (woken != NULL) {
+    *woken = pdFALSE;
+  }
+  return queue_send(queue, item, 0, false, false);
+}
+
+static BaseType_t queue_receive(QueueHandle_t queue, void *item, TickType_t ticks, bool peek) {
+  struct timespec deadline = deadline_after(ticks);
+  BaseType_t ret = pdFALSE;
+  pthread_mutex_lock(&queue->lock);
+  pthread_cleanup_push(unlock_mutex, &queue->lock);
+  while (queue->count == 0 && cond_wait(&queue->readable, &queue->lock, ticks, &deadline)) {
+  }
+  if (queue->count > 0) {
+    if (queue->item_size > 0 && item != NULL) {
+      memcpy(item, &queue->storage[(size_t)queue->head * queue->item_size], queue->item_size);
+    }
+    if (!peek) {
+      queue->head = (queue->head + 1) % queue->length;
+      queue->count--;
+      pthread_cond_signal(&queue->writable);
+    }
+    ret = pdTRUE;
+  }
+  pthread_cleanup_pop(1);
+  return ret;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t queue, void *item, TickType_t ticks) {
+  return queue_receive(queue, item, ticks, false);
+}
+
+BaseType_t xQueuePeek(QueueHandle_t queue, void *item, TickType_t ticks) {
+  return queue_receive(queue, item, ticks, true);
+}
+
+BaseType_t xQueueReset(QueueHandle_t queue) {
+  pthread_mutex_lock(&queue->lock);
+  queue->head = 0;
+  queue->count = 0;
+  pthread_cond_broadcast(&queue->writable);
+  pthread_mutex_unlock(&queue->lock);
+  return pdPASS;
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue) {
+  pthread_mutex_lock(&queue->lock);
+  UBaseType_t count = queue->count;
+  pthread_mutex_unlock(&queue->lock);
+  return count;
+}
+
+UBaseType_t uxQueueSpacesAvailable(QueueHandle_t queue) {
+  pthread_mutex_lock(&queue->lock);
+  UBaseType_t spaces = queue->length - queue->count;
+  pthread_mutex_unlock(&queue->lock);
+  return spaces;
+}
+
+// 事件组
+
+static bool event_match(EventBits_t current, EventBits_t bits, bool wait_for_all) {
+  return wait_for_all ? (current & bits) == bits : (current & bits) != 0;
+}
+
+EventGroupHandle_t xEventGroupCreate(void) {
+  EventGroupHandle_t group = calloc(1, sizeof(*group));
+  if (group != NULL) {
+    pthread_mutex_init(&group->lock, NULL);
+    cond_init(&group->cond);
+  }
+  return group;
+}
+
+void vEventGroupDelete(EventGroupHandle_t group) {
+  if (group == NULL) {
+    return;
+  }
+  pthread_mutex_destroy(&group->lock);
+  pthread_cond_destroy(&group->cond);
+  free(group);
+}
+
+EventBits_t xEventGroupSetBits(EventGroupHandle_t group, EventBits_t bits) {
+  pthread_mutex_lock(&group->lock);
+  group->bits |= bits;
+  EventBits_t clear = 0;
+  for (event_waiter_t *w = group->waiters; w != NULL; w = w->next) {
+    if (!w->satisfied && event_match(group->bits, w->bits, w->wait_for_all)) {
+      w->satisfied = true;
+      w->result = group->bits;
+      if (w->clear_on_exit) {
+        clear |= w->bits;
+      }
+    }
+  }
+  group->bits &= ~clear;
+  EventBits_t result = group->bits;
+  pthread_cond_broadcast(&group->cond);
+  pthread_mutex_unlock(&group->lock);
+  return result;
+}
+
+EventBits_t xEventGroupClearBits(EventGroupHandle_t group, EventBits_t bits) {
+  pthread_mutex_lock(&group->lock);
+  EventBits_t old = group->bits;
+  group->bits &= ~bits;
+  pthread_mutex_unlock(&group->lock);
+  return old;
+}
+
+EventBits_t xEventGroupGetBits(EventGroupHandle_t group) {
+  pthread_mutex_lock(&group->lock);
+  EventBits_t bits = group->bits;
+  pthread_mutex_unlock(&group->lock);
+  return bits;
+}
+
+static void event_waiter_remove(void *arg) {
+  void **ctx = arg;
+  EventGroupHandle_t group = ctx[0];
+  event_waiter_t *waiter = ctx[1];
+  for (event_waiter_t **p = &group->waiters; *p != NULL; p = &(*p)->next) {
+    if (*p == waiter) {
+      *p = waiter->next;
+      break;
+    }
+  }
+  pthread_mutex_unlock(&group->lock);
+}
+
+EventBits_t xEventGroupWaitBits(EventGroupHandle_t group, EventBits_t bits, BaseType_t clear_on_exit,
+                                BaseType_t wait_for_all, TickType_t ticks) {
+  struct timespec deadline = deadline_after(ticks);
+  event_waiter_t waiter = {
+      .bits = bits,
+      .wait_for_all = wait_for_all,
+      .clear_on_exit = clear_on_exit,
+  };
+  void *ctx[2] = {group, &waiter};
+  pthread_mutex_lock(&group->lock);
+  if (event_match(group->bits, bits, wait_for_all)) {
+    waiter.result = group->bits;
+    if (clear_on_exit) {
+      group->bits &= ~bits;
+    }
+    pthread_mutex_unlock(&group->lock);
+    return waiter.result;
+  }
+
+  waiter.next = group->waiters;
+  group->waiters = &waiter;
+  pthread_cleanup_push(event_waiter_remove, ctx);
+  while (!waiter.satisfied && cond_wait(&group->cond, &group->lock, ticks, &deadline)) {
+  }
+  if (!waiter.satisfied) {
+    waiter.result = group->bits;
+  }
+  pthread_cleanup_pop(1);
+  return waiter.result;
+}
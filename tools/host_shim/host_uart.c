@@ -0,0 +1,628 @@
+/*
+ * UART 驱动主机替身实现，见 include/driver/uart.h
+ *
+ * 每个端口两个线程：发送线程在每块数据的最后一个停止位时刻把它写进
+ * 设备文件；接收线程读设备文件，按字符时间推算线路占用，在 FIFO 满
+ * 阈值或 RX 超时时刻投递事件。所有状态由端口锁保护。
+ */
+#include "driver/uart.h"
+#include "esp_timer.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+#define HOST_UART_RX_FULL_THRESHOLD 120 // 与 IDF 驱动默认的 FIFO 满阈值相同
+#define HOST_UART_FIFO_LEN 128
+
+typedef struct tx_chunk {
+  struct tx_chunk *next;
+  int64_t end_us; // 最后一个停止位结束的时刻
+  size_t length;
+  uint8_t data[];
+} tx_chunk_t;
+
+typedef struct {
+  int fd;
+  int wake_pipe[2]; // 唤醒接收线程
+  bool installed;
+  bool stop;
+  pthread_mutex_t lock;
+  pthread_cond_t cond;
+  pthread_t rx_thread;
+  pthread_t tx_thread;
+  QueueHandle_t events;
+
+  int baud_rate;
+  uart_parity_t parity;
+  uart_mode_t mode;
+  uint8_t rx_timeout_symbols;
+  uint8_t rx_full_threshold;
+  uint32_t char_us;
+
+  // 接收
+  uint8_t *rx_buf;
+  size_t rx_size;
+  size_t rx_head;
+  size_t rx_count;
+  size_t rx_unreported; // 已进 FIFO 但未以事件上报的字节
+  int64_t rx_line_end;  // 对端最后一个字节在线路上结束的时刻
+  bool rx_burst_open;
+  int64_t rx_burst_start;
+  uint16_t rx_burst_len;
+  bool rx_burst_collision;
+
+  // 发送
+  tx_chunk_t *tx_head;
+  tx_chunk_t *tx_tail;
+  int64_t tx_start; // 最近一块的起始时刻
+  int64_t tx_end;   // 已提交数据全部移出的时刻
+  bool collision;
+
+  // 线路日志
+  host_uart_line_t log[HOST_UART_LINE_LOG_LEN];
+  uint64_t log_total; // 累计写入条数
+  uint64_t log_base;  // 已取出的条数
+  uint64_t log_last_tx;
+  bool log_has_tx;
+} host_uart_port_t;
+
+static host_uart_port_t s_ports[UART_NUM_MAX] = {
+    [0 ... UART_NUM_MAX - 1] = {.fd = -1, .wake_pipe = {-1, -1}, .lock = PTHREAD_MUTEX_INITIALIZER},
+};
+
+static host_uart_port_t *port_get(uart_port_t uart_num) {
+  return uart_num >= 0 && uart_num < UART_NUM_MAX ? &s_ports[uart_num] : NULL;
+}
+
+static host_uart_port_t *port_installed(uart_port_t uart_num) {
+  host_uart_port_t *port = port_get(uart_num);
+  return port != NULL && port->installed ? port : NULL;
+}
+
+static struct timespec timespec_at(int64_t esp_us) {
+  // esp_timer_get_time 与 CLOCK_MONOTONIC 只差一个常量
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  int64_t abs_us = (int64_t)now.tv_sec * 1000000 + now.tv_nsec / 1000 + (esp_us - esp_timer_get_time());
+  struct timespec ts = {(time_t)(abs_us / 1000000), (long)(abs_us % 1000000) * 1000};
+  return ts;
+}
+
+// 每字符位数：起始位 + 8 数据位 + 校验位 + 1 停止位
+static void port_update_timing(host_uart_port_t *port) {
+  int bits = port->parity == UART_PARITY_DISABLE ? 10 : 11;
+  port->char_us = (uint32_t)((bits * 1000000ULL + port->baud_rate - 1) / port->baud_rate);
+}
+
+static host_uart_line_t *log_append(host_uart_port_t *port) {
+  host_uart_line_t *entry = &port->log[port->log_total % HOST_UART_LINE_LOG_LEN];
+  memset(entry, 0, sizeof(*entry));
+  port->log_total++;
+  return entry;
+}
+
+static host_uart_line_t *log_last_tx(host_uart_port_t *port) {
+  if (!port->log_has_tx || port->log_last_tx < port->log_base ||
+      port->log_total - port->log_last_tx > HOST_UART_LINE_LOG_LEN) {
+    return NULL;
+  }
+  return &port->log[port->log_last_tx % HOST_UART_LINE_LOG_LEN];
+}
+
+static void post_event(host_uart_port_t *port, uart_event_type_t type, size_t size, bool timeout_flag) {
+  if (port->events == NULL) {
+    return;
+  }
+  uart_event_t event = {.type = type, .size = size, .timeout_flag = timeout_flag};
+  xQueueSend(port->events, &event, 0); // 与驱动一样，队列满时丢弃事件
+}
+
+static void rx_close_burst(host_uart_port_t *port) {
+  host_uart_line_t *entry = log_append(port);
+  entry->start_us = port->rx_burst_start;
+  entry->end_us = port->rx_line_end;
+  entry->length = port->rx_burst_len;
+  entry->collision = port->rx_burst_collision;
+  port->rx_burst_open = false;
+}
+
+// 收到对端一批字节：按字符时间排在线路上，与本端发送窗口重叠即为冲突
+static void rx_accept(host_uart_port_t *port, const uint8_t *data, size_t length) {
+  int64_t now = esp_timer_get_time();
+  int64_t start = now > port->rx_line_end ? now : port->rx_line_end;
+  if (!port->rx_burst_open) {
+    port->rx_burst_open = true;
+    port->rx_burst_start = start;
+    port->rx_burst_len = 0;
+    port->rx_burst_collision = false;
+  }
+  port->rx_line_end = start + (int64_t)length * port->char_us;
+  port->rx_burst_len += (uint16_t)length;
+
+  if (port->tx_end > start && port->tx_start < port->rx_line_end) {
+    port->collision = true;
+    port->rx_burst_collision = true;
+    host_uart_line_t *tx = log_last_tx(port);
+    if (tx != NULL) {
+      tx->collision = true;
+    }
+  }
+
+  size_t stored = 0;
+  while (stored < length && port->rx_count < port->rx_size) {
+    port->rx_buf[(port->rx_head + port->rx_count) % port->rx_size] = data[stored++];
+    port->rx_count++;
+  }
+  port->rx_unreported += stored;
+  if (stored < length) {
+    post_event(port, UART_BUFFER_FULL, length - stored, false);
+  }
+  pthread_cond_broadcast(&port->cond);
+}
+
+static void *rx_thread(void *arg) {
+  host_uart_port_t *port = arg;
+  uint8_t buf[256];
+  pthread_mutex_lock(&port->lock);
+  while (!port->stop) {
+    int64_t now = esp_timer_get_time();
+    int64_t deadline = now + 100000;
+
+    if (port->rx_unreported >= port->rx_full_threshold) {
+      // 达到满阈值的那个字节进入 FIFO 的时刻
+      int64_t full_at = port->rx_line_end -
+                        (int64_t)(port->rx_unreported - port->rx_full_threshold) * port->char_us;
+      if (now >= full_at) {
+        post_event(port, UART_DATA, port->rx_full_threshold, false);
+        port->rx_unreported -= port->rx_full_threshold;
+        continue;
+      }
+      deadline = full_at;
+    } else if (port->rx_burst_open) {
+      // RX 超时只在 FIFO 非空时触发；被 flush 掉的突发只结束日志条目
+      int64_t timeout_at = port->rx_line_end + (int64_t)port->rx_timeout_symbols * port->char_us;
+      if (now >= timeout_at) {
+        if (port->rx_unreported > 0) {
+          post_event(port, UART_DATA, port->rx_unreported, true);
+          port->rx_unreported = 0;
+        }
+        rx_close_burst(port);
+        continue;
+      }
+      deadline = timeout_at;
+    }
+
+    pthread_mutex_unlock(&port->lock);
+    struct pollfd fds[2] = {
+        {.fd = port->fd, .events = POLLIN},
+        {.fd = port->wake_pipe[0], .events = POLLIN},
+    };
+    int64_t wait_us = deadline - now;
+    struct timespec ts = {(time_t)(wait_us / 1000000), (long)(wait_us % 1000000) * 1000};
+    int ready = ppoll(fds, 2, &ts, NULL);
+    ssize_t n = 0;
+    if (ready > 0 && (fds[0].revents & POLLIN)) {
+      n = read(port->fd, buf, sizeof(buf));
+    } else if (ready > 0 && (fds[0].revents & POLLHUP)) {
+      usleep(1000); // 伪终端主端尚未打开
+    }
+    if (ready > 0 && (fds[1].revents & POLLIN)) {
+      char c;
+      while (read(port->wake_pipe[0], &c, 1) == 1) {
+      }
+    }
+    pthread_mutex_lock(&port->lock);
+    if (n > 0) {
+      rx_accept(port, buf, (size_t)n);
+    }
+  }
+  pthread_mutex_unlock(&port->lock);
+  return NULL;
+}
+
+static void *tx_thread(void *arg) {
+  host_uart_port_t *port = arg;
+  pthread_mutex_lock(&port->lock);
+  while (!port->stop) {
+    tx_chunk_t *chunk = port->tx_head;
+    if (chunk == NULL) {
+      pthread_cond_wait(&port->cond, &port->lock);
+      continue;
+    }
+    if (esp_timer_get_time() < chunk->end_us) {
+      struct timespec ts = timespec_at(chunk->end_us);
+      pthread_cond_timedwait(&port->cond, &port->lock, &ts);
+      continue;
+    }
+    port->tx_head = chunk->next;
+    if (port->tx_head == NULL) {
+      port->tx_tail = NULL;
+    }
+    pthread_mutex_unlock(&port->lock);
+    size_t done = 0;
+    while (done < chunk->length) {
+      ssize_t n = write(port->fd, chunk->data + done, chunk->length - done);
+      if (n <= 0 && errno != EINTR) {
+        break;
+      }
+      done += n > 0 ? (size_t)n : 0;
+    }
+    free(chunk);
+    pthread_mutex_lock(&port->lock);
+    pthread_cond_broadcast(&port->cond);
+  }
+  pthread_mutex_unlock(&port->lock);
+  return NULL;
+}
+
+esp_err_t host_uart_attach(uart_port_t uart_num, const char *path) {
+  host_uart_port_t *port = port_get(uart_num);
+  if (port == NULL || port->installed || path == NULL) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  int fd = open(path, O_RDWR | O_NOCTTY);
+  if (fd < 0) {
+    return ESP_FAIL;
+  }
+  struct termios tio;
+  if (tcgetattr(fd, &tio) == 0) {
+    cfmakeraw(&tio);
+    tcsetattr(fd, TCSANOW, &tio);
+  }
+  if (port->fd >= 0) {
+    close(port->fd);
+  }
+  port->fd = fd;
+  return ESP_OK;
+}
+
+void host_uart_detach(uart_port_t uart_num) {
+  host_uart_port_t *port = port_get(uart_num);
+  if (port == NULL || port->installed || port->fd < 0) {
+    return;
+  }
+  close(port->fd);
+  port->fd = -1;
+}
+
+size_t host_uart_line_log(uart_port_t uart_num, host_uart_line_t *out, size_t max) {
+  host_uart_port_t *port = port_get(uart_num);
+  if (port == NULL) {
+    return 0;
+  }
+  pthread_mutex_lock(&port->lock);
+  uint64_t first = port->log_base;
+  if (port->log_total - first > HOST_UART_LINE_LOG_LEN) {
+    first = port->log_total - HOST_UART_LINE_LOG_LEN;
+  }
+  if (port->log_total - first > max) {
+    first = port->log_total - max;
+  }
+  size_t count = 0;
+  for (uint64_t i = first; i < port->log_total; i++) {
+    out[count++] = port->log[i % HOST_UART_LINE_LOG_LEN];
+  }
+  port->log_base = port->log_total;
+  pthread_mutex_unlock(&port->lock);
+  return count;
+}
+
+esp_err_t uart_driver_install(uart_port_t uart_num, int rx_buffer_size, int tx_buffer_size,
+                              int queue_size, QueueHandle_t *uart_queue, int intr_alloc_flags) {
+  (void)tx_buffer_size;
+  (void)intr_alloc_flags;
+  host_uart_port_t *port = port_get(uart_num);
+  if (port == NULL || rx_buffer_size <= 0) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  if (port->installed || port->fd < 0) {
+    return ESP_ERR_INVALID_STATE; // 未调用 host_uart_attach
+  }
+  port->rx_buf = malloc((size_t)rx_buffer_size);
+  if (port->rx_buf == NULL || pipe(port->wake_pipe) != 0) {
+    free(port->rx_buf);
+    port->rx_buf = NULL;
+    return ESP_ERR_NO_MEM;
+  }
+  fcntl(port->wake_pipe[0], F_SETFL, O_NONBLOCK);
+  port->rx_size = (size_t)rx_buffer_size;
+  port->rx_head = port->rx_count = port->rx_unreported = 0;
+  port->rx_burst_open = false;
+  port->rx_line_end = port->tx_end = port->tx_start = 0;
+  port->collision = false;
+  port->baud_rate = 115200;
+  port->parity = UART_PARITY_DISABLE;
+  port->mode = UART_MODE_UART;
+  port->rx_timeout_symbols = 10;
+  port->rx_full_threshold = HOST_UART_RX_FULL_THRESHOLD;
+  port_update_timing(port);
+  port->events = NULL;
+  if (queue_size > 0 && uart_queue != NULL) {
+    port->events = xQueueCreate((UBaseType_t)queue_size, sizeof(uart_event_t));
+    *uart_queue = port->events;
+  }
+  pthread_condattr_t attr;
+  pthread_condattr_init(&attr);
+  pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+  pthread_cond_init(&port->cond, &attr);
+  pthread_condattr_destroy(&attr);
+  port->stop = false;
+  port->installed = true;
+  signal(SIGPIPE, SIG_IGN);
+  pthread_create(&port->rx_thread, NULL, rx_thread, port);
+  pthread_create(&port->tx_thread, NULL, tx_thread, port);
+  return ESP_OK;
+}
+
+esp_err_t uart_driver_delete(uart_port_t uart_num) {
+  host_uart_port_t *port = port_installed(uart_num);
+  if (port == NULL) {
+    return ESP_ERR_INVALID_STATE;
+  }
+  pthread_mutex_lock(&port->lock);
+  port->stop = true;
+  pthread_cond_broadcast(&port->cond);
+  pthread_mutex_unlock(&port->lock);
+  (void)!write(port->wake_pipe[1], "x", 1);
+  pthread_join(port->rx_thread, NULL);
+  pthread_join(port->tx_thread, NULL);
+
+  while (port->tx_head != NULL) {
+    tx_chunk_t *next = port->tx_head->next;
+    free(port->tx_head);
+    port->tx_head = next;
+  }
+  port->tx_tail = NULL;
+  close(port->wake_pipe[0]);
+  close(port->wake_pipe[1]);
+  port->wake_pipe[0] = port->wake_pipe[1] = -1;
+  if (port->events != NULL) {
+    vQueueDelete(port->events);
+    port->events = NULL;
+  }
+  pthread_cond_destroy(&port->cond);
+  free(port->rx_buf);
+  port->rx_buf = NULL;
+  port->installed = false;
+  return ESP_OK;
+}
+
+bool uart_is_driver_installed(uart_port_t uart_num) { return port_installed(uart_num) != NULL; }
+
+esp_err_t uart_param_config(uart_port_t uart_num, const uart_config_t *config) {
+  host_uart_port_t *port = port_installed(uart_num);
+  if (port == NULL || config == NULL || config->baud_rate <= 0) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  pthread_mutex_lock(&port->lock);
+  port->baud_rate = config->baud_rate;
+  port->parity = config->parity;
+  port_update_timing(port);
+  pthread_mutex_unlock(&port->lock);
+  return ESP_OK;
+}
+
+esp_err_t uart_set_pin(uart_port_t uart_num, int tx_io, int rx_io, int rts_io, int cts_io) {
+  (void)tx_io;
+  (void)rx_io;
+  (void)rts_io;
+  (void)cts_io;
+  return port_get(uart_num) != NULL ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+esp_err_t uart_set_mode(uart_port_t uart_num, uart_mode_t mode) {
+  host_uart_port_t *port = port_installed(uart_num);
+  if (port == NULL) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  pthread_mutex_lock(&port->lock);
+  port->mode = mode;
+  pthread_mutex_unlock(&port->lock);
+  return ESP_OK;
+}
+
+esp_err_t uart_set_rx_timeout(uart_port_t uart_num, uint8_t tout_thresh) {
+  host_uart_port_t *port = port_installed(uart_num);
+  if (port == NULL || tout_thresh > 126) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  pthread_mutex_lock(&port->lock);
+  port->rx_timeout_symbols = tout_thresh;
+  pthread_mutex_unlock(&port->lock);
+  return ESP_OK;
+}
+
+esp_err_t uart_set_rx_full_threshold(uart_port_t uart_num, int threshold) {
+  host_uart_port_t *port = port_installed(uart_num);
+  if (port == NULL || threshold < 1 || threshold >= HOST_UART_FIFO_LEN) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  pthread_mutex_lock(&port->lock);
+  port->rx_full_threshold = (uint8_t)threshold;
+  pthread_mutex_unlock(&port->lock);
+  // 唤醒接收线程按新阈值重算：FIFO 中已够数的字节立即上报
+  (void)!write(port->wake_pipe[1], "x", 1);
+  return ESP_OK;
+}
+
+esp_err_t uart_set_baudrate(uart_port_t uart_num, uint32_t baud_rate) {
+  host_uart_port_t *port = port_installed(uart_num);
+  if (port == NULL || baud_rate == 0) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  pthread_mutex_lock(&port->lock);
+  port->baud_rate = (int)baud_rate;
+  port_update_timing(port);
+  pthread_mutex_unlock(&port->lock);
+  return ESP_OK;
+}
+
+esp_err_t uart_get_baudrate(uart_port_t uart_num, uint32_t *baud_rate) {
+  host_uart_port_t *port = port_installed(uart_num);
+  if (port == NULL || baud_rate == NULL) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  *baud_rate = (uint32_t)port->baud_rate;
+  return ESP_OK;
+}
+
+esp_err_t uart_set_parity(uart_port_t uart_num, uart_parity_t parity) {
+  host_uart_port_t *port = port_installed(uart_num);
+  if (port == NULL) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  pthread_mutex_lock(&port->lock);
+  port->parity = parity;
+  port_update_timing(port);
+  pthread_mutex_unlock(&port->lock);
+  return ESP_OK;
+}
+
+esp_err_t uart_get_collision_flag(uart_port_t uart_num, bool *collision_flag) {
+  host_uart_port_t *port = port_installed(uart_num);
+  if (port == NULL || collision_flag == NULL) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  pthread_mutex_lock(&port->lock);
+  *collision_flag = port->mode == UART_MODE_RS485_HALF_DUPLEX && port->collision;
+  pthread_mutex_unlock(&port->lock);
+  return ESP_OK;
+}
+
+int uart_write_bytes(uart_port_t uart_num, const void *src, size_t size) {
+  host_uart_port_t *port = port_installed(uart_num);
+  if (port == NULL || src == NULL) {
+    return -1;
+  }
+  if (size == 0) {
+    return 0;
+  }
+  tx_chunk_t *chunk = malloc(sizeof(*chunk) + size);
+  if (chunk == NULL) {
+    return -1;
+  }
+  memcpy(chunk->data, src, size);
+  chunk->length = size;
+  chunk->next = NULL;
+
+  pthread_mutex_lock(&port->lock);
+  int64_t now = esp_timer_get_time();
+  int64_t start = now > port->tx_end ? now : port->tx_end;
+  chunk->end_us = start + (int64_t)size * port->char_us;
+  // 与硬件一样，冲突标志在每次新的发送开始时清除
+  port->collision = port->rx_line_end > start;
+  port->tx_start = start;
+  port->tx_end = chunk->end_us;
+
+  host_uart_line_t *entry = log_append(port);
+  entry->start_us = start;
+  entry->end_us = chunk->end_us;
+  entry->length = (uint16_t)size;
+  entry->tx = true;
+  entry->de = port->mode == UART_MODE_RS485_HALF_DUPLEX;
+  entry->collision = port->collision;
+  if (port->collision && port->rx_burst_open) {
+    port->rx_burst_collision = true;
+  }
+  port->log_last_tx = port->log_total - 1;
+  port->log_has_tx = true;
+
+  if (port->tx_tail != NULL) {
+    port->tx_tail->next = chunk;
+  } else {
+    port->tx_head = chunk;
+  }
+  port->tx_tail = chunk;
+  pthread_cond_broadcast(&port->cond);
+  pthread_mutex_unlock(&port->lock);
+  return (int)size;
+}
+
+int uart_read_bytes(uart_port_t uart_num, void *buf, uint32_t length, TickType_t ticks_to_wait) {
+  host_uart_port_t *port = port_installed(uart_num);
+  if (port == NULL || buf == NULL) {
+    return -1;
+  }
+  int64_t deadline = ticks_to_wait == portMAX_DELAY
+                         ? INT64_MAX
+                         : esp_timer_get_time() + (int64_t)pdTICKS_TO_MS(ticks_to_wait) * 1000;
+  uint8_t *dst = buf;
+  size_t done = 0;
+  pthread_mutex_lock(&port->lock);
+  while (done < length) {
+    while (port->rx_count > 0 && done < length) {
+      dst[done++] = port->rx_buf[port->rx_head];
+      port->rx_head = (port->rx_head + 1) % port->rx_size;
+      port->rx_count--;
+    }
+    if (done == length || esp_timer_get_time() >= deadline) {
+      break;
+    }
+    if (deadline == INT64_MAX) {
+      pthread_cond_wait(&port->cond, &port->lock);
+    } else {
+      struct timespec ts = timespec_at(deadline);
+      pthread_cond_timedwait(&port->cond, &port->lock, &ts);
+    }
+  }
+  pthread_mutex_unlock(&port->lock);
+  return (int)done;
+}
+
+esp_err_t uart_wait_tx_done(uart_port_t uart_num, TickType_t ticks_to_wait) {
+  host_uart_port_t *port = port_installed(uart_num);
+  if (port == NULL) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  int64_t deadline = ticks_to_wait == portMAX_DELAY
+                         ? INT64_MAX
+                         : esp_timer_get_time() + (int64_t)pdTICKS_TO_MS(ticks_to_wait) * 1000;
+  esp_err_t ret = ESP_OK;
+  pthread_mutex_lock(&port->lock);
+  for (;;) {
+    int64_t now = esp_timer_get_time();
+    if (now >= port->tx_end) {
+      break;
+    }
+    if (now >= deadline) {
+      ret = ESP_ERR_TIMEOUT;
+      break;
+    }
+    // 按最后一个停止位的时刻返回，不等发送线程真正写完设备文件
+    struct timespec ts = timespec_at(port->tx_end < deadline ? port->tx_end : deadline);
+    pthread_cond_timedwait(&port->cond, &port->lock, &ts);
+  }
+  pthread_mutex_unlock(&port->lock);
+  return ret;
+}
+
+esp_err_t uart_flush_input(uart_port_t uart_num) {
+  host_uart_port_t *port = port_installed(uart_num);
+  if (port == NULL) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  pthread_mutex_lock(&port->lock);
+  // 与硬件一样同时清空 FIFO：这些字节不会再触发 RX 超时事件
+  port->rx_head = 0;
+  port->rx_count = 0;
+  port->rx_unreported = 0;
+  pthread_mutex_unlock(&port->lock);
+  return ESP_OK;
+}
+
+esp_err_t uart_get_buffered_data_len(uart_port_t uart_num, size_t *size) {
+  host_uart_port_t *port = port_installed(uart_num);
+  if (port == NULL || size == NULL) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  pthread_mutex_lock(&port->lock);
+  *size = port->rx_count;
+  pthread_mutex_unlock(&port->lock);
+  return ESP_OK;
+}
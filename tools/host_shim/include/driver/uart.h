@@ -0,0 +1,170 @@
+#ifndef HOST_DRIVER_UART_H
+#define HOST_DRIVER_UART_H
+
+/*
+ * UART 驱动主机替身：端口接到一个串口设备文件上（通常是伪终端从端，
+ * 如 tower_sim 的 -l 链接），按波特率模拟线路时序：
+ *
+ * - 发送：uart_write_bytes() 立即返回，数据在最后一个停止位移出的时刻
+ *   整块写入设备文件；uart_wait_tx_done() 等到该时刻。
+ * - 接收：对端写入的字节按字符时间占用线路，线路静默达到 RX 超时
+ *   阈值后投递带 timeout_flag 的 UART_DATA 事件；未上报字节达到 FIFO
+ *   满阈值（默认 120，uart_set_rx_full_threshold 可改）时先投递不带超时
+ *   标志的事件。
+ * - RS485 半双工模式下 DE 在发送开始时置位、最后一个停止位结束时释放；
+ *   DE 置位期间线路上出现对端字节记为冲突。
+ *
+ * 每次发送与每个接收突发都记入线路日志（host_uart_line_log），供时序
+ * 测试检查 DE 窗口、帧间隔与收发切换。
+ */
+
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef int uart_port_t;
+
+#define UART_NUM_0 0
+#define UART_NUM_1 1
+#define UART_NUM_2 2
+#define UART_NUM_MAX 3
+
+#define UART_PIN_NO_CHANGE (-1)
+
+typedef enum {
+  UART_DATA_5_BITS,
+  UART_DATA_6_BITS,
+  UART_DATA_7_BITS,
+  UART_DATA_8_BITS,
+  UART_DATA_BITS_MAX,
+} uart_word_length_t;
+
+typedef enum {
+  UART_PARITY_DISABLE = 0,
+  UART_PARITY_EVEN = 2,
+  UART_PARITY_ODD = 3,
+} uart_parity_t;
+
+typedef enum {
+  UART_STOP_BITS_1 = 1,
+  UART_STOP_BITS_1_5,
+  UART_STOP_BITS_2,
+  UART_STOP_BITS_MAX,
+} uart_stop_bits_t;
+
+typedef enum {
+  UART_HW_FLOWCTRL_DISABLE,
+  UART_HW_FLOWCTRL_RTS,
+  UART_HW_FLOWCTRL_CTS,
+  UART_HW_FLOWCTRL_CTS_RTS,
+  UART_HW_FLOWCTRL_MAX,
+} uart_hw_flowcontrol_t;
+
+typedef enum {
+  UART_SCLK_APB = 1,
+  UART_SCLK_DEFAULT = UART_SCLK_APB,
+} uart_sclk_t;
+
+typedef enum {
+  UART_MODE_UART,
+  UART_MODE_RS485_HALF_DUPLEX,
+  UART_MODE_IRDA,
+  UART_MODE_RS485_COLLISION_DETECT,
+  UART_MODE_RS485_APP_CTRL,
+} uart_mode_t;
+
+typedef struct {
+  int baud_rate;
+  uart_word_length_t data_bits;
+  uart_parity_t parity;
+  uart_stop_bits_t stop_bits;
+  uart_hw_flowcontrol_t flow_ctrl;
+  uint8_t rx_flow_ctrl_thresh;
+  uart_sclk_t source_clk;
+} uart_config_t;
+
+typedef enum {
+  UART_DATA,
+  UART_BREAK,
+  UART_BUFFER_FULL,
+  UART_FIFO_OVF,
+  UART_FRAME_ERR,
+  UART_PARITY_ERR,
+  UART_DATA_BREAK,
+  UART_PATTERN_DET,
+  UART_EVENT_MAX,
+} uart_event_type_t;
+
+typedef struct {
+  uart_event_type_t type;
+  size_t size;
+  bool timeout_flag;
+} uart_event_t;
+
+#define ESP_INTR_FLAG_IRAM (1 << 10)
+
+esp_err_t uart_driver_install(uart_port_t uart_num, int rx_buffer_size,
+                              int tx_buffer_size, int queue_size,
+                              QueueHandle_t *uart_queue, int intr_alloc_flags);
+esp_err_t uart_driver_delete(uart_port_t uart_num);
+bool uart_is_driver_installed(uart_port_t uart_num);
+esp_err_t uart_param_config(uart_port_t uart_num, const uart_config_t *config);
+esp_err_t uart_set_pin(uart_port_t uart_num, int tx_io, int rx_io, int rts_io,
+                       int cts_io);
+esp_err_t uart_set_mode(uart_port_t uart_num, uart_mode_t mode);
+esp_err_t uart_set_rx_timeout(uart_port_t uart_num, uint8_t tout_thresh);
+esp_err_t uart_set_rx_full_threshold(uart_port_t uart_num, int threshold);
+esp_err_t uart_set_baudrate(uart_port_t uart_num, uint32_t baud_rate);
+esp_err_t uart_get_baudrate(uart_port_t uart_num, uint32_t *baud_rate);
+esp_err_t uart_set_parity(uart_port_t uart_num, uart_parity_t parity);
+esp_err_t uart_get_collision_flag(uart_port_t uart_num, bool *collision_flag);
+int uart_write_bytes(uart_port_t uart_num, const void *src, size_t size);
+int uart_read_bytes(uart_port_t uart_num, void *buf, uint32_t length,
+                    TickType_t ticks_to_wait);
+esp_err_t uart_wait_tx_done(uart_port_t uart_num, TickType_t ticks_to_wait);
+esp_err_t uart_flush_input(uart_port_t uart_num);
+esp_err_t uart_get_buffered_data_len(uart_port_t uart_num, size_t *size);
+
+// 以下为主机专用扩展
+
+/**
+ * @brief 把端口接到串口设备文件上（设为原始模式），须在 uart_driver_install 之前调用
+ * @return ESP_OK，打不开返回 ESP_FAIL
+ */
+esp_err_t host_uart_attach(uart_port_t uart_num, const char *path);
+
+/**
+ * @brief 断开端口并关闭设备文件（驱动须已删除）
+ */
+void host_uart_detach(uart_port_t uart_num);
+
+// 线路日志条目：一次发送或一个接收突发
+typedef struct {
+  int64_t start_us; // 第一个起始位
+  int64_t end_us;   // 最后一个停止位结束
+  uint16_t length;
+  bool tx;
+  bool de;        // 发送期间 DE 由硬件置位（RS485 半双工模式）
+  bool collision; // 发送与接收在线路上重叠
+} host_uart_line_t;
+
+#define HOST_UART_LINE_LOG_LEN 4096
+
+/**
+ * @brief 取出线路日志（按时间顺序）并清空
+ * @return 取出的条目数，超出 max 的最早条目被丢弃
+ */
+size_t host_uart_line_log(uart_port_t uart_num, host_uart_line_t *out, size_t max);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HOST_DRIVER_UART_H
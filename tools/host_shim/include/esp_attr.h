@@ -0,0 +1,9 @@
+#ifndef HOST_ESP_ATTR_H
+#define HOST_ESP_ATTR_H
+
+#define IRAM_ATTR
+#define DRAM_ATTR
+#define EXT_RAM_BSS_ATTR
+#define FORCE_INLINE_ATTR static inline __attribute__((always_inline))
+
+#endif // HOST_ESP_ATTR_H
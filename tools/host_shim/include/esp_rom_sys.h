@@ -0,0 +1,17 @@
+#ifndef HOST_ESP_ROM_SYS_H
+#define HOST_ESP_ROM_SYS_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// 至少延时 us 微秒；末段忙等保证精度，之前睡眠让出 CPU
+void esp_rom_delay_us(uint32_t us);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HOST_ESP_ROM_SYS_H
@@ -0,0 +1,38 @@
+/*
+ * 主机测试公用的检查宏与结果汇总
+ *
+ * 只由测试程序的主文件包含：失败计数是该文件内的静态变量。
+ */
+#ifndef HOST_TEST_H
+#define HOST_TEST_H
+
+#include <stdio.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+static int s_failures;
+
+// 条件不成立时打印位置与说明并计一次失败，测试继续执行
+#define CHECK(cond, ...)                                                       \
+  do {                                                                         \
+    if (!(cond)) {                                                             \
+      printf("FAIL %s:%d: ", __FILE__, __LINE__);                              \
+      printf(__VA_ARGS__);                                                     \
+      printf("\n");                                                            \
+      s_failures++;                                                            \
+    }                                                                          \
+  } while (0)
+
+// 打印汇总行，返回进程退出码：有失败为 1
+static inline int host_test_summary(void) {
+  printf("%s: %d failure(s)\n", s_failures ? "FAIL" : "PASS", s_failures);
+  return s_failures ? 1 : 0;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HOST_TEST_H
@@ -0,0 +1,7 @@
+#ifndef HOST_SDKCONFIG_H
+#define HOST_SDKCONFIG_H
+
+// 主机构建使用的配置子集，取值与仓库根目录 sdkconfig 一致
+#define CONFIG_FREERTOS_HZ 1000
+
+#endif // HOST_SDKCONFIG_H
@@ -0,0 +1,335 @@
+/*
+ * 总线优先级通道离线基准
+ *
+ * 用固件同一份通道仲裁代码（main/rs485_lanes.c）对一条 RS485 总线做
+ * 离散事件仿真：若干轮询任务让轮询通道始终饱和（长读、偶发超时），
+ * 操作员命令与报警命令按泊松过程到达。报告各通道的等待分布，并与
+ * 不分通道的先来先得做对比。
+ *
+ * 报警通道的理论上界：到达时正在进行的那次事务的剩余时间，加上已在
+ * 报警通道排队者的持有时间。每个报警都按此上界检查，任何一次超出
+ * 即退出码 1，可直接用作回归测试。
+ *
+ * 编译（在 tools 目录）：
+ *   make lane_bench
+ *
+ * make check 用 -d 60 跑一分钟仿真（约 30 次报警），几毫秒即完成。
+ *
+ * 用法：
+ *   lane_bench [-b 波特率] [-p 轮询任务数] [-c 命令间隔ms] [-a 报警间隔ms]
+ *              [-T 超时概率] [-d 仿真秒数] [-s 随机种子]
+ */
+#include "rs485_lanes.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define BENCH_QUEUE_MAX 64
+#define BENCH_TURNAROUND_US 2000 // 从站应答延迟
+#define BENCH_TIMEOUT_US 100000  // 主站应答超时，同 MODBUS_DEFAULT_TIMEOUT_MS
+
+typedef struct {
+  int baud;
+  int poll_tasks;
+  double command_ms; // 平均到达间隔
+  double alarm_ms;
+  double timeout_rate;
+  double seconds;
+  uint64_t seed;
+} bench_config_t;
+
+typedef struct {
+  int64_t arrival_us;
+  int64_t bound_us; // 仅报警：到达时算出的等待上界
+} bench_waiter_t;
+
+typedef struct {
+  bench_waiter_t items[BENCH_QUEUE_MAX];
+  size_t head;
+  size_t count;
+} bench_queue_t;
+
+typedef struct {
+  uint32_t samples;
+  uint32_t max_us;
+  uint64_t sum_us;
+  uint32_t hist[8]; // <1 <5 <10 <50 <100 <500 <1000 >=1000 ms
+} bench_lane_report_t;
+
+typedef struct {
+  bench_lane_report_t lanes[RS485_LANE_COUNT];
+  uint32_t bound_violations;
+  int64_t worst_bound_us;
+  uint64_t busy_us[RS485_LANE_COUNT];
+  int64_t elapsed_us;
+  rs485_lane_stats_t stats[RS485_LANE_COUNT];
+} bench_report_t;
+
+static uint64_t s_rng;
+
+static double rand_unit(void) {
+  s_rng ^= s_rng << 13;
+  s_rng ^= s_rng >> 7;
+  s_rng ^= s_rng << 17;
+  return (double)(s_rng >> 11) / (double)(1ULL << 53);
+}
+
+static int64_t rand_exp_us(double mean_ms) {
+  return (int64_t)(-log(1.0 - rand_unit()) * mean_ms * 1000.0) + 1;
+}
+
+static void queue_push(bench_queue_t *q, bench_waiter_t w) {
+  if (q->count < BENCH_QUEUE_MAX) {
+    q->items[(q->head + q->count++) % BENCH_QUEUE_MAX] = w;
+  }
+}
+
+static bench_waiter_t queue_pop(bench_queue_t *q) {
+  bench_waiter_t w = q->items[q->head];
+  q->head = (q->head + 1) % BENCH_QUEUE_MAX;
+  q->count--;
+  return w;
+}
+
+// 一次事务占用总线的时间：请求 + 应答延迟 + 应答 + t3.5
+static int64_t hold_us(const bench_config_t *cfg, rs485_lane_t lane) {
+  double char_us = 10e6 / cfg->baud;
+  double gap_us = cfg->baud > 19200 ? 1750 : char_us * 3.5;
+  if (lane != RS485_LANE_POLL) {
+    // FC06 写灯光寄存器，塔灯回显：各 10 字节
+    return (int64_t)(20 * char_us + BENCH_TURNAROUND_US + gap_us);
+  }
+  if (rand_unit() < cfg->timeout_rate) {
+    return (int64_t)(8 * char_us + BENCH_TIMEOUT_US);
+  }
+  int regs = 1 + (int)(rand_unit() * 125);
+  return (int64_t)((8 + 5 + 2 * regs) * char_us + BENCH_TURNAROUND_US + gap_us);
+}
+
+static void report_add(bench_lane_report_t *r, int64_t wait_us) {
+  static const uint32_t edges_ms[] = {1, 5, 10, 50, 100, 500, 1000};
+  uint32_t us = (uint32_t)wait_us;
+  size_t bucket = 0;
+  while (bucket < 7 && us >= edges_ms[bucket] * 1000) {
+    bucket++;
+  }
+  r->hist[bucket]++;
+  r->samples++;
+  r->sum_us += us;
+  if (us > r->max_us) {
+    r->max_us = us;
+  }
+}
+
+// 仿真状态
+typedef struct {
+  const bench_config_t *cfg;
+  bool strict; // false 时所有请求进同一队列（先来先得）
+  rs485_lanes_t lanes;
+  bench_queue_t queues[RS485_LANE_COUNT];
+  bench_queue_t fifo;
+  uint8_t fifo_lane[BENCH_QUEUE_MAX];
+  int64_t now;
+  bool busy;
+  rs485_lane_t owner;
+  int64_t grant_us;
+  int64_t free_us;
+  int64_t alarm_hold_us;
+  bench_report_t *rep;
+} bench_sim_t;
+
+static void sim_start(bench_sim_t *sim, rs485_lane_t lane, int64_t arrival_us) {
+  sim->owner = lane;
+  sim->grant_us = sim->now;
+  sim->free_us = sim->now + hold_us(sim->cfg, lane);
+  sim->busy = true;
+  report_add(&sim->rep->lanes[lane], sim->now - arrival_us);
+}
+
+// 申请总线：空闲立即开始，否则排队
+static void sim_request(bench_sim_t *sim, rs485_lane_t lane) {
+  bench_waiter_t w = {.arrival_us = sim->now, .bound_us = 0};
+  if (lane == RS485_LANE_ALARM) {
+    // 上界 = 当前事务剩余时间 + 前面排队的报警
+    w.bound_us = (sim->busy ? sim->free_us - sim->now : 0) +
+                 (int64_t)sim->queues[RS485_LANE_ALARM].count * sim->alarm_hold_us;
+  }
+  if (sim->strict) {
+    if (rs485_lanes_acquire(&sim->lanes, lane)) {
+      rs485_lanes_record_wait(&sim->lanes, lane, 0);
+      sim_start(sim, lane, sim->now);
+    } else {
+      queue_push(&sim->queues[lane], w);
+    }
+  } else if (!sim->busy) {
+    sim_start(sim, lane, sim->now);
+  } else {
+    sim->fifo_lane[(sim->fifo.head + sim->fifo.count) % BENCH_QUEUE_MAX] = (uint8_t)lane;
+    queue_push(&sim->fifo, w);
+  }
+}
+
+static void sim_check_alarm(bench_sim_t *sim, const bench_waiter_t *w) {
+  if (w->bound_us > sim->rep->worst_bound_us) {
+    sim->rep->worst_bound_us = w->bound_us;
+  }
+  if (sim->now - w->arrival_us > w->bound_us) {
+    sim->rep->bound_violations++;
+  }
+}
+
+// 当前事务结束：把总线交给下一个等待者
+static void sim_release(bench_sim_t *sim) {
+  sim->now = sim->free_us;
+  uint32_t held = (uint32_t)(sim->free_us - sim->grant_us);
+  sim->rep->busy_us[sim->owner] += held;
+  sim->busy = false;
+  if (sim->strict) {
+    int next = rs485_lanes_release(&sim->lanes, held);
+    if (next >= 0) {
+      bench_waiter_t w = queue_pop(&sim->queues[next]);
+      rs485_lanes_record_wait(&sim->lanes, (rs485_lane_t)next, (uint32_t)(sim->now - w.arrival_us));
+      if (next == RS485_LANE_ALARM) {
+        sim_check_alarm(sim, &w);
+      }
+      sim_start(sim, (rs485_lane_t)next, w.arrival_us);
+    }
+  } else if (sim->fifo.count > 0) {
+    rs485_lane_t next = (rs485_lane_t)sim->fifo_lane[sim->fifo.head];
+    bench_waiter_t w = queue_pop(&sim->fifo);
+    if (next == RS485_LANE_ALARM) {
+      sim_check_alarm(sim, &w);
+    }
+    sim_start(sim, next, w.arrival_us);
+  }
+}
+
+static void simulate(const bench_config_t *cfg, bool strict, bench_report_t *rep) {
+  static bench_sim_t sim;
+  memset(&sim, 0, sizeof(sim));
+  memset(rep, 0, sizeof(*rep));
+  sim.cfg = cfg;
+  sim.strict = strict;
+  sim.rep = rep;
+  rs485_lanes_init(&sim.lanes);
+  s_rng = cfg->seed ? cfg->seed : 1;
+  sim.alarm_hold_us = hold_us(cfg, RS485_LANE_ALARM);
+
+  const int64_t end_us = (int64_t)(cfg->seconds * 1e6);
+  int64_t next_command = rand_exp_us(cfg->command_ms);
+  int64_t next_alarm = rand_exp_us(cfg->alarm_ms);
+  for (int i = 0; i < cfg->poll_tasks; i++) {
+    sim_request(&sim, RS485_LANE_POLL);
+  }
+
+  while (sim.now < end_us) {
+    if (sim.busy && sim.free_us <= next_command && sim.free_us <= next_alarm) {
+      rs485_lane_t done = sim.owner;
+      sim_release(&sim);
+      // 轮询任务做完一次立即发下一次：轮询通道始终饱和
+      if (done == RS485_LANE_POLL) {
+        sim_request(&sim, RS485_LANE_POLL);
+      }
+    } else if (next_command <= next_alarm) {
+      sim.now = next_command;
+      next_command += rand_exp_us(cfg->command_ms);
+      sim_request(&sim, RS485_LANE_COMMAND);
+    } else {
+      sim.now = next_alarm;
+      next_alarm += rand_exp_us(cfg->alarm_ms);
+      sim_request(&sim, RS485_LANE_ALARM);
+    }
+  }
+  rep->elapsed_us = sim.now;
+  memcpy(rep->stats, sim.lanes.stats, sizeof(rep->stats));
+}
+
+static void print_report(const char *title, const bench_report_t *rep) {
+  static const char *names[RS485_LANE_COUNT] = {"alarm", "command", "poll"};
+  printf("%s\n", title);
+  printf("  lane      grants   avg ms   max ms  bus %%   <1 <5 <10 <50 <100 <500 <1s >=1s (ms)\n");
+  for (int lane = 0; lane < RS485_LANE_COUNT; lane++) {
+    const bench_lane_report_t *r = &rep->lanes[lane];
+    printf("  %-8s %7u %8.2f %8.2f %5.1f  ", names[lane], r->samples,
+           r->samples ? r->sum_us / 1000.0 / r->samples : 0.0, r->max_us / 1000.0,
+           100.0 * rep->busy_us[lane] / (rep->elapsed_us ? rep->elapsed_us : 1));
+    for (int b = 0; b < 8; b++) {
+      printf(" %u", r->hist[b]);
+    }
+    printf("\n");
+  }
+}
+
+int main(int argc, char **argv) {
+  bench_config_t cfg = {
+      .baud = 9600,
+      .poll_tasks = 3,
+      .command_ms = 500,
+      .alarm_ms = 2000,
+      .timeout_rate = 0.05,
+      .seconds = 3600,
+      .seed = 1,
+  };
+  int opt;
+  while ((opt = getopt(argc, argv, "b:p:c:a:T:d:s:")) != -1) {
+    switch (opt) {
+    case 'b':
+      cfg.baud = atoi(optarg);
+      break;
+    case 'p':
+      cfg.poll_tasks = atoi(optarg);
+      break;
+    case 'c':
+      cfg.command_ms = atof(optarg);
+      break;
+    case 'a':
+      cfg.alarm_ms = atof(optarg);
+      break;
+    case 'T':
+      cfg.timeout_rate = atof(optarg);
+      break;
+    case 'd':
+      cfg.seconds = atof(optarg);
+      break;
+    case 's':
+      cfg.seed = strtoull(optarg, NULL, 0);
+      break;
+    default:
+      fprintf(stderr,
+              "usage: %s [-b baud] [-p poll_tasks] [-c command_ms] [-a alarm_ms] "
+              "[-T timeout_rate] [-d seconds] [-s seed]\n",
+              argv[0]);
+      return 2;
+    }
+  }
+  if (cfg.baud <= 0 || cfg.poll_tasks < 1 || cfg.poll_tasks > BENCH_QUEUE_MAX / 2) {
+    fprintf(stderr, "invalid arguments\n");
+    return 2;
+  }
+
+  printf("%d baud, %d saturating poll tasks, command every %.0f ms, alarm every %.0f ms, "
+         "%.0f s simulated\n\n",
+         cfg.baud, cfg.poll_tasks, cfg.command_ms, cfg.alarm_ms, cfg.seconds);
+
+  bench_report_t fifo;
+  bench_report_t lanes;
+  simulate(&cfg, false, &fifo);
+  simulate(&cfg, true, &lanes);
+  print_report("first come, first served:", &fifo);
+  printf("\n");
+  print_report("strict priority lanes:", &lanes);
+
+  // 报警上界：另一次事务的最长持有时间
+  uint32_t longest_hold = 0;
+  for (int lane = 0; lane < RS485_LANE_COUNT; lane++) {
+    if (lanes.stats[lane].max_hold_us > longest_hold) {
+      longest_hold = lanes.stats[lane].max_hold_us;
+    }
+  }
+  printf("\nalarm wait: max %.2f ms, longest single transaction %.2f ms, worst per-alarm bound %.2f ms\n",
+         lanes.lanes[RS485_LANE_ALARM].max_us / 1000.0, longest_hold / 1000.0, lanes.worst_bound_us / 1000.0);
+  printf("bound violations: %u (first come, first served: %u)\n", lanes.bound_violations, fifo.bound_violations);
+  return lanes.bound_violations ? 1 : 0;
+}
@@ -0,0 +1,398 @@
+/*
+ * PLC 从站口主机测试（Linux）
+ *
+ * 把固件的从站与总线代码（main/modbus_slave.c、main/rs485_comm.c）编译到
+ * 主机替身上，UART 接伪终端；测试在伪终端主端扮演 PLC 主站，按与
+ * main.cpp 相同的寄存器映射与取值检查发请求，检查应答：
+ *
+ *   - FC06/FC10 写命令寄存器：合法灯光命令回显并触发写回调；
+ *   - 不在命令表中的值（含高字节非 0）回异常 03，寄存器与回调都不变；
+ *   - 写只读镜像回异常 02；FC03 读回寄存器映射；
+ *   - FC05/FC0F 写线圈：置位触发对应灯光命令，复位当前激活的线圈即关灯，
+ *     同一帧中置位的线圈决定最终命令；非法值回异常 03，越界回异常 02；
+ *     FC01 读回只有激活命令对应的线圈置位；
+ *   - 应答时间从请求最后一个字节算到应答开始发送，不少于 t3.5；
+ *   - 快速路径：请求后跟多余字节时，收满预期长度即发布（不等后面的字节
+ *     与 t3.5），发布的帧只含预期长度。
+ *
+ * 编译（在 tools 目录）：
+ *   make plc_slave_test
+ *
+ * 任何一项检查不通过退出码为 1。
+ */
+#include "modbus_slave.h"
+#include "host_test.h"
+#include "rs485_comm.h"
+#include "rs485_crc.h"
+#include "rs485_frames.h"
+#include "driver/uart.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include <fcntl.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <unistd.h>
+
+#define TEST_UART UART_NUM_1
+#define TEST_BAUD 19200
+#define TEST_SLAVE_ADDR 0x10
+
+// 与 main.cpp 的 PLC 寄存器映射一致
+#define PLC_REG_LIGHT_ACTUAL 0
+#define PLC_REG_LIGHT_CONFIRMED 1
+#define PLC_REG_LIGHT_COMMAND 2
+#define PLC_REG_COUNT 3
+
+// 与 main.cpp 的 s_plc_coil_cmds 一致
+static const rs485_cmd_t s_coil_cmds[] = {
+    RS485_CMD_RED_ON,          RS485_CMD_YELLOW_ON,         RS485_CMD_GREEN_ON,
+    RS485_CMD_RED_SLOW_FLASH,  RS485_CMD_YELLOW_SLOW_FLASH, RS485_CMD_GREEN_SLOW_FLASH,
+    RS485_CMD_RED_BURST_FLASH, RS485_CMD_YELLOW_BURST_FLASH, RS485_CMD_GREEN_BURST_FLASH,
+};
+#define PLC_COIL_COUNT (sizeof(s_coil_cmds) / sizeof(s_coil_cmds[0]))
+
+static modbus_slave_t *s_slave;
+static uint32_t s_writes;
+static uint16_t s_last_write;
+static uint32_t s_commands;
+static uint16_t s_last_coil;
+static rs485_cmd_t s_last_cmd;
+static size_t s_frame_len;      // 最近一次发布的帧长
+static int64_t s_frame_at_us;   // 最近一次发布的时刻
+
+// 与 main.cpp 的 on_plc_validate 相同
+static bool plc_validate(uint16_t address, uint16_t value, void *user_ctx) {
+  (void)user_ctx;
+  if (address != PLC_REG_LIGHT_COMMAND) {
+    return true;
+  }
+  return value <= 0xFF && rs485_frames_command(RS485_DEVICE_ADDR, (rs485_cmd_t)value) != NULL;
+}
+
+static void plc_write(uint16_t address, uint16_t quantity, void *user_ctx) {
+  (void)user_ctx;
+  if (address <= PLC_REG_LIGHT_COMMAND && address + quantity > PLC_REG_LIGHT_COMMAND) {
+    modbus_slave_get_register(s_slave, PLC_REG_LIGHT_COMMAND, &s_last_write);
+    __atomic_add_fetch(&s_writes, 1, __ATOMIC_RELEASE);
+  }
+}
+
+static void plc_command(uint16_t coil, rs485_cmd_t cmd, void *user_ctx) {
+  (void)user_ctx;
+  s_last_coil = coil;
+  s_last_cmd = cmd;
+  __atomic_add_fetch(&s_commands, 1, __ATOMIC_RELEASE);
+}
+
+static void on_frame(const uint8_t *frame, size_t length, void *user_ctx) {
+  (void)frame;
+  (void)user_ctx;
+  s_frame_len = length;
+  __atomic_store_n(&s_frame_at_us, esp_timer_get_time(), __ATOMIC_RELEASE);
+}
+
+static int open_pty(char *slave, size_t slave_size) {
+  int fd = posix_openpt(O_RDWR | O_NOCTTY);
+  if (fd < 0 || grantpt(fd) != 0 || unlockpt(fd) != 0 ||
+      ptsname_r(fd, slave, slave_size) != 0) {
+    perror("posix_openpt");
+    return -1;
+  }
+  struct termios tio;
+  tcgetattr(fd, &tio);
+  cfmakeraw(&tio);
+  tcsetattr(fd, TCSANOW, &tio);
+  return fd;
+}
+
+static size_t frame_finish(uint8_t *frame, size_t len) {
+  uint16_t crc = rs485_crc16_update(RS485_CRC16_INIT, frame, len);
+  frame[len++] = (uint8_t)(crc & 0xFF);
+  frame[len++] = (uint8_t)(crc >> 8);
+  return len;
+}
+
+// 发一帧请求并收应答：收到第一个字节后静默 20ms 即认为应答结束
+static size_t plc_transact(int fd, const uint8_t *request, size_t len, uint8_t *response,
+                           size_t max) {
+  tcflush(fd, TCIFLUSH);
+  if (write(fd, request, len) != (ssize_t)len) {
+    return 0;
+  }
+  size_t got = 0;
+  int timeout_ms = 500;
+  while (got < max) {
+    struct pollfd pfd = {.fd = fd, .events = POLLIN};
+    if (poll(&pfd, 1, timeout_ms) <= 0) {
+      break;
+    }
+    ssize_t n = read(fd, &response[got], max - got);
+    if (n <= 0) {
+      break;
+    }
+    got += (size_t)n;
+    timeout_ms = 20;
+  }
+  return got;
+}
+
+static size_t write_single(int fd, uint16_t address, uint16_t value, uint8_t *response) {
+  uint8_t request[8] = {TEST_SLAVE_ADDR, MODBUS_FC_WRITE_SINGLE_REGISTER, (uint8_t)(address >> 8),
+                        (uint8_t)address, (uint8_t)(value >> 8), (uint8_t)value};
+  return plc_transact(fd, request, frame_finish(request, 6), response, 64);
+}
+
+static size_t write_multiple(int fd, uint16_t address, const uint16_t *values, uint16_t qty,
+                             uint8_t *response) {
+  uint8_t request[64] = {TEST_SLAVE_ADDR, MODBUS_FC_WRITE_MULTIPLE_REGISTERS,
+                         (uint8_t)(address >> 8), (uint8_t)address, (uint8_t)(qty >> 8),
+                         (uint8_t)qty, (uint8_t)(qty * 2)};
+  for (uint16_t i = 0; i < qty; i++) {
+    request[7 + i * 2] = (uint8_t)(values[i] >> 8);
+    request[8 + i * 2] = (uint8_t)values[i];
+  }
+  return plc_transact(fd, request, frame_finish(request, 7 + qty * 2), response, 64);
+}
+
+static size_t write_coil(int fd, uint16_t coil, uint16_t value, uint8_t *response) {
+  uint8_t request[8] = {TEST_SLAVE_ADDR, MODBUS_FC_WRITE_SINGLE_COIL, (uint8_t)(coil >> 8), (uint8_t)coil,
+                        (uint8_t)(value >> 8), (uint8_t)value};
+  return plc_transact(fd, request, frame_finish(request, 6), response, 64);
+}
+
+// bits 的第 i 位为线圈 address + i
+static size_t write_coils(int fd, uint16_t address, uint16_t qty, uint16_t bits, uint8_t *response) {
+  uint8_t request[16] = {TEST_SLAVE_ADDR, MODBUS_FC_WRITE_MULTIPLE_COILS, (uint8_t)(address >> 8),
+                         (uint8_t)address, (uint8_t)(qty >> 8), (uint8_t)qty, (uint8_t)((qty + 7) / 8),
+                         (uint8_t)bits, (uint8_t)(bits >> 8)};
+  return plc_transact(fd, request, frame_finish(request, 7 + (qty + 7) / 8), response, 64);
+}
+
+// 读回全部线圈，返回位图；应答不对时返回 -1
+static int read_coils(int fd) {
+  uint8_t request[8] = {TEST_SLAVE_ADDR, MODBUS_FC_READ_COILS, 0, 0, 0, PLC_COIL_COUNT};
+  uint8_t response[64];
+  size_t len = plc_transact(fd, request, frame_finish(request, 6), response, sizeof(response));
+  if (len != 7 || response[1] != MODBUS_FC_READ_COILS || response[2] != 2 ||
+      rs485_crc16_update(RS485_CRC16_INIT, response, len) != 0) {
+    return -1;
+  }
+  return response[3] | (response[4] << 8);
+}
+
+static bool is_exception(const uint8_t *response, size_t len, uint8_t function, uint8_t code) {
+  return len == 5 && response[0] == TEST_SLAVE_ADDR && response[1] == (function | 0x80) &&
+         response[2] == code && rs485_crc16_update(RS485_CRC16_INIT, response, len) == 0;
+}
+
+static uint16_t command_register(modbus_slave_t *slave) {
+  uint16_t value = 0;
+  modbus_slave_get_register(slave, PLC_REG_LIGHT_COMMAND, &value);
+  return value;
+}
+
+// 等待应答发出后分发的写回调
+static uint32_t writes_after(uint32_t before) {
+  for (int i = 0; i < 50 && __atomic_load_n(&s_writes, __ATOMIC_ACQUIRE) == before; i++) {
+    vTaskDelay(pdMS_TO_TICKS(2));
+  }
+  return __atomic_load_n(&s_writes, __ATOMIC_ACQUIRE);
+}
+
+static void test_fc06(int fd, modbus_slave_t *slave) {
+  uint8_t response[64];
+  uint32_t writes = s_writes;
+  size_t len = write_single(fd, PLC_REG_LIGHT_COMMAND, RS485_CMD_RED_ON, response);
+  CHECK(len == 8 && response[1] == MODBUS_FC_WRITE_SINGLE_REGISTER && response[5] == RS485_CMD_RED_ON,
+        "FC06 valid command: %zu byte response", len);
+  CHECK(writes_after(writes) == writes + 1 && s_last_write == RS485_CMD_RED_ON,
+        "FC06 valid command: write callback");
+
+  static const uint16_t rejected[] = {0x0000, 0x0014, 0x0099, 0x0111, 0xFF60};
+  for (size_t i = 0; i < sizeof(rejected) / sizeof(rejected[0]); i++) {
+    writes = s_writes;
+    len = write_single(fd, PLC_REG_LIGHT_COMMAND, rejected[i], response);
+    CHECK(is_exception(response, len, MODBUS_FC_WRITE_SINGLE_REGISTER, MODBUS_EX_ILLEGAL_DATA_VALUE),
+          "FC06 0x%04X: expected exception 03, got %zu bytes", rejected[i], len);
+    CHECK(command_register(slave) == RS485_CMD_RED_ON, "FC06 0x%04X changed the register to 0x%04X",
+          rejected[i], command_register(slave));
+    CHECK(writes_after(writes) == writes, "FC06 0x%04X: write callback called", rejected[i]);
+  }
+
+  len = write_single(fd, PLC_REG_LIGHT_ACTUAL, RS485_CMD_GREEN_ON, response);
+  CHECK(is_exception(response, len, MODBUS_FC_WRITE_SINGLE_REGISTER, MODBUS_EX_ILLEGAL_DATA_ADDRESS),
+        "FC06 to the read-only mirror: expected exception 02, got %zu bytes", len);
+}
+
+static void test_fc10(int fd, modbus_slave_t *slave) {
+  uint8_t response[64];
+  uint32_t writes = s_writes;
+  uint16_t off = RS485_CMD_LIGHT_OFF;
+  size_t len = write_multiple(fd, PLC_REG_LIGHT_COMMAND, &off, 1, response);
+  CHECK(len == 8 && response[1] == MODBUS_FC_WRITE_MULTIPLE_REGISTERS, "FC10 valid command: %zu bytes",
+        len);
+  CHECK(writes_after(writes) == writes + 1 && s_last_write == RS485_CMD_LIGHT_OFF,
+        "FC10 valid command: write callback");
+
+  uint16_t bad = 0x0042;
+  writes = s_writes;
+  len = write_multiple(fd, PLC_REG_LIGHT_COMMAND, &bad, 1, response);
+  CHECK(is_exception(response, len, MODBUS_FC_WRITE_MULTIPLE_REGISTERS, MODBUS_EX_ILLEGAL_DATA_VALUE),
+        "FC10 0x0042: expected exception 03, got %zu bytes", len);
+  CHECK(command_register(slave) == RS485_CMD_LIGHT_OFF && writes_after(writes) == writes,
+        "FC10 0x0042 was applied");
+}
+
+static void test_fc03(int fd) {
+  uint8_t request[8] = {TEST_SLAVE_ADDR, MODBUS_FC_READ_HOLDING_REGISTERS, 0, 0, 0, PLC_REG_COUNT};
+  uint8_t response[64];
+  size_t len = plc_transact(fd, request, frame_finish(request, 6), response, sizeof(response));
+  CHECK(len == 5 + PLC_REG_COUNT * 2 && rs485_crc16_update(RS485_CRC16_INIT, response, len) == 0 &&
+            response[2] == PLC_REG_COUNT * 2 && response[8] == RS485_CMD_LIGHT_OFF &&
+            response[4] == RS485_CMD_GREEN_ON && response[6] == 1,
+        "FC03 register map: %zu bytes", len);
+}
+
+// 等待应答发出后分发的命令回调
+static uint32_t commands_after(uint32_t before) {
+  for (int i = 0; i < 50 && __atomic_load_n(&s_commands, __ATOMIC_ACQUIRE) == before; i++) {
+    vTaskDelay(pdMS_TO_TICKS(2));
+  }
+  return __atomic_load_n(&s_commands, __ATOMIC_ACQUIRE);
+}
+
+static void test_coils(int fd) {
+  uint8_t response[64];
+  uint32_t commands = s_commands;
+  uint8_t request[8] = {TEST_SLAVE_ADDR, MODBUS_FC_WRITE_SINGLE_COIL, 0, 1, 0xFF, 0x00};
+  size_t len = write_coil(fd, 1, 0xFF00, response);
+  CHECK(len == 8 && memcmp(response, request, 6) == 0, "FC05 coil 1 on: %zu byte response", len);
+  CHECK(commands_after(commands) == commands + 1 && s_last_coil == 1 && s_last_cmd == RS485_CMD_YELLOW_ON,
+        "FC05 coil 1 on: command callback coil %u cmd 0x%02X", s_last_coil, s_last_cmd);
+  int bits = read_coils(fd);
+  CHECK(bits == 0x002, "FC01 after coil 1 on: 0x%03X", bits);
+
+  // 复位未激活的线圈不改变命令
+  commands = s_commands;
+  len = write_coil(fd, 0, 0x0000, response);
+  CHECK(len == 8 && commands_after(commands) == commands, "FC05 inactive coil 0 off: command callback called");
+
+  len = write_coil(fd, 1, 0x0000, response);
+  CHECK(len == 8 && commands_after(commands) == commands + 1 && s_last_cmd == RS485_CMD_LIGHT_OFF,
+        "FC05 active coil 1 off: cmd 0x%02X", s_last_cmd);
+  bits = read_coils(fd);
+  CHECK(bits == 0, "FC01 after coil 1 off: 0x%03X", bits);
+
+  commands = s_commands;
+  len = write_coil(fd, 2, 0x1234, response);
+  CHECK(is_exception(response, len, MODBUS_FC_WRITE_SINGLE_COIL, MODBUS_EX_ILLEGAL_DATA_VALUE),
+        "FC05 value 0x1234: expected exception 03, got %zu bytes", len);
+  len = write_coil(fd, PLC_COIL_COUNT, 0xFF00, response);
+  CHECK(is_exception(response, len, MODBUS_FC_WRITE_SINGLE_COIL, MODBUS_EX_ILLEGAL_DATA_ADDRESS),
+        "FC05 coil %u: expected exception 02, got %zu bytes", (unsigned)PLC_COIL_COUNT, len);
+  CHECK(commands_after(commands) == commands, "FC05 rejected writes: command callback called");
+
+  // 线圈 0 与 5 同帧置位：按线圈顺序后置位的 5 生效
+  len = write_coils(fd, 0, PLC_COIL_COUNT, 0x021, response);
+  CHECK(len == 8 && response[1] == MODBUS_FC_WRITE_MULTIPLE_COILS && response[5] == PLC_COIL_COUNT,
+        "FC0F coils 0 and 5 on: %zu byte response", len);
+  CHECK(commands_after(commands) == commands + 1 && s_last_coil == 5 &&
+            s_last_cmd == RS485_CMD_GREEN_SLOW_FLASH,
+        "FC0F: command callback coil %u cmd 0x%02X", s_last_coil, s_last_cmd);
+  bits = read_coils(fd);
+  CHECK(bits == 0x020, "FC01 after FC0F: 0x%03X", bits);
+
+  commands = s_commands;
+  len = write_coils(fd, 4, PLC_COIL_COUNT, 0x001, response);
+  CHECK(is_exception(response, len, MODBUS_FC_WRITE_MULTIPLE_COILS, MODBUS_EX_ILLEGAL_DATA_ADDRESS),
+        "FC0F past the last coil: expected exception 02, got %zu bytes", len);
+  CHECK(commands_after(commands) == commands && read_coils(fd) == 0x020, "FC0F past the last coil was applied");
+}
+
+// FC06 后跟 8 个多余字节：线路上共 16 个字符，快速路径在第 8 个字符
+// 收完时就发布，早于多余字节与其后的 t3.5
+static void test_fast_path(int fd, rs485_bus_t *bus) {
+  uint32_t char_us = 0;
+  rs485_bus_get_timing(bus, &char_us, NULL);
+  uint8_t request[16] = {TEST_SLAVE_ADDR, MODBUS_FC_WRITE_SINGLE_REGISTER, 0, PLC_REG_LIGHT_COMMAND, 0,
+                         RS485_CMD_YELLOW_ON};
+  frame_finish(request, 6);
+  uint8_t response[64];
+  s_frame_len = 0;
+  __atomic_store_n(&s_frame_at_us, 0, __ATOMIC_RELEASE);
+  int64_t start_us = esp_timer_get_time();
+  size_t len = plc_transact(fd, request, sizeof(request), response, sizeof(response));
+  int64_t published_us = __atomic_load_n(&s_frame_at_us, __ATOMIC_ACQUIRE) - start_us;
+  CHECK(len == 8 && memcmp(response, request, 6) == 0, "FC06 with trailing bytes: %zu byte reply", len);
+  CHECK(s_frame_len == 8, "fast path published %zu bytes, expected 8", s_frame_len);
+  CHECK(published_us > 0 && published_us < 12 * (int64_t)char_us,
+        "fast path published after %lld us, expected < %lu (12 chars)", (long long)published_us,
+        (unsigned long)(12 * char_us));
+}
+
+int main(void) {
+  esp_log_level_set("*", ESP_LOG_WARN);
+
+  char path[64];
+  int fd = open_pty(path, sizeof(path));
+  if (fd < 0 || host_uart_attach(TEST_UART, path) != ESP_OK) {
+    return 1;
+  }
+  rs485_bus_config_t bus_config = {
+      .uart_num = TEST_UART,
+      .tx_pin = 20,
+      .rx_pin = 19,
+      .de_pin = UART_PIN_NO_CHANGE,
+      .baud_rate = TEST_BAUD,
+      .parity = UART_PARITY_DISABLE,
+      .task_core = -1,
+  };
+  rs485_bus_t *bus = rs485_bus_open(&bus_config);
+
+  modbus_slave_config_t config = {
+      .address = TEST_SLAVE_ADDR,
+      .register_count = PLC_REG_COUNT,
+      .writable_start = PLC_REG_LIGHT_COMMAND,
+      .write_cb = plc_write,
+      .coil_cmds = s_coil_cmds,
+      .coil_count = PLC_COIL_COUNT,
+      .command_cb = plc_command,
+      .validate_cb = plc_validate,
+  };
+  modbus_slave_t *slave = modbus_slave_create(&config);
+  if (bus == NULL || slave == NULL || !modbus_slave_start(slave, bus)) {
+    printf("FAIL: bus or slave start\n");
+    return 1;
+  }
+  s_slave = slave;
+  modbus_slave_set_register(slave, PLC_REG_LIGHT_ACTUAL, RS485_CMD_GREEN_ON);
+  modbus_slave_set_register(slave, PLC_REG_LIGHT_CONFIRMED, 1);
+  rs485_bus_register_frame_callback(bus, on_frame, NULL);
+
+  test_fc06(fd, slave);
+  test_fc10(fd, slave);
+  test_fc03(fd);
+  test_coils(fd);
+  test_fast_path(fd, bus);
+
+  modbus_slave_stats_t stats;
+  modbus_slave_get_stats(slave, &stats);
+  printf("slave: %lu requests, %lu exceptions, %lu crc errors, turnaround last %lu max %lu us\n",
+         (unsigned long)stats.requests, (unsigned long)stats.exceptions,
+         (unsigned long)stats.crc_errors, (unsigned long)stats.last_turnaround_us,
+         (unsigned long)stats.max_turnaround_us);
+  CHECK(stats.exceptions == 10 && stats.crc_errors == 0, "slave stats");
+  // 应答前总线至少静默 t3.5，从请求最后一个字节算起的应答时间不会更短
+  uint32_t frame_gap_us = 0;
+  rs485_bus_get_timing(bus, NULL, &frame_gap_us);
+  CHECK(stats.last_turnaround_us >= frame_gap_us, "last turnaround %lu us below t3.5 %lu us",
+        (unsigned long)stats.last_turnaround_us, (unsigned long)frame_gap_us);
+
+  close(fd);
+  return host_test_summary();
+}
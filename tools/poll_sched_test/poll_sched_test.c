@@ -0,0 +1,114 @@
+/*
+ * 轮询表可调度性分析主机测试（Linux）
+ *
+ * 用整数时序参数手算几张小轮询表的最坏响应时间，检查
+ * modbus_poll_cost_us、modbus_poll_utilization_permille 与
+ * modbus_poll_schedulable 的结果：
+ *
+ *   - 单次事务开销与利用率；
+ *   - 非抢占阻塞只来自低优先级项中开销最大者；
+ *   - 优先级类别先于周期（单调速率只在同类内生效）；
+ *   - 高优先级项多次释放时排队时间迭代到不动点；
+ *   - 过载时迭代在超过截止期限后停止并判为不可调度。
+ *
+ * 编译（在 tools 目录）：
+ *   make poll_sched_test
+ *
+ * 任何一项检查不通过退出码为 1。
+ */
+#include "modbus_poll.h"
+#include "host_test.h"
+#include <stdio.h>
+
+// 整数参数便于手算：FC03 读 1 个寄存器 = (8 + 7) 字节 → 15·100 + 2000 + 2·1000 = 5500us
+static const modbus_poll_timing_t s_timing = {
+    .char_time_us = 100,
+    .frame_gap_us = 1000,
+    .turnaround_us = 2000,
+};
+
+static modbus_poll_item_t item(uint16_t quantity, uint32_t period_ms, uint8_t priority) {
+  modbus_poll_item_t it = {
+      .slave = 1,
+      .function = MODBUS_FC_READ_HOLDING_REGISTERS,
+      .quantity = quantity,
+      .period_ms = period_ms,
+      .priority = priority,
+  };
+  return it;
+}
+
+static void expect_table(const char *name, const modbus_poll_item_t *items, size_t count,
+                         bool schedulable, const uint32_t *expected) {
+  uint32_t response[MODBUS_POLL_MAX_ITEMS];
+  bool ok = modbus_poll_schedulable(items, count, &s_timing, response);
+  CHECK(ok == schedulable, "%s: schedulable %d, expected %d", name, ok, schedulable);
+  for (size_t i = 0; i < count; i++) {
+    CHECK(response[i] == expected[i], "%s: item %zu response %lu us, expected %lu", name, i,
+          (unsigned long)response[i], (unsigned long)expected[i]);
+  }
+  printf("%s: %s", name, ok ? "schedulable" : "not schedulable");
+  for (size_t i = 0; i < count; i++) {
+    printf(" R%zu=%luus", i, (unsigned long)response[i]);
+  }
+  printf("\n");
+}
+
+static void test_cost(void) {
+  modbus_poll_item_t reg = item(1, 100, 0);
+  CHECK(modbus_poll_cost_us(&reg, &s_timing) == 5500, "FC03 x1 cost %lu",
+        (unsigned long)modbus_poll_cost_us(&reg, &s_timing));
+
+  // 60 个寄存器：8 + 5 + 120 = 133 字节
+  modbus_poll_item_t block = item(60, 100, 0);
+  CHECK(modbus_poll_cost_us(&block, &s_timing) == 17300, "FC03 x60 cost %lu",
+        (unsigned long)modbus_poll_cost_us(&block, &s_timing));
+
+  // 16 个线圈：应答 5 + 2 字节
+  modbus_poll_item_t coils = item(16, 100, 0);
+  coils.function = MODBUS_FC_READ_COILS;
+  CHECK(modbus_poll_cost_us(&coils, &s_timing) == 5500, "FC01 x16 cost %lu",
+        (unsigned long)modbus_poll_cost_us(&coils, &s_timing));
+
+  // 5500/10 + 17300/100 = 550 + 173 千分比
+  modbus_poll_item_t table[] = {item(1, 10, 0), item(60, 100, 0)};
+  uint32_t permille = modbus_poll_utilization_permille(table, 2, &s_timing);
+  CHECK(permille == 723, "utilization %lu permille", (unsigned long)permille);
+}
+
+int main(void) {
+  test_cost();
+
+  // 高优先级项被低优先级的长事务阻塞一次：R0 = 17300 + 5500
+  {
+    modbus_poll_item_t table[] = {item(1, 25, 0), item(1, 40, 0), item(60, 200, 0)};
+    const uint32_t expected[] = {22800, 28300, 28300};
+    expect_table("blocking", table, 3, true, expected);
+  }
+
+  // 优先级类别优先：周期更长的 0 类项排在 1 类项前面
+  //   R1 = 阻塞 5500（项 2）+ 干扰 17300（项 0）+ 5500
+  {
+    modbus_poll_item_t table[] = {item(60, 1000, 0), item(1, 100, 1), item(1, 200, 1)};
+    const uint32_t expected[] = {22800, 28300, 28300};
+    expect_table("classes", table, 3, true, expected);
+  }
+
+  // 项 2 的排队时间：11000 → 16500 → 22000 → 27500（不动点），R2 = 27500 + 17300；
+  // 前两项被项 2 阻塞后超过各自的 10/15ms 周期
+  {
+    modbus_poll_item_t table[] = {item(1, 10, 0), item(1, 15, 0), item(60, 100, 0)};
+    const uint32_t expected[] = {22800, 33800, 44800};
+    expect_table("fixed point", table, 3, false, expected);
+  }
+
+  // 过载（利用率 > 100%）：项 2 的迭代在越过 60ms 截止期限后停止
+  //   w = 11000 → 22000 → 33000 → 44000，R2 = 44000 + 17300
+  {
+    modbus_poll_item_t table[] = {item(1, 10, 0), item(1, 10, 0), item(60, 60, 0)};
+    const uint32_t expected[] = {22800, 33800, 61300};
+    expect_table("overload", table, 3, false, expected);
+  }
+
+  return host_test_summary();
+}
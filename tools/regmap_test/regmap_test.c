@@ -0,0 +1,238 @@
+/*
+ * 声明式寄存器表与读取计划主机测试（Linux）
+ *
+ * 用 MODBUS_REGMAP_DEFINE 展开一张电表寄存器表，检查
+ * modbus_regmap_plan 的合并规则与 modbus_regmap_store 的拆分：
+ *
+ *   - 宏展开出的下标、表项与带类型读取函数；
+ *   - 相邻定义合并，间隙不超过 max_gap 时合并，功能码不同不合并；
+ *   - 合并后不超过 125 个寄存器，32 位定义跨上限时另起一帧；
+ *   - 重叠定义只读一次，间隙寄存器数不把重叠算进去；
+ *   - 应答按定义拆回，只覆盖半个 32 位值的应答不写入；
+ *   - 16/32 位、有符号与浮点读取，未读到的寄存器返回 0；
+ *   - 空表、非法功能码与越界地址被拒绝。
+ *
+ * 编译（在 tools 目录）：
+ *   make regmap_test
+ *
+ * 任何一项检查不通过退出码为 1。
+ */
+#include "modbus_regmap.h"
+#include "host_test.h"
+#include "esp_log.h"
+#include <stdio.h>
+
+// 定义顺序故意打乱，计划须按（功能码, 地址）排序
+#define METER_REGMAP(X, p)                                                     \
+  X(p, power, 0x04, 0x0006, f32)                                               \
+  X(p, voltage, 0x04, 0x0000, u16)                                             \
+  X(p, current, 0x04, 0x0001, s16)                                             \
+  X(p, energy, 0x04, 0x0002, u32)                                              \
+  X(p, setpoint, 0x03, 0x0010, s32)                                            \
+  X(p, mode, 0x03, 0x0000, u16)
+
+MODBUS_REGMAP_DEFINE(meter, METER_REGMAP)
+
+// 与 poll_sched_test 相同的整数时序：FC03 读 1 个寄存器 5500us
+static const modbus_poll_timing_t s_timing = {
+    .char_time_us = 100,
+    .frame_gap_us = 1000,
+    .turnaround_us = 2000,
+};
+
+static void expect_read(const modbus_regmap_plan_t *plan, uint16_t i, uint8_t function, uint16_t address,
+                        uint16_t quantity) {
+  CHECK(i < plan->read_count, "read %u missing (%u reads)", i, plan->read_count);
+  if (i >= plan->read_count) {
+    return;
+  }
+  const modbus_regmap_read_t *r = &plan->reads[i];
+  CHECK(r->function == function && r->address == address && r->quantity == quantity,
+        "read %u: fc %u addr 0x%X qty %u, expected fc %u addr 0x%X qty %u", i, r->function, r->address,
+        r->quantity, function, address, quantity);
+}
+
+static modbus_result_t result_of(uint8_t function, uint16_t address, const uint16_t *regs, uint16_t quantity) {
+  modbus_result_t result = {
+      .status = MODBUS_OK,
+      .slave = 1,
+      .function = function,
+      .address = address,
+      .quantity = quantity,
+  };
+  memcpy(result.registers, regs, quantity * sizeof(uint16_t));
+  return result;
+}
+
+static void test_define(void) {
+  CHECK(meter_reg_count == 6 && meter_regmap.count == 6, "%d registers", meter_reg_count);
+  CHECK(strcmp(meter_regmap.name, "meter") == 0, "map name %s", meter_regmap.name);
+  CHECK(meter_reg_power == 0 && meter_reg_mode == 5, "indices follow the list");
+  const modbus_reg_def_t *energy = &meter_regmap.regs[meter_reg_energy];
+  CHECK(strcmp(energy->name, "energy") == 0 && energy->function == MODBUS_FC_READ_INPUT_REGISTERS &&
+            energy->address == 0x0002 && energy->type == MODBUS_REG_U32,
+        "energy: %s fc %u addr 0x%X type %u", energy->name, energy->function, energy->address, energy->type);
+  CHECK(modbus_regmap_width(energy) == 2 && modbus_regmap_width(&meter_regmap.regs[meter_reg_current]) == 1,
+        "widths");
+}
+
+static void test_merge_and_gap(void) {
+  modbus_regmap_plan_t plan;
+
+  // max_gap 0：只合并相邻，0x0004..0x0005 的间隙把 power 分开
+  CHECK(modbus_regmap_plan(&meter_regmap, 0, NULL, &plan), "plan gap 0");
+  CHECK(plan.read_count == 4, "gap 0: %u reads", plan.read_count);
+  expect_read(&plan, 0, MODBUS_FC_READ_HOLDING_REGISTERS, 0x0000, 1);
+  expect_read(&plan, 1, MODBUS_FC_READ_HOLDING_REGISTERS, 0x0010, 2);
+  expect_read(&plan, 2, MODBUS_FC_READ_INPUT_REGISTERS, 0x0000, 4);
+  expect_read(&plan, 3, MODBUS_FC_READ_INPUT_REGISTERS, 0x0006, 2);
+  CHECK(plan.registers == 9 && plan.gap_registers == 0 && plan.frames_saved == 2,
+        "gap 0: %u registers, %u gap, %u saved", plan.registers, plan.gap_registers, plan.frames_saved);
+  CHECK(plan.naive_us == 0 && plan.planned_us == 0, "no timing, no estimate");
+
+  // max_gap 2：多读两个间隙寄存器换掉一帧；FC03 的 15 个间隙仍不合并
+  CHECK(modbus_regmap_plan(&meter_regmap, 2, &s_timing, &plan), "plan gap 2");
+  CHECK(plan.read_count == 3, "gap 2: %u reads", plan.read_count);
+  expect_read(&plan, 2, MODBUS_FC_READ_INPUT_REGISTERS, 0x0000, 8);
+  CHECK(plan.registers == 11 && plan.gap_registers == 2 && plan.frames_saved == 3,
+        "gap 2: %u registers, %u gap, %u saved", plan.registers, plan.gap_registers, plan.frames_saved);
+  CHECK(plan.planned_us < plan.naive_us, "estimate %lu -> %lu us", (unsigned long)plan.naive_us,
+        (unsigned long)plan.planned_us);
+
+  // 间隙再大，功能码不同的定义也不合并
+  CHECK(modbus_regmap_plan(&meter_regmap, 100, NULL, &plan), "plan gap 100");
+  CHECK(plan.read_count == 2, "gap 100: %u reads", plan.read_count);
+  expect_read(&plan, 0, MODBUS_FC_READ_HOLDING_REGISTERS, 0x0000, 0x12);
+  expect_read(&plan, 1, MODBUS_FC_READ_INPUT_REGISTERS, 0x0000, 8);
+  CHECK(plan.gap_registers == 17, "gap 100: %u gap registers", plan.gap_registers);
+
+  // 单帧开销 5500 - 200 = 5300us，每个寄存器 200us
+  uint16_t gap = modbus_regmap_break_even_gap(&s_timing);
+  CHECK(gap == 26, "break-even gap %u", gap);
+  CHECK(modbus_regmap_break_even_gap(NULL) == 0, "break-even gap without timing");
+}
+
+static void test_cap(void) {
+  modbus_regmap_plan_t plan;
+
+  // 0x0000..0x007C 正好 125 个寄存器；0x007D 超出上限另起一帧
+  static const modbus_reg_def_t edge_defs[] = {
+      {"first", MODBUS_FC_READ_HOLDING_REGISTERS, 0x0000, MODBUS_REG_U16},
+      {"last", MODBUS_FC_READ_HOLDING_REGISTERS, 0x007C, MODBUS_REG_U16},
+      {"over", MODBUS_FC_READ_HOLDING_REGISTERS, 0x007D, MODBUS_REG_U16},
+  };
+  static const modbus_regmap_t edge = {"edge", edge_defs, 3};
+  CHECK(modbus_regmap_plan(&edge, MODBUS_MAX_READ_REGISTERS, NULL, &plan), "plan edge");
+  CHECK(plan.read_count == 2, "edge: %u reads", plan.read_count);
+  expect_read(&plan, 0, MODBUS_FC_READ_HOLDING_REGISTERS, 0x0000, MODBUS_MAX_READ_REGISTERS);
+  expect_read(&plan, 1, MODBUS_FC_READ_HOLDING_REGISTERS, 0x007D, 1);
+
+  // 32 位定义的低字落在第 126 个寄存器：整个定义移到下一帧
+  static const modbus_reg_def_t wide_defs[] = {
+      {"first", MODBUS_FC_READ_HOLDING_REGISTERS, 0x0000, MODBUS_REG_U16},
+      {"wide", MODBUS_FC_READ_HOLDING_REGISTERS, 0x007C, MODBUS_REG_U32},
+  };
+  static const modbus_regmap_t wide = {"wide", wide_defs, 2};
+  CHECK(modbus_regmap_plan(&wide, MODBUS_MAX_READ_REGISTERS, NULL, &plan), "plan wide");
+  CHECK(plan.read_count == 2, "wide: %u reads", plan.read_count);
+  expect_read(&plan, 0, MODBUS_FC_READ_HOLDING_REGISTERS, 0x0000, 1);
+  expect_read(&plan, 1, MODBUS_FC_READ_HOLDING_REGISTERS, 0x007C, 2);
+}
+
+static void test_overlap(void) {
+  modbus_regmap_plan_t plan;
+
+  // 同一 32 位值的整体、高字与低字，再加一个与之重叠并向后延伸的 32 位值
+  static const modbus_reg_def_t defs[] = {
+      {"whole", MODBUS_FC_READ_HOLDING_REGISTERS, 0x0020, MODBUS_REG_U32},
+      {"high", MODBUS_FC_READ_HOLDING_REGISTERS, 0x0020, MODBUS_REG_U16},
+      {"low", MODBUS_FC_READ_HOLDING_REGISTERS, 0x0021, MODBUS_REG_S16},
+      {"shifted", MODBUS_FC_READ_HOLDING_REGISTERS, 0x0021, MODBUS_REG_S32},
+  };
+  static const modbus_regmap_t map = {"overlap", defs, 4};
+  CHECK(modbus_regmap_plan(&map, 0, NULL, &plan), "plan overlap");
+  CHECK(plan.read_count == 1, "overlap: %u reads", plan.read_count);
+  expect_read(&plan, 0, MODBUS_FC_READ_HOLDING_REGISTERS, 0x0020, 3);
+  CHECK(plan.registers == 3 && plan.gap_registers == 0 && plan.frames_saved == 3,
+        "overlap: %u registers, %u gap, %u saved", plan.registers, plan.gap_registers, plan.frames_saved);
+
+  static const uint16_t regs[] = {0x1234, 0xFFFF, 0xFFFE};
+  modbus_result_t result = result_of(MODBUS_FC_READ_HOLDING_REGISTERS, 0x0020, regs, 3);
+  modbus_regmap_values_t values = {0};
+  modbus_regmap_store(&plan, &result, &values);
+  CHECK(values.valid == 0xF, "overlap valid 0x%X", (unsigned)values.valid);
+  CHECK(modbus_regmap_get_u32(&values, 0) == 0x1234FFFF, "whole 0x%X", (unsigned)modbus_regmap_get_u32(&values, 0));
+  CHECK(modbus_regmap_get_u16(&values, 1) == 0x1234, "high 0x%X", modbus_regmap_get_u16(&values, 1));
+  CHECK(modbus_regmap_get_s16(&values, 2) == -1, "low %d", modbus_regmap_get_s16(&values, 2));
+  CHECK(modbus_regmap_get_s32(&values, 3) == -2, "shifted %d", (int)modbus_regmap_get_s32(&values, 3));
+}
+
+static void test_store(void) {
+  modbus_regmap_plan_t plan;
+  CHECK(modbus_regmap_plan(&meter_regmap, 0, NULL, &plan), "plan store");
+
+  modbus_regmap_values_t values = {0};
+  CHECK(!modbus_regmap_valid(&values, meter_reg_voltage) && meter_get_voltage(&values) == 0 &&
+            meter_get_power(&values) == 0.0f,
+        "unread registers read as 0");
+
+  // FC04 0x0000..0x0003：voltage、current、energy；power 在另一帧
+  static const uint16_t first[] = {230, 0xFFF6, 0x0001, 0x86A0};
+  modbus_result_t result = result_of(MODBUS_FC_READ_INPUT_REGISTERS, 0x0000, first, 4);
+  modbus_regmap_store(&plan, &result, &values);
+  CHECK(meter_get_voltage(&values) == 230, "voltage %u", meter_get_voltage(&values));
+  CHECK(meter_get_current(&values) == -10, "current %d", meter_get_current(&values));
+  CHECK(meter_get_energy(&values) == 100000, "energy %u", (unsigned)meter_get_energy(&values));
+  CHECK(!modbus_regmap_valid(&values, meter_reg_power), "power stored from another read");
+  CHECK(!modbus_regmap_valid(&values, meter_reg_mode), "FC04 reply stored into FC03 register");
+
+  // 1234.5f = 0x449A5000，高字在前
+  static const uint16_t second[] = {0x449A, 0x5000};
+  result = result_of(MODBUS_FC_READ_INPUT_REGISTERS, 0x0006, second, 2);
+  modbus_regmap_store(&plan, &result, &values);
+  CHECK(meter_get_power(&values) == 1234.5f, "power %f", (double)meter_get_power(&values));
+
+  // 只覆盖 setpoint 低字的应答不能写入半个值
+  static const uint16_t half[] = {0x0007};
+  result = result_of(MODBUS_FC_READ_HOLDING_REGISTERS, 0x0011, half, 1);
+  modbus_regmap_store(&plan, &result, &values);
+  CHECK(!modbus_regmap_valid(&values, meter_reg_setpoint), "half a 32-bit register stored");
+
+  // 失败的读取不改变已有值
+  static const uint16_t setpoint[] = {0xFFFF, 0xFF38};
+  result = result_of(MODBUS_FC_READ_HOLDING_REGISTERS, 0x0010, setpoint, 2);
+  result.status = MODBUS_ERR_TIMEOUT;
+  modbus_regmap_store(&plan, &result, &values);
+  CHECK(!modbus_regmap_valid(&values, meter_reg_setpoint), "failed read stored");
+  result.status = MODBUS_OK;
+  modbus_regmap_store(&plan, &result, &values);
+  CHECK(meter_get_setpoint(&values) == -200, "setpoint %d", (int)meter_get_setpoint(&values));
+
+  CHECK(values.valid == ((1u << meter_reg_count) - 1 - (1u << meter_reg_mode)), "valid 0x%X",
+        (unsigned)values.valid);
+  CHECK(!modbus_regmap_valid(&values, MODBUS_REGMAP_MAX_REGS), "index past the table");
+}
+
+static void test_invalid(void) {
+  modbus_regmap_plan_t plan;
+  static const modbus_reg_def_t write_def[] = {{"coil", MODBUS_FC_WRITE_SINGLE_REGISTER, 0, MODBUS_REG_U16}};
+  static const modbus_reg_def_t end_def[] = {{"end", MODBUS_FC_READ_HOLDING_REGISTERS, 0xFFFF, MODBUS_REG_U32}};
+  static const modbus_regmap_t empty = {"empty", write_def, 0};
+  static const modbus_regmap_t write = {"write", write_def, 1};
+  static const modbus_regmap_t end = {"end", end_def, 1};
+  CHECK(!modbus_regmap_plan(&empty, 0, NULL, &plan), "empty map accepted");
+  CHECK(!modbus_regmap_plan(&write, 0, NULL, &plan), "write function accepted");
+  CHECK(!modbus_regmap_plan(&end, 0, NULL, &plan), "32-bit register past 0xFFFF accepted");
+}
+
+int main(void) {
+  // 计划日志与非法定义的错误日志是预期输出，不打印
+  esp_log_level_set("*", ESP_LOG_NONE);
+  test_define();
+  test_merge_and_gap();
+  test_cap();
+  test_overlap();
+  test_store();
+  test_invalid();
+  return host_test_summary();
+}
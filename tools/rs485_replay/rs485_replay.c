@@ -0,0 +1,356 @@
+/*
+ * RS485 抓包离线回放
+ *
+ * 把 rs485_capture_export() 导出的抓包按原顺序送入固件同一份帧解析器
+ * （main/rs485_parser.c），并与整帧 CRC 判定（与 rs485_comm.c 常规路径
+ * 相同的规则，含塔灯 00 00 后缀）及抓包时记录的结果逐帧比对；同时按
+ * 主站逻辑把请求与应答配对：由请求帧还原 modbus_request_t（重新编码须与
+ * 原帧一致），CRC 正确的应答交给固件的 modbus_master_decode() 解码。
+ * 以尽可能快的速度重复回放，报告吞吐。
+ *
+ * 编译（在 tools 目录）：
+ *   make rs485_replay
+ *
+ * 用法：
+ *   rs485_replay [-s] [-c 块大小] [-n 重复次数] capture.bin
+ *     -s  抓包来自从站口（本机收请求、发应答）
+ *     -c  每次喂给解析器的字节数，模拟 FIFO 分块（默认整帧）
+ *     -n  吞吐测试重复次数（默认 100）
+ *
+ * 存在行为差异（解析器、抓包记录与整帧 CRC 判定不一致，或配对的应答被
+ * 主站判为无效应答）时退出码为 1，可直接用作回归测试；同目录的
+ * tower_bench.cap 由 tower_bench -c 录下，供 make check 回放。
+ */
+#include "modbus_master.h"
+#include "rs485_capture.h"
+#include "rs485_crc.h"
+#include "rs485_parser.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+typedef struct {
+  const uint8_t *data;
+  rs485_capture_record_t rec;
+  int64_t time_us; // 相对首帧
+} replay_frame_t;
+
+// 等待应答的请求，写入数据指向 regs 或原帧
+typedef struct {
+  const replay_frame_t *frame;
+  bool decodable; // 能还原为 modbus_request_t
+  modbus_request_t request;
+  uint8_t coil;
+  uint16_t regs[MODBUS_MAX_WRITE_REGISTERS];
+} replay_pending_t;
+
+typedef struct {
+  size_t frames;
+  size_t parser_mismatches;  // 解析器与整帧 CRC 判定不一致
+  size_t capture_mismatches; // 整帧 CRC 判定与抓包记录不一致
+  size_t transactions;       // 请求与应答配对成功
+  size_t unanswered;         // 请求后未见应答
+  size_t unexpected;         // 无对应请求的应答
+  size_t undecodable;        // 无法还原为 modbus_request_t 的请求
+  size_t decoded;            // 应答经 modbus_master_decode 解码为 MODBUS_OK
+  size_t exceptions;         // 异常应答
+  size_t invalid;            // 被主站判为无效应答
+  uint64_t turnaround_sum_us;
+  uint32_t turnaround_max_us;
+} replay_report_t;
+
+// 整帧 CRC 判定，规则与 rs485_comm.c 的 rs485_rx_crc_ok() 相同
+static bool frame_crc_ok(const uint8_t *frame, size_t length) {
+  if (rs485_crc16_update(RS485_CRC16_INIT, frame, length) == 0) {
+    return true;
+  }
+  return length >= 4 && frame[length - 2] == 0 && frame[length - 1] == 0 &&
+         rs485_crc16_update(RS485_CRC16_INIT, frame, length - 2) == 0;
+}
+
+static rs485_parse_result_t parse_frame(rs485_parser_t *parser,
+                                        const uint8_t *data, size_t length,
+                                        size_t chunk) {
+  rs485_parser_reset(parser);
+  rs485_parse_result_t result = RS485_PARSE_INCOMPLETE;
+  for (size_t off = 0; off < length && result == RS485_PARSE_INCOMPLETE;
+       off += chunk) {
+    size_t n = length - off < chunk ? length - off : chunk;
+    result = rs485_parser_feed(parser, &data[off], n);
+  }
+  return rs485_parser_finish(parser);
+}
+
+static uint16_t get_u16(const uint8_t *p) {
+  return (uint16_t)((p[0] << 8) | p[1]);
+}
+
+// 由请求帧还原主站请求；按 modbus_master_encode() 重新编码须与原帧一致
+static bool request_from_frame(const uint8_t *frame, size_t length,
+                               replay_pending_t *p) {
+  modbus_request_t *req = &p->request;
+  memset(req, 0, sizeof(*req));
+  if (length < 8) {
+    return false;
+  }
+  req->slave = frame[0];
+  req->function = frame[1];
+  req->address = get_u16(&frame[2]);
+  req->quantity = get_u16(&frame[4]);
+  switch (req->function) {
+  case MODBUS_FC_WRITE_SINGLE_COIL:
+    p->coil = req->quantity == 0xFF00;
+    req->values = &p->coil;
+    req->quantity = 1;
+    break;
+  case MODBUS_FC_WRITE_SINGLE_REGISTER:
+    p->regs[0] = req->quantity;
+    req->values = p->regs;
+    req->quantity = 1;
+    break;
+  case MODBUS_FC_WRITE_MULTIPLE_COILS:
+    req->values = &frame[7];
+    break;
+  case MODBUS_FC_WRITE_MULTIPLE_REGISTERS:
+    if (req->quantity > MODBUS_MAX_WRITE_REGISTERS ||
+        length < 7u + req->quantity * 2u) {
+      return false;
+    }
+    for (uint16_t i = 0; i < req->quantity; i++) {
+      p->regs[i] = get_u16(&frame[7 + i * 2]);
+    }
+    req->values = p->regs;
+    break;
+  default:
+    break;
+  }
+  uint8_t encoded[RS485_FRAME_MAX_LEN];
+  size_t n = modbus_master_encode(req, encoded);
+  return n > 0 && n <= length && memcmp(encoded, frame, n) == 0;
+}
+
+static void print_frame(const char *what, size_t index,
+                        const replay_frame_t *f) {
+  printf("#%zu %s %s len=%u:", index, what,
+         (f->rec.flags & RS485_CAPTURE_FLAG_RX) ? "RX" : "TX", f->rec.length);
+  for (size_t i = 0; i < f->rec.length && i < 32; i++) {
+    printf(" %02X", f->data[i]);
+  }
+  printf("\n");
+}
+
+static void replay(const replay_frame_t *frames, size_t count, bool slave,
+                   size_t chunk, bool verbose, replay_report_t *report) {
+  rs485_parser_t requests;
+  rs485_parser_t responses;
+  rs485_parser_init(&requests, RS485_PARSER_REQUEST);
+  rs485_parser_init(&responses, RS485_PARSER_RESPONSE);
+  memset(report, 0, sizeof(*report));
+
+  replay_pending_t pending = {0};
+  for (size_t i = 0; i < count; i++) {
+    const replay_frame_t *f = &frames[i];
+    bool rx = (f->rec.flags & RS485_CAPTURE_FLAG_RX) != 0;
+    bool is_request = rx == slave;
+    bool crc_ok = frame_crc_ok(f->data, f->rec.length);
+    rs485_parse_result_t result =
+        parse_frame(is_request ? &requests : &responses, f->data,
+                    f->rec.length, chunk);
+    report->frames++;
+
+    if ((result == RS485_PARSE_FRAME) != crc_ok) {
+      report->parser_mismatches++;
+      if (verbose) {
+        printf("parser=%d crc_ok=%d ", result, crc_ok);
+        print_frame("parser differs", i, f);
+      }
+    }
+    if (rx && crc_ok == ((f->rec.flags & RS485_CAPTURE_FLAG_CRC_ERROR) != 0)) {
+      report->capture_mismatches++;
+      if (verbose) {
+        print_frame("capture differs", i, f);
+      }
+    }
+
+    // 主站配对：应答地址须与请求相同，功能码相同或为其异常码
+    if (is_request) {
+      if (pending.frame != NULL) {
+        report->unanswered++;
+      }
+      pending.frame = f->rec.length >= 2 && f->data[0] != 0 && crc_ok ? f : NULL;
+      if (pending.frame != NULL) {
+        pending.decodable = request_from_frame(f->data, f->rec.length, &pending);
+        if (!pending.decodable) {
+          report->undecodable++;
+          if (verbose) {
+            print_frame("not a master request", i, f);
+          }
+        }
+      }
+    } else if (pending.frame != NULL && f->rec.length >= 2 &&
+               f->data[0] == pending.frame->data[0] &&
+               (f->data[1] & 0x7F) == pending.frame->data[1]) {
+      uint32_t turnaround = (uint32_t)(f->time_us - pending.frame->time_us);
+      report->transactions++;
+      report->turnaround_sum_us += turnaround;
+      if (turnaround > report->turnaround_max_us) {
+        report->turnaround_max_us = turnaround;
+      }
+      if (pending.decodable && crc_ok) {
+        modbus_result_t decoded;
+        modbus_status_t status = modbus_master_decode(
+            &pending.request, f->data, f->rec.length, &decoded);
+        if (status == MODBUS_OK) {
+          report->decoded++;
+        } else if (status == MODBUS_ERR_EXCEPTION) {
+          report->exceptions++;
+        } else {
+          report->invalid++;
+          if (verbose) {
+            print_frame("invalid response", i, f);
+          }
+        }
+      }
+      pending.frame = NULL;
+    } else {
+      report->unexpected++;
+    }
+  }
+  if (pending.frame != NULL) {
+    report->unanswered++;
+  }
+}
+
+static uint8_t *load_file(const char *path, size_t *size) {
+  FILE *fp = fopen(path, "rb");
+  if (fp == NULL) {
+    perror(path);
+    return NULL;
+  }
+  fseek(fp, 0, SEEK_END);
+  long len = ftell(fp);
+  fseek(fp, 0, SEEK_SET);
+  uint8_t *buf = len > 0 ? malloc((size_t)len) : NULL;
+  if (buf == NULL || fread(buf, 1, (size_t)len, fp) != (size_t)len) {
+    fprintf(stderr, "%s: read failed\n", path);
+    free(buf);
+    buf = NULL;
+  }
+  fclose(fp);
+  *size = (size_t)len;
+  return buf;
+}
+
+static double now_s(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+int main(int argc, char **argv) {
+  bool slave = false;
+  size_t chunk = 0;
+  long repeat = 100;
+  int opt;
+  while ((opt = getopt(argc, argv, "sc:n:")) != -1) {
+    switch (opt) {
+    case 's':
+      slave = true;
+      break;
+    case 'c':
+      chunk = (size_t)strtoul(optarg, NULL, 0);
+      break;
+    case 'n':
+      repeat = strtol(optarg, NULL, 0);
+      break;
+    default:
+      fprintf(stderr, "usage: %s [-s] [-c chunk] [-n repeat] capture.bin\n",
+              argv[0]);
+      return 2;
+    }
+  }
+  if (optind >= argc) {
+    fprintf(stderr, "usage: %s [-s] [-c chunk] [-n repeat] capture.bin\n",
+            argv[0]);
+    return 2;
+  }
+  if (chunk == 0) {
+    chunk = RS485_PARSER_MAX_FRAME;
+  }
+
+  size_t size = 0;
+  uint8_t *buf = load_file(argv[optind], &size);
+  if (buf == NULL) {
+    return 2;
+  }
+  if (size < RS485_CAPTURE_FILE_HEADER_LEN ||
+      memcmp(buf, RS485_CAPTURE_MAGIC, 4) != 0 ||
+      buf[4] != RS485_CAPTURE_VERSION) {
+    fprintf(stderr, "%s: not a version %d capture\n", argv[optind],
+            RS485_CAPTURE_VERSION);
+    return 2;
+  }
+
+  // 先建索引，回放循环只做解析
+  size_t capacity = 1024;
+  size_t count = 0;
+  replay_frame_t *frames = malloc(capacity * sizeof(*frames));
+  int64_t t = 0;
+  for (size_t pos = RS485_CAPTURE_FILE_HEADER_LEN;
+       pos + RS485_CAPTURE_RECORD_HEADER_LEN <= size;) {
+    replay_frame_t f;
+    rs485_capture_decode_header(&buf[pos], &f.rec);
+    pos += RS485_CAPTURE_RECORD_HEADER_LEN;
+    if (pos + f.rec.length > size) {
+      fprintf(stderr, "truncated record at offset %zu\n", pos);
+      break;
+    }
+    t += f.rec.delta_us;
+    f.time_us = t;
+    f.data = &buf[pos];
+    pos += f.rec.length;
+    if (count == capacity) {
+      capacity *= 2;
+      frames = realloc(frames, capacity * sizeof(*frames));
+    }
+    frames[count++] = f;
+  }
+
+  replay_report_t report;
+  replay(frames, count, slave, chunk, true, &report);
+
+  double start = now_s();
+  for (long i = 0; i < repeat; i++) {
+    replay_report_t r;
+    replay(frames, count, slave, chunk, false, &r);
+  }
+  double elapsed = now_s() - start;
+
+  printf("frames: %zu over %.3f s of bus time\n", report.frames, t / 1e6);
+  printf("transactions: %zu, unanswered: %zu, unexpected: %zu\n",
+         report.transactions, report.unanswered, report.unexpected);
+  if (report.transactions > 0) {
+    printf("request-to-response: avg %llu us, max %u us\n",
+           (unsigned long long)(report.turnaround_sum_us /
+                                report.transactions),
+           report.turnaround_max_us);
+  }
+  printf("decoded: %zu ok, %zu exceptions, %zu invalid, %zu undecodable requests\n",
+         report.decoded, report.exceptions, report.invalid,
+         report.undecodable);
+  printf("parser mismatches: %zu, capture mismatches: %zu\n",
+         report.parser_mismatches, report.capture_mismatches);
+  if (repeat > 0 && elapsed > 0) {
+    printf("throughput: %.0f frames/s (chunk %zu, %ld passes)\n",
+           (double)count * repeat / elapsed, chunk, repeat);
+  }
+
+  free(frames);
+  free(buf);
+  return report.parser_mismatches || report.capture_mismatches ||
+                 report.invalid
+             ? 1
+             : 0;
+}
@@ -0,0 +1,460 @@
+/*
+ * Modbus TCP → RTU 网关（Linux）与压测客户端
+ *
+ * 网关模式把固件的网关与总线代码（main/modbus_gateway.c、modbus_tcp.c、
+ * rs485_comm.c 等）原样编译到主机替身上（tools/host_shim），UART 接
+ * tower_sim 的伪终端；请求经优先级通道与断路器上总线，与面板上一致。
+ * 每秒打印一次吞吐。压测模式开若干并发连接，每个连接保持一个未完成
+ * 请求，报告每秒请求数、延迟及各连接之间的公平性。自测模式在本进程
+ * 内依次启动 tower_sim、网关与压测，供 make check 使用：
+ *
+ *   - 每个连接的请求都完成且无异常应答、连接未中断；
+ *   - 各连接平均延迟之比不超过 BENCH_MAX_FAIRNESS（公平性）；
+ *   - 网关占用总线的时间不低于 TEST_MIN_BUS_BUSY_PERCENT（吞吐）。
+ *
+ * 编译（在 tools 目录）：
+ *   make tcp_gateway
+ *
+ * 用法：
+ *   tcp_gateway -D 串口 [-b 波特率] [-p 端口] [-c 缓存ms] [-t 超时ms]
+ *   tcp_gateway -B [-h 主机] [-p 端口] [-n 连接数] [-r 每连接请求数]
+ *               [-u 单元号] [-a 寄存器]
+ *   tcp_gateway -T [-S tower_sim 路径] [-b 波特率] [-p 端口] [-n 连接数]
+ *               [-r 每连接请求数] [-u 单元号] [-a 寄存器]
+ *     -D 一般为 tower_sim 的伪终端；线路时序由主机替身按 -b 模拟。
+ *     -T 默认从本程序所在目录启动 tower_sim，模拟塔灯 1,2,3。
+ *
+ * 例：
+ *   tower_sim -l /tmp/tower -a 1,2,3 &
+ *   tcp_gateway -D /tmp/tower -p 1502 -c 200 &
+ *   tcp_gateway -B -p 1502 -n 4 -r 200 -u 1 -a 0xC2
+ *
+ * 压测与自测有检查不通过时退出码为 1。
+ */
+#include "modbus_gateway.h"
+#include "modbus_tcp.h"
+#include "rs485_comm.h"
+#include "driver/uart.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include <arpa/inet.h>
+#include <errno.h>
+#include <libgen.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#define GATEWAY_UART UART_NUM_1
+#define BENCH_MAX_CLIENTS 64
+#define BENCH_MAX_FAIRNESS 2.0 // 最慢与最快连接平均延迟之比上限
+#define TEST_TOWERS "1,2,3"
+#define TEST_MIN_BUS_BUSY_PERCENT 50
+
+static volatile sig_atomic_t s_stop = 0;
+static int s_sim_pid = -1;
+
+static void on_signal(int sig) {
+  (void)sig;
+  s_stop = 1;
+}
+
+static int64_t now_us(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+// 在 link 上打开固件总线并启动网关；失败时已打印原因
+static rs485_bus_t *gateway_open(const char *link, int baud, uint16_t port,
+                                 uint32_t cache_ms, uint32_t timeout_ms) {
+  if (host_uart_attach(GATEWAY_UART, link) != ESP_OK) {
+    perror(link);
+    return NULL;
+  }
+  rs485_bus_config_t bus_config = {
+      .uart_num = GATEWAY_UART,
+      .tx_pin = 17,
+      .rx_pin = 18,
+      .de_pin = UART_PIN_NO_CHANGE,
+      .baud_rate = baud,
+      .parity = UART_PARITY_DISABLE,
+      .task_core = -1,
+  };
+  rs485_bus_t *bus = rs485_bus_open(&bus_config);
+  if (bus == NULL) {
+    fprintf(stderr, "bus open failed\n");
+    host_uart_detach(GATEWAY_UART);
+    return NULL;
+  }
+  modbus_gateway_config_t config = {
+      .port = port,
+      .cache_ttl_ms = cache_ms,
+      .timeout_ms = timeout_ms,
+  };
+  if (!modbus_gateway_start(bus, &config)) {
+    fprintf(stderr, "gateway start on port %u failed\n", port);
+    rs485_bus_close(bus);
+    host_uart_detach(GATEWAY_UART);
+    return NULL;
+  }
+  return bus;
+}
+
+static int run_gateway(const char *device, int baud, uint16_t port,
+                       uint32_t cache_ms, uint32_t timeout_ms) {
+  if (gateway_open(device, baud, port, cache_ms, timeout_ms) == NULL) {
+    return 1;
+  }
+  printf("gateway on port %u -> %s @ %d, cache %u ms\n", port, device, baud,
+         cache_ms);
+  fflush(stdout);
+
+  // 网关在自己的任务里运行，这里只按秒取统计快照
+  modbus_tcp_stats_t prev = {0};
+  modbus_tcp_stats_t total = {0};
+  int64_t last_us = now_us();
+  int64_t start_us = last_us;
+  while (!s_stop) {
+    vTaskDelay(pdMS_TO_TICKS(100));
+    modbus_gateway_get_stats(&total);
+    int64_t t = now_us();
+    if (t - last_us >= 1000000) {
+      double secs = (t - last_us) / 1e6;
+      printf("%.1f req/s (%.1f bus, %.1f cached), bus busy %.0f%%, "
+             "%u clients, %u timeouts, %u errors\n",
+             (total.requests - prev.requests) / secs,
+             (total.bus_transactions - prev.bus_transactions) / secs,
+             (total.cache_hits - prev.cache_hits) / secs,
+             (total.bus_us - prev.bus_us) / 1e4 / secs, total.clients,
+             total.timeouts - prev.timeouts, total.errors - prev.errors);
+      fflush(stdout);
+      prev = total;
+      last_us = t;
+    }
+  }
+
+  double secs = (now_us() - start_us) / 1e6;
+  printf("requests %u (%.1f/s), bus %u, cached %u, timeouts %u, errors %u, "
+         "protocol errors %u, accepted %u, refused %u\n",
+         total.requests, secs > 0 ? total.requests / secs : 0.0,
+         total.bus_transactions, total.cache_hits, total.timeouts,
+         total.errors, total.protocol_errors, total.accepted, total.refused);
+  return 0;
+}
+
+typedef struct {
+  int fd;
+  uint16_t tid;
+  uint32_t sent;
+  uint32_t done;
+  uint32_t exceptions;
+  int64_t sent_us;
+  int64_t latency_us;
+  int64_t max_latency_us;
+  bool lost; // 连接被拒绝或中断
+} bench_client_t;
+
+static bool bench_send(bench_client_t *c, uint8_t unit, uint16_t reg) {
+  uint8_t adu[12] = {(uint8_t)(c->tid >> 8), (uint8_t)c->tid, 0, 0, 0, 6, unit,
+                     0x03, (uint8_t)(reg >> 8), (uint8_t)reg, 0, 1};
+  c->sent_us = now_us();
+  c->sent++;
+  return send(c->fd, adu, sizeof(adu), MSG_NOSIGNAL) == (ssize_t)sizeof(adu);
+}
+
+// 收一个完整应答；返回 false 表示连接出错
+static bool bench_receive(bench_client_t *c) {
+  uint8_t adu[MODBUS_TCP_ADU_MAX];
+  if (recv(c->fd, adu, 7, MSG_WAITALL) != 7) {
+    return false;
+  }
+  size_t length = ((size_t)adu[4] << 8) | adu[5];
+  if (length < 2 || length > 1 + MODBUS_TCP_PDU_MAX ||
+      recv(c->fd, &adu[7], length - 1, MSG_WAITALL) != (ssize_t)(length - 1)) {
+    return false;
+  }
+  if ((((uint16_t)adu[0] << 8) | adu[1]) != c->tid) {
+    fprintf(stderr, "transaction id mismatch\n");
+    return false;
+  }
+  int64_t latency = now_us() - c->sent_us;
+  c->latency_us += latency;
+  c->max_latency_us = latency > c->max_latency_us ? latency : c->max_latency_us;
+  if (adu[7] & 0x80) {
+    c->exceptions++;
+  }
+  c->done++;
+  c->tid++;
+  return true;
+}
+
+static int run_bench(const char *host, uint16_t port, int clients,
+                     uint32_t requests, uint8_t unit, uint16_t reg) {
+  bench_client_t bench[BENCH_MAX_CLIENTS] = {0};
+  struct pollfd pfds[BENCH_MAX_CLIENTS];
+  struct sockaddr_in addr = {.sin_family = AF_INET, .sin_port = htons(port)};
+  inet_pton(AF_INET, host, &addr.sin_addr);
+
+  for (int i = 0; i < clients; i++) {
+    bench[i].fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (connect(bench[i].fd, (struct sockaddr *)&addr, sizeof(addr)) != 0) {
+      perror("connect");
+      return 1;
+    }
+    int one = 1;
+    setsockopt(bench[i].fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    bench[i].tid = (uint16_t)(i << 12);
+  }
+
+  int64_t start_us = now_us();
+  for (int i = 0; i < clients; i++) {
+    bench_send(&bench[i], unit, reg);
+  }
+  int active = clients;
+  while (active > 0 && !s_stop) {
+    for (int i = 0; i < clients; i++) {
+      pfds[i].fd = !bench[i].lost && bench[i].done < requests ? bench[i].fd : -1;
+      pfds[i].events = POLLIN;
+    }
+    if (poll(pfds, (nfds_t)clients, 5000) <= 0) {
+      fprintf(stderr, "no response within 5 s\n");
+      break;
+    }
+    for (int i = 0; i < clients; i++) {
+      if (pfds[i].fd < 0 || !(pfds[i].revents & (POLLIN | POLLHUP))) {
+        continue;
+      }
+      if (!bench_receive(&bench[i])) {
+        fprintf(stderr, "client %d: connection lost\n", i);
+        bench[i].lost = true;
+        active--;
+      } else if (bench[i].done < requests) {
+        bench_send(&bench[i], unit, reg);
+      } else {
+        active--;
+      }
+    }
+  }
+  double secs = (now_us() - start_us) / 1e6;
+
+  uint32_t done = 0;
+  uint32_t exceptions = 0;
+  bool complete = true;
+  double min_avg = 0;
+  double max_avg = 0;
+  for (int i = 0; i < clients; i++) {
+    bench_client_t *c = &bench[i];
+    double avg = c->done ? c->latency_us / 1000.0 / c->done : 0;
+    printf("client %d: %u done, %u exceptions, avg %.1f ms, max %.1f ms%s\n",
+           i, c->done, c->exceptions, avg, c->max_latency_us / 1000.0,
+           c->lost ? ", connection lost" : "");
+    min_avg = i == 0 || avg < min_avg ? avg : min_avg;
+    max_avg = avg > max_avg ? avg : max_avg;
+    done += c->done;
+    exceptions += c->exceptions;
+    complete = complete && !c->lost && c->done == requests;
+    close(c->fd);
+  }
+  printf("%u requests in %.2f s: %.1f req/s, %u exceptions, "
+         "per-client avg latency %.1f..%.1f ms\n",
+         done, secs, secs > 0 ? done / secs : 0.0, exceptions, min_avg,
+         max_avg);
+
+  int failures = 0;
+  if (!complete) {
+    printf("FAIL: not every client completed %u requests\n", requests);
+    failures++;
+  }
+  if (exceptions > 0) {
+    printf("FAIL: %u exception responses\n", exceptions);
+    failures++;
+  }
+  if (min_avg <= 0 || max_avg > min_avg * BENCH_MAX_FAIRNESS) {
+    printf("FAIL: slowest client waits %.1fx the fastest (limit %.1fx)\n",
+           min_avg > 0 ? max_avg / min_avg : 0.0, BENCH_MAX_FAIRNESS);
+    failures++;
+  }
+  return failures ? 1 : 0;
+}
+
+// 启动 tower_sim 并等待链接出现
+static bool start_sim(const char *sim_path, const char *link, int baud) {
+  char baud_str[16];
+  snprintf(baud_str, sizeof(baud_str), "%d", baud);
+  unlink(link);
+  s_sim_pid = fork();
+  if (s_sim_pid == 0) {
+    execl(sim_path, sim_path, "-l", link, "-a", TEST_TOWERS, "-b", baud_str,
+          (char *)NULL);
+    perror(sim_path);
+    _exit(127);
+  }
+  if (s_sim_pid < 0) {
+    perror("fork");
+    return false;
+  }
+  for (int i = 0; i < 200; i++) {
+    struct stat st;
+    if (lstat(link, &st) == 0) {
+      return true;
+    }
+    int status;
+    if (waitpid(s_sim_pid, &status, WNOHANG) == s_sim_pid) {
+      s_sim_pid = -1;
+      return false;
+    }
+    usleep(10000);
+  }
+  return false;
+}
+
+static void stop_sim(void) {
+  if (s_sim_pid > 0) {
+    kill(s_sim_pid, SIGTERM);
+    waitpid(s_sim_pid, NULL, 0);
+    s_sim_pid = -1;
+  }
+}
+
+// 自测：模拟塔灯 + 固件网关 + 压测，检查公平性与总线占用
+static int run_test(const char *sim_path, int baud, uint16_t port, int clients,
+                    uint32_t requests, uint8_t unit, uint16_t reg) {
+  char link[64];
+  snprintf(link, sizeof(link), "/tmp/tcp_gateway.%d", (int)getpid());
+  if (!start_sim(sim_path, link, baud)) {
+    fprintf(stderr, "failed to start %s\n", sim_path);
+    stop_sim();
+    return 1;
+  }
+  rs485_bus_t *bus = gateway_open(link, baud, port, 0, 100);
+  if (bus == NULL) {
+    stop_sim();
+    return 1;
+  }
+  // 模拟器每 10ms 检查一次从端是否已打开，在此之前写入的帧会积在一起
+  vTaskDelay(pdMS_TO_TICKS(50));
+
+  modbus_tcp_stats_t before = {0};
+  modbus_gateway_get_stats(&before);
+  int64_t start_us = now_us();
+  int failures = run_bench("127.0.0.1", port, clients, requests, unit, reg);
+  int64_t elapsed_us = now_us() - start_us;
+  // 统计快照由网关任务每轮刷新，等它跟上最后一个应答
+  vTaskDelay(pdMS_TO_TICKS(200));
+  modbus_tcp_stats_t after = {0};
+  modbus_gateway_get_stats(&after);
+
+  uint32_t busy = elapsed_us > 0
+                      ? (uint32_t)((after.bus_us - before.bus_us) * 100 /
+                                   (uint64_t)elapsed_us)
+                      : 0;
+  printf("gateway: %u bus transactions, %u timeouts, %u errors, "
+         "bus busy %u%%\n",
+         after.bus_transactions - before.bus_transactions,
+         after.timeouts - before.timeouts, after.errors - before.errors,
+         busy);
+  if (busy < TEST_MIN_BUS_BUSY_PERCENT) {
+    printf("FAIL: bus busy %u%% below %u%%\n", busy,
+           TEST_MIN_BUS_BUSY_PERCENT);
+    failures++;
+  }
+  if (after.timeouts != before.timeouts || after.errors != before.errors) {
+    printf("FAIL: bus timeouts or errors\n");
+    failures++;
+  }
+  // 网关任务没有停止接口，直接结束进程；只收掉模拟器
+  stop_sim();
+  unlink(link);
+  printf("%s: %d failure(s)\n", failures ? "FAIL" : "PASS", failures);
+  return failures ? 1 : 0;
+}
+
+int main(int argc, char **argv) {
+  const char *device = NULL;
+  const char *host = "127.0.0.1";
+  const char *sim_path = NULL;
+  bool bench = false;
+  bool test = false;
+  int baud = 9600;
+  int port = -1;
+  uint32_t cache_ms = 0;
+  uint32_t timeout_ms = 100;
+  int clients = 4;
+  uint32_t requests = 100;
+  uint8_t unit = 1;
+  uint16_t reg = 0x00C2;
+
+  int opt;
+  while ((opt = getopt(argc, argv, "D:b:p:c:t:Bh:n:r:u:a:TS:")) != -1) {
+    switch (opt) {
+    case 'D': device = optarg; break;
+    case 'b': baud = atoi(optarg); break;
+    case 'p': port = (int)strtoul(optarg, NULL, 0); break;
+    case 'c': cache_ms = (uint32_t)strtoul(optarg, NULL, 0); break;
+    case 't': timeout_ms = (uint32_t)strtoul(optarg, NULL, 0); break;
+    case 'B': bench = true; break;
+    case 'h': host = optarg; break;
+    case 'n': clients = atoi(optarg); break;
+    case 'r': requests = (uint32_t)strtoul(optarg, NULL, 0); break;
+    case 'u': unit = (uint8_t)strtoul(optarg, NULL, 0); break;
+    case 'a': reg = (uint16_t)strtoul(optarg, NULL, 0); break;
+    case 'T': test = true; break;
+    case 'S': sim_path = optarg; break;
+    default:
+      fprintf(stderr,
+              "usage: %s -D device [-b baud] [-p port] [-c cache_ms] "
+              "[-t timeout_ms]\n"
+              "       %s -B [-h host] [-p port] [-n clients] [-r requests] "
+              "[-u unit] [-a register]\n"
+              "       %s -T [-S tower_sim] [-b baud] [-p port] [-n clients] "
+              "[-r requests] [-u unit] [-a register]\n",
+              argv[0], argv[0], argv[0]);
+      return 2;
+    }
+  }
+  signal(SIGINT, on_signal);
+  signal(SIGTERM, on_signal);
+  signal(SIGPIPE, SIG_IGN);
+
+  if ((bench || test) && (clients < 1 || clients > BENCH_MAX_CLIENTS)) {
+    fprintf(stderr, "clients must be 1..%d\n", BENCH_MAX_CLIENTS);
+    return 2;
+  }
+  if (bench) {
+    return run_bench(host, port < 0 ? MODBUS_TCP_DEFAULT_PORT : (uint16_t)port,
+                     clients, requests, unit, reg);
+  }
+  esp_log_level_set("*", ESP_LOG_WARN);
+  if (test) {
+    // 默认端口随进程号错开，并行运行的检查互不冲突
+    char default_sim[4096];
+    if (sim_path == NULL) {
+      char self[4096];
+      snprintf(self, sizeof(self), "%s", argv[0]);
+      snprintf(default_sim, sizeof(default_sim), "%s/tower_sim", dirname(self));
+      sim_path = default_sim;
+    }
+    return run_test(sim_path, baud,
+                    port < 0 ? (uint16_t)(20000 + getpid() % 10000) : (uint16_t)port,
+                    clients, requests, unit, reg);
+  }
+  if (device == NULL) {
+    fprintf(stderr, "missing -D device\n");
+    return 2;
+  }
+  return run_gateway(device, baud,
+                     port < 0 ? MODBUS_TCP_DEFAULT_PORT : (uint16_t)port,
+                     cache_ms, timeout_ms);
+}
@@ -0,0 +1,534 @@
+/*
+ * RS485 总线主机基准：固件总线代码对模拟塔灯（Linux）
+ *
+ * 把 main/rs485_comm.c 原样编译到主机替身上（tools/host_shim，UART 接
+ * 伪终端），另起一个 tower_sim 进程在伪终端另一端模拟塔灯，经真实的
+ * 发送、切帧与超时路径检查并测量：
+ *
+ *   - 在线查询（地址 0xFF、寄存器 0x3F）由第一个塔灯应答；
+ *   - 每个塔灯的全部灯光命令（0x11..0x60 写 0xC2）被回显，读回一致；
+ *   - 广播命令执行但不应答，读回所有塔灯一致；
+ *   - 组命令逐个等到回显，返回的确认数等于塔灯数，读回一致；
+ *   - n 次读事务的延迟分布与吞吐量。模拟器注入误码或丢帧时，失败的
+ *     事务只能表现为 CRC 错误或超时，成功的事务数据必须正确；
+ *   - 同样 n 次读交给 Modbus 主站任务背靠背执行，报告
+ *     modbus_master_utilization_permille()；无故障时须达到 80%；
+ *   - 地址扫描（modbus_discovery）1..32：登记表恰为模拟的塔灯；从最大
+ *     塔灯地址之后重扫，旧设备不再留在登记表中，且静默地址只等首字节，
+ *     总耗时不超过按首字节超时推算的上限。
+ *
+ * 编译（在 tools 目录）：
+ *   make tower_bench
+ *
+ * 用法：
+ *   tower_bench [-S tower_sim 路径 | -l 已运行模拟器的链接] [-a 地址,...]
+ *               [-b 波特率] [-n 读事务数] [-t 应答延迟us] [-e 误码率]
+ *               [-d 丢帧率] [-s 随机种子] [-w 应答超时ms] [-c 抓包文件]
+ *     默认从本程序所在目录启动 tower_sim；-l 时 -t/-e/-d/-s 不起作用。
+ *     -c 把整次运行的收发帧按 rs485_capture 格式写入文件，供 rs485_replay
+ *     回放（tools/rs485_replay/tower_bench.cap 即 -n 20 时录下）。
+ *
+ * 任何一项检查不通过退出码为 1。
+ */
+#include "modbus_discovery.h"
+#include "modbus_master.h"
+#include "rs485_capture.h"
+#include "rs485_comm.h"
+#include "rs485_crc.h"
+#include "rs485_frames.h"
+#include "driver/uart.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include <libgen.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#define BENCH_UART UART_NUM_1
+#define BENCH_MAX_TOWERS 32
+#define BENCH_MIN_UTILIZATION_PERMILLE 800
+#define BENCH_SCAN_LAST 32
+#define BENCH_SCAN_TURNAROUND_MS 10
+#define BENCH_CAPTURE_SIZE (256 * 1024)
+
+static const rs485_cmd_t s_cmds[] = {
+    RS485_CMD_RED_ON,          RS485_CMD_YELLOW_ON,          RS485_CMD_GREEN_ON,
+    RS485_CMD_RED_SLOW_FLASH,  RS485_CMD_YELLOW_SLOW_FLASH,  RS485_CMD_GREEN_SLOW_FLASH,
+    RS485_CMD_RED_BURST_FLASH, RS485_CMD_YELLOW_BURST_FLASH, RS485_CMD_GREEN_BURST_FLASH,
+    RS485_CMD_LIGHT_OFF,
+};
+
+typedef struct {
+  uint8_t addrs[BENCH_MAX_TOWERS];
+  size_t addr_count;
+  uint32_t timeout_ms;
+  bool faults; // 模拟器注入误码或丢帧
+  int failures;
+} bench_t;
+
+static int s_sim_pid = -1;
+
+// 启动 tower_sim 并等待链接出现
+static bool start_sim(const char *sim_path, const char *link, const char *addrs, int baud,
+                      const char *turnaround, const char *ber, const char *drop, const char *seed) {
+  char baud_str[16];
+  snprintf(baud_str, sizeof(baud_str), "%d", baud);
+  unlink(link);
+  s_sim_pid = fork();
+  if (s_sim_pid == 0) {
+    execl(sim_path, sim_path, "-l", link, "-a", addrs, "-b", baud_str, "-t", turnaround, "-e", ber,
+          "-d", drop, "-s", seed, (char *)NULL);
+    perror(sim_path);
+    _exit(127);
+  }
+  if (s_sim_pid < 0) {
+    perror("fork");
+    return false;
+  }
+  for (int i = 0; i < 200; i++) {
+    struct stat st;
+    if (lstat(link, &st) == 0) {
+      return true;
+    }
+    int status;
+    if (waitpid(s_sim_pid, &status, WNOHANG) == s_sim_pid) {
+      s_sim_pid = -1;
+      return false;
+    }
+    usleep(10000);
+  }
+  return false;
+}
+
+static void stop_sim(void) {
+  if (s_sim_pid > 0) {
+    kill(s_sim_pid, SIGTERM);
+    waitpid(s_sim_pid, NULL, 0);
+    s_sim_pid = -1;
+  }
+}
+
+// 一次事务；返回应答长度，crc_ok 输出 CRC 结果
+static int transact(rs485_bus_t *bus, const bench_t *b, const uint8_t *request, uint8_t *response,
+                    bool *crc_ok) {
+  *crc_ok = false;
+  return rs485_bus_transact(bus, request, RS485_FRAME_LENGTH, response, 16, b->timeout_ms, crc_ok);
+}
+
+// 读灯光寄存器，失败返回 -1
+static int read_light(rs485_bus_t *bus, const bench_t *b, uint8_t addr) {
+  uint8_t request[RS485_FRAME_LENGTH];
+  uint8_t response[16];
+  bool crc_ok;
+  rs485_frames_build(request, addr, 0x03, RS485_REG_LIGHT, 1);
+  int n = transact(bus, b, request, response, &crc_ok);
+  if (n != 7 || !crc_ok || response[0] != addr || response[1] != 0x03 || response[2] != 2) {
+    return -1;
+  }
+  return (response[3] << 8) | response[4];
+}
+
+#define CHECK(b, cond, ...)                                                    \
+  do {                                                                         \
+    if (!(cond)) {                                                             \
+      printf("FAIL: ");                                                        \
+      printf(__VA_ARGS__);                                                     \
+      printf("\n");                                                            \
+      (b)->failures++;                                                         \
+    }                                                                          \
+  } while (0)
+
+static void test_query(rs485_bus_t *bus, bench_t *b) {
+  uint8_t response[16];
+  bool crc_ok;
+  int n = transact(bus, b, rs485_frames_query_devices(), response, &crc_ok);
+  CHECK(b, n == 7 && crc_ok && response[0] == b->addrs[0] && response[4] == b->addrs[0],
+        "online query: %d bytes, crc %s, address 0x%02X", n, crc_ok ? "ok" : "bad",
+        n > 0 ? response[0] : 0);
+}
+
+static void test_commands(rs485_bus_t *bus, bench_t *b) {
+  for (size_t t = 0; t < b->addr_count; t++) {
+    uint8_t addr = b->addrs[t];
+    for (size_t i = 0; i < sizeof(s_cmds) / sizeof(s_cmds[0]); i++) {
+      uint8_t request[RS485_FRAME_LENGTH];
+      uint8_t response[16];
+      bool crc_ok;
+      rs485_frames_build(request, addr, 0x06, RS485_REG_LIGHT, (uint16_t)s_cmds[i]);
+      int n = transact(bus, b, request, response, &crc_ok);
+      CHECK(b, n == 8 && crc_ok && memcmp(response, request, 6) == 0,
+            "tower 0x%02X command 0x%02X: %d byte echo, crc %s", addr, s_cmds[i], n,
+            crc_ok ? "ok" : "bad");
+      int light = read_light(bus, b, addr);
+      CHECK(b, light == (int)s_cmds[i], "tower 0x%02X after 0x%02X reads back %d", addr, s_cmds[i],
+            light);
+    }
+  }
+}
+
+// 模拟器只对应答注入故障，广播总会执行；注入故障时不读回
+static void test_broadcast(rs485_bus_t *bus, bench_t *b) {
+  CHECK(b, rs485_bus_send_command_to(bus, RS485_MODBUS_BROADCAST_ADDR, RS485_CMD_YELLOW_SLOW_FLASH),
+        "broadcast send");
+  // 模拟器按至少 2ms 静默切帧，高于 19200 时 t3.5 只有 1750us：
+  // 广播后多等一会，免得与下一帧请求被当成一帧
+  vTaskDelay(pdMS_TO_TICKS(5));
+  for (size_t t = 0; !b->faults && t < b->addr_count; t++) {
+    int light = read_light(bus, b, b->addrs[t]);
+    CHECK(b, light == RS485_CMD_YELLOW_SLOW_FLASH, "tower 0x%02X after broadcast reads back %d",
+          b->addrs[t], light);
+  }
+}
+
+static void test_group(rs485_bus_t *bus, bench_t *b) {
+  size_t acked = rs485_bus_send_group_command(bus, b->addrs, b->addr_count, RS485_CMD_GREEN_BURST_FLASH);
+  CHECK(b, acked == b->addr_count, "group command acked by %zu of %zu towers", acked, b->addr_count);
+  for (size_t t = 0; t < b->addr_count; t++) {
+    int light = read_light(bus, b, b->addrs[t]);
+    CHECK(b, light == RS485_CMD_GREEN_BURST_FLASH, "tower 0x%02X after group command reads back %d",
+          b->addrs[t], light);
+  }
+}
+
+static int cmp_i64(const void *a, const void *b) {
+  int64_t x = *(const int64_t *)a, y = *(const int64_t *)b;
+  return x < y ? -1 : x > y;
+}
+
+// 轮流读各塔灯：统计延迟与失败类型
+static void bench_reads(rs485_bus_t *bus, bench_t *b, size_t count) {
+  int64_t *latency = calloc(count, sizeof(*latency));
+  size_t ok = 0, timeouts = 0, crc_errors = 0, wrong = 0;
+  int64_t start = esp_timer_get_time();
+  for (size_t i = 0; i < count; i++) {
+    uint8_t addr = b->addrs[i % b->addr_count];
+    uint8_t request[RS485_FRAME_LENGTH];
+    uint8_t response[16];
+    bool crc_ok;
+    rs485_frames_build(request, addr, 0x03, RS485_REG_LIGHT, 1);
+    int64_t t0 = esp_timer_get_time();
+    int n = transact(bus, b, request, response, &crc_ok);
+    int64_t t1 = esp_timer_get_time();
+    if (n == 0) {
+      timeouts++;
+    } else if (n > 0 && !crc_ok) {
+      crc_errors++;
+    } else if (n == 7 && response[0] == addr && response[4] == RS485_CMD_YELLOW_SLOW_FLASH) {
+      latency[ok++] = t1 - t0;
+    } else {
+      wrong++;
+    }
+  }
+  double elapsed_s = (esp_timer_get_time() - start) / 1e6;
+
+  CHECK(b, wrong == 0, "%zu reads returned a good CRC with wrong content", wrong);
+  if (!b->faults) {
+    CHECK(b, ok == count, "%zu of %zu reads failed without injected faults (%zu timeouts, %zu crc)",
+          count - ok, count, timeouts, crc_errors);
+  }
+  if (ok > 0) {
+    qsort(latency, ok, sizeof(*latency), cmp_i64);
+    printf("reads: %zu ok, %zu timeouts, %zu crc errors, %.1f txn/s; latency p50 %lld us, "
+           "p99 %lld us, max %lld us\n",
+           ok, timeouts, crc_errors, count / elapsed_s, (long long)latency[ok / 2],
+           (long long)latency[(ok * 99) / 100], (long long)latency[ok - 1]);
+  } else {
+    printf("reads: 0 ok, %zu timeouts, %zu crc errors\n", timeouts, crc_errors);
+  }
+  free(latency);
+}
+
+typedef struct {
+  SemaphoreHandle_t done;
+  size_t ok;
+  size_t failed;
+} master_run_t;
+
+static void on_master_done(const modbus_result_t *result, void *user_ctx) {
+  master_run_t *run = user_ctx;
+  if (result->status == MODBUS_OK && result->registers[0] == RS485_CMD_YELLOW_SLOW_FLASH) {
+    run->ok++;
+  } else {
+    run->failed++;
+  }
+  xSemaphoreGive(run->done);
+}
+
+// 主站任务背靠背执行：队列保持非空，上一应答之后只隔 t3.5 就发下一请求
+static void bench_master(rs485_bus_t *bus, bench_t *b, size_t count) {
+  master_run_t run = {.done = xSemaphoreCreateCounting(count, 0)};
+  modbus_master_t *master = modbus_master_create(bus);
+  if (master == NULL || run.done == NULL) {
+    CHECK(b, false, "master create");
+    return;
+  }
+  modbus_request_t requests[BENCH_MAX_TOWERS];
+  for (size_t t = 0; t < b->addr_count; t++) {
+    requests[t] = (modbus_request_t){
+        .slave = b->addrs[t],
+        .function = MODBUS_FC_READ_HOLDING_REGISTERS,
+        .address = RS485_REG_LIGHT,
+        .quantity = 1,
+        .timeout_ms = (uint16_t)b->timeout_ms,
+        .retry_class = MODBUS_CLASS_DISCOVERY, // 不经断路器：注入故障时也保持总线忙碌
+    };
+  }
+
+  int64_t start = esp_timer_get_time();
+  size_t submitted = 0;
+  for (size_t completed = 0; completed < count; completed++) {
+    while (submitted < count && modbus_master_submit(master, &requests[submitted % b->addr_count],
+                                                     on_master_done, &run) == MODBUS_OK) {
+      submitted++;
+    }
+    xSemaphoreTake(run.done, portMAX_DELAY);
+  }
+  uint32_t permille = modbus_master_utilization_permille(master);
+  double elapsed_s = (esp_timer_get_time() - start) / 1e6;
+  modbus_master_stats_t stats;
+  modbus_master_get_stats(master, &stats);
+  modbus_master_destroy(master);
+  vSemaphoreDelete(run.done);
+
+  printf("master: %zu ok, %zu failed, %.1f txn/s, utilization %lu.%lu%% (%llu us held)\n", run.ok,
+         run.failed, count / elapsed_s, (unsigned long)(permille / 10), (unsigned long)(permille % 10),
+         (unsigned long long)stats.busy_us);
+  if (!b->faults) {
+    CHECK(b, run.ok == count, "%zu of %zu master reads failed", run.failed, count);
+    CHECK(b, permille >= BENCH_MIN_UTILIZATION_PERMILLE, "master utilization %lu permille, expected >= %d",
+          (unsigned long)permille, BENCH_MIN_UTILIZATION_PERMILLE);
+  }
+}
+
+static void on_scan_done(size_t device_count, void *user_ctx) {
+  (void)device_count;
+  xSemaphoreGive((SemaphoreHandle_t)user_ctx);
+}
+
+// 扫描 first..BENCH_SCAN_LAST，返回耗时（微秒）
+static int64_t scan(modbus_master_t *master, uint8_t first, SemaphoreHandle_t done) {
+  modbus_discovery_config_t config = {
+      .first_address = first,
+      .last_address = BENCH_SCAN_LAST,
+      .initial_turnaround_ms = BENCH_SCAN_TURNAROUND_MS,
+  };
+  int64_t start = esp_timer_get_time();
+  if (!modbus_discovery_start(master, &config, on_scan_done, done)) {
+    return -1;
+  }
+  xSemaphoreTake(done, portMAX_DELAY);
+  while (modbus_discovery_is_running()) {
+    vTaskDelay(1);
+  }
+  return esp_timer_get_time() - start;
+}
+
+// 扫描范围内的塔灯数与登记表是否恰好一致
+static size_t scan_expected(const bench_t *b, uint8_t first) {
+  size_t n = 0;
+  for (size_t t = 0; t < b->addr_count; t++) {
+    n += b->addrs[t] >= first && b->addrs[t] <= BENCH_SCAN_LAST;
+  }
+  return n;
+}
+
+static bool registry_matches(const bench_t *b, uint8_t first) {
+  modbus_device_info_t devices[MODBUS_DISCOVERY_MAX_DEVICES];
+  size_t count = modbus_discovery_get_devices(devices, MODBUS_DISCOVERY_MAX_DEVICES);
+  if (count != scan_expected(b, first)) {
+    return false;
+  }
+  for (size_t i = 0; i < count; i++) {
+    bool known = false;
+    for (size_t t = 0; t < b->addr_count; t++) {
+      known = known || (devices[i].address == b->addrs[t] && devices[i].address >= first);
+    }
+    if (!known) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// 先扫 1..32 核对登记表；再从最大塔灯地址之后重扫：范围内全是静默地址，
+// 登记表须清空，且每个地址只等首字节：不超过 t3.5 + 请求 + 首字节超时
+// （余量 + 2 字符 + 1ms，取整到毫秒）+ 1ms 调度余量。若等满整帧 + t3.5，
+// 每个地址会多出 7 个字符加 t3.5
+static void bench_discovery(rs485_bus_t *bus, bench_t *b) {
+  uint32_t char_us = 0, gap_us = 0;
+  rs485_bus_get_timing(bus, &char_us, &gap_us);
+  SemaphoreHandle_t done = xSemaphoreCreateBinary();
+  modbus_master_t *master = modbus_master_create(bus);
+  if (master == NULL || done == NULL) {
+    CHECK(b, false, "discovery setup");
+    return;
+  }
+
+  int64_t elapsed = scan(master, 1, done);
+  CHECK(b, elapsed >= 0 && registry_matches(b, 1), "discovery registry does not match the simulated towers");
+
+  uint8_t first = 0;
+  for (size_t t = 0; t < b->addr_count; t++) {
+    first = b->addrs[t] >= first ? (uint8_t)(b->addrs[t] + 1) : first;
+  }
+  if (first <= BENCH_SCAN_LAST) {
+    elapsed = scan(master, first, done);
+    int64_t first_byte_us = ((BENCH_SCAN_TURNAROUND_MS * 1000 + 2 * char_us + 1000 + 999) / 1000) * 1000;
+    int64_t limit = (int64_t)(BENCH_SCAN_LAST - first + 1) * (gap_us + 8 * char_us + first_byte_us + 1000);
+    printf("discovery: %d silent addresses in %lld ms (limit %lld ms)\n", BENCH_SCAN_LAST - first + 1,
+           (long long)(elapsed / 1000), (long long)(limit / 1000));
+    CHECK(b, registry_matches(b, first), "rescan from 0x%02X kept stale devices", first);
+    CHECK(b, elapsed >= 0 && elapsed <= limit, "silent scan took %lld us, limit %lld us", (long long)elapsed,
+          (long long)limit);
+  }
+
+  modbus_master_destroy(master);
+  vSemaphoreDelete(done);
+}
+
+static bool capture_write(const uint8_t *data, size_t length, void *user_ctx) {
+  return fwrite(data, 1, length, (FILE *)user_ctx) == length;
+}
+
+// 导出抓包；环写满丢弃过最老记录时回放开头会有无请求的应答
+static void save_capture(const char *path, bench_t *b) {
+  FILE *fp = fopen(path, "wb");
+  if (fp == NULL) {
+    perror(path);
+    b->failures++;
+    return;
+  }
+  size_t records = rs485_capture_export(capture_write, fp);
+  uint32_t dropped = 0;
+  rs485_capture_get_stats(NULL, &dropped);
+  if (fclose(fp) != 0) {
+    perror(path);
+    b->failures++;
+  }
+  printf("capture: %zu records to %s (%lu dropped)\n", records, path, (unsigned long)dropped);
+}
+
+int main(int argc, char **argv) {
+  bench_t b = {.timeout_ms = 100};
+  const char *sim_path = NULL;
+  const char *link = NULL;
+  const char *addrs = "1,2,3";
+  const char *turnaround = "1000";
+  const char *ber = "0";
+  const char *drop = "0";
+  const char *seed = "1";
+  const char *capture = NULL;
+  int baud = 19200;
+  size_t reads = 200;
+
+  int opt;
+  while ((opt = getopt(argc, argv, "S:l:a:b:n:t:e:d:s:w:c:")) != -1) {
+    switch (opt) {
+    case 'S': sim_path = optarg; break;
+    case 'l': link = optarg; break;
+    case 'a': addrs = optarg; break;
+    case 'b': baud = atoi(optarg); break;
+    case 'n': reads = strtoul(optarg, NULL, 0); break;
+    case 't': turnaround = optarg; break;
+    case 'e': ber = optarg; break;
+    case 'd': drop = optarg; break;
+    case 's': seed = optarg; break;
+    case 'w': b.timeout_ms = (uint32_t)strtoul(optarg, NULL, 0); break;
+    case 'c': capture = optarg; break;
+    default:
+      fprintf(stderr,
+              "usage: %s [-S tower_sim | -l link] [-a addr,...] [-b baud] [-n reads] "
+              "[-t turnaround_us] [-e bit_error_rate] [-d drop_rate] [-s seed] [-w timeout_ms] "
+              "[-c capture]\n",
+              argv[0]);
+      return 2;
+    }
+  }
+  b.faults = atof(ber) > 0 || atof(drop) > 0;
+  for (char *list = strdup(addrs), *tok = strtok(list, ",");
+       tok != NULL && b.addr_count < BENCH_MAX_TOWERS; tok = strtok(NULL, ",")) {
+    b.addrs[b.addr_count++] = (uint8_t)strtoul(tok, NULL, 0);
+  }
+  esp_log_level_set("*", ESP_LOG_WARN);
+
+  char own_link[64];
+  char default_sim[4096];
+  if (link == NULL) {
+    if (sim_path == NULL) {
+      char self[4096];
+      snprintf(self, sizeof(self), "%s", argv[0]);
+      snprintf(default_sim, sizeof(default_sim), "%s/tower_sim", dirname(self));
+      sim_path = default_sim;
+    }
+    snprintf(own_link, sizeof(own_link), "/tmp/tower_bench.%d", (int)getpid());
+    link = own_link;
+    if (!start_sim(sim_path, link, addrs, baud, turnaround, ber, drop, seed)) {
+      fprintf(stderr, "failed to start %s\n", sim_path);
+      stop_sim();
+      return 1;
+    }
+  }
+
+  if (host_uart_attach(BENCH_UART, link) != ESP_OK) {
+    perror(link);
+    stop_sim();
+    return 1;
+  }
+  rs485_bus_config_t config = {
+      .uart_num = BENCH_UART,
+      .tx_pin = 17,
+      .rx_pin = 18,
+      .de_pin = UART_PIN_NO_CHANGE,
+      .baud_rate = baud,
+      .parity = UART_PARITY_DISABLE,
+      .task_core = -1,
+  };
+  rs485_bus_t *bus = rs485_bus_open(&config);
+  if (bus == NULL) {
+    printf("FAIL: bus open\n");
+    host_uart_detach(BENCH_UART);
+    stop_sim();
+    return 1;
+  }
+  // 模拟器每 10ms 检查一次从端是否已打开，在此之前写入的帧会积在一起
+  vTaskDelay(pdMS_TO_TICKS(50));
+  if (capture != NULL && !rs485_capture_start(BENCH_CAPTURE_SIZE)) {
+    printf("FAIL: capture start\n");
+    b.failures++;
+  }
+
+  // 注入故障时功能检查没有意义，只做基准
+  if (!b.faults) {
+    test_query(bus, &b);
+    test_commands(bus, &b);
+    test_group(bus, &b);
+    bench_discovery(bus, &b);
+  }
+  test_broadcast(bus, &b);
+  bench_reads(bus, &b, reads);
+  bench_master(bus, &b, reads);
+
+  rs485_bus_stats_t stats;
+  rs485_bus_get_stats(bus, &stats);
+  printf("bus: %lu tx frames, %lu rx frames, %lu crc errors, %lu rx errors, %lu timeouts\n",
+         (unsigned long)stats.tx_frames, (unsigned long)stats.rx_frames,
+         (unsigned long)stats.rx_crc_errors, (unsigned long)stats.rx_errors,
+         (unsigned long)stats.rx_timeouts);
+  if (capture != NULL) {
+    save_capture(capture, &b);
+  }
+
+  rs485_bus_close(bus);
+  host_uart_detach(BENCH_UART);
+  fflush(stdout);
+  stop_sim();
+  printf("%s: %d failure(s)\n", b.failures ? "FAIL" : "PASS", b.failures);
+  return b.failures ? 1 : 0;
+}
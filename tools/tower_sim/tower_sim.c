@@ -0,0 +1,368 @@
+/*
+ * 塔灯总线模拟器（Linux）
+ *
+ * 打开一对伪终端，在主端模拟一条 RS485 总线上的若干塔灯；从端（或
+ * -l 指定的符号链接）交给被测程序当串口使用。也可用 -D 直接接到
+ * USB-RS485 转换器上，让真实面板对着模拟塔灯运行。
+ *
+ * 模拟的命令集与固件一致：
+ *   - FC06 写 0x00C2：灯光命令 0x11..0x60，回显请求
+ *   - FC03 读 0x00C2：返回当前灯光状态
+ *   - FC03 读 0x003F：在线查询，返回设备地址（查询地址 0xFF 时由第一个
+ *     塔灯应答）
+ *   - 地址 0 广播写：执行但不应答
+ *   其他寄存器回异常 02，其他功能码回异常 01。请求可带 00 00 后缀。
+ *
+ * 编译（在仓库根目录）：
+ *   g++ -O2 -Imain -x c tools/tower_sim/tower_sim.c -x c++ main/rs485_crc.cpp \
+ *       -o tower_sim
+ *
+ * 用法：
+ *   tower_sim [-l 链接路径 | -D 串口设备] [-a 地址,...] [-b 波特率]
+ *             [-t 应答延迟us] [-e 误码率] [-d 丢帧率] [-s 随机种子] [-v]
+ *     -e  每个应答翻转一个随机位的概率（0..1）
+ *     -d  收到请求后不应答的概率（0..1）
+ */
+#define _XOPEN_SOURCE 700
+#define _DEFAULT_SOURCE
+#include "rs485_crc.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+#define SIM_MAX_TOWERS 32
+#define SIM_FRAME_MAX 256
+
+#define REG_LIGHT 0x00C2
+#define REG_QUERY 0x003F
+#define QUERY_ADDR 0xFF
+
+typedef struct {
+  uint8_t address;
+  uint16_t light; // 当前灯光命令，0x60 为关闭
+  uint32_t commands;
+} sim_tower_t;
+
+typedef struct {
+  sim_tower_t towers[SIM_MAX_TOWERS];
+  size_t tower_count;
+  uint32_t char_time_us;
+  uint32_t gap_us;
+  uint32_t turnaround_us;
+  double bit_error_rate;
+  double drop_rate;
+  bool verbose;
+
+  uint32_t requests;
+  uint32_t responses;
+  uint32_t dropped;
+  uint32_t corrupted;
+  uint32_t crc_errors;
+} sim_t;
+
+static volatile sig_atomic_t s_stop = 0;
+
+static void on_signal(int sig) {
+  (void)sig;
+  s_stop = 1;
+}
+
+static double rand_unit(void) { return rand() / ((double)RAND_MAX + 1); }
+
+static void sleep_us(uint32_t us) {
+  struct timespec ts = {us / 1000000, (long)(us % 1000000) * 1000};
+  while (nanosleep(&ts, &ts) != 0 && errno == EINTR && !s_stop) {
+  }
+}
+
+static size_t finish(uint8_t *frame, size_t len) {
+  uint16_t crc = rs485_crc16_update(RS485_CRC16_INIT, frame, len);
+  frame[len++] = (uint8_t)(crc & 0xFF);
+  frame[len++] = (uint8_t)(crc >> 8);
+  return len;
+}
+
+static bool valid_light(uint16_t value) {
+  switch (value) {
+  case 0x11: case 0x12: case 0x13:
+  case 0x21: case 0x22: case 0x23:
+  case 0x31: case 0x32: case 0x33:
+  case 0x60:
+    return true;
+  default:
+    return false;
+  }
+}
+
+static sim_tower_t *find_tower(sim_t *sim, uint8_t address) {
+  for (size_t i = 0; i < sim->tower_count; i++) {
+    if (sim->towers[i].address == address) {
+      return &sim->towers[i];
+    }
+  }
+  return NULL;
+}
+
+static void dump(const char *dir, const uint8_t *frame, size_t len) {
+  printf("%s", dir);
+  for (size_t i = 0; i < len; i++) {
+    printf(" %02X", frame[i]);
+  }
+  printf("\n");
+  fflush(stdout);
+}
+
+// 处理一帧请求，返回应答长度（0 为不应答）
+static size_t handle_request(sim_t *sim, const uint8_t *req, size_t len,
+                             uint8_t *resp) {
+  // 允许塔灯帧的 00 00 后缀
+  if (len >= 10 && req[len - 2] == 0 && req[len - 1] == 0 &&
+      rs485_crc16_update(RS485_CRC16_INIT, req, len - 2) == 0) {
+    len -= 2;
+  } else if (len < 4 || rs485_crc16_update(RS485_CRC16_INIT, req, len) != 0) {
+    sim->crc_errors++;
+    return 0;
+  }
+  sim->requests++;
+
+  uint8_t addr = req[0];
+  uint8_t fc = req[1];
+  bool broadcast = addr == 0;
+  sim_tower_t *tower = addr == QUERY_ADDR && sim->tower_count > 0
+                           ? &sim->towers[0]
+                           : find_tower(sim, addr);
+  if (!broadcast && tower == NULL) {
+    return 0; // 总线上没有这个地址
+  }
+  uint16_t reg = len >= 8 ? (uint16_t)((req[2] << 8) | req[3]) : 0;
+  uint16_t value = len >= 8 ? (uint16_t)((req[4] << 8) | req[5]) : 0;
+
+  resp[0] = addr;
+  resp[1] = fc;
+  if (fc == 0x06 && len == 8) {
+    if (reg != REG_LIGHT) {
+      resp[1] |= 0x80;
+      resp[2] = 0x02;
+      return broadcast ? 0 : finish(resp, 3);
+    }
+    if (!valid_light(value)) {
+      resp[1] |= 0x80;
+      resp[2] = 0x03;
+      return broadcast ? 0 : finish(resp, 3);
+    }
+    for (size_t i = 0; i < sim->tower_count; i++) {
+      sim_tower_t *t = &sim->towers[i];
+      if (broadcast || t == tower) {
+        t->light = value;
+        t->commands++;
+      }
+    }
+    if (broadcast) {
+      return 0;
+    }
+    memcpy(resp, req, 6);
+    return finish(resp, 6);
+  }
+  if (fc == 0x03 && len == 8 && !broadcast) {
+    // 查询帧数量字段为 0，按 1 个寄存器应答
+    uint16_t qty = value == 0 ? 1 : value;
+    if (qty != 1 || (reg != REG_LIGHT && reg != REG_QUERY)) {
+      resp[1] |= 0x80;
+      resp[2] = 0x02;
+      return finish(resp, 3);
+    }
+    uint16_t v = reg == REG_LIGHT ? tower->light : tower->address;
+    resp[0] = tower->address;
+    resp[2] = 2;
+    resp[3] = (uint8_t)(v >> 8);
+    resp[4] = (uint8_t)(v & 0xFF);
+    return finish(resp, 5);
+  }
+  if (broadcast) {
+    return 0;
+  }
+  resp[1] |= 0x80;
+  resp[2] = 0x01;
+  return finish(resp, 3);
+}
+
+static void respond(sim_t *sim, int fd, uint8_t *resp, size_t len) {
+  if (rand_unit() < sim->drop_rate) {
+    sim->dropped++;
+    if (sim->verbose) {
+      dump("drop", resp, len);
+    }
+    return;
+  }
+  if (rand_unit() < sim->bit_error_rate) {
+    size_t bit = (size_t)(rand_unit() * len * 8);
+    resp[bit / 8] ^= (uint8_t)(1u << (bit % 8));
+    sim->corrupted++;
+  }
+  sleep_us(sim->turnaround_us);
+  if (write(fd, resp, len) != (ssize_t)len) {
+    perror("write");
+    return;
+  }
+  // 按线路速率占用总线，被测方看到的下一帧间隔才真实
+  sleep_us((uint32_t)(len * sim->char_time_us));
+  sim->responses++;
+  if (sim->verbose) {
+    dump("<-", resp, len);
+  }
+}
+
+static int open_bus(const char *device, const char *link, int baud) {
+  int fd;
+  if (device != NULL) {
+    fd = open(device, O_RDWR | O_NOCTTY);
+    if (fd < 0) {
+      perror(device);
+      return -1;
+    }
+    struct termios tio;
+    tcgetattr(fd, &tio);
+    cfmakeraw(&tio);
+    speed_t speed = baud == 115200 ? B115200 : baud == 57600 ? B57600
+                    : baud == 38400 ? B38400 : baud == 19200 ? B19200
+                    : B9600;
+    cfsetispeed(&tio, speed);
+    cfsetospeed(&tio, speed);
+    tcsetattr(fd, TCSANOW, &tio);
+    return fd;
+  }
+
+  fd = posix_openpt(O_RDWR | O_NOCTTY);
+  if (fd < 0 || grantpt(fd) != 0 || unlockpt(fd) != 0) {
+    perror("posix_openpt");
+    return -1;
+  }
+  const char *slave = ptsname(fd);
+  // 从端设为原始模式，避免行规程改写二进制帧
+  int sfd = open(slave, O_RDWR | O_NOCTTY);
+  if (sfd >= 0) {
+    struct termios tio;
+    tcgetattr(sfd, &tio);
+    cfmakeraw(&tio);
+    tcsetattr(sfd, TCSANOW, &tio);
+    close(sfd);
+  }
+  if (link != NULL) {
+    unlink(link);
+    if (symlink(slave, link) != 0) {
+      perror(link);
+    }
+  }
+  printf("tower bus on %s%s%s\n", slave, link ? " -> " : "", link ? link : "");
+  fflush(stdout);
+  return fd;
+}
+
+int main(int argc, char **argv) {
+  sim_t sim = {0};
+  const char *link = NULL;
+  const char *device = NULL;
+  const char *addrs = "1";
+  int baud = 9600;
+  unsigned seed = (unsigned)time(NULL);
+  sim.turnaround_us = 2000;
+
+  int opt;
+  while ((opt = getopt(argc, argv, "l:D:a:b:t:e:d:s:v")) != -1) {
+    switch (opt) {
+    case 'l': link = optarg; break;
+    case 'D': device = optarg; break;
+    case 'a': addrs = optarg; break;
+    case 'b': baud = atoi(optarg); break;
+    case 't': sim.turnaround_us = (uint32_t)strtoul(optarg, NULL, 0); break;
+    case 'e': sim.bit_error_rate = atof(optarg); break;
+    case 'd': sim.drop_rate = atof(optarg); break;
+    case 's': seed = (unsigned)strtoul(optarg, NULL, 0); break;
+    case 'v': sim.verbose = true; break;
+    default:
+      fprintf(stderr,
+              "usage: %s [-l link | -D device] [-a addr,...] [-b baud] "
+              "[-t turnaround_us] [-e bit_error_rate] [-d drop_rate] "
+              "[-s seed] [-v]\n",
+              argv[0]);
+      return 2;
+    }
+  }
+  srand(seed);
+
+  for (char *list = strdup(addrs), *tok = strtok(list, ",");
+       tok != NULL && sim.tower_count < SIM_MAX_TOWERS;
+       tok = strtok(NULL, ",")) {
+    sim_tower_t *t = &sim.towers[sim.tower_count++];
+    t->address = (uint8_t)strtoul(tok, NULL, 0);
+    t->light = 0x60;
+  }
+
+  // 8N1 每字符 10 位；与固件相同，高于 19200 时 t3.5 固定 1750us
+  sim.char_time_us = (uint32_t)((10 * 1000000ULL + baud - 1) / baud);
+  sim.gap_us = baud > 19200 ? 1750 : (sim.char_time_us * 7 + 1) / 2;
+
+  int fd = open_bus(device, link, baud);
+  if (fd < 0) {
+    return 1;
+  }
+  signal(SIGINT, on_signal);
+  signal(SIGTERM, on_signal);
+
+  // 主机调度粒度为毫秒级，帧间静默至少按 2ms 判断
+  int gap_ms = (int)((sim.gap_us + 999) / 1000);
+  gap_ms = gap_ms < 2 ? 2 : gap_ms;
+  uint8_t frame[SIM_FRAME_MAX];
+  uint8_t resp[SIM_FRAME_MAX];
+  size_t len = 0;
+  while (!s_stop) {
+    struct pollfd pfd = {.fd = fd, .events = POLLIN};
+    int ready = poll(&pfd, 1, len > 0 ? gap_ms : 500);
+    if (ready > 0 && (pfd.revents & POLLIN)) {
+      ssize_t n = read(fd, &frame[len], sizeof(frame) - len);
+      if (n > 0) {
+        len += (size_t)n;
+      }
+      if (len < sizeof(frame)) {
+        continue;
+      }
+    } else if (ready > 0 && (pfd.revents & POLLHUP)) {
+      sleep_us(10000); // 从端尚未被打开；间隔要短，否则刚打开时的几帧会积在一起
+      continue;
+    }
+    if (len == 0) {
+      continue;
+    }
+    // 线路静默：一帧结束
+    if (sim.verbose) {
+      dump("->", frame, len);
+    }
+    size_t rlen = handle_request(&sim, frame, len, resp);
+    if (rlen > 0) {
+      respond(&sim, fd, resp, rlen);
+    }
+    len = 0;
+  }
+
+  printf("requests %u, responses %u, dropped %u, corrupted %u, crc errors %u\n",
+         sim.requests, sim.responses, sim.dropped, sim.corrupted,
+         sim.crc_errors);
+  for (size_t i = 0; i < sim.tower_count; i++) {
+    printf("tower 0x%02X: light 0x%02X, %u commands\n", sim.towers[i].address,
+           sim.towers[i].light, sim.towers[i].commands);
+  }
+  if (link != NULL) {
+    unlink(link);
+  }
+  close(fd);
+  return 0;
+}